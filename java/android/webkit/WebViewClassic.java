@@ -4992,6 +4992,17 @@ public final class WebViewClassic implements WebViewProvider, WebViewProvider.Sc
         mWebViewCore.sendMessage(EventHub.DUMP_RENDERTREE, toFile ? 1 : 0, 0);
     }
 
+    /**
+     * Dump the invalidation and recording statistics of the recent frames as
+     * JSON to adb shell if "toFile" is False, otherwise dump them to
+     * "/sdcard/recordingStats.json"
+     *
+     * debug only
+     */
+    public void dumpRecordingStats(boolean toFile) {
+        mWebViewCore.sendMessage(EventHub.DUMP_RECORDING_STATS, toFile ? 1 : 0, 0);
+    }
+
     /**
      * Called by DRT on UI thread, need to proxy to WebCore thread.
      *
@@ -5188,6 +5199,10 @@ public final class WebViewClassic implements WebViewProvider, WebViewProvider.Sc
                 case KeyEvent.KEYCODE_8:
                     dumpRenderTree(keyCode == KeyEvent.KEYCODE_7);
                     break;
+                case KeyEvent.KEYCODE_9:
+                case KeyEvent.KEYCODE_0:
+                    dumpRecordingStats(keyCode == KeyEvent.KEYCODE_9);
+                    break;
             }
         }
 
@@ -666,6 +666,8 @@ public final class WebViewCore {
 
     private native void nativeDumpRenderTree(int nativeClass, boolean useFile);
 
+    private native void nativeDumpRecordingStats(int nativeClass, boolean useFile);
+
     private native void nativeSetJsFlags(int nativeClass, String flags);
 
     /**
@@ -1128,6 +1130,7 @@ public final class WebViewCore {
         // debugging
         static final int DUMP_DOMTREE = 170;
         static final int DUMP_RENDERTREE = 171;
+        static final int DUMP_RECORDING_STATS = 172;
 
         static final int SET_JS_FLAGS = 174;
         static final int CONTENT_INVALIDATE_ALL = 175;
@@ -1587,6 +1590,10 @@ public final class WebViewCore {
                             nativeDumpRenderTree(mNativeClass, msg.arg1 == 1);
                             break;
 
+                        case DUMP_RECORDING_STATS:
+                            nativeDumpRecordingStats(mNativeClass, msg.arg1 == 1);
+                            break;
+
                         case SET_JS_FLAGS:
                             nativeSetJsFlags(mNativeClass, (String)msg.obj);
                             break;
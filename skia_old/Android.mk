@@ -303,6 +303,7 @@ LOCAL_SRC_FILES:= \
 	src/utils/SkBitSet.cpp \
 	src/utils/SkBoundaryPatch.cpp \
 	src/utils/SkCamera.cpp \
+	src/utils/SkCondVar.cpp \
 	src/utils/SkCubicInterval.cpp \
 	src/utils/SkCullPoints.cpp \
 	src/utils/SkDeferredCanvas.cpp \
@@ -322,6 +323,7 @@ LOCAL_SRC_FILES:= \
 	src/utils/SkProxyCanvas.cpp \
 	src/utils/SkSHA1.cpp \
 	src/utils/SkRTConf.cpp \
+	src/utils/SkThreadPool.cpp \
 	src/utils/SkThreadUtils_pthread.cpp \
 	src/utils/SkThreadUtils_pthread_other.cpp \
 	src/utils/SkUnitMappers.cpp
@@ -433,18 +435,23 @@ LOCAL_SRC_FILES += \
     src/opts/SkBlitRow_opts_arm_neon.cpp
 endif
 
+# SkXfermode_opts_arm_neon.cpp has not been compiled and tested on ARM yet,
+# keep the portable xfermode procs until it has.
+
 LOCAL_SRC_FILES += \
     src/core/SkUtilsArm.cpp \
 	src/opts/opts_check_arm.cpp \
 	src/opts/memset.arm.S \
 	src/opts/SkBitmapProcState_opts_arm.cpp \
-	src/opts/SkBlitRow_opts_arm.cpp
+	src/opts/SkBlitRow_opts_arm.cpp \
+	src/opts/SkXfermode_opts_none.cpp
 
 else
 LOCAL_SRC_FILES += \
 	src/opts/SkBlitRow_opts_none.cpp \
 	src/opts/SkBitmapProcState_opts_none.cpp \
-	src/opts/SkUtils_opts_none.cpp
+	src/opts/SkUtils_opts_none.cpp \
+	src/opts/SkXfermode_opts_none.cpp
 endif
 
 
@@ -6,6 +6,7 @@ LOCAL_SRC_FILES := \
   benchmain.cpp \
   SkBenchmark.cpp \
   BenchTimer.cpp \
+  BenchThreads.cpp \
   BenchSysTimer_posix.cpp \
   BenchGpuTimer_gl.cpp \
   SkBenchLogger.cpp \
@@ -51,7 +52,8 @@ LOCAL_SRC_FILES += \
   TextBench.cpp \
   TileBench.cpp \
   VertBench.cpp \
-  WriterBench.cpp
+  WriterBench.cpp \
+  XfermodeBench.cpp
 
 # Files that are missing dependencies
 #LOCAL_SRC_FILES += \
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2012 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "BenchThreads.h"
+#include "SkThreadUtils.h"
+
+BenchThreads::BenchThreads(int count, Proc proc, void* context)
+        : fProc(proc)
+        , fContext(context)
+        , fCount(count)
+        , fWorkers(count)
+        , fThreads(count)
+        , fGeneration(0)
+        , fPending(0)
+        , fQuit(false) {
+    for (int i = 0; i < fCount; i++) {
+        fWorkers[i].fOwner = this;
+        fWorkers[i].fIndex = i;
+        fThreads[i] = SkNEW_ARGS(SkThread, (WorkerProc, &fWorkers[i]));
+        if (!fThreads[i]->start()) {
+            // run() would wait for it forever
+            sk_throw();
+        }
+    }
+}
+
+BenchThreads::~BenchThreads() {
+    fCondVar.lock();
+    fQuit = true;
+    fCondVar.broadcast();
+    fCondVar.unlock();
+    for (int i = 0; i < fCount; i++) {
+        fThreads[i]->join();
+        SkDELETE(fThreads[i]);
+    }
+}
+
+void BenchThreads::run() {
+    fCondVar.lock();
+    fGeneration += 1;
+    fPending = fCount;
+    fCondVar.broadcast();
+    while (fPending > 0) {
+        fCondVar.wait();
+    }
+    fCondVar.unlock();
+}
+
+void BenchThreads::WorkerProc(void* data) {
+    Worker* worker = (Worker*)data;
+    BenchThreads* owner = worker->fOwner;
+    int generation = 0;
+    for (;;) {
+        owner->fCondVar.lock();
+        while (owner->fGeneration == generation && !owner->fQuit) {
+            owner->fCondVar.wait();
+        }
+        if (owner->fQuit) {
+            owner->fCondVar.unlock();
+            return;
+        }
+        generation = owner->fGeneration;
+        owner->fCondVar.unlock();
+
+        owner->fProc(owner->fContext, worker->fIndex);
+
+        owner->fCondVar.lock();
+        owner->fPending -= 1;
+        if (0 == owner->fPending) {
+            // the other workers wake up too, and go back to waiting
+            owner->fCondVar.broadcast();
+        }
+        owner->fCondVar.unlock();
+    }
+}
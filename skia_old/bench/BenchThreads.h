@@ -0,0 +1,55 @@
+/*
+ * Copyright 2012 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef BenchThreads_DEFINED
+#define BenchThreads_DEFINED
+
+#include "SkCondVar.h"
+#include "SkTemplates.h"
+
+class SkThread;
+
+/**
+ * Keeps a set of threads around between draws, so that benchmarks running work
+ * on several threads only time the work: create it in onPreDraw, call run() in
+ * onDraw and delete it in onPostDraw.
+ */
+class BenchThreads : SkNoncopyable {
+public:
+    typedef void (*Proc)(void* context, int index);
+
+    BenchThreads(int count, Proc proc, void* context);
+    ~BenchThreads();
+
+    /**
+     * Calls proc(context, index) on each thread, with index from 0 to count - 1,
+     * and returns when all of them are done.
+     */
+    void run();
+
+private:
+    struct Worker {
+        BenchThreads*   fOwner;
+        int             fIndex;
+    };
+
+    static void WorkerProc(void* data);
+
+    Proc                    fProc;
+    void*                   fContext;
+    int                     fCount;
+    SkAutoTArray<Worker>    fWorkers;
+    SkAutoTArray<SkThread*> fThreads;
+
+    // guards the fields below, and wakes the workers and run()
+    SkCondVar   fCondVar;
+    int         fGeneration;    // bumped by each run()
+    int         fPending;       // workers still running this generation
+    bool        fQuit;
+};
+
+#endif
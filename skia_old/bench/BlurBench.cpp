@@ -11,6 +11,7 @@
 #include "SkRandom.h"
 #include "SkShader.h"
 #include "SkString.h"
+#include "SkBlurMask.h"
 #include "SkBlurMaskFilter.h"
 
 #define SMALL   SkIntToScalar(2)
@@ -29,6 +30,7 @@ class BlurBench : public SkBenchmark {
     SkScalar    fRadius;
     SkBlurMaskFilter::BlurStyle fStyle;
     uint32_t                    fFlags;
+    size_t      fCacheLimit;
     SkString    fName;
 
 public:
@@ -50,6 +52,16 @@ protected:
         return fName.c_str();
     }
 
+    // Every draw repeats the same ovals, so keep SkBlurMask's cache out of the
+    // way and time the blur itself (see BlurCacheBench for the cache).
+    virtual void onPreDraw() {
+        fCacheLimit = SkBlurMask::SetCacheLimit(0);
+    }
+
+    virtual void onPostDraw() {
+        SkBlurMask::SetCacheLimit(fCacheLimit);
+    }
+
     virtual void onDraw(SkCanvas* canvas) {
         SkPaint paint;
         this->setupPaint(&paint);
@@ -74,6 +86,68 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/*  Draws the same blurred round rect over and over, like a page full of
+    identical box-shadows, with SkBlurMask's cache of blurred masks turned on
+    or off ("_nocache").
+ */
+class BlurCacheBench : public SkBenchmark {
+    SkScalar    fRadius;
+    uint32_t    fFlags;
+    bool        fUseCache;
+    size_t      fCacheLimit;
+    SkString    fName;
+
+public:
+    BlurCacheBench(void* param, SkScalar rad, uint32_t flags, bool useCache)
+            : INHERITED(param) {
+        fRadius = rad;
+        fFlags = flags;
+        fUseCache = useCache;
+        fName.printf("blur_shadow_%d_%s%s", SkScalarRound(rad),
+                     flags & SkBlurMaskFilter::kHighQuality_BlurFlag ?
+                         "high_quality" : "low_quality",
+                     useCache ? "" : "_nocache");
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        fCacheLimit = SkBlurMask::GetCacheLimit();
+        if (!fUseCache) {
+            SkBlurMask::SetCacheLimit(0);
+        }
+    }
+
+    virtual void onPostDraw() {
+        SkBlurMask::SetCacheLimit(fCacheLimit);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setAntiAlias(true);
+        SkMaskFilter* mf = SkBlurMaskFilter::Create(fRadius,
+                                                    SkBlurMaskFilter::kNormal_BlurStyle,
+                                                    fFlags);
+        paint.setMaskFilter(mf)->unref();
+
+        // unlike a plain rect, a round rect isn't blurred as a nine-patch, so
+        // each draw blurs the whole mask
+        SkRect r = SkRect::MakeXYWH(fRadius, fRadius,
+                                    SkIntToScalar(120), SkIntToScalar(80));
+        SkScalar corner = SkIntToScalar(8);
+        for (int i = 0; i < SkBENCHLOOP(10); i++) {
+            canvas->drawRoundRect(r, corner, corner, paint);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 DEF_BENCH(return new BlurBench(p, SMALL, SkBlurMaskFilter::kNormal_BlurStyle);)
 DEF_BENCH(return new BlurBench(p, SMALL, SkBlurMaskFilter::kSolid_BlurStyle);)
 DEF_BENCH(return new BlurBench(p, SMALL, SkBlurMaskFilter::kOuter_BlurStyle);)
@@ -103,3 +177,8 @@ DEF_BENCH(return new BlurBench(p, REALBIG, SkBlurMaskFilter::kNormal_BlurStyle,
 DEF_BENCH(return new BlurBench(p, REAL, SkBlurMaskFilter::kNormal_BlurStyle, SkBlurMaskFilter::kHighQuality_BlurFlag);)
 
 DEF_BENCH(return new BlurBench(p, 0, SkBlurMaskFilter::kNormal_BlurStyle);)
+
+DEF_BENCH(return new BlurCacheBench(p, BIG, 0, true);)
+DEF_BENCH(return new BlurCacheBench(p, BIG, 0, false);)
+DEF_BENCH(return new BlurCacheBench(p, BIG, SkBlurMaskFilter::kHighQuality_BlurFlag, true);)
+DEF_BENCH(return new BlurCacheBench(p, BIG, SkBlurMaskFilter::kHighQuality_BlurFlag, false);)
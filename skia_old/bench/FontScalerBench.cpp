@@ -6,6 +6,7 @@
  */
 
 #include "SkBenchmark.h"
+#include "BenchThreads.h"
 #include "SkCanvas.h"
 #include "SkGraphics.h"
 #include "SkPaint.h"
@@ -51,6 +52,83 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/*  Creates the same strikes as FontScalerBench, but from several threads at
+    once, each drawing a share of the text sizes into its own bitmap, to show
+    how strike creation scales when tiles are painted in parallel.
+ */
+class FontScalerThreadBench : public SkBenchmark {
+    SkString    fName;
+    SkString    fText;
+    bool        fDoLCD;
+    int         fThreadCount;
+    SkBitmap*   fBitmaps;
+    BenchThreads* fThreads;
+
+    static void ThreadProc(void* context, int index) {
+        const FontScalerThreadBench* bench = (const FontScalerThreadBench*)context;
+        SkCanvas canvas(bench->fBitmaps[index]);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setLCDRenderText(bench->fDoLCD);
+
+        int i = 0;
+        for (int ps = 9; ps <= 24; ps += 2, i++) {
+            if (i % bench->fThreadCount != index) {
+                continue;
+            }
+            paint.setTextSize(SkIntToScalar(ps));
+            canvas.drawText(bench->fText.c_str(), bench->fText.size(),
+                            0, SkIntToScalar(20), paint);
+        }
+    }
+
+public:
+    FontScalerThreadBench(void* param, bool doLCD, int threadCount)
+            : INHERITED(param) {
+        fName.printf("fontscaler_%s_threads_%d", doLCD ? "lcd" : "aa",
+                     threadCount);
+        fText.set("abcdefghijklmnopqrstuvwxyz01234567890");
+        fDoLCD = doLCD;
+        fThreadCount = threadCount;
+        fBitmaps = NULL;
+        fThreads = NULL;
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    virtual void onPreDraw() {
+        fBitmaps = SkNEW_ARRAY(SkBitmap, fThreadCount);
+        for (int t = 0; t < fThreadCount; t++) {
+            fBitmaps[t].setConfig(SkBitmap::kARGB_8888_Config, 640, 40);
+            fBitmaps[t].allocPixels();
+        }
+        fThreads = SkNEW_ARGS(BenchThreads, (fThreadCount, ThreadProc, this));
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        bool prev = gSkSuppressFontCachePurgeSpew;
+        gSkSuppressFontCachePurgeSpew = true;
+
+        // as above, time the creation process
+        SkGraphics::PurgeFontCache();
+        fThreads->run();
+
+        gSkSuppressFontCachePurgeSpew = prev;
+    }
+
+    virtual void onPostDraw() {
+        SkDELETE(fThreads);
+        fThreads = NULL;
+        SkDELETE_ARRAY(fBitmaps);
+        fBitmaps = NULL;
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return SkNEW_ARGS(FontScalerBench, (p, false)); }
@@ -58,3 +136,11 @@ static SkBenchmark* Fact1(void* p) { return SkNEW_ARGS(FontScalerBench, (p, true
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
+
+static SkBenchmark* FactT1(void* p) { return SkNEW_ARGS(FontScalerThreadBench, (p, false, 1)); }
+static SkBenchmark* FactT2(void* p) { return SkNEW_ARGS(FontScalerThreadBench, (p, false, 2)); }
+static SkBenchmark* FactT4(void* p) { return SkNEW_ARGS(FontScalerThreadBench, (p, false, 4)); }
+
+static BenchRegistry gRegT1(FactT1);
+static BenchRegistry gRegT2(FactT2);
+static BenchRegistry gRegT4(FactT4);
@@ -6,6 +6,7 @@
  * found in the LICENSE file.
  */
 #include "SkBenchmark.h"
+#include "BenchThreads.h"
 #include "SkCanvas.h"
 #include "SkFontHost.h"
 #include "SkPaint.h"
@@ -127,6 +128,90 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/*  Draws the same text from several threads at once, each into its own
+    bitmap, the way tiles are painted in parallel. The total number of draws
+    is the same for any thread count, so the times show how the glyph cache
+    scales. Each draw cycles through a few text sizes, so that the threads
+    keep switching strikes instead of only using their last one.
+ */
+class TextThreadBench : public SkBenchmark {
+    SkPaint     fPaint;
+    SkString    fText;
+    SkString    fName;
+    int         fThreadCount;
+    SkBitmap*   fBitmaps;
+    BenchThreads* fThreads;
+    enum {
+        N = SkBENCHLOOP(800),
+        kSizeCount = 4
+    };
+
+    static void ThreadProc(void* context, int index) {
+        const TextThreadBench* bench = (const TextThreadBench*)context;
+        const SkBitmap& bitmap = bench->fBitmaps[index];
+        SkCanvas canvas(bitmap);
+        SkRandom rand;
+        SkPaint paint(bench->fPaint);
+
+        const SkScalar x0 = SkIntToScalar(-10);
+        const SkScalar y0 = SkIntToScalar(-10);
+        const SkScalar size = paint.getTextSize();
+        const int count = N / bench->fThreadCount;
+        for (int i = 0; i < count; i++) {
+            paint.setTextSize(size + SkIntToScalar(i % kSizeCount));
+            SkScalar x = x0 + rand.nextUScalar1() * bitmap.width();
+            SkScalar y = y0 + rand.nextUScalar1() * bitmap.height();
+            canvas.drawText(bench->fText.c_str(), bench->fText.size(), x, y, paint);
+        }
+    }
+
+public:
+    TextThreadBench(void* param, const char text[], int ps, FontQuality fq,
+                    int threadCount) : INHERITED(param) {
+        fText.set(text);
+        fThreadCount = threadCount;
+        fBitmaps = NULL;
+        fThreads = NULL;
+        fPaint.setAntiAlias(kBW != fq);
+        fPaint.setLCDRenderText(kLCD == fq);
+        fPaint.setTextSize(SkIntToScalar(ps));
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() {
+        fName.printf("text_%g_%s_threads_%d",
+                     SkScalarToFloat(fPaint.getTextSize()),
+                     fontQualityName(fPaint), fThreadCount);
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        const SkIPoint dim = this->getSize();
+        fBitmaps = SkNEW_ARRAY(SkBitmap, fThreadCount);
+        for (int t = 0; t < fThreadCount; t++) {
+            fBitmaps[t].setConfig(SkBitmap::kARGB_8888_Config, dim.fX, dim.fY);
+            fBitmaps[t].allocPixels();
+            fBitmaps[t].eraseColor(SK_ColorWHITE);
+        }
+        fThreads = SkNEW_ARGS(BenchThreads, (fThreadCount, ThreadProc, this));
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        fThreads->run();
+    }
+
+    virtual void onPostDraw() {
+        SkDELETE(fThreads);
+        fThreads = NULL;
+        SkDELETE_ARRAY(fBitmaps);
+        fBitmaps = NULL;
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #define STR     "Hamburgefons"
@@ -158,3 +243,11 @@ static BenchRegistry gReg22(Fact22);
 static BenchRegistry gReg23(Fact23);
 
 static BenchRegistry gReg111(Fact111);
+
+static SkBenchmark* FactT1(void* p) { return new TextThreadBench(p, STR, 16, kAA, 1); }
+static SkBenchmark* FactT2(void* p) { return new TextThreadBench(p, STR, 16, kAA, 2); }
+static SkBenchmark* FactT4(void* p) { return new TextThreadBench(p, STR, 16, kAA, 4); }
+
+static BenchRegistry gRegT1(FactT1);
+static BenchRegistry gRegT2(FactT2);
+static BenchRegistry gRegT4(FactT4);
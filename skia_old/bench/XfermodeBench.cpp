@@ -0,0 +1,120 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBenchmark.h"
+#include "SkColorPriv.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkUtils.h"
+#include "SkXfermode.h"
+
+/*  Blends a row of pixels with SkXfermode::xfer32(), which may blend several
+    pixels at a time (see src/opts), next to the same mode one pixel at a time
+    through its SkXfermodeProc ("_scalar").
+ */
+class XfermodeBench : public SkBenchmark {
+    enum {
+        kWidth  = 256,
+        kLoop   = 2000
+    };
+    SkXfermode* fXfer;
+    SkPMColor   fSrc[kWidth];
+    SkPMColor   fDst[kWidth];
+    SkAlpha     fAA[kWidth];
+    bool        fUseAA;
+    SkString    fName;
+
+public:
+    XfermodeBench(void* param, SkXfermode::Mode mode, const char name[],
+                  bool scalar, bool useAA) : INHERITED(param) {
+        if (scalar) {
+            fXfer = new SkProcXfermode(SkXfermode::GetProc(mode));
+        } else {
+            fXfer = SkXfermode::Create(mode);
+        }
+        fUseAA = useAA;
+        fName.printf("xfermode_%s%s%s", name, useAA ? "_aa" : "",
+                     scalar ? "_scalar" : "");
+
+        SkRandom rand;
+        for (int i = 0; i < kWidth; ++i) {
+            unsigned a = rand.nextU() & 0xFF;
+            fSrc[i] = SkPackARGB32(a, rand.nextRangeU(0, a),
+                                   rand.nextRangeU(0, a), rand.nextRangeU(0, a));
+            fAA[i] = rand.nextU() & 0xFF;
+        }
+        fIsRendering = false;
+    }
+
+    virtual ~XfermodeBench() {
+        SkSafeUnref(fXfer);
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        const SkAlpha* aa = fUseAA ? fAA : NULL;
+        int n = SkBENCHLOOP(kLoop);
+        for (int i = 0; i < n; i++) {
+            // start from the same opaque-ish row each time, blending into the
+            // previous result would drift towards the mode's fixed point
+            sk_memset32(fDst, 0xFF804020, kWidth);
+            fXfer->xfer32(fDst, fSrc, kWidth, aa);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+#define M(mode)     SkXfermode::mode
+
+DEF_BENCH(return new XfermodeBench(p, M(kDst_Mode), "dst", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDst_Mode), "dst", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstOver_Mode), "dstover", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstOver_Mode), "dstover", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcIn_Mode), "srcin", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcIn_Mode), "srcin", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstIn_Mode), "dstin", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstIn_Mode), "dstin", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcOut_Mode), "srcout", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcOut_Mode), "srcout", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstOut_Mode), "dstout", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstOut_Mode), "dstout", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcATop_Mode), "srcatop", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcATop_Mode), "srcatop", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstATop_Mode), "dstatop", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDstATop_Mode), "dstatop", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kXor_Mode), "xor", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kXor_Mode), "xor", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kPlus_Mode), "plus", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kPlus_Mode), "plus", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kModulate_Mode), "modulate", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kModulate_Mode), "modulate", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kScreen_Mode), "screen", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kScreen_Mode), "screen", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kOverlay_Mode), "overlay", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kOverlay_Mode), "overlay", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDarken_Mode), "darken", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDarken_Mode), "darken", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kLighten_Mode), "lighten", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kLighten_Mode), "lighten", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kHardLight_Mode), "hardlight", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kHardLight_Mode), "hardlight", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDifference_Mode), "difference", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kDifference_Mode), "difference", true, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kExclusion_Mode), "exclusion", false, false);)
+DEF_BENCH(return new XfermodeBench(p, M(kExclusion_Mode), "exclusion", true, false);)
+
+// with coverage, as when drawing antialiased edges
+DEF_BENCH(return new XfermodeBench(p, M(kSrcATop_Mode), "srcatop", false, true);)
+DEF_BENCH(return new XfermodeBench(p, M(kSrcATop_Mode), "srcatop", true, true);)
+DEF_BENCH(return new XfermodeBench(p, M(kOverlay_Mode), "overlay", false, true);)
+DEF_BENCH(return new XfermodeBench(p, M(kOverlay_Mode), "overlay", true, true);)
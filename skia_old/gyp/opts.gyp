@@ -49,6 +49,7 @@
             '../src/opts/SkBlitRow_opts_SSE2.cpp',
             '../src/opts/SkBlitRect_opts_SSE2.cpp',
             '../src/opts/SkUtils_opts_SSE2.cpp',
+            '../src/opts/SkXfermode_opts_SSE2.cpp',
           ],
         }],
         [ 'skia_arch_type == "arm" and armv7 == 1', {
@@ -79,6 +80,13 @@
                 'opts_neon',
               ]
             }],
+            # The NEON xfermode procs stay out of the build until they have
+            # run on ARM hardware.
+            [ 'skia_os != "ios"', {
+              'sources': [
+                '../src/opts/SkXfermode_opts_none.cpp',
+              ],
+            }],
             [ 'skia_os == "ios"', {
               'sources!': [
                 # these fail to compile under xcode for ios
@@ -94,6 +102,7 @@
             '../src/opts/SkBitmapProcState_opts_none.cpp',
             '../src/opts/SkBlitRow_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
+            '../src/opts/SkXfermode_opts_none.cpp',
           ],
         }],
       ],
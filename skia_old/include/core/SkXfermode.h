@@ -231,6 +231,10 @@ protected:
         fProc = proc;
     }
 
+    SkXfermodeProc getProc() const {
+        return fProc;
+    }
+
 private:
     SkXfermodeProc  fProc;
 
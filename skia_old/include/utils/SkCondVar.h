@@ -8,6 +8,9 @@
 #ifndef SkCondVar_DEFINED
 #define SkCondVar_DEFINED
 
+// for SK_USE_POSIX_THREADS, which sets the layout and the implementation
+#include "SkTypes.h"
+
 #ifdef SK_USE_POSIX_THREADS
 #include <pthread.h>
 #elif defined(SK_BUILD_FOR_WIN32)
@@ -15,7 +15,6 @@
 #include "SkTLS.h"
 
 //#define SPEW_PURGE_STATUS
-//#define USE_CACHE_HASH
 //#define RECORD_HASH_EFFICIENCY
 
 bool gSkSuppressFontCachePurgeSpew;
@@ -374,26 +373,56 @@ void SkGlyphCache::invokeAndRemoveAuxProcs() {
     #define SK_DEFAULT_FONT_CACHE_LIMIT     (2 * 1024 * 1024)
 #endif
 
-#ifdef USE_CACHE_HASH
-    #define HASH_BITCOUNT   6
-    #define HASH_COUNT      (1 << HASH_BITCOUNT)
-    #define HASH_MASK       (HASH_COUNT - 1)
+// Purge the shared cache on a background thread, so that the thread that went
+// over budget does not pay for deleting strikes in the middle of a draw
+#if defined(SK_BUILD_FOR_ANDROID) && defined(SK_USE_POSIX_THREADS)
+    #define SK_GLYPHCACHE_BACKGROUND_PURGE
+#endif
 
-    static unsigned desc_to_hashindex(const SkDescriptor* desc)
-    {
-        SkASSERT(HASH_MASK < 256);  // since our munging reduces to 8 bits
+#include "SkThread.h"
 
-        uint32_t n = *(const uint32_t*)desc;    //desc->getChecksum();
-        SkASSERT(n == desc->getChecksum());
+#ifdef SK_GLYPHCACHE_BACKGROUND_PURGE
+#include "SkCondVar.h"
+#include "SkThreadUtils.h"
+#endif
 
-        // don't trust that the low bits of checksum vary enough, so...
-        n ^= (n >> 24) ^ (n >> 16) ^ (n >> 8) ^ (n >> 30);
+/*  The shared cache is split into shards, picked by the descriptor checksum,
+    each with its own list and mutex, so that threads drawing with different
+    strikes do not contend on one lock. The budget covers all the shards.
+*/
+struct SkGlyphCache_Shard {
+    SkGlyphCache_Shard() : fMutex(NULL), fHead(NULL), fMemoryUsed(0) {}
 
-        return n & HASH_MASK;
-    }
-#endif
+    SkMutex*        fMutex;
+    SkGlyphCache*   fHead;
+    size_t          fMemoryUsed;
+};
 
-#include "SkThread.h"
+/*  Each thread keeps the last strike it attached to itself, outside of the
+    shards, so that drawing several runs of text with the same paint finds it
+    without contending on a shard lock. The strike stays counted against the
+    budget, and the globals keep a list of all the thread strikes, so that
+    another thread wanting the same strike takes it instead of creating a
+    duplicate, and purges and VisitAllCaches reach it. Only those contend on
+    the strike's mutex. The strike goes back to its shard when the thread
+    attaches a different strike or exits.
+*/
+struct SkGlyphCache_ThreadStrike {
+    SkMutex                     fMutex;
+    SkGlyphCache*               fCache;
+    SkGlyphCache_ThreadStrike*  fPrev;
+    SkGlyphCache_ThreadStrike*  fNext;
+
+    // Takes the strike out of the thread and the budget, fMutex must be held
+    inline SkGlyphCache* take(SkGlyphCache_Globals*);
+
+    static void* Create();
+    static void Delete(void* ptr);
+
+    static SkGlyphCache_ThreadStrike& Get() {
+        return *(SkGlyphCache_ThreadStrike*)SkTLS::Get(Create, Delete);
+    }
+};
 
 class SkGlyphCache_Globals {
 public:
@@ -402,34 +431,58 @@ public:
         kYes_UseMutex  // shared cache
     };
 
+    enum {
+        kShardBits  = 3,
+        kShardCount = 1 << kShardBits
+    };
+
     SkGlyphCache_Globals(UseMutex um) {
-        fHead = NULL;
+        // a thread-local cache is never contended, so it only needs one list
+        fShardCount = (kYes_UseMutex == um) ? kShardCount : 1;
+        for (int i = 0; i < fShardCount; i++) {
+            fShards[i].fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
+        }
         fTotalMemoryUsed = 0;
         fFontCacheLimit = SK_DEFAULT_FONT_CACHE_LIMIT;
-        fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
-
-#ifdef USE_CACHE_HASH
-        sk_bzero(fHash, sizeof(fHash));
+        fUseThreadStrike = (kYes_UseMutex == um);
+        fThreadStrikeMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
+        fThreadStrikes = NULL;
+#ifdef SK_GLYPHCACHE_BACKGROUND_PURGE
+        fPurgeThread = NULL;
+        fPurgePending = false;
+        fBackgroundPurge = (kYes_UseMutex == um);
 #endif
     }
 
     ~SkGlyphCache_Globals() {
-        SkGlyphCache* cache = fHead;
-        while (cache) {
-            SkGlyphCache* next = cache->fNext;
-            SkDELETE(cache);
-            cache = next;
+        for (int i = 0; i < fShardCount; i++) {
+            SkGlyphCache* cache = fShards[i].fHead;
+            while (cache) {
+                SkGlyphCache* next = cache->fNext;
+                SkDELETE(cache);
+                cache = next;
+            }
+            SkDELETE(fShards[i].fMutex);
         }
+        SkDELETE(fThreadStrikeMutex);
+    }
 
-        SkDELETE(fMutex);
+    SkGlyphCache_Shard* shardFor(const SkDescriptor* desc) {
+        // don't trust that the low bits of checksum vary enough, so...
+        uint32_t n = desc->getChecksum();
+        n ^= (n >> 24) ^ (n >> 16) ^ (n >> 8);
+        return &fShards[n & (fShardCount - 1)];
     }
 
-    SkMutex*        fMutex;
-    SkGlyphCache*   fHead;
-    size_t          fTotalMemoryUsed;
-#ifdef USE_CACHE_HASH
-    SkGlyphCache*   fHash[HASH_COUNT];
-#endif
+    SkGlyphCache_Shard  fShards[kShardCount];
+    int                 fShardCount;
+    // updated with sk_atomic_add, since each shard only holds its own lock
+    int32_t             fTotalMemoryUsed;
+    // whether each thread keeps its last strike out of the shards
+    bool                fUseThreadStrike;
+    // the list of thread strikes, see SkGlyphCache_ThreadStrike
+    SkMutex*                    fThreadStrikeMutex;
+    SkGlyphCache_ThreadStrike*  fThreadStrikes;
 
 #ifdef SK_DEBUG
     void validate() const;
@@ -441,6 +494,16 @@ public:
     size_t  setFontCacheLimit(size_t limit);
     void    purgeAll(); // does not change budget
 
+    // Frees strikes from the tails of the shards, taking each lock in turn
+    size_t  purge(size_t bytesNeeded);
+    // Called after attaching a strike took the cache over budget
+    void    overBudget(size_t bytesNeeded);
+
+    // Takes the strike for desc from whichever thread keeps it, or NULL
+    SkGlyphCache* takeThreadStrike(const SkDescriptor* desc);
+    // Frees the strikes the threads keep, once the shards are empty
+    size_t  purgeThreadStrikes(size_t bytesNeeded);
+
     // can return NULL
     static SkGlyphCache_Globals* FindTLS() {
         return (SkGlyphCache_Globals*)SkTLS::Find(CreateTLS);
@@ -455,6 +518,15 @@ public:
 private:
     size_t  fFontCacheLimit;
 
+#ifdef SK_GLYPHCACHE_BACKGROUND_PURGE
+    SkCondVar   fPurgeCondition;
+    SkThread*   fPurgeThread;
+    bool        fPurgePending;
+    bool        fBackgroundPurge;
+
+    static void PurgeThreadProc(void* globals);
+#endif
+
     static void* CreateTLS() {
         return SkNEW_ARGS(SkGlyphCache_Globals, (kNo_UseMutex));
     }
@@ -475,15 +547,106 @@ size_t SkGlyphCache_Globals::setFontCacheLimit(size_t newLimit) {
 
     size_t currUsed = fTotalMemoryUsed;
     if (currUsed > newLimit) {
-        SkAutoMutexAcquire    ac(fMutex);
-        SkGlyphCache::InternalFreeCache(this, currUsed - newLimit);
+        this->purge(currUsed - newLimit);
     }
     return prevLimit;
 }
 
 void SkGlyphCache_Globals::purgeAll() {
-    SkAutoMutexAcquire    ac(fMutex);
-    SkGlyphCache::InternalFreeCache(this, fTotalMemoryUsed);
+    this->purge(fTotalMemoryUsed);
+}
+
+size_t SkGlyphCache_Globals::purge(size_t bytesNeeded) {
+    size_t bytesFreed = 0;
+    int shard = 0;
+    int emptyShards = 0;
+    // Round robin over the shards so that no single shard is emptied to
+    // make room for the others, and delete outside the lock
+    while (bytesFreed < bytesNeeded && emptyShards < fShardCount) {
+        SkGlyphCache* cache;
+        {
+            SkGlyphCache_Shard& s = fShards[shard];
+            SkAutoMutexAcquire ac(s.fMutex);
+            cache = SkGlyphCache::FindTail(s.fHead);
+            if (cache) {
+                cache->detach(&s.fHead);
+                SkASSERT(s.fMemoryUsed >= cache->fMemoryUsed);
+                s.fMemoryUsed -= cache->fMemoryUsed;
+                sk_atomic_add(&fTotalMemoryUsed, -(int32_t)cache->fMemoryUsed);
+            }
+        }
+        if (cache) {
+            bytesFreed += cache->fMemoryUsed;
+            SkDELETE(cache);
+            emptyShards = 0;
+        } else {
+            emptyShards += 1;
+        }
+        shard = (shard + 1) % fShardCount;
+    }
+
+    if (bytesFreed < bytesNeeded && fUseThreadStrike) {
+        bytesFreed += this->purgeThreadStrikes(bytesNeeded - bytesFreed);
+    }
+
+#ifdef SPEW_PURGE_STATUS
+    if (bytesFreed && !gSkSuppressFontCachePurgeSpew) {
+        SkDebugf("purging %dK from font cache\n", (int)(bytesFreed >> 10));
+    }
+#endif
+
+    return bytesFreed;
+}
+
+#ifdef SK_GLYPHCACHE_BACKGROUND_PURGE
+void SkGlyphCache_Globals::PurgeThreadProc(void* context) {
+    SkGlyphCache_Globals* globals = (SkGlyphCache_Globals*)context;
+    for (;;) {
+        globals->fPurgeCondition.lock();
+        while (!globals->fPurgePending) {
+            globals->fPurgeCondition.wait();
+        }
+        globals->fPurgePending = false;
+        globals->fPurgeCondition.unlock();
+
+        size_t used = globals->fTotalMemoryUsed;
+        size_t budgeted = globals->getFontCacheLimit();
+        if (used > budgeted) {
+            // don't do any "small" purges
+            size_t bytesNeeded = used - budgeted;
+            if (bytesNeeded < (used >> 2))
+                bytesNeeded = used >> 2;
+            globals->purge(bytesNeeded);
+        }
+    }
+}
+#endif
+
+void SkGlyphCache_Globals::overBudget(size_t bytesNeeded) {
+#ifdef SK_GLYPHCACHE_BACKGROUND_PURGE
+    // Hand the purge to the purge thread, unless it has fallen so far behind
+    // that the cache is twice its budget
+    if (fBackgroundPurge && bytesNeeded < fFontCacheLimit) {
+        fPurgeCondition.lock();
+        if (!fPurgeThread) {
+            fPurgeThread = SkNEW_ARGS(SkThread, (PurgeThreadProc, this));
+            if (!fPurgeThread->start()) {
+                fBackgroundPurge = false;
+            }
+        }
+        fPurgePending = true;
+        fPurgeCondition.signal();
+        fPurgeCondition.unlock();
+        if (fBackgroundPurge) {
+            return;
+        }
+    }
+#endif
+    // don't do any "small" purges
+    size_t minToPurge = fTotalMemoryUsed >> 2;
+    if (bytesNeeded < minToPurge)
+        bytesNeeded = minToPurge;
+    this->purge(bytesNeeded);
 }
 
 // Returns the shared globals
@@ -500,25 +663,115 @@ static SkGlyphCache_Globals& getGlobals() {
     return tls ? *tls : getSharedGlobals();
 }
 
+SkGlyphCache* SkGlyphCache_ThreadStrike::take(SkGlyphCache_Globals* globals) {
+    SkGlyphCache* cache = fCache;
+    fCache = NULL;
+    sk_atomic_add(&globals->fTotalMemoryUsed, -(int32_t)cache->fMemoryUsed);
+    return cache;
+}
+
+void* SkGlyphCache_ThreadStrike::Create() {
+    SkGlyphCache_ThreadStrike* strike = SkNEW(SkGlyphCache_ThreadStrike);
+    strike->fCache = NULL;
+    strike->fPrev = NULL;
+
+    SkGlyphCache_Globals& globals = getSharedGlobals();
+    SkAutoMutexAcquire ac(globals.fThreadStrikeMutex);
+    strike->fNext = globals.fThreadStrikes;
+    if (strike->fNext) {
+        strike->fNext->fPrev = strike;
+    }
+    globals.fThreadStrikes = strike;
+    return strike;
+}
+
+void SkGlyphCache_ThreadStrike::Delete(void* ptr) {
+    SkGlyphCache_ThreadStrike* strike = (SkGlyphCache_ThreadStrike*)ptr;
+    SkGlyphCache_Globals& globals = getSharedGlobals();
+    {
+        // no other thread holds the strike's mutex once it is off the list
+        SkAutoMutexAcquire ac(globals.fThreadStrikeMutex);
+        if (strike->fPrev) {
+            strike->fPrev->fNext = strike->fNext;
+        } else {
+            globals.fThreadStrikes = strike->fNext;
+        }
+        if (strike->fNext) {
+            strike->fNext->fPrev = strike->fPrev;
+        }
+    }
+    if (strike->fCache) {
+        SkGlyphCache::AttachCacheToShard(&globals, strike->take(&globals));
+    }
+    SkDELETE(strike);
+}
+
+SkGlyphCache* SkGlyphCache_Globals::takeThreadStrike(const SkDescriptor* desc) {
+    SkAutoMutexAcquire ac(fThreadStrikeMutex);
+    for (SkGlyphCache_ThreadStrike* strike = fThreadStrikes; strike != NULL;
+         strike = strike->fNext) {
+        SkAutoMutexAcquire acStrike(strike->fMutex);
+        if (strike->fCache && strike->fCache->fDesc->equals(*desc)) {
+            return strike->take(this);
+        }
+    }
+    return NULL;
+}
+
+size_t SkGlyphCache_Globals::purgeThreadStrikes(size_t bytesNeeded) {
+    SkTDArray<SkGlyphCache*> caches;
+    size_t bytesFreed = 0;
+    {
+        SkAutoMutexAcquire ac(fThreadStrikeMutex);
+        for (SkGlyphCache_ThreadStrike* strike = fThreadStrikes;
+             strike != NULL && bytesFreed < bytesNeeded; strike = strike->fNext) {
+            SkAutoMutexAcquire acStrike(strike->fMutex);
+            if (strike->fCache) {
+                SkGlyphCache* cache = strike->take(this);
+                bytesFreed += cache->fMemoryUsed;
+                *caches.append() = cache;
+            }
+        }
+    }
+    // delete outside the locks, like purge()
+    for (int i = 0; i < caches.count(); i++) {
+        SkDELETE(caches[i]);
+    }
+    return bytesFreed;
+}
+
 void SkGlyphCache::VisitAllCaches(bool (*proc)(SkGlyphCache*, void*),
                                   void* context) {
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
-    SkGlyphCache*         cache;
 
     globals.validate();
 
-    for (cache = globals.fHead; cache != NULL; cache = cache->fNext) {
-        if (proc(cache, context)) {
-            break;
+    for (int i = 0; i < globals.fShardCount; i++) {
+        SkGlyphCache_Shard& shard = globals.fShards[i];
+        SkAutoMutexAcquire ac(shard.fMutex);
+        for (SkGlyphCache* cache = shard.fHead; cache != NULL; cache = cache->fNext) {
+            if (proc(cache, context)) {
+                return;
+            }
+        }
+    }
+
+    if (globals.fUseThreadStrike) {
+        SkAutoMutexAcquire ac(globals.fThreadStrikeMutex);
+        for (SkGlyphCache_ThreadStrike* strike = globals.fThreadStrikes;
+             strike != NULL; strike = strike->fNext) {
+            SkAutoMutexAcquire acStrike(strike->fMutex);
+            if (strike->fCache && proc(strike->fCache, context)) {
+                return;
+            }
         }
     }
 
     globals.validate();
 }
 
-/*  This guy calls the visitor from within the mutext lock, so the visitor
-    cannot:
+/*  This guy calls the visitor from within the shard's mutex lock, so the
+    visitor cannot:
     - take too much time
     - try to acquire the mutext again
     - call a fontscaler (which might call into the cache)
@@ -529,25 +782,28 @@ SkGlyphCache* SkGlyphCache::VisitCache(const SkDescriptor* desc,
     SkASSERT(desc);
 
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
-    SkGlyphCache*         cache;
-    bool                  insideMutex = true;
-
-    globals.validate();
 
-#ifdef USE_CACHE_HASH
-    SkGlyphCache** hash = globals.fHash;
-    unsigned index = desc_to_hashindex(desc);
-    cache = hash[index];
-    if (cache && *cache->fDesc == *desc) {
-        cache->detach(&globals.fHead);
-        goto FOUND_IT;
+    if (globals.fUseThreadStrike) {
+        SkGlyphCache_ThreadStrike& strike = SkGlyphCache_ThreadStrike::Get();
+        SkAutoMutexAcquire ac(strike.fMutex);
+        SkGlyphCache* cache = strike.fCache;
+        if (cache && cache->fDesc->equals(*desc)) {
+            AutoValidate av(cache);
+            if (proc(cache, context)) {   // stay detached
+                return strike.take(&globals);
+            }
+            return NULL;
+        }
     }
-#endif
 
-    for (cache = globals.fHead; cache != NULL; cache = cache->fNext) {
+    SkGlyphCache_Shard&   shard = *globals.shardFor(desc);
+    SkAutoMutexAcquire    ac(shard.fMutex);
+    SkGlyphCache*         cache;
+    bool                  insideMutex = true;
+
+    for (cache = shard.fHead; cache != NULL; cache = cache->fNext) {
         if (cache->fDesc->equals(*desc)) {
-            cache->detach(&globals.fHead);
+            cache->detach(&shard.fHead);
             goto FOUND_IT;
         }
     }
@@ -556,9 +812,13 @@ SkGlyphCache* SkGlyphCache::VisitCache(const SkDescriptor* desc,
         side-effects like trying to access the cache/mutex (yikes!)
     */
     ac.release();           // release the mutex now
-    insideMutex = false;    // can't use globals anymore
+    insideMutex = false;    // can't use the shard anymore
 
-    cache = SkNEW_ARGS(SkGlyphCache, (desc));
+    // another thread may be keeping the strike to itself
+    cache = globals.fUseThreadStrike ? globals.takeThreadStrike(desc) : NULL;
+    if (NULL == cache) {
+        cache = SkNEW_ARGS(SkGlyphCache, (desc));
+    }
 
 FOUND_IT:
 
@@ -566,18 +826,13 @@ FOUND_IT:
 
     if (proc(cache, context)) {   // stay detached
         if (insideMutex) {
-            SkASSERT(globals.fTotalMemoryUsed >= cache->fMemoryUsed);
-            globals.fTotalMemoryUsed -= cache->fMemoryUsed;
-#ifdef USE_CACHE_HASH
-            hash[index] = NULL;
-#endif
+            SkASSERT(shard.fMemoryUsed >= cache->fMemoryUsed);
+            shard.fMemoryUsed -= cache->fMemoryUsed;
+            sk_atomic_add(&globals.fTotalMemoryUsed, -(int32_t)cache->fMemoryUsed);
         }
     } else {                        // reattach
         if (insideMutex) {
-            cache->attachToHead(&globals.fHead);
-#ifdef USE_CACHE_HASH
-            hash[index] = cache;
-#endif
+            cache->attachToHead(&shard.fHead);
         } else {
             AttachCache(cache);
         }
@@ -591,30 +846,51 @@ void SkGlyphCache::AttachCache(SkGlyphCache* cache) {
     SkASSERT(cache->fNext == NULL);
 
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
-
-    globals.validate();
-    cache->validate();
 
-    // if we have a fixed budget for our cache, do a purge here
-    {
-        size_t allocated = globals.fTotalMemoryUsed + cache->fMemoryUsed;
-        size_t budgeted = globals.getFontCacheLimit();
-        if (allocated > budgeted) {
-            (void)InternalFreeCache(&globals, allocated - budgeted);
+    if (globals.fUseThreadStrike) {
+        SkGlyphCache_ThreadStrike& strike = SkGlyphCache_ThreadStrike::Get();
+        SkGlyphCache* previous;
+        {
+            SkAutoMutexAcquire ac(strike.fMutex);
+            cache->validate();
+            previous = strike.fCache ? strike.take(&globals) : NULL;
+            strike.fCache = cache;
+        }
+        size_t allocated = sk_atomic_add(&globals.fTotalMemoryUsed,
+                                         (int32_t)cache->fMemoryUsed) + cache->fMemoryUsed;
+        if (!previous) {
+            size_t budgeted = globals.getFontCacheLimit();
+            if (allocated > budgeted) {
+                globals.overBudget(allocated - budgeted);
+            }
+            return;
         }
+        cache = previous;
     }
 
-    cache->attachToHead(&globals.fHead);
-    globals.fTotalMemoryUsed += cache->fMemoryUsed;
+    AttachCacheToShard(&globals, cache);
+}
 
-#ifdef USE_CACHE_HASH
-    unsigned index = desc_to_hashindex(cache->fDesc);
-    SkASSERT(globals.fHash[index] != cache);
-    globals.fHash[index] = cache;
-#endif
+void SkGlyphCache::AttachCacheToShard(SkGlyphCache_Globals* globals,
+                                      SkGlyphCache* cache) {
+    SkGlyphCache_Shard& shard = *globals->shardFor(cache->fDesc);
+    size_t allocated;
+    {
+        SkAutoMutexAcquire ac(shard.fMutex);
 
-    globals.validate();
+        cache->validate();
+
+        cache->attachToHead(&shard.fHead);
+        shard.fMemoryUsed += cache->fMemoryUsed;
+        allocated = sk_atomic_add(&globals->fTotalMemoryUsed,
+                                  (int32_t)cache->fMemoryUsed) + cache->fMemoryUsed;
+    }
+
+    // if we have a fixed budget for our cache, do a purge here
+    size_t budgeted = globals->getFontCacheLimit();
+    if (allocated > budgeted) {
+        globals->overBudget(allocated - budgeted);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -630,65 +906,27 @@ SkGlyphCache* SkGlyphCache::FindTail(SkGlyphCache* cache) {
 
 #ifdef SK_DEBUG
 void SkGlyphCache_Globals::validate() const {
+    // other threads may be updating the other shards, so only a cache with
+    // a single unlocked list can be checked against its total
+    if (fShardCount != 1 || fShards[0].fMutex) {
+        return;
+    }
+
     size_t computed = 0;
 
-    const SkGlyphCache* head = fHead;
+    const SkGlyphCache* head = fShards[0].fHead;
     while (head != NULL) {
         computed += head->fMemoryUsed;
         head = head->fNext;
     }
 
-    if (fTotalMemoryUsed != computed) {
+    if ((size_t)fTotalMemoryUsed != computed) {
         printf("total %d, computed %d\n", (int)fTotalMemoryUsed, (int)computed);
     }
-    SkASSERT(fTotalMemoryUsed == computed);
+    SkASSERT((size_t)fTotalMemoryUsed == computed);
 }
 #endif
 
-size_t SkGlyphCache::InternalFreeCache(SkGlyphCache_Globals* globals,
-                                       size_t bytesNeeded) {
-    globals->validate();
-
-    size_t  bytesFreed = 0;
-    int     count = 0;
-
-    // don't do any "small" purges
-    size_t minToPurge = globals->fTotalMemoryUsed >> 2;
-    if (bytesNeeded < minToPurge)
-        bytesNeeded = minToPurge;
-
-    SkGlyphCache* cache = FindTail(globals->fHead);
-    while (cache != NULL && bytesFreed < bytesNeeded) {
-        SkGlyphCache* prev = cache->fPrev;
-        bytesFreed += cache->fMemoryUsed;
-
-#ifdef USE_CACHE_HASH
-        unsigned index = desc_to_hashindex(cache->fDesc);
-        if (cache == globals->fHash[index]) {
-            globals->fHash[index] = NULL;
-        }
-#endif
-
-        cache->detach(&globals->fHead);
-        SkDELETE(cache);
-        cache = prev;
-        count += 1;
-    }
-
-    SkASSERT(bytesFreed <= globals->fTotalMemoryUsed);
-    globals->fTotalMemoryUsed -= bytesFreed;
-    globals->validate();
-
-#ifdef SPEW_PURGE_STATUS
-    if (count && !gSkSuppressFontCachePurgeSpew) {
-        SkDebugf("purging %dK from font cache [%d entries]\n",
-                 (int)(bytesFreed >> 10), count);
-    }
-#endif
-
-    return bytesFreed;
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifdef SK_DEBUG
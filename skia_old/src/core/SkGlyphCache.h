@@ -22,6 +22,7 @@ struct SkDeviceProperties;
 class SkPaint;
 
 class SkGlyphCache_Globals;
+struct SkGlyphCache_ThreadStrike;
 
 /** \class SkGlyphCache
 
@@ -31,8 +32,9 @@ class SkGlyphCache_Globals;
     either instantly if it is already cahced, or by first generating it and then
     adding it to the strike.
 
-    The strikes are held in a global list, available to all threads. To interact
-    with one, call either VisitCache() or DetachCache().
+    The strikes are held in a global, sharded list, available to all threads,
+    and each thread keeps the last strike it used to itself. To interact with
+    one, call either VisitCache() or DetachCache().
 */
 class SkGlyphCache {
 public:
@@ -262,12 +264,13 @@ private:
     AuxProcRec* fAuxProcList;
     void invokeAndRemoveAuxProcs();
 
-    // This relies on the caller to have already acquired the mutex to access the global cache
-    static size_t InternalFreeCache(SkGlyphCache_Globals*, size_t bytesNeeded);
+    // Adds the strike to its shard, skipping the calling thread's own strike
+    static void AttachCacheToShard(SkGlyphCache_Globals*, SkGlyphCache*);
 
     inline static SkGlyphCache* FindTail(SkGlyphCache* head);
 
     friend class SkGlyphCache_Globals;
+    friend struct SkGlyphCache_ThreadStrike;
 };
 
 class SkAutoGlyphCache {
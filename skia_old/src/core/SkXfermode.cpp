@@ -8,6 +8,7 @@
 
 
 #include "SkXfermode.h"
+#include "SkXfermode_opts.h"
 #include "SkColorPriv.h"
 #include "SkFlattenableBuffers.h"
 #include "SkMathPriv.h"
@@ -714,6 +715,17 @@ public:
         // these may be valid, or may be CANNOT_USE_COEFF
         fSrcCoeff = rec.fSC;
         fDstCoeff = rec.fDC;
+        fProcSIMD = SkPlatformXfermodeProcSIMD(mode);
+    }
+
+    virtual void xfer32(SkPMColor dst[], const SkPMColor src[], int count,
+                        const SkAlpha aa[]) const SK_OVERRIDE {
+        if (NULL != fProcSIMD) {
+            SkASSERT(dst && src && count >= 0);
+            fProcSIMD(dst, src, count, aa, this->getProc());
+        } else {
+            this->INHERITED::xfer32(dst, src, count, aa);
+        }
     }
 
     virtual bool asMode(Mode* mode) const SK_OVERRIDE {
@@ -750,6 +762,7 @@ protected:
         fDstCoeff = rec.fDC;
         // now update our function-ptr in the super class
         this->INHERITED::setProc(rec.fProc);
+        fProcSIMD = SkPlatformXfermodeProcSIMD(fMode);
     }
 
     virtual void flatten(SkFlattenableWriteBuffer& buffer) const SK_OVERRIDE {
@@ -757,9 +770,13 @@ protected:
         buffer.write32(fMode);
     }
 
+    // whether xfer32 has a vectorized version for this mode
+    bool hasProcSIMD() const { return NULL != fProcSIMD; }
+
 private:
     Mode    fMode;
     Coeff   fSrcCoeff, fDstCoeff;
+    SkXfermodeProcSIMD  fProcSIMD;
 
     typedef SkProcXfermode INHERITED;
 };
@@ -952,7 +969,7 @@ void SkDstInXfermode::xfer32(SkPMColor* SK_RESTRICT dst,
     if (count <= 0) {
         return;
     }
-    if (NULL != aa) {
+    if (NULL != aa || this->hasProcSIMD()) {
         return this->INHERITED::xfer32(dst, src, count, aa);
     }
 
@@ -996,7 +1013,7 @@ void SkDstOutXfermode::xfer32(SkPMColor* SK_RESTRICT dst,
     if (count <= 0) {
         return;
     }
-    if (NULL != aa) {
+    if (NULL != aa || this->hasProcSIMD()) {
         return this->INHERITED::xfer32(dst, src, count, aa);
     }
 
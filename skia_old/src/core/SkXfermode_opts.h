@@ -0,0 +1,26 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_DEFINED
+#define SkXfermode_opts_DEFINED
+
+#include "SkXfermode.h"
+
+/** Blends count src pixels into dst with a mode, the same way as
+    SkProcXfermode::xfer32(), several pixels at a time. proc is the portable
+    proc for the mode, for the pixels left over at the end of the row.
+*/
+typedef void (*SkXfermodeProcSIMD)(SkPMColor dst[], const SkPMColor src[],
+                                   int count, const SkAlpha aa[],
+                                   SkXfermodeProc proc);
+
+/** Returns the platform's vectorized xfer32 for the mode, or NULL if there is
+    none (or the CPU doesn't support it). Implemented in src/opts.
+*/
+SkXfermodeProcSIMD SkPlatformXfermodeProcSIMD(SkXfermode::Mode mode);
+
+#endif
@@ -320,6 +320,448 @@ static void get_adjusted_radii(SkScalar passRadius, int *loRadius, int *hiRadius
     }
 }
 
+/*  The vertical passes of the separable blur run down the columns instead of
+    transposing: each row of the output is a row-wide step of the running sums
+    of the horizontal kernels above, with one sum per column. They compute the
+    same values as boxBlur() / boxBlurInterp() on the transposed mask, and the
+    row steps are vectorized.
+ */
+
+#if defined(__ARM_HAVE_NEON) && defined(SK_CPU_LENDIAN)
+    #define SK_BLUR_USE_NEON
+    #include <arm_neon.h>
+#elif defined(SK_CPU_SSE_LEVEL) && SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #define SK_BLUR_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef SK_BLUR_USE_SSE2
+// Low 32 bits of a * b, SSE2 has no 32 bit multiply
+static inline __m128i blur_mul32_SSE2(const __m128i& a, const __m128i& b) {
+    __m128i r1 = _mm_mul_epu32(a, b);
+    __m128i r2 = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(r1, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(r2, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Loads 8 bytes as two vectors of 4 u32
+static inline void blur_load8_SSE2(const uint8_t* p, __m128i* lo, __m128i* hi) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)p), zero);
+    *lo = _mm_unpacklo_epi16(v, zero);
+    *hi = _mm_unpackhi_epi16(v, zero);
+}
+
+// Stores the top byte of 8 u32 lanes
+static inline void blur_store8_SSE2(uint8_t* p, const __m128i& lo, const __m128i& hi) {
+    __m128i v = _mm_packs_epi32(_mm_srli_epi32(lo, 24), _mm_srli_epi32(hi, 24));
+    _mm_storel_epi64((__m128i*)p, _mm_packus_epi16(v, v));
+}
+#endif
+
+/*  sum += add; dst = sum * scale >> 24; sum -= sub;
+    add and sub are rows of the source, or a row of zeros.
+ */
+static void box_blur_row(uint8_t dst[], uint32_t sum[], const uint8_t add[],
+                         const uint8_t sub[], int width, uint32_t scale) {
+    int x = 0;
+#if defined(SK_BLUR_USE_NEON)
+    const uint32x4_t vscale = vdupq_n_u32(scale);
+    for (; x <= width - 8; x += 8) {
+        uint16x8_t a = vmovl_u8(vld1_u8(add + x));
+        uint16x8_t s = vmovl_u8(vld1_u8(sub + x));
+        uint32x4_t lo = vaddw_u16(vld1q_u32(sum + x), vget_low_u16(a));
+        uint32x4_t hi = vaddw_u16(vld1q_u32(sum + x + 4), vget_high_u16(a));
+        uint16x4_t dlo = vshrn_n_u32(vmulq_u32(lo, vscale), 16);
+        uint16x4_t dhi = vshrn_n_u32(vmulq_u32(hi, vscale), 16);
+        vst1_u8(dst + x, vshrn_n_u16(vcombine_u16(dlo, dhi), 8));
+        vst1q_u32(sum + x, vsubw_u16(lo, vget_low_u16(s)));
+        vst1q_u32(sum + x + 4, vsubw_u16(hi, vget_high_u16(s)));
+    }
+#elif defined(SK_BLUR_USE_SSE2)
+    const __m128i vscale = _mm_set1_epi32(scale);
+    for (; x <= width - 8; x += 8) {
+        __m128i alo, ahi, slo, shi;
+        blur_load8_SSE2(add + x, &alo, &ahi);
+        blur_load8_SSE2(sub + x, &slo, &shi);
+        __m128i lo = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + x)), alo);
+        __m128i hi = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + x + 4)), ahi);
+        blur_store8_SSE2(dst + x, blur_mul32_SSE2(lo, vscale),
+                         blur_mul32_SSE2(hi, vscale));
+        _mm_storeu_si128((__m128i*)(sum + x), _mm_sub_epi32(lo, slo));
+        _mm_storeu_si128((__m128i*)(sum + x + 4), _mm_sub_epi32(hi, shi));
+    }
+#endif
+    for (; x < width; ++x) {
+        uint32_t s = sum[x] + add[x];
+        dst[x] = (s * scale) >> 24;
+        sum[x] = s - sub[x];
+    }
+}
+
+/*  inner = outer - innerSub; outer += add;
+    dst = (outer * outerScale + inner * innerScale) >> 24; outer -= outerSub;
+ */
+static void box_blur_interp_row(uint8_t dst[], uint32_t outer[],
+                                const uint8_t add[], const uint8_t innerSub[],
+                                const uint8_t outerSub[], int width,
+                                uint32_t outerScale, uint32_t innerScale) {
+    int x = 0;
+#if defined(SK_BLUR_USE_NEON)
+    const uint32x4_t vos = vdupq_n_u32(outerScale);
+    const uint32x4_t vis = vdupq_n_u32(innerScale);
+    for (; x <= width - 8; x += 8) {
+        uint16x8_t a = vmovl_u8(vld1_u8(add + x));
+        uint16x8_t is = vmovl_u8(vld1_u8(innerSub + x));
+        uint16x8_t os = vmovl_u8(vld1_u8(outerSub + x));
+        uint32x4_t olo = vld1q_u32(outer + x);
+        uint32x4_t ohi = vld1q_u32(outer + x + 4);
+        uint32x4_t ilo = vsubw_u16(olo, vget_low_u16(is));
+        uint32x4_t ihi = vsubw_u16(ohi, vget_high_u16(is));
+        olo = vaddw_u16(olo, vget_low_u16(a));
+        ohi = vaddw_u16(ohi, vget_high_u16(a));
+        uint16x4_t dlo = vshrn_n_u32(vmlaq_u32(vmulq_u32(ilo, vis), olo, vos), 16);
+        uint16x4_t dhi = vshrn_n_u32(vmlaq_u32(vmulq_u32(ihi, vis), ohi, vos), 16);
+        vst1_u8(dst + x, vshrn_n_u16(vcombine_u16(dlo, dhi), 8));
+        vst1q_u32(outer + x, vsubw_u16(olo, vget_low_u16(os)));
+        vst1q_u32(outer + x + 4, vsubw_u16(ohi, vget_high_u16(os)));
+    }
+#elif defined(SK_BLUR_USE_SSE2)
+    const __m128i vos = _mm_set1_epi32(outerScale);
+    const __m128i vis = _mm_set1_epi32(innerScale);
+    for (; x <= width - 8; x += 8) {
+        __m128i alo, ahi, islo, ishi, oslo, oshi;
+        blur_load8_SSE2(add + x, &alo, &ahi);
+        blur_load8_SSE2(innerSub + x, &islo, &ishi);
+        blur_load8_SSE2(outerSub + x, &oslo, &oshi);
+        __m128i olo = _mm_loadu_si128((const __m128i*)(outer + x));
+        __m128i ohi = _mm_loadu_si128((const __m128i*)(outer + x + 4));
+        __m128i ilo = _mm_sub_epi32(olo, islo);
+        __m128i ihi = _mm_sub_epi32(ohi, ishi);
+        olo = _mm_add_epi32(olo, alo);
+        ohi = _mm_add_epi32(ohi, ahi);
+        blur_store8_SSE2(dst + x,
+                         _mm_add_epi32(blur_mul32_SSE2(olo, vos), blur_mul32_SSE2(ilo, vis)),
+                         _mm_add_epi32(blur_mul32_SSE2(ohi, vos), blur_mul32_SSE2(ihi, vis)));
+        _mm_storeu_si128((__m128i*)(outer + x), _mm_sub_epi32(olo, oslo));
+        _mm_storeu_si128((__m128i*)(outer + x + 4), _mm_sub_epi32(ohi, oshi));
+    }
+#endif
+    for (; x < width; ++x) {
+        uint32_t o = outer[x];
+        uint32_t i = o - innerSub[x];
+        o += add[x];
+        dst[x] = (o * outerScale + i * innerScale) >> 24;
+        outer[x] = o - outerSub[x];
+    }
+}
+
+/**
+ *  The vertical twin of boxBlur(): blurs the columns of a width x height
+ *  source, writing height + 2 * max(leftRadius, rightRadius) rows. The sums
+ *  and zero rows are sized for width columns.
+ */
+static int boxBlurY(const uint8_t* src, int srcRB, uint8_t* dst, int dstRB,
+                    int leftRadius, int rightRadius, int width, int height,
+                    uint32_t sum[], const uint8_t zeros[])
+{
+    int diameter = leftRadius + rightRadius;
+    int kernelSize = diameter + 1;
+    int border = SkMin32(height, diameter);
+    uint32_t scale = (1 << 24) / kernelSize;
+    int new_height = height + SkMax32(leftRadius, rightRadius) * 2;
+
+    memset(sum, 0, width * sizeof(uint32_t));
+    for (int y = 0; y < rightRadius - leftRadius; y++) {
+        memset(dst, 0, width);
+        dst += dstRB;
+    }
+    const uint8_t* right = src;
+    const uint8_t* left = src;
+    for (int y = 0; y < border; ++y) {
+        box_blur_row(dst, sum, right, zeros, width, scale);
+        right += srcRB;
+        dst += dstRB;
+    }
+    for (int y = height; y < diameter; ++y) {
+        box_blur_row(dst, sum, zeros, zeros, width, scale);
+        dst += dstRB;
+    }
+    for (int y = diameter; y < height; ++y) {
+        box_blur_row(dst, sum, right, left, width, scale);
+        right += srcRB;
+        left += srcRB;
+        dst += dstRB;
+    }
+    for (int y = 0; y < border; ++y) {
+        box_blur_row(dst, sum, zeros, left, width, scale);
+        left += srcRB;
+        dst += dstRB;
+    }
+    for (int y = 0; y < leftRadius - rightRadius; y++) {
+        memset(dst, 0, width);
+        dst += dstRB;
+    }
+    return new_height;
+}
+
+/**
+ *  The vertical twin of boxBlurInterp(), see boxBlurY().
+ */
+static int boxBlurInterpY(const uint8_t* src, int srcRB, uint8_t* dst, int dstRB,
+                          int radius, int width, int height, uint8_t outer_weight,
+                          uint32_t sum[], const uint8_t zeros[])
+{
+    int diameter = radius * 2;
+    int kernelSize = diameter + 1;
+    int border = SkMin32(height, diameter);
+    int inner_weight = 255 - outer_weight;
+    outer_weight += outer_weight >> 7;
+    inner_weight += inner_weight >> 7;
+    uint32_t outer_scale = (outer_weight << 16) / kernelSize;
+    uint32_t inner_scale = (inner_weight << 16) / (kernelSize - 2);
+    int new_height = height + diameter;
+
+    memset(sum, 0, width * sizeof(uint32_t));
+    const uint8_t* right = src;
+    const uint8_t* left = src;
+    for (int y = 0; y < border; ++y) {
+        box_blur_interp_row(dst, sum, right, zeros, zeros, width,
+                            outer_scale, inner_scale);
+        right += srcRB;
+        dst += dstRB;
+    }
+    // like boxBlurInterp(), the inner sum stays one row short here
+    const uint8_t* last = height > 0 ? right - srcRB : zeros;
+    for (int y = height; y < diameter; ++y) {
+        box_blur_interp_row(dst, sum, zeros, last, zeros, width,
+                            outer_scale, inner_scale);
+        dst += dstRB;
+    }
+    for (int y = diameter; y < height; ++y) {
+        box_blur_interp_row(dst, sum, right, left, left, width,
+                            outer_scale, inner_scale);
+        right += srcRB;
+        left += srcRB;
+        dst += dstRB;
+    }
+    for (int y = 0; y < border; ++y) {
+        box_blur_interp_row(dst, sum, zeros, left, left, width,
+                            outer_scale, inner_scale);
+        left += srcRB;
+        dst += dstRB;
+    }
+    return new_height;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Large blurs split each pass in bands, rows for the horizontal passes and
+    columns for the vertical ones, and run them on a small pool of threads
+    alongside the calling thread.
+ */
+
+#if defined(SK_BUILD_FOR_ANDROID) && defined(SK_USE_POSIX_THREADS)
+    #define SK_BLURMASK_THREADS
+#endif
+
+typedef void (*BlurBandProc)(const void* pass, int start, int stop);
+
+#ifdef SK_BLURMASK_THREADS
+
+#include "SkCondVar.h"
+#include "SkRunnable.h"
+#include "SkThread.h"
+#include "SkThreadPool.h"
+
+#include <unistd.h>
+
+// A pass smaller than this isn't worth handing to other threads
+#define BLUR_MIN_THREADED_PIXELS    (96 * 1024)
+#define BLUR_MAX_BANDS              4
+
+namespace {
+
+class BlurBandRunnable : public SkRunnable {
+public:
+    void init(BlurBandProc proc, const void* pass, int start, int stop,
+              SkCondVar* done, int* pending) {
+        fProc = proc;
+        fPass = pass;
+        fStart = start;
+        fStop = stop;
+        fDone = done;
+        fPending = pending;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fProc(fPass, fStart, fStop);
+        fDone->lock();
+        if (0 == --*fPending) {
+            fDone->signal();
+        }
+        fDone->unlock();
+    }
+
+private:
+    BlurBandProc    fProc;
+    const void*     fPass;
+    int             fStart, fStop;
+    SkCondVar*      fDone;
+    int*            fPending;
+};
+
+}
+
+SK_DECLARE_STATIC_MUTEX(gBlurPoolMutex);
+static SkThreadPool* gBlurPool;
+static int gBlurBandCount;
+
+// Returns how many bands a large pass is split in, creating the pool the first
+// time, with one thread less than the bands since the caller runs one band
+static int blur_band_count() {
+    SkAutoMutexAcquire ac(gBlurPoolMutex);
+    if (0 == gBlurBandCount) {
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        gBlurBandCount = SkPin32((int32_t)cpus, 1, BLUR_MAX_BANDS);
+        if (gBlurBandCount > 1) {
+            gBlurPool = SkNEW_ARGS(SkThreadPool, (gBlurBandCount - 1));
+        }
+    }
+    return gBlurBandCount;
+}
+
+/*  Calls proc over [0, count) in bands that are multiples of align, on several
+    threads when the pass touches enough pixels.
+ */
+static void run_blur_bands(BlurBandProc proc, const void* pass, int count,
+                           int align, size_t pixels) {
+    int bands = pixels >= BLUR_MIN_THREADED_PIXELS ? blur_band_count() : 1;
+    int bandSize = (count + bands - 1) / bands;
+    bandSize = (bandSize + align - 1) / align * align;
+    if (bands <= 1 || bandSize >= count) {
+        proc(pass, 0, count);
+        return;
+    }
+
+    BlurBandRunnable runnables[BLUR_MAX_BANDS];
+    SkCondVar done;
+    int pending = 0;
+    int start = bandSize;
+    // the first band is for this thread
+    for (; start < count; start += bandSize) {
+        runnables[pending++].init(proc, pass, start,
+                                  SkMin32(start + bandSize, count),
+                                  &done, &pending);
+    }
+    int queued = pending;
+    for (int i = 0; i < queued; ++i) {
+        gBlurPool->add(&runnables[i]);
+    }
+    proc(pass, 0, bandSize);
+
+    done.lock();
+    while (pending > 0) {
+        done.wait();
+    }
+    done.unlock();
+}
+
+#else
+
+static void run_blur_bands(BlurBandProc proc, const void* pass, int count,
+                           int align, size_t pixels) {
+    proc(pass, 0, count);
+}
+
+#endif
+
+struct BlurPass {
+    const uint8_t*  fSrc;
+    int             fSrcRB;
+    uint8_t*        fDst;
+    int             fDstRB;
+    int             fLeftRadius, fRightRadius;
+    int             fWidth, fHeight;
+    int             fOuterWeight;   // 255 for a box blur of integer radius
+};
+
+// rows [start, stop) of a horizontal pass
+static void blur_x_band(const void* context, int start, int stop) {
+    const BlurPass& pass = *(const BlurPass*)context;
+    const uint8_t* src = pass.fSrc + start * pass.fSrcRB;
+    uint8_t* dst = pass.fDst + start * pass.fDstRB;
+    if (255 == pass.fOuterWeight) {
+        boxBlur(src, pass.fSrcRB, dst, pass.fLeftRadius, pass.fRightRadius,
+                pass.fWidth, stop - start, false);
+    } else {
+        boxBlurInterp(src, pass.fSrcRB, dst, pass.fLeftRadius,
+                      pass.fWidth, stop - start, false, pass.fOuterWeight);
+    }
+}
+
+// columns [start, stop) of a vertical pass
+static void blur_y_band(const void* context, int start, int stop) {
+    const BlurPass& pass = *(const BlurPass*)context;
+    int width = stop - start;
+    SkAutoTMalloc<uint32_t> sum(width);
+    SkAutoTMalloc<uint8_t>  zeros(width);
+    memset(zeros.get(), 0, width);
+    if (255 == pass.fOuterWeight) {
+        boxBlurY(pass.fSrc + start, pass.fSrcRB, pass.fDst + start, pass.fDstRB,
+                 pass.fLeftRadius, pass.fRightRadius, width, pass.fHeight,
+                 sum.get(), zeros.get());
+    } else {
+        boxBlurInterpY(pass.fSrc + start, pass.fSrcRB, pass.fDst + start,
+                       pass.fDstRB, pass.fLeftRadius, width, pass.fHeight,
+                       pass.fOuterWeight, sum.get(), zeros.get());
+    }
+}
+
+/**
+ *  Blurs the rows of src with boxBlur(), or boxBlurInterp() when outerWeight
+ *  isn't 255, and returns the width of the result.
+ */
+static int blur_x(const uint8_t* src, int srcRB, uint8_t* dst,
+                  int leftRadius, int rightRadius, int width, int height,
+                  int outerWeight) {
+    BlurPass pass;
+    pass.fSrc = src;
+    pass.fSrcRB = srcRB;
+    pass.fDst = dst;
+    pass.fDstRB = width + SkMax32(leftRadius, rightRadius) * 2;
+    pass.fLeftRadius = leftRadius;
+    pass.fRightRadius = rightRadius;
+    pass.fWidth = width;
+    pass.fHeight = height;
+    pass.fOuterWeight = outerWeight;
+    run_blur_bands(blur_x_band, &pass, height, 16, pass.fDstRB * height);
+    return pass.fDstRB;
+}
+
+/**
+ *  Blurs the columns of src (rows of width bytes) in place of a transposed
+ *  blur_x(), and returns the height of the result.
+ */
+static int blur_y(const uint8_t* src, uint8_t* dst,
+                  int leftRadius, int rightRadius, int width, int height,
+                  int outerWeight) {
+    BlurPass pass;
+    pass.fSrc = src;
+    pass.fSrcRB = width;
+    pass.fDst = dst;
+    pass.fDstRB = width;
+    pass.fLeftRadius = leftRadius;
+    pass.fRightRadius = rightRadius;
+    pass.fWidth = width;
+    pass.fHeight = height;
+    pass.fOuterWeight = outerWeight;
+    int new_height = height + SkMax32(leftRadius, rightRadius) * 2;
+    // bands of whole cache lines
+    run_blur_bands(blur_y_band, &pass, width, 64, width * new_height);
+    return new_height;
+}
+
 // Unrolling the integer blur kernel seems to give us a ~15% speedup on Windows,
 // breakeven on Mac, and ~15% slowdown on Linux.
 // Reading a word at a time when bulding the sum buffer seems to give
@@ -921,31 +1363,29 @@ bool SkBlurMask::Blur(SkMask* dst, const SkMask& src,
                 int loRadius, hiRadius;
                 get_adjusted_radii(passRadius, &loRadius, &hiRadius);
                 if (kHigh_Quality == quality) {
-                    // Do three X blurs, with a transpose on the final one.
-                    w = boxBlur(sp, src.fRowBytes, tp, loRadius, hiRadius, w, h, false);
-                    w = boxBlur(tp, w,             dp, hiRadius, loRadius, w, h, false);
-                    w = boxBlur(dp, w,             tp, hiRadius, hiRadius, w, h, true);
-                    // Do three Y blurs, with a transpose on the final one.
-                    h = boxBlur(tp, h,             dp, loRadius, hiRadius, h, w, false);
-                    h = boxBlur(dp, h,             tp, hiRadius, loRadius, h, w, false);
-                    h = boxBlur(tp, h,             dp, hiRadius, hiRadius, h, w, true);
+                    // Do three X blurs, then three Y blurs down the columns.
+                    w = blur_x(sp, src.fRowBytes, tp, loRadius, hiRadius, w, h, 255);
+                    w = blur_x(tp, w,             dp, hiRadius, loRadius, w, h, 255);
+                    w = blur_x(dp, w,             tp, hiRadius, hiRadius, w, h, 255);
+                    h = blur_y(tp, dp, loRadius, hiRadius, w, h, 255);
+                    h = blur_y(dp, tp, hiRadius, loRadius, w, h, 255);
+                    h = blur_y(tp, dp, hiRadius, hiRadius, w, h, 255);
                 } else {
-                    w = boxBlur(sp, src.fRowBytes, tp, rx, rx, w, h, true);
-                    h = boxBlur(tp, h,             dp, ry, ry, h, w, true);
+                    w = blur_x(sp, src.fRowBytes, tp, rx, rx, w, h, 255);
+                    h = blur_y(tp, dp, ry, ry, w, h, 255);
                 }
             } else {
                 if (kHigh_Quality == quality) {
-                    // Do three X blurs, with a transpose on the final one.
-                    w = boxBlurInterp(sp, src.fRowBytes, tp, rx, w, h, false, outer_weight);
-                    w = boxBlurInterp(tp, w,             dp, rx, w, h, false, outer_weight);
-                    w = boxBlurInterp(dp, w,             tp, rx, w, h, true, outer_weight);
-                    // Do three Y blurs, with a transpose on the final one.
-                    h = boxBlurInterp(tp, h,             dp, ry, h, w, false, outer_weight);
-                    h = boxBlurInterp(dp, h,             tp, ry, h, w, false, outer_weight);
-                    h = boxBlurInterp(tp, h,             dp, ry, h, w, true, outer_weight);
+                    // Do three X blurs, then three Y blurs down the columns.
+                    w = blur_x(sp, src.fRowBytes, tp, rx, rx, w, h, outer_weight);
+                    w = blur_x(tp, w,             dp, rx, rx, w, h, outer_weight);
+                    w = blur_x(dp, w,             tp, rx, rx, w, h, outer_weight);
+                    h = blur_y(tp, dp, ry, ry, w, h, outer_weight);
+                    h = blur_y(dp, tp, ry, ry, w, h, outer_weight);
+                    h = blur_y(tp, dp, ry, ry, w, h, outer_weight);
                 } else {
-                    w = boxBlurInterp(sp, src.fRowBytes, tp, rx, w, h, true, outer_weight);
-                    h = boxBlurInterp(tp, h,             dp, ry, h, w, true, outer_weight);
+                    w = blur_x(sp, src.fRowBytes, tp, rx, rx, w, h, outer_weight);
+                    h = blur_y(tp, dp, ry, ry, w, h, outer_weight);
                 }
             }
         } else {
@@ -1016,18 +1456,200 @@ bool SkBlurMask::Blur(SkMask* dst, const SkMask& src,
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Pages draw the same shadow over and over (a box-shadow on every item of a
+    list, a text-shadow on repeated labels), so the last blurred masks are
+    kept, keyed by the blur and the source mask's size and pixels. Shapes with
+    the same bounds rarely have the same coverage, so the bounds alone can't
+    be the key.
+ */
+
+#include "SkChecksum.h"
+#include "SkThread.h"
+
+#ifndef SK_DEFAULT_BLUR_MASK_CACHE_LIMIT
+    #define SK_DEFAULT_BLUR_MASK_CACHE_LIMIT    (1024 * 1024)
+#endif
+
+// Blurs of smaller masks are cheaper to redo than to hash and copy
+#define BLUR_CACHE_MIN_SRC_SIZE     (32 * 32)
+
+struct SkBlurMaskCacheRec {
+    SkBlurMaskCacheRec* fNext;  // most recently used first
+    SkBlurMaskCacheRec* fPrev;
+    uint32_t    fHash;
+    SkScalar    fRadius;
+    uint8_t     fStyle;
+    uint8_t     fQuality;
+    bool        fSeparable;
+    int         fSrcWidth, fSrcHeight;
+    size_t      fSrcSize;       // packed source rows, padded to 4 bytes
+    SkIRect     fBounds;        // of the blur, relative to the source's top-left
+    uint32_t    fRowBytes;
+    size_t      fImageSize;
+    SkIPoint    fMargin;
+
+    size_t size() const { return sizeof(*this) + fSrcSize + fImageSize; }
+    // the packed source follows the record, then the blurred image
+    uint8_t* src() { return (uint8_t*)(this + 1); }
+    uint8_t* image() { return this->src() + fSrcSize; }
+};
+
+SK_DECLARE_STATIC_MUTEX(gBlurCacheMutex);
+static SkBlurMaskCacheRec* gBlurCacheHead;
+static SkBlurMaskCacheRec* gBlurCacheTail;
+static size_t gBlurCacheUsed;
+static size_t gBlurCacheLimit = SK_DEFAULT_BLUR_MASK_CACHE_LIMIT;
+
+static void blur_cache_detach(SkBlurMaskCacheRec* rec) {
+    if (rec->fPrev) {
+        rec->fPrev->fNext = rec->fNext;
+    } else {
+        gBlurCacheHead = rec->fNext;
+    }
+    if (rec->fNext) {
+        rec->fNext->fPrev = rec->fPrev;
+    } else {
+        gBlurCacheTail = rec->fPrev;
+    }
+}
+
+static void blur_cache_attach_head(SkBlurMaskCacheRec* rec) {
+    rec->fPrev = NULL;
+    rec->fNext = gBlurCacheHead;
+    if (gBlurCacheHead) {
+        gBlurCacheHead->fPrev = rec;
+    } else {
+        gBlurCacheTail = rec;
+    }
+    gBlurCacheHead = rec;
+}
+
+// Call with gBlurCacheMutex held
+static void blur_cache_purge(size_t limit) {
+    while (gBlurCacheUsed > limit) {
+        SkBlurMaskCacheRec* rec = gBlurCacheTail;
+        SkASSERT(rec);
+        blur_cache_detach(rec);
+        gBlurCacheUsed -= rec->size();
+        sk_free(rec);
+    }
+}
+
+size_t SkBlurMask::GetCacheLimit() {
+    SkAutoMutexAcquire ac(gBlurCacheMutex);
+    return gBlurCacheLimit;
+}
+
+size_t SkBlurMask::SetCacheLimit(size_t bytes) {
+    SkAutoMutexAcquire ac(gBlurCacheMutex);
+    size_t prev = gBlurCacheLimit;
+    gBlurCacheLimit = bytes;
+    blur_cache_purge(bytes);
+    return prev;
+}
+
+bool SkBlurMask::CachedBlur(SkMask* dst, const SkMask& src,
+                            SkScalar radius, Style style, Quality quality,
+                            SkIPoint* margin, bool separable)
+{
+    int sw = src.fBounds.width();
+    int sh = src.fBounds.height();
+    size_t srcSize = SkAlign4((size_t)sw * sh);
+    size_t limit = SkBlurMask::GetCacheLimit();
+    if (NULL == src.fImage || src.fFormat != SkMask::kA8_Format ||
+        srcSize < BLUR_CACHE_MIN_SRC_SIZE || srcSize > (limit >> 3)) {
+        return SkBlurMask::Blur(dst, src, radius, style, quality, margin, separable);
+    }
+
+    // the key: the source rows packed and padded for SkChecksum
+    SkAutoTMalloc<uint32_t> packed(srcSize >> 2);
+    uint8_t* pp = (uint8_t*)packed.get();
+    for (int y = 0; y < sh; ++y) {
+        memcpy(pp + y * sw, src.fImage + y * src.fRowBytes, sw);
+    }
+    memset(pp + sw * sh, 0, srcSize - sw * sh);
+    uint32_t hash = SkChecksum::Compute(packed.get(), srcSize);
+
+    {
+        SkAutoMutexAcquire ac(gBlurCacheMutex);
+        for (SkBlurMaskCacheRec* rec = gBlurCacheHead; rec; rec = rec->fNext) {
+            if (rec->fHash == hash && rec->fRadius == radius &&
+                rec->fStyle == style && rec->fQuality == quality &&
+                rec->fSeparable == separable &&
+                rec->fSrcWidth == sw && rec->fSrcHeight == sh &&
+                !memcmp(rec->src(), pp, srcSize)) {
+                if (rec != gBlurCacheHead) {
+                    blur_cache_detach(rec);
+                    blur_cache_attach_head(rec);
+                }
+                dst->fBounds = rec->fBounds;
+                dst->fBounds.offset(src.fBounds.fLeft, src.fBounds.fTop);
+                dst->fRowBytes = rec->fRowBytes;
+                dst->fFormat = SkMask::kA8_Format;
+                dst->fImage = SkMask::AllocImage(rec->fImageSize);
+                memcpy(dst->fImage, rec->image(), rec->fImageSize);
+                if (margin) {
+                    *margin = rec->fMargin;
+                }
+                return true;
+            }
+        }
+    }
+
+    SkIPoint blurMargin;
+    if (!SkBlurMask::Blur(dst, src, radius, style, quality, &blurMargin, separable)) {
+        return false;
+    }
+    if (margin) {
+        *margin = blurMargin;
+    }
+    size_t imageSize = dst->computeImageSize();
+    if (NULL == dst->fImage || srcSize + imageSize > (limit >> 2)) {
+        return true;
+    }
+
+    SkBlurMaskCacheRec* rec = (SkBlurMaskCacheRec*)sk_malloc_flags(
+            sizeof(SkBlurMaskCacheRec) + srcSize + imageSize, 0);
+    if (NULL == rec) {
+        return true;
+    }
+    rec->fHash = hash;
+    rec->fRadius = radius;
+    rec->fStyle = SkToU8(style);
+    rec->fQuality = SkToU8(quality);
+    rec->fSeparable = separable;
+    rec->fSrcWidth = sw;
+    rec->fSrcHeight = sh;
+    rec->fSrcSize = srcSize;
+    rec->fBounds = dst->fBounds;
+    rec->fBounds.offset(-src.fBounds.fLeft, -src.fBounds.fTop);
+    rec->fRowBytes = dst->fRowBytes;
+    rec->fImageSize = imageSize;
+    rec->fMargin = blurMargin;
+    memcpy(rec->src(), pp, srcSize);
+    memcpy(rec->image(), dst->fImage, imageSize);
+
+    SkAutoMutexAcquire ac(gBlurCacheMutex);
+    blur_cache_attach_head(rec);
+    gBlurCacheUsed += rec->size();
+    blur_cache_purge(gBlurCacheLimit);
+    return true;
+}
+
 bool SkBlurMask::BlurSeparable(SkMask* dst, const SkMask& src,
                                SkScalar radius, Style style, Quality quality,
                                SkIPoint* margin)
 {
-    return SkBlurMask::Blur(dst, src, radius, style, quality, margin, true);
+    return SkBlurMask::CachedBlur(dst, src, radius, style, quality, margin, true);
 }
 
 bool SkBlurMask::Blur(SkMask* dst, const SkMask& src,
                      SkScalar radius, Style style, Quality quality,
                      SkIPoint* margin)
 {
-    return SkBlurMask::Blur(dst, src, radius, style, quality, margin, false);
+    return SkBlurMask::CachedBlur(dst, src, radius, style, quality, margin, false);
 }
 
 /* Convolving a box with itself three times results in a piecewise
@@ -38,10 +38,25 @@ public:
     static bool BlurSeparable(SkMask* dst, const SkMask& src,
                               SkScalar radius, Style style, Quality quality,
                               SkIPoint* margin = NULL);
+
+    /** Blur() and BlurSeparable() keep their last results in a cache, keyed by
+        the source mask and the blur, so that drawing the same shadow again
+        only copies it. Returns the cache's budget in bytes.
+    */
+    static size_t GetCacheLimit();
+
+    /** Sets the cache's budget in bytes, purging it if need be, and returns
+        the previous budget. 0 turns the cache off.
+    */
+    static size_t SetCacheLimit(size_t bytes);
+
 private:
     static bool Blur(SkMask* dst, const SkMask& src,
                      SkScalar radius, Style style, Quality quality,
                      SkIPoint* margin, bool separable);
+    static bool CachedBlur(SkMask* dst, const SkMask& src,
+                           SkScalar radius, Style style, Quality quality,
+                           SkIPoint* margin, bool separable);
 };
 
 #endif
@@ -0,0 +1,426 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts_SSE2.h"
+#include "SkColorPriv.h"
+
+#include <emmintrin.h>
+
+/* The procs below blend 4 pixels at a time, with each component of the 4
+   pixels in its own 32 bit lane, and give exactly the same results as the
+   portable procs in core/SkXfermode.cpp, which they follow line by line.
+   ColorDodge, ColorBurn and SoftLight divide per component and are left to
+   the portable procs.
+ */
+
+static inline __m128i SkGetPackedA32_SSE2(const __m128i& src) {
+    __m128i a = _mm_slli_epi32(src, (24 - SK_A32_SHIFT));
+    return _mm_srli_epi32(a, 24);
+}
+
+static inline __m128i SkGetPackedR32_SSE2(const __m128i& src) {
+    __m128i r = _mm_slli_epi32(src, (24 - SK_R32_SHIFT));
+    return _mm_srli_epi32(r, 24);
+}
+
+static inline __m128i SkGetPackedG32_SSE2(const __m128i& src) {
+    __m128i g = _mm_slli_epi32(src, (24 - SK_G32_SHIFT));
+    return _mm_srli_epi32(g, 24);
+}
+
+static inline __m128i SkGetPackedB32_SSE2(const __m128i& src) {
+    __m128i b = _mm_slli_epi32(src, (24 - SK_B32_SHIFT));
+    return _mm_srli_epi32(b, 24);
+}
+
+static inline __m128i SkPackARGB32_SSE2(const __m128i& a, const __m128i& r,
+                                        const __m128i& g, const __m128i& b) {
+    __m128i a1 = _mm_slli_epi32(a, SK_A32_SHIFT);
+    __m128i r1 = _mm_slli_epi32(r, SK_R32_SHIFT);
+    __m128i g1 = _mm_slli_epi32(g, SK_G32_SHIFT);
+    __m128i b1 = _mm_slli_epi32(b, SK_B32_SHIFT);
+    return _mm_or_si128(_mm_or_si128(a1, r1), _mm_or_si128(g1, b1));
+}
+
+// Low 32 bits of a * b, SSE2 has no 32 bit multiply
+static inline __m128i Multiply32_SSE2(const __m128i& a, const __m128i& b) {
+    __m128i r1 = _mm_mul_epu32(a, b);
+    __m128i r2 = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(r1, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(r2, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// a * b, for a and b in [0..255], in a single 16 bit multiply
+static inline __m128i MulU8_SSE2(const __m128i& a, const __m128i& b) {
+    return _mm_mullo_epi16(a, b);
+}
+
+static inline __m128i Select_SSE2(const __m128i& mask, const __m128i& a,
+                                  const __m128i& b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i SkMin32_SSE2(const __m128i& a, const __m128i& b) {
+    return Select_SSE2(_mm_cmplt_epi32(a, b), a, b);
+}
+
+static inline __m128i SkDiv255Round_SSE2(const __m128i& a) {
+    __m128i prod = _mm_add_epi32(a, _mm_set1_epi32(128));
+    prod = _mm_add_epi32(prod, _mm_srli_epi32(prod, 8));
+    return _mm_srli_epi32(prod, 8);
+}
+
+static inline __m128i SkAlphaMulAlpha_SSE2(const __m128i& a, const __m128i& b) {
+    return SkDiv255Round_SSE2(MulU8_SSE2(a, b));
+}
+
+static inline __m128i SkAlphaMulQ_SSE2(const __m128i& c, const __m128i& scale) {
+    const __m128i mask = _mm_set1_epi32(0xFF00FF);
+    __m128i rb = Multiply32_SSE2(_mm_and_si128(c, mask), scale);
+    rb = _mm_and_si128(_mm_srli_epi32(rb, 8), mask);
+    __m128i ag = Multiply32_SSE2(_mm_and_si128(_mm_srli_epi32(c, 8), mask), scale);
+    ag = _mm_andnot_si128(mask, ag);
+    return _mm_or_si128(rb, ag);
+}
+
+static inline __m128i clamp_signed_byte_SSE2(const __m128i& n) {
+    __m128i cmp = _mm_cmplt_epi32(n, _mm_setzero_si128());
+    __m128i ret = _mm_andnot_si128(cmp, n);
+    cmp = _mm_cmpgt_epi32(ret, _mm_set1_epi32(255));
+    return Select_SSE2(cmp, _mm_set1_epi32(255), ret);
+}
+
+static inline __m128i clamp_div255round_SSE2(const __m128i& prod) {
+    __m128i ret = SkDiv255Round_SSE2(prod);
+    __m128i cmp = _mm_cmpgt_epi32(prod, _mm_set1_epi32(255 * 255 - 1));
+    ret = Select_SSE2(cmp, _mm_set1_epi32(255), ret);
+    cmp = _mm_cmpgt_epi32(prod, _mm_setzero_si128());
+    return _mm_and_si128(cmp, ret);
+}
+
+static inline __m128i srcover_byte_SSE2(const __m128i& a, const __m128i& b) {
+    return _mm_sub_epi32(_mm_add_epi32(a, b), SkAlphaMulAlpha_SSE2(a, b));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// These have external linkage so that they can be template arguments
+
+//  kDst_Mode,      //!< [Da, Dc]
+__m128i dst_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    return dst;
+}
+
+//  kDstOver_Mode,  //!< [Sa + Da - Sa*Da, Dc + (1 - Da)*Sc]
+__m128i dstover_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i scale = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(dst));
+    return _mm_add_epi32(dst, SkAlphaMulQ_SSE2(src, scale));
+}
+
+//  kSrcIn_Mode,    //!< [Sa * Da, Sc * Da]
+__m128i srcin_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i scale = _mm_add_epi32(SkGetPackedA32_SSE2(dst), _mm_set1_epi32(1));
+    return SkAlphaMulQ_SSE2(src, scale);
+}
+
+//  kDstIn_Mode,    //!< [Sa * Da, Sa * Dc]
+__m128i dstin_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i scale = _mm_add_epi32(SkGetPackedA32_SSE2(src), _mm_set1_epi32(1));
+    return SkAlphaMulQ_SSE2(dst, scale);
+}
+
+//  kSrcOut_Mode,   //!< [Sa * (1 - Da), Sc * (1 - Da)]
+__m128i srcout_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i scale = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(dst));
+    return SkAlphaMulQ_SSE2(src, scale);
+}
+
+//  kDstOut_Mode,   //!< [Da * (1 - Sa), Dc * (1 - Sa)]
+__m128i dstout_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i scale = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(src));
+    return SkAlphaMulQ_SSE2(dst, scale);
+}
+
+//  kSrcATop_Mode,  //!< [Da, Sc * Da + (1 - Sa) * Dc]
+__m128i srcatop_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i isa = _mm_sub_epi32(_mm_set1_epi32(255), sa);
+
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(da, r, g, b);
+}
+
+//  kDstATop_Mode,  //!< [Sa, Sa * Dc + Sc * (1 - Da)]
+__m128i dstatop_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i ida = _mm_sub_epi32(_mm_set1_epi32(255), da);
+
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(sa, r, g, b);
+}
+
+//  kXor_Mode   [Sa + Da - 2 * Sa * Da, Sc * (1 - Da) + (1 - Sa) * Dc]
+__m128i xor_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i isa = _mm_sub_epi32(_mm_set1_epi32(255), sa);
+    __m128i ida = _mm_sub_epi32(_mm_set1_epi32(255), da);
+
+    __m128i a1 = _mm_add_epi32(sa, da);
+    __m128i a2 = _mm_slli_epi32(SkAlphaMulAlpha_SSE2(sa, da), 1);
+    __m128i a = _mm_sub_epi32(a1, a2);
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+// kPlus_Mode
+__m128i plus_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    // saturated_add() on each byte
+    return _mm_adds_epu8(src, dst);
+}
+
+// kModulate_Mode
+__m128i modulate_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i a = SkAlphaMulAlpha_SSE2(SkGetPackedA32_SSE2(src),
+                                     SkGetPackedA32_SSE2(dst));
+    __m128i r = SkAlphaMulAlpha_SSE2(SkGetPackedR32_SSE2(src),
+                                     SkGetPackedR32_SSE2(dst));
+    __m128i g = SkAlphaMulAlpha_SSE2(SkGetPackedG32_SSE2(src),
+                                     SkGetPackedG32_SSE2(dst));
+    __m128i b = SkAlphaMulAlpha_SSE2(SkGetPackedB32_SSE2(src),
+                                     SkGetPackedB32_SSE2(dst));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+// kScreen_Mode
+__m128i screen_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i a = srcover_byte_SSE2(SkGetPackedA32_SSE2(src),
+                                  SkGetPackedA32_SSE2(dst));
+    __m128i r = srcover_byte_SSE2(SkGetPackedR32_SSE2(src),
+                                  SkGetPackedR32_SSE2(dst));
+    __m128i g = srcover_byte_SSE2(SkGetPackedG32_SSE2(src),
+                                  SkGetPackedG32_SSE2(dst));
+    __m128i b = srcover_byte_SSE2(SkGetPackedB32_SSE2(src),
+                                  SkGetPackedB32_SSE2(dst));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+// Applies a per component blend to r, g and b, with a = srcover_byte(sa, da)
+#define SEPARABLE_MODEPROC_SSE2(name)                                         \
+    __m128i name##_modeproc_SSE2(const __m128i& src, const __m128i& dst) {   \
+        __m128i sa = SkGetPackedA32_SSE2(src);                                \
+        __m128i da = SkGetPackedA32_SSE2(dst);                                \
+        __m128i a = srcover_byte_SSE2(sa, da);                                \
+        __m128i r = name##_byte_SSE2(SkGetPackedR32_SSE2(src),                \
+                                     SkGetPackedR32_SSE2(dst), sa, da);       \
+        __m128i g = name##_byte_SSE2(SkGetPackedG32_SSE2(src),                \
+                                     SkGetPackedG32_SSE2(dst), sa, da);       \
+        __m128i b = name##_byte_SSE2(SkGetPackedB32_SSE2(src),                \
+                                     SkGetPackedB32_SSE2(dst), sa, da);       \
+        return SkPackARGB32_SSE2(a, r, g, b);                                 \
+    }
+
+// sa * da - 2 * (da - dc) * (sa - sc), shared by overlay and hardlight
+static inline __m128i overlay_high_SSE2(const __m128i& sc, const __m128i& dc,
+                                        const __m128i& sa, const __m128i& da) {
+    __m128i tmp = Multiply32_SSE2(_mm_sub_epi32(da, dc), _mm_sub_epi32(sa, sc));
+    return _mm_sub_epi32(MulU8_SSE2(sa, da), _mm_slli_epi32(tmp, 1));
+}
+
+// sc * (255 - da) + dc * (255 - sa)
+static inline __m128i cross_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                      const __m128i& sa, const __m128i& da) {
+    const __m128i c255 = _mm_set1_epi32(255);
+    return _mm_add_epi32(MulU8_SSE2(sc, _mm_sub_epi32(c255, da)),
+                         MulU8_SSE2(dc, _mm_sub_epi32(c255, sa)));
+}
+
+// kOverlay_Mode
+static inline __m128i overlay_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                        const __m128i& sa, const __m128i& da) {
+    __m128i tmp = cross_byte_SSE2(sc, dc, sa, da);
+    // 2 * dc <= da
+    __m128i cmp = _mm_cmpgt_epi32(_mm_slli_epi32(dc, 1), da);
+    __m128i rc = Select_SSE2(cmp, overlay_high_SSE2(sc, dc, sa, da),
+                             _mm_slli_epi32(MulU8_SSE2(sc, dc), 1));
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, tmp));
+}
+SEPARABLE_MODEPROC_SSE2(overlay)
+
+// kDarken_Mode
+static inline __m128i darken_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                       const __m128i& sa, const __m128i& da) {
+    __m128i sd = MulU8_SSE2(sc, da);
+    __m128i ds = MulU8_SSE2(dc, sa);
+    __m128i scdc = _mm_add_epi32(sc, dc);
+    // sd < ds ? srcover : dstover
+    __m128i cmp = _mm_cmplt_epi32(sd, ds);
+    return _mm_sub_epi32(scdc, SkDiv255Round_SSE2(Select_SSE2(cmp, ds, sd)));
+}
+SEPARABLE_MODEPROC_SSE2(darken)
+
+// kLighten_Mode
+static inline __m128i lighten_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                        const __m128i& sa, const __m128i& da) {
+    __m128i sd = MulU8_SSE2(sc, da);
+    __m128i ds = MulU8_SSE2(dc, sa);
+    __m128i scdc = _mm_add_epi32(sc, dc);
+    // sd > ds ? srcover : dstover
+    __m128i cmp = _mm_cmpgt_epi32(sd, ds);
+    return _mm_sub_epi32(scdc, SkDiv255Round_SSE2(Select_SSE2(cmp, ds, sd)));
+}
+SEPARABLE_MODEPROC_SSE2(lighten)
+
+// kHardLight_Mode
+static inline __m128i hardlight_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                          const __m128i& sa, const __m128i& da) {
+    // 2 * sc <= sa
+    __m128i cmp = _mm_cmpgt_epi32(_mm_slli_epi32(sc, 1), sa);
+    __m128i rc = Select_SSE2(cmp, overlay_high_SSE2(sc, dc, sa, da),
+                             _mm_slli_epi32(MulU8_SSE2(sc, dc), 1));
+    __m128i tmp = cross_byte_SSE2(sc, dc, sa, da);
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, tmp));
+}
+SEPARABLE_MODEPROC_SSE2(hardlight)
+
+// kDifference_Mode
+static inline __m128i difference_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                           const __m128i& sa, const __m128i& da) {
+    __m128i tmp = SkMin32_SSE2(MulU8_SSE2(sc, da), MulU8_SSE2(dc, sa));
+    __m128i diff = _mm_sub_epi32(_mm_add_epi32(sc, dc),
+                                 _mm_slli_epi32(SkDiv255Round_SSE2(tmp), 1));
+    return clamp_signed_byte_SSE2(diff);
+}
+SEPARABLE_MODEPROC_SSE2(difference)
+
+// kExclusion_Mode
+static inline __m128i exclusion_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                          const __m128i& sa, const __m128i& da) {
+    __m128i r = _mm_add_epi32(MulU8_SSE2(sc, da), MulU8_SSE2(dc, sa));
+    r = _mm_sub_epi32(r, _mm_slli_epi32(MulU8_SSE2(sc, dc), 1));
+    r = _mm_add_epi32(r, cross_byte_SSE2(sc, dc, sa, da));
+    return clamp_div255round_SSE2(r);
+}
+SEPARABLE_MODEPROC_SSE2(exclusion)
+
+///////////////////////////////////////////////////////////////////////////////
+
+// SkFourByteInterp(src, dst, aa) for aa in [1..255], computed as
+// (src * scale + dst * (256 - scale)) >> 8 which is the same value
+static inline __m128i SkFourByteInterp_SSE2(const __m128i& src, const __m128i& dst,
+                                            const __m128i& aa) {
+    __m128i scale = _mm_add_epi32(aa, _mm_set1_epi32(1));
+    __m128i iscale = _mm_sub_epi32(_mm_set1_epi32(256), scale);
+#define INTERP_COMPONENT_SSE2(C)                                              \
+    _mm_srli_epi32(_mm_add_epi32(MulU8_SSE2(SkGetPacked##C##32_SSE2(src), scale), \
+                                 MulU8_SSE2(SkGetPacked##C##32_SSE2(dst), iscale)), 8)
+    __m128i a = INTERP_COMPONENT_SSE2(A);
+    __m128i r = INTERP_COMPONENT_SSE2(R);
+    __m128i g = INTERP_COMPONENT_SSE2(G);
+    __m128i b = INTERP_COMPONENT_SSE2(B);
+#undef INTERP_COMPONENT_SSE2
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+typedef __m128i (*ModeProc_SSE2)(const __m128i& src, const __m128i& dst);
+
+template <ModeProc_SSE2 proc>
+void xfer32_SSE2(SkPMColor dst[], const SkPMColor src[], int count,
+                 const SkAlpha aa[], SkXfermodeProc proc1) {
+    if (NULL == aa) {
+        while (count >= 4) {
+            __m128i s = _mm_loadu_si128((const __m128i*)src);
+            __m128i d = _mm_loadu_si128((const __m128i*)dst);
+            _mm_storeu_si128((__m128i*)dst, proc(s, d));
+            src += 4;
+            dst += 4;
+            count -= 4;
+        }
+        for (int i = count - 1; i >= 0; --i) {
+            dst[i] = proc1(src[i], dst[i]);
+        }
+    } else {
+        while (count >= 4) {
+            __m128i a = _mm_setr_epi32(aa[0], aa[1], aa[2], aa[3]);
+            __m128i zero = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+            if (0xFFFF != _mm_movemask_epi8(zero)) {
+                __m128i s = _mm_loadu_si128((const __m128i*)src);
+                __m128i d = _mm_loadu_si128((const __m128i*)dst);
+                __m128i c = SkFourByteInterp_SSE2(proc(s, d), d, a);
+                // aa == 0 leaves dst alone
+                _mm_storeu_si128((__m128i*)dst, Select_SSE2(zero, d, c));
+            }
+            src += 4;
+            dst += 4;
+            aa += 4;
+            count -= 4;
+        }
+        for (int i = count - 1; i >= 0; --i) {
+            unsigned a = aa[i];
+            if (0 != a) {
+                SkPMColor dstC = dst[i];
+                SkPMColor C = proc1(src[i], dstC);
+                if (a != 0xFF) {
+                    C = SkFourByteInterp(C, dstC, a);
+                }
+                dst[i] = C;
+            }
+        }
+    }
+}
+
+static const SkXfermodeProcSIMD gSSE2XfermodeProcs[] = {
+    NULL,                           // kClear_Mode, see SkClearXfermode
+    NULL,                           // kSrc_Mode, see SkSrcXfermode
+    xfer32_SSE2<dst_modeproc_SSE2>,
+    NULL,                           // kSrcOver_Mode, see SkBlitRow
+    xfer32_SSE2<dstover_modeproc_SSE2>,
+    xfer32_SSE2<srcin_modeproc_SSE2>,
+    xfer32_SSE2<dstin_modeproc_SSE2>,
+    xfer32_SSE2<srcout_modeproc_SSE2>,
+    xfer32_SSE2<dstout_modeproc_SSE2>,
+    xfer32_SSE2<srcatop_modeproc_SSE2>,
+    xfer32_SSE2<dstatop_modeproc_SSE2>,
+    xfer32_SSE2<xor_modeproc_SSE2>,
+
+    xfer32_SSE2<plus_modeproc_SSE2>,
+    xfer32_SSE2<modulate_modeproc_SSE2>,
+    xfer32_SSE2<screen_modeproc_SSE2>,
+    xfer32_SSE2<overlay_modeproc_SSE2>,
+    xfer32_SSE2<darken_modeproc_SSE2>,
+    xfer32_SSE2<lighten_modeproc_SSE2>,
+    NULL,                           // kColorDodge_Mode
+    NULL,                           // kColorBurn_Mode
+    xfer32_SSE2<hardlight_modeproc_SSE2>,
+    NULL,                           // kSoftLight_Mode
+    xfer32_SSE2<difference_modeproc_SSE2>,
+    xfer32_SSE2<exclusion_modeproc_SSE2>,
+};
+
+SkXfermodeProcSIMD SkPlatformXfermodeProcSIMD_SSE2(SkXfermode::Mode mode) {
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(gSSE2XfermodeProcs) == SkXfermode::kLastMode + 1,
+                      mode_count_SSE2);
+    SkASSERT((unsigned)mode <= SkXfermode::kLastMode);
+    return gSSE2XfermodeProcs[mode];
+}
@@ -0,0 +1,408 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts_arm_neon.h"
+#include "SkColorPriv.h"
+
+#include <arm_neon.h>
+
+/* The NEON twin of SkXfermode_opts_SSE2.cpp: 4 pixels at a time, each
+   component in its own 32 bit lane, with the same results as the portable
+   procs in core/SkXfermode.cpp.
+ */
+
+static inline uint32x4_t SkGetPackedA32_neon(uint32x4_t src) {
+    return vshrq_n_u32(vshlq_n_u32(src, 24 - SK_A32_SHIFT), 24);
+}
+
+static inline uint32x4_t SkGetPackedR32_neon(uint32x4_t src) {
+    return vshrq_n_u32(vshlq_n_u32(src, 24 - SK_R32_SHIFT), 24);
+}
+
+static inline uint32x4_t SkGetPackedG32_neon(uint32x4_t src) {
+    return vshrq_n_u32(vshlq_n_u32(src, 24 - SK_G32_SHIFT), 24);
+}
+
+static inline uint32x4_t SkGetPackedB32_neon(uint32x4_t src) {
+    return vshrq_n_u32(vshlq_n_u32(src, 24 - SK_B32_SHIFT), 24);
+}
+
+static inline uint32x4_t SkPackARGB32_neon(uint32x4_t a, uint32x4_t r,
+                                           uint32x4_t g, uint32x4_t b) {
+    uint32x4_t a1 = vshlq_n_u32(a, SK_A32_SHIFT);
+    uint32x4_t r1 = vshlq_n_u32(r, SK_R32_SHIFT);
+    uint32x4_t g1 = vshlq_n_u32(g, SK_G32_SHIFT);
+    uint32x4_t b1 = vshlq_n_u32(b, SK_B32_SHIFT);
+    return vorrq_u32(vorrq_u32(a1, r1), vorrq_u32(g1, b1));
+}
+
+// Signed comparisons, the intermediate products in the separable modes can
+// be negative
+static inline uint32x4_t SkCmpLT32_neon(uint32x4_t a, uint32x4_t b) {
+    return vcltq_s32(vreinterpretq_s32_u32(a), vreinterpretq_s32_u32(b));
+}
+
+static inline uint32x4_t SkCmpGT32_neon(uint32x4_t a, uint32x4_t b) {
+    return vcgtq_s32(vreinterpretq_s32_u32(a), vreinterpretq_s32_u32(b));
+}
+
+static inline uint32x4_t SkMin32_neon(uint32x4_t a, uint32x4_t b) {
+    return vbslq_u32(SkCmpLT32_neon(a, b), a, b);
+}
+
+static inline uint32x4_t SkDiv255Round_neon(uint32x4_t a) {
+    uint32x4_t prod = vaddq_u32(a, vdupq_n_u32(128));
+    prod = vaddq_u32(prod, vshrq_n_u32(prod, 8));
+    return vshrq_n_u32(prod, 8);
+}
+
+static inline uint32x4_t SkAlphaMulAlpha_neon(uint32x4_t a, uint32x4_t b) {
+    return SkDiv255Round_neon(vmulq_u32(a, b));
+}
+
+static inline uint32x4_t SkAlphaMulQ_neon(uint32x4_t c, uint32x4_t scale) {
+    const uint32x4_t mask = vdupq_n_u32(0xFF00FF);
+    uint32x4_t rb = vmulq_u32(vandq_u32(c, mask), scale);
+    rb = vandq_u32(vshrq_n_u32(rb, 8), mask);
+    uint32x4_t ag = vmulq_u32(vandq_u32(vshrq_n_u32(c, 8), mask), scale);
+    ag = vbicq_u32(ag, mask);
+    return vorrq_u32(rb, ag);
+}
+
+static inline uint32x4_t clamp_signed_byte_neon(uint32x4_t n) {
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t ret = vbicq_u32(n, SkCmpLT32_neon(n, zero));
+    uint32x4_t c255 = vdupq_n_u32(255);
+    return vbslq_u32(SkCmpGT32_neon(ret, c255), c255, ret);
+}
+
+static inline uint32x4_t clamp_div255round_neon(uint32x4_t prod) {
+    uint32x4_t ret = SkDiv255Round_neon(prod);
+    uint32x4_t cmp = SkCmpGT32_neon(prod, vdupq_n_u32(255 * 255 - 1));
+    ret = vbslq_u32(cmp, vdupq_n_u32(255), ret);
+    cmp = SkCmpGT32_neon(prod, vdupq_n_u32(0));
+    return vandq_u32(cmp, ret);
+}
+
+static inline uint32x4_t srcover_byte_neon(uint32x4_t a, uint32x4_t b) {
+    return vsubq_u32(vaddq_u32(a, b), SkAlphaMulAlpha_neon(a, b));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// These have external linkage so that they can be template arguments
+
+//  kDst_Mode,      //!< [Da, Dc]
+uint32x4_t dst_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    return dst;
+}
+
+//  kDstOver_Mode,  //!< [Sa + Da - Sa*Da, Dc + (1 - Da)*Sc]
+uint32x4_t dstover_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t scale = vsubq_u32(vdupq_n_u32(256), SkGetPackedA32_neon(dst));
+    return vaddq_u32(dst, SkAlphaMulQ_neon(src, scale));
+}
+
+//  kSrcIn_Mode,    //!< [Sa * Da, Sc * Da]
+uint32x4_t srcin_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t scale = vaddq_u32(SkGetPackedA32_neon(dst), vdupq_n_u32(1));
+    return SkAlphaMulQ_neon(src, scale);
+}
+
+//  kDstIn_Mode,    //!< [Sa * Da, Sa * Dc]
+uint32x4_t dstin_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t scale = vaddq_u32(SkGetPackedA32_neon(src), vdupq_n_u32(1));
+    return SkAlphaMulQ_neon(dst, scale);
+}
+
+//  kSrcOut_Mode,   //!< [Sa * (1 - Da), Sc * (1 - Da)]
+uint32x4_t srcout_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t scale = vsubq_u32(vdupq_n_u32(256), SkGetPackedA32_neon(dst));
+    return SkAlphaMulQ_neon(src, scale);
+}
+
+//  kDstOut_Mode,   //!< [Da * (1 - Sa), Dc * (1 - Sa)]
+uint32x4_t dstout_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t scale = vsubq_u32(vdupq_n_u32(256), SkGetPackedA32_neon(src));
+    return SkAlphaMulQ_neon(dst, scale);
+}
+
+// a1 * sc + a2 * dc for each of r, g and b, packed with a
+static inline uint32x4_t atop_neon(uint32x4_t src, uint32x4_t dst,
+                                   uint32x4_t a1, uint32x4_t a2, uint32x4_t a) {
+    uint32x4_t r = vaddq_u32(SkAlphaMulAlpha_neon(a1, SkGetPackedR32_neon(src)),
+                             SkAlphaMulAlpha_neon(a2, SkGetPackedR32_neon(dst)));
+    uint32x4_t g = vaddq_u32(SkAlphaMulAlpha_neon(a1, SkGetPackedG32_neon(src)),
+                             SkAlphaMulAlpha_neon(a2, SkGetPackedG32_neon(dst)));
+    uint32x4_t b = vaddq_u32(SkAlphaMulAlpha_neon(a1, SkGetPackedB32_neon(src)),
+                             SkAlphaMulAlpha_neon(a2, SkGetPackedB32_neon(dst)));
+    return SkPackARGB32_neon(a, r, g, b);
+}
+
+//  kSrcATop_Mode,  //!< [Da, Sc * Da + (1 - Sa) * Dc]
+uint32x4_t srcatop_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t sa = SkGetPackedA32_neon(src);
+    uint32x4_t da = SkGetPackedA32_neon(dst);
+    uint32x4_t isa = vsubq_u32(vdupq_n_u32(255), sa);
+    return atop_neon(src, dst, da, isa, da);
+}
+
+//  kDstATop_Mode,  //!< [Sa, Sa * Dc + Sc * (1 - Da)]
+uint32x4_t dstatop_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t sa = SkGetPackedA32_neon(src);
+    uint32x4_t da = SkGetPackedA32_neon(dst);
+    uint32x4_t ida = vsubq_u32(vdupq_n_u32(255), da);
+    return atop_neon(src, dst, ida, sa, sa);
+}
+
+//  kXor_Mode   [Sa + Da - 2 * Sa * Da, Sc * (1 - Da) + (1 - Sa) * Dc]
+uint32x4_t xor_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t sa = SkGetPackedA32_neon(src);
+    uint32x4_t da = SkGetPackedA32_neon(dst);
+    uint32x4_t isa = vsubq_u32(vdupq_n_u32(255), sa);
+    uint32x4_t ida = vsubq_u32(vdupq_n_u32(255), da);
+
+    uint32x4_t a = vsubq_u32(vaddq_u32(sa, da),
+                             vshlq_n_u32(SkAlphaMulAlpha_neon(sa, da), 1));
+    return atop_neon(src, dst, ida, isa, a);
+}
+
+// kPlus_Mode
+uint32x4_t plus_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    // saturated_add() on each byte
+    return vreinterpretq_u32_u8(vqaddq_u8(vreinterpretq_u8_u32(src),
+                                          vreinterpretq_u8_u32(dst)));
+}
+
+// kModulate_Mode
+uint32x4_t modulate_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t a = SkAlphaMulAlpha_neon(SkGetPackedA32_neon(src),
+                                        SkGetPackedA32_neon(dst));
+    uint32x4_t r = SkAlphaMulAlpha_neon(SkGetPackedR32_neon(src),
+                                        SkGetPackedR32_neon(dst));
+    uint32x4_t g = SkAlphaMulAlpha_neon(SkGetPackedG32_neon(src),
+                                        SkGetPackedG32_neon(dst));
+    uint32x4_t b = SkAlphaMulAlpha_neon(SkGetPackedB32_neon(src),
+                                        SkGetPackedB32_neon(dst));
+    return SkPackARGB32_neon(a, r, g, b);
+}
+
+// kScreen_Mode
+uint32x4_t screen_modeproc_neon(uint32x4_t src, uint32x4_t dst) {
+    uint32x4_t a = srcover_byte_neon(SkGetPackedA32_neon(src),
+                                     SkGetPackedA32_neon(dst));
+    uint32x4_t r = srcover_byte_neon(SkGetPackedR32_neon(src),
+                                     SkGetPackedR32_neon(dst));
+    uint32x4_t g = srcover_byte_neon(SkGetPackedG32_neon(src),
+                                     SkGetPackedG32_neon(dst));
+    uint32x4_t b = srcover_byte_neon(SkGetPackedB32_neon(src),
+                                     SkGetPackedB32_neon(dst));
+    return SkPackARGB32_neon(a, r, g, b);
+}
+
+// Applies a per component blend to r, g and b, with a = srcover_byte(sa, da)
+#define SEPARABLE_MODEPROC_NEON(name)                                         \
+    uint32x4_t name##_modeproc_neon(uint32x4_t src, uint32x4_t dst) {         \
+        uint32x4_t sa = SkGetPackedA32_neon(src);                             \
+        uint32x4_t da = SkGetPackedA32_neon(dst);                             \
+        uint32x4_t a = srcover_byte_neon(sa, da);                             \
+        uint32x4_t r = name##_byte_neon(SkGetPackedR32_neon(src),             \
+                                        SkGetPackedR32_neon(dst), sa, da);    \
+        uint32x4_t g = name##_byte_neon(SkGetPackedG32_neon(src),             \
+                                        SkGetPackedG32_neon(dst), sa, da);    \
+        uint32x4_t b = name##_byte_neon(SkGetPackedB32_neon(src),             \
+                                        SkGetPackedB32_neon(dst), sa, da);    \
+        return SkPackARGB32_neon(a, r, g, b);                                 \
+    }
+
+// sa * da - 2 * (da - dc) * (sa - sc), shared by overlay and hardlight
+static inline uint32x4_t overlay_high_neon(uint32x4_t sc, uint32x4_t dc,
+                                           uint32x4_t sa, uint32x4_t da) {
+    uint32x4_t tmp = vmulq_u32(vsubq_u32(da, dc), vsubq_u32(sa, sc));
+    return vsubq_u32(vmulq_u32(sa, da), vshlq_n_u32(tmp, 1));
+}
+
+// sc * (255 - da) + dc * (255 - sa)
+static inline uint32x4_t cross_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                         uint32x4_t sa, uint32x4_t da) {
+    const uint32x4_t c255 = vdupq_n_u32(255);
+    return vaddq_u32(vmulq_u32(sc, vsubq_u32(c255, da)),
+                     vmulq_u32(dc, vsubq_u32(c255, sa)));
+}
+
+// kOverlay_Mode
+static inline uint32x4_t overlay_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                           uint32x4_t sa, uint32x4_t da) {
+    uint32x4_t tmp = cross_byte_neon(sc, dc, sa, da);
+    // 2 * dc <= da
+    uint32x4_t cmp = SkCmpGT32_neon(vshlq_n_u32(dc, 1), da);
+    uint32x4_t rc = vbslq_u32(cmp, overlay_high_neon(sc, dc, sa, da),
+                              vshlq_n_u32(vmulq_u32(sc, dc), 1));
+    return clamp_div255round_neon(vaddq_u32(rc, tmp));
+}
+SEPARABLE_MODEPROC_NEON(overlay)
+
+// kDarken_Mode
+static inline uint32x4_t darken_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                          uint32x4_t sa, uint32x4_t da) {
+    uint32x4_t sd = vmulq_u32(sc, da);
+    uint32x4_t ds = vmulq_u32(dc, sa);
+    // sd < ds ? srcover : dstover
+    uint32x4_t cmp = SkCmpLT32_neon(sd, ds);
+    return vsubq_u32(vaddq_u32(sc, dc),
+                     SkDiv255Round_neon(vbslq_u32(cmp, ds, sd)));
+}
+SEPARABLE_MODEPROC_NEON(darken)
+
+// kLighten_Mode
+static inline uint32x4_t lighten_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                           uint32x4_t sa, uint32x4_t da) {
+    uint32x4_t sd = vmulq_u32(sc, da);
+    uint32x4_t ds = vmulq_u32(dc, sa);
+    // sd > ds ? srcover : dstover
+    uint32x4_t cmp = SkCmpGT32_neon(sd, ds);
+    return vsubq_u32(vaddq_u32(sc, dc),
+                     SkDiv255Round_neon(vbslq_u32(cmp, ds, sd)));
+}
+SEPARABLE_MODEPROC_NEON(lighten)
+
+// kHardLight_Mode
+static inline uint32x4_t hardlight_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                             uint32x4_t sa, uint32x4_t da) {
+    // 2 * sc <= sa
+    uint32x4_t cmp = SkCmpGT32_neon(vshlq_n_u32(sc, 1), sa);
+    uint32x4_t rc = vbslq_u32(cmp, overlay_high_neon(sc, dc, sa, da),
+                              vshlq_n_u32(vmulq_u32(sc, dc), 1));
+    uint32x4_t tmp = cross_byte_neon(sc, dc, sa, da);
+    return clamp_div255round_neon(vaddq_u32(rc, tmp));
+}
+SEPARABLE_MODEPROC_NEON(hardlight)
+
+// kDifference_Mode
+static inline uint32x4_t difference_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                              uint32x4_t sa, uint32x4_t da) {
+    uint32x4_t tmp = SkMin32_neon(vmulq_u32(sc, da), vmulq_u32(dc, sa));
+    uint32x4_t diff = vsubq_u32(vaddq_u32(sc, dc),
+                                vshlq_n_u32(SkDiv255Round_neon(tmp), 1));
+    return clamp_signed_byte_neon(diff);
+}
+SEPARABLE_MODEPROC_NEON(difference)
+
+// kExclusion_Mode
+static inline uint32x4_t exclusion_byte_neon(uint32x4_t sc, uint32x4_t dc,
+                                             uint32x4_t sa, uint32x4_t da) {
+    uint32x4_t r = vaddq_u32(vmulq_u32(sc, da), vmulq_u32(dc, sa));
+    r = vsubq_u32(r, vshlq_n_u32(vmulq_u32(sc, dc), 1));
+    r = vaddq_u32(r, cross_byte_neon(sc, dc, sa, da));
+    return clamp_div255round_neon(r);
+}
+SEPARABLE_MODEPROC_NEON(exclusion)
+
+///////////////////////////////////////////////////////////////////////////////
+
+// SkFourByteInterp(src, dst, aa) for aa in [1..255], computed as
+// (src * scale + dst * (256 - scale)) >> 8 which is the same value
+static inline uint32x4_t SkFourByteInterp_neon(uint32x4_t src, uint32x4_t dst,
+                                               uint32x4_t aa) {
+    uint32x4_t scale = vaddq_u32(aa, vdupq_n_u32(1));
+    uint32x4_t iscale = vsubq_u32(vdupq_n_u32(256), scale);
+#define INTERP_COMPONENT_NEON(C)                                              \
+    vshrq_n_u32(vaddq_u32(vmulq_u32(SkGetPacked##C##32_neon(src), scale),     \
+                          vmulq_u32(SkGetPacked##C##32_neon(dst), iscale)), 8)
+    uint32x4_t a = INTERP_COMPONENT_NEON(A);
+    uint32x4_t r = INTERP_COMPONENT_NEON(R);
+    uint32x4_t g = INTERP_COMPONENT_NEON(G);
+    uint32x4_t b = INTERP_COMPONENT_NEON(B);
+#undef INTERP_COMPONENT_NEON
+    return SkPackARGB32_neon(a, r, g, b);
+}
+
+typedef uint32x4_t (*ModeProc_neon)(uint32x4_t src, uint32x4_t dst);
+
+template <ModeProc_neon proc>
+void xfer32_neon(SkPMColor dst[], const SkPMColor src[], int count,
+                 const SkAlpha aa[], SkXfermodeProc proc1) {
+    if (NULL == aa) {
+        while (count >= 4) {
+            uint32x4_t s = vld1q_u32(src);
+            uint32x4_t d = vld1q_u32(dst);
+            vst1q_u32(dst, proc(s, d));
+            src += 4;
+            dst += 4;
+            count -= 4;
+        }
+        for (int i = count - 1; i >= 0; --i) {
+            dst[i] = proc1(src[i], dst[i]);
+        }
+    } else {
+        while (count >= 4) {
+            if (aa[0] | aa[1] | aa[2] | aa[3]) {
+                uint32x4_t a = vdupq_n_u32(0);
+                a = vsetq_lane_u32(aa[0], a, 0);
+                a = vsetq_lane_u32(aa[1], a, 1);
+                a = vsetq_lane_u32(aa[2], a, 2);
+                a = vsetq_lane_u32(aa[3], a, 3);
+                uint32x4_t s = vld1q_u32(src);
+                uint32x4_t d = vld1q_u32(dst);
+                uint32x4_t c = SkFourByteInterp_neon(proc(s, d), d, a);
+                // aa == 0 leaves dst alone
+                uint32x4_t zero = vceqq_u32(a, vdupq_n_u32(0));
+                vst1q_u32(dst, vbslq_u32(zero, d, c));
+            }
+            src += 4;
+            dst += 4;
+            aa += 4;
+            count -= 4;
+        }
+        for (int i = count - 1; i >= 0; --i) {
+            unsigned a = aa[i];
+            if (0 != a) {
+                SkPMColor dstC = dst[i];
+                SkPMColor C = proc1(src[i], dstC);
+                if (a != 0xFF) {
+                    C = SkFourByteInterp(C, dstC, a);
+                }
+                dst[i] = C;
+            }
+        }
+    }
+}
+
+static const SkXfermodeProcSIMD gNEONXfermodeProcs[] = {
+    NULL,                           // kClear_Mode, see SkClearXfermode
+    NULL,                           // kSrc_Mode, see SkSrcXfermode
+    xfer32_neon<dst_modeproc_neon>,
+    NULL,                           // kSrcOver_Mode, see SkBlitRow
+    xfer32_neon<dstover_modeproc_neon>,
+    xfer32_neon<srcin_modeproc_neon>,
+    xfer32_neon<dstin_modeproc_neon>,
+    xfer32_neon<srcout_modeproc_neon>,
+    xfer32_neon<dstout_modeproc_neon>,
+    xfer32_neon<srcatop_modeproc_neon>,
+    xfer32_neon<dstatop_modeproc_neon>,
+    xfer32_neon<xor_modeproc_neon>,
+
+    xfer32_neon<plus_modeproc_neon>,
+    xfer32_neon<modulate_modeproc_neon>,
+    xfer32_neon<screen_modeproc_neon>,
+    xfer32_neon<overlay_modeproc_neon>,
+    xfer32_neon<darken_modeproc_neon>,
+    xfer32_neon<lighten_modeproc_neon>,
+    NULL,                           // kColorDodge_Mode
+    NULL,                           // kColorBurn_Mode
+    xfer32_neon<hardlight_modeproc_neon>,
+    NULL,                           // kSoftLight_Mode
+    xfer32_neon<difference_modeproc_neon>,
+    xfer32_neon<exclusion_modeproc_neon>,
+};
+
+SkXfermodeProcSIMD SkPlatformXfermodeProcSIMD_neon(SkXfermode::Mode mode) {
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(gNEONXfermodeProcs) == SkXfermode::kLastMode + 1,
+                      mode_count_neon);
+    SkASSERT((unsigned)mode <= SkXfermode::kLastMode);
+    return gNEONXfermodeProcs[mode];
+}
@@ -0,0 +1,15 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_arm_neon_DEFINED
+#define SkXfermode_opts_arm_neon_DEFINED
+
+#include "SkXfermode_opts.h"
+
+SkXfermodeProcSIMD SkPlatformXfermodeProcSIMD_neon(SkXfermode::Mode mode);
+
+#endif
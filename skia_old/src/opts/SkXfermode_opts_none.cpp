@@ -0,0 +1,12 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts.h"
+
+SkXfermodeProcSIMD SkPlatformXfermodeProcSIMD(SkXfermode::Mode mode) {
+    return NULL;
+}
@@ -12,6 +12,7 @@
 #include "SkBlitRect_opts_SSE2.h"
 #include "SkBlitRow_opts_SSE2.h"
 #include "SkUtils_opts_SSE2.h"
+#include "SkXfermode_opts_SSE2.h"
 #include "SkUtils.h"
 
 #if defined(_MSC_VER) && defined(_WIN64)
@@ -244,3 +245,11 @@ SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
         return NULL;
     }
 }
+
+SkXfermodeProcSIMD SkPlatformXfermodeProcSIMD(SkXfermode::Mode mode) {
+    if (cachedHasSSE2()) {
+        return SkPlatformXfermodeProcSIMD_SSE2(mode);
+    } else {
+        return NULL;
+    }
+}
@@ -6,6 +6,7 @@
  * found in the LICENSE file.
  */
 #include "Test.h"
+#include "SkBlurMask.h"
 #include "SkBlurMaskFilter.h"
 #include "SkCanvas.h"
 #include "SkMath.h"
@@ -158,5 +159,76 @@ static void test_blur(skiatest::Reporter* reporter) {
     }
 }
 
+static void fill_mask(SkMask* mask, int w, int h, uint32_t seed) {
+    mask->fBounds.set(10, 20, 10 + w, 20 + h);
+    mask->fFormat = SkMask::kA8_Format;
+    mask->fRowBytes = w;
+    mask->fImage = SkMask::AllocImage(mask->computeImageSize());
+    SkRandom rand(seed);
+    for (size_t i = 0; i < mask->computeImageSize(); ++i) {
+        mask->fImage[i] = rand.nextU() & 0xFF;
+    }
+}
+
+static bool masks_equal(const SkMask& a, const SkMask& b) {
+    if (a.fBounds != b.fBounds || a.fRowBytes != b.fRowBytes) {
+        return false;
+    }
+    for (int y = 0; y < a.fBounds.height(); ++y) {
+        if (memcmp(a.getAddr8(a.fBounds.fLeft, a.fBounds.fTop + y),
+                   b.getAddr8(b.fBounds.fLeft, b.fBounds.fTop + y),
+                   a.fBounds.width())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Blurring the same mask twice hits SkBlurMask's cache, which must hand back
+// exactly what blurring from scratch does, and must not confuse two masks
+// that only share their bounds.
+static void test_blur_cache(skiatest::Reporter* reporter) {
+    SkMask srcA, srcB;
+    fill_mask(&srcA, 64, 48, 1);
+    fill_mask(&srcB, 64, 48, 2);
+
+    const size_t limit = SkBlurMask::GetCacheLimit();
+    const SkScalar radius = SkIntToScalar(6);
+
+    for (int style = 0; style < SkBlurMask::kStyleCount; ++style) {
+        for (int q = 0; q <= SkBlurMask::kHigh_Quality; ++q) {
+            SkBlurMask::Style s = static_cast<SkBlurMask::Style>(style);
+            SkBlurMask::Quality quality = static_cast<SkBlurMask::Quality>(q);
+            SkMask uncached, first, second, other;
+            SkIPoint margin0, margin1, margin2;
+
+            SkBlurMask::SetCacheLimit(0);
+            SkBlurMask::BlurSeparable(&uncached, srcA, radius, s, quality, &margin0);
+            SkBlurMask::SetCacheLimit(limit);
+            SkBlurMask::BlurSeparable(&first, srcA, radius, s, quality, &margin1);
+            SkBlurMask::BlurSeparable(&second, srcA, radius, s, quality, &margin2);
+            SkBlurMask::BlurSeparable(&other, srcB, radius, s, quality, NULL);
+
+            REPORTER_ASSERT(reporter, masks_equal(uncached, first));
+            REPORTER_ASSERT(reporter, masks_equal(first, second));
+            REPORTER_ASSERT(reporter, margin0 == margin1 && margin1 == margin2);
+            REPORTER_ASSERT(reporter, !masks_equal(first, other));
+
+            SkMask::FreeImage(uncached.fImage);
+            SkMask::FreeImage(first.fImage);
+            SkMask::FreeImage(second.fImage);
+            SkMask::FreeImage(other.fImage);
+        }
+    }
+
+    SkMask::FreeImage(srcA.fImage);
+    SkMask::FreeImage(srcB.fImage);
+}
+
+static void TestBlur(skiatest::Reporter* reporter) {
+    test_blur(reporter);
+    test_blur_cache(reporter);
+}
+
 #include "TestClassDef.h"
-DEFINE_TESTCLASS("BlurMaskFilter", BlurTestClass, test_blur)
+DEFINE_TESTCLASS("BlurMaskFilter", BlurTestClass, TestBlur)
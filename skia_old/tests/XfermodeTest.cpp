@@ -7,6 +7,8 @@
  */
 #include "Test.h"
 #include "SkColor.h"
+#include "SkColorPriv.h"
+#include "SkRandom.h"
 #include "SkXfermode.h"
 
 static SkPMColor bogusXfermodeProc(SkPMColor src, SkPMColor dst) {
@@ -63,9 +65,68 @@ static void test_IsMode(skiatest::Reporter* reporter) {
     }
 }
 
+static SkPMColor random_pmcolor(SkRandom& rand) {
+    unsigned a = rand.nextU() & 0xFF;
+    // mostly opaque and clear pixels, as in real content
+    switch (rand.nextU() & 7) {
+        case 0: a = 0; break;
+        case 1: a = 0xFF; break;
+    }
+    return SkPackARGB32(a, rand.nextRangeU(0, a), rand.nextRangeU(0, a),
+                        rand.nextRangeU(0, a));
+}
+
+// The modes' xfer32 may blend several pixels at a time (see src/opts), it has
+// to give exactly what blending one pixel at a time with the mode's proc does.
+static void test_xfer32(skiatest::Reporter* reporter) {
+    static const int kMaxCount = 67;
+    SkPMColor src[kMaxCount], dst[kMaxCount], expected[kMaxCount];
+    SkAlpha aa[kMaxCount];
+    SkRandom rand;
+
+    // kClear_Mode and kSrc_Mode have their own xfer32, which rounds
+    // differently under coverage, and kSrcOver_Mode has no SkXfermode
+    for (int i = SkXfermode::kDst_Mode; i <= SkXfermode::kLastMode; ++i) {
+        SkXfermode::Mode mode = (SkXfermode::Mode)i;
+        if (SkXfermode::kSrcOver_Mode == mode) {
+            continue;
+        }
+        SkXfermode* xfer = SkXfermode::Create(mode);
+        SkProcXfermode reference(SkXfermode::GetProc(mode));
+
+        for (int count = 1; count <= kMaxCount; count += 3) {
+            for (int useAA = 0; useAA <= 1; ++useAA) {
+                for (int j = 0; j < count; ++j) {
+                    src[j] = random_pmcolor(rand);
+                    dst[j] = expected[j] = random_pmcolor(rand);
+                    aa[j] = rand.nextU() & 0xFF;
+                    if (0 == (rand.nextU() & 3)) {
+                        aa[j] = (rand.nextU() & 1) ? 0xFF : 0;
+                    }
+                }
+                const SkAlpha* coverage = useAA ? aa : NULL;
+                xfer->xfer32(dst, src, count, coverage);
+                reference.xfer32(expected, src, count, coverage);
+
+                for (int j = 0; j < count; ++j) {
+                    if (dst[j] != expected[j]) {
+                        SkString str;
+                        str.printf("xfer32 mode %d pixel %d of %d: %08x != %08x",
+                                   i, j, count, dst[j], expected[j]);
+                        reporter->reportFailed(str);
+                        break;
+                    }
+                }
+            }
+        }
+        xfer->unref();
+    }
+}
+
 static void test_xfermodes(skiatest::Reporter* reporter) {
     test_asMode(reporter);
     test_IsMode(reporter);
+    test_xfer32(reporter);
 }
 
 #include "TestClassDef.h"
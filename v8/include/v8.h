@@ -533,6 +533,19 @@ class V8EXPORT ScriptData {  // NOLINT
    */
   static ScriptData* PreCompile(Handle<String> source);
 
+  /**
+   * Pre-compiles the specified script (context-independent) without using
+   * any isolate, so that it can be called on any thread.
+   *
+   * \param input Pointer to UTF-16 script source code.
+   * \param length Length of the source code in UTF-16 code units.
+   * \param max_stack_size The amount of stack space the preparser may use.
+   * Returns NULL if the preparser ran out of stack.
+   */
+  static ScriptData* PreCompile(const uint16_t* input,
+                                int length,
+                                size_t max_stack_size);
+
   /**
    * Load previous pre-compilation data.
    *
@@ -1449,6 +1449,18 @@ ScriptData* ScriptData::PreCompile(v8::Handle<String> source) {
 }
 
 
+ScriptData* ScriptData::PreCompile(const uint16_t* input,
+                                   int length,
+                                   size_t max_stack_size) {
+  i::Utf16ArrayCharacterStream stream(input, length);
+  uintptr_t stack_limit =
+      reinterpret_cast<uintptr_t>(&stream) - max_stack_size;
+  return i::ParserApi::PreParseOnAnyThread(&stream,
+                                           i::FLAG_harmony_scoping,
+                                           stack_limit);
+}
+
+
 ScriptData* ScriptData::New(const char* data, int length) {
   // Return an empty ScriptData if the length is obviously invalid.
   if (length % sizeof(unsigned) != 0) {
@@ -613,6 +613,7 @@ bool Compiler::CompileLazy(CompilationInfo* info) {
   Handle<SharedFunctionInfo> shared = info->shared_info();
   int compiled_size = shared->end_position() - shared->start_position();
   isolate->counters()->total_compile_size()->Increment(compiled_size);
+  isolate->counters()->lazy_compiles()->Increment();
 
   // Generate the AST for the lazily compiled function.
   if (ParserApi::Parse(info, kNoParsingFlags)) {
@@ -5953,6 +5953,30 @@ ScriptDataImpl* ParserApi::PreParse(Utf16CharacterStream* source,
 }
 
 
+ScriptDataImpl* ParserApi::PreParseOnAnyThread(Utf16CharacterStream* source,
+                                               int flags,
+                                               uintptr_t stack_limit) {
+  if (FLAG_lazy) {
+    flags |= kAllowLazy;
+  }
+  UnicodeCache unicode_cache;
+  Scanner scanner(&unicode_cache);
+  scanner.SetHarmonyScoping(FLAG_harmony_scoping);
+  scanner.Initialize(source);
+  CompleteParserRecorder recorder;
+  preparser::PreParser::PreParseResult result =
+      preparser::PreParser::PreParseProgram(&scanner,
+                                            &recorder,
+                                            flags,
+                                            stack_limit);
+  if (result == preparser::PreParser::kPreParseStackOverflow) {
+    return NULL;
+  }
+  Vector<unsigned> store = recorder.ExtractData();
+  return new ScriptDataImpl(store);
+}
+
+
 bool RegExpParser::ParseRegExp(FlatStringReader* input,
                                bool multiline,
                                RegExpCompileData* result) {
@@ -181,6 +181,13 @@ class ParserApi {
   static ScriptDataImpl* PartialPreParse(Handle<String> source,
                                          v8::Extension* extension,
                                          int flags);
+
+  // Generic preparser generating full preparse data that does not use the
+  // current isolate, so it can run on any thread. Returns NULL if the
+  // stack limit is hit.
+  static ScriptDataImpl* PreParseOnAnyThread(Utf16CharacterStream* source,
+                                             int flags,
+                                             uintptr_t stack_limit);
 };
 
 // ----------------------------------------------------------------------------
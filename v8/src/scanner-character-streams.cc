@@ -320,4 +320,20 @@ ExternalTwoByteStringUtf16CharacterStream
   pos_ = start_position;
 }
 
+
+// ----------------------------------------------------------------------------
+// Utf16ArrayCharacterStream
+
+Utf16ArrayCharacterStream::~Utf16ArrayCharacterStream() { }
+
+
+Utf16ArrayCharacterStream::Utf16ArrayCharacterStream(const uc16* data,
+                                                     int length)
+    : Utf16CharacterStream(),
+      raw_data_(data) {
+  buffer_cursor_ = raw_data_;
+  buffer_end_ = raw_data_ + length;
+  pos_ = 0;
+}
+
 } }  // namespace v8::internal
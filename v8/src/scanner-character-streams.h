@@ -124,6 +124,31 @@ class ExternalTwoByteStringUtf16CharacterStream: public Utf16CharacterStream {
   const uc16* raw_data_;  // Pointer to the actual array of characters.
 };
 
+
+// UTF16 buffer to read characters from an array outside the V8 heap.
+class Utf16ArrayCharacterStream: public Utf16CharacterStream {
+ public:
+  Utf16ArrayCharacterStream(const uc16* data, int length);
+  virtual ~Utf16ArrayCharacterStream();
+
+  virtual void PushBack(uc32 character) {
+    ASSERT(buffer_cursor_ > raw_data_);
+    buffer_cursor_--;
+    pos_--;
+  }
+
+ protected:
+  virtual unsigned SlowSeekForward(unsigned delta) {
+    // Fast case always handles seeking.
+    return 0;
+  }
+  virtual bool ReadBlock() {
+    // Entire array is read at start.
+    return false;
+  }
+  const uc16* raw_data_;  // Pointer to the actual array of characters.
+};
+
 } }  // namespace v8::internal
 
 #endif  // V8_SCANNER_CHARACTER_STREAMS_H_
@@ -96,6 +96,7 @@ LOCAL_C_INCLUDES := \
 	external/icu/icu4c/source/common \
 	external/icu/icu4c/source/i18n \
 	external/jpeg \
+	external/libpng \
 	external/libxml2/include \
 	external/hyphenation \
 	external/sqlite/dist \
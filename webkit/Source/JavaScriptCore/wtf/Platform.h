@@ -738,6 +738,8 @@
 #define ENABLE_LINK_PREFETCH 1
 #define ENABLE_WEB_TIMING 1
 #define ENABLE_MEDIA_CAPTURE 1
+// Dead cache resources are kept in unpinned ashmem (see PurgeableBufferAndroid.cpp)
+#define ENABLE_PURGEABLE_MEMORY 1
 
 // Android ENABLE guards not present upstream
 #define ENABLE_COMPOSITED_FIXED_ELEMENTS 1 // FIXME: Rename to ENABLE_ANDROID_COMPOSITED_FIXED_ELEMENTS
@@ -781,6 +783,25 @@
 #define ANDROID_ANIMATED_GIF
 // apple-touch-icon support in <link> tags
 #define ANDROID_APPLE_TOUCH_ICON
+// Share styles between matching elements anywhere in the document, not only
+// between siblings and cousins (see CSSStyleSelector::canUseSharedStyleCache)
+#define ANDROID_SHARED_STYLE_CACHE
+// Cache the Harfbuzz output for complex script runs (see ShapedRunCache in
+// FontAndroid.cpp)
+#define ANDROID_SHAPED_RUN_CACHE
+// Preparse downloaded scripts on a background thread (see V8ScriptPreparser)
+#define ANDROID_BACKGROUND_PREPARSE
+// Keep compiled scripts on their CachedScript (see V8CompiledScript)
+#define ANDROID_COMPILED_SCRIPT_CACHE
+// Decode images on a worker ahead of their first draw (see ImageDecodeQueue)
+#define ANDROID_BACKGROUND_IMAGE_DECODE
+// Show JPEGs and PNGs while they load (see ImageSourceAndroid.cpp)
+#define ANDROID_PROGRESSIVE_IMAGE_DECODE
+// Subsample decoded images to their displayed size once the decoded image
+// budget is used up (see ImageSourceAndroid.cpp)
+#define ANDROID_DECODED_IMAGE_BUDGET
+// Allocate nodes and styles from per document slabs (see DocumentArena)
+#define ANDROID_DOCUMENT_ARENA
 
 // This is present in JavaScriptCore/config.h, which Android does not use.
 #define WTF_CHANGES 1
@@ -93,6 +93,14 @@ struct CStringTranslator {
     static bool equal(StringImpl* r, const char* s)
     {
         int length = r->length();
+        if (r->is8Bit()) {
+            const LChar* d = r->characters8();
+            for (int i = 0; i != length; ++i) {
+                if (d[i] != static_cast<unsigned char>(s[i]))
+                    return false;
+            }
+            return !s[length];
+        }
         const UChar* d = r->characters();
         for (int i = 0; i != length; ++i) {
             unsigned char c = s[i];
@@ -113,9 +121,9 @@ struct CStringTranslator {
 bool operator==(const AtomicString& a, const char* b)
 { 
     StringImpl* impl = a.impl();
-    if ((!impl || !impl->characters()) && !b)
+    if (!impl && !b)
         return true;
-    if ((!impl || !impl->characters()) || !b)
+    if (!impl || !b)
         return false;
     return CStringTranslator::equal(impl, b); 
 }
@@ -140,10 +148,13 @@ static inline bool equal(StringImpl* string, const UChar* characters, unsigned l
     if (string->length() != length)
         return false;
 
+    if (string->is8Bit())
+        return WTF::equal(string->characters8(), characters, length);
+
     // FIXME: perhaps we should have a more abstract macro that indicates when
     // going 4 bytes at a time is unsafe
 #if CPU(ARM) || CPU(SH4) || CPU(MIPS) || CPU(SPARC)
-    const UChar* stringCharacters = string->characters();
+    const UChar* stringCharacters = string->characters16();
     for (unsigned i = 0; i != length; ++i) {
         if (*stringCharacters++ != *characters++)
             return false;
@@ -152,7 +163,7 @@ static inline bool equal(StringImpl* string, const UChar* characters, unsigned l
 #else
     /* Do it 4-bytes-at-a-time on architectures where it's safe */
 
-    const uint32_t* stringCharacters = reinterpret_cast<const uint32_t*>(string->characters());
+    const uint32_t* stringCharacters = reinterpret_cast<const uint32_t*>(string->characters16());
     const uint32_t* bufferCharacters = reinterpret_cast<const uint32_t*>(characters);
 
     unsigned halfLength = length >> 1;
@@ -185,6 +196,34 @@ struct UCharBufferTranslator {
     }
 
     static void translate(StringImpl*& location, const UCharBuffer& buf, unsigned hash)
+    {
+        location = StringImpl::create8BitIfPossible(buf.s, buf.length).leakRef();
+        location->setHash(hash);
+        location->setIsAtomic(true);
+    }
+};
+
+struct LCharBuffer {
+    const LChar* s;
+    unsigned length;
+};
+
+struct LCharBufferTranslator {
+    static unsigned hash(const LCharBuffer& buf)
+    {
+        return StringHasher::computeHash(buf.s, buf.length);
+    }
+
+    static bool equal(StringImpl* const& str, const LCharBuffer& buf)
+    {
+        if (str->length() != buf.length)
+            return false;
+        if (str->is8Bit())
+            return WTF::equal(str->characters8(), buf.s, buf.length);
+        return WTF::equal(str->characters16(), buf.s, buf.length);
+    }
+
+    static void translate(StringImpl*& location, const LCharBuffer& buf, unsigned hash)
     {
         location = StringImpl::create(buf.s, buf.length).leakRef();
         location->setHash(hash);
@@ -212,7 +251,7 @@ struct HashAndCharactersTranslator {
 
     static void translate(StringImpl*& location, const HashAndCharacters& buffer, unsigned hash)
     {
-        location = StringImpl::create(buffer.characters, buffer.length).leakRef();
+        location = StringImpl::create8BitIfPossible(buffer.characters, buffer.length).leakRef();
         location->setHash(hash);
         location->setIsAtomic(true);
     }
@@ -236,6 +275,9 @@ struct HashAndUTF8CharactersTranslator {
         if (buffer.utf16Length != string->length())
             return false;
 
+        if (string->is8Bit() && buffer.utf16Length == buffer.length)
+            return WTF::equal(string->characters8(), reinterpret_cast<const LChar*>(buffer.characters), buffer.length);
+
         const UChar* stringCharacters = string->characters();
 
         // If buffer contains only ASCII characters UTF-8 and UTF16 length are the same.
@@ -253,6 +295,13 @@ struct HashAndUTF8CharactersTranslator {
 
     static void translate(StringImpl*& location, const HashAndUTF8Characters& buffer, unsigned hash)
     {
+        if (buffer.utf16Length == buffer.length) {
+            location = StringImpl::create(reinterpret_cast<const LChar*>(buffer.characters), buffer.length).leakRef();
+            location->setHash(hash);
+            location->setIsAtomic(true);
+            return;
+        }
+
         UChar* target;
         location = StringImpl::createUninitialized(buffer.utf16Length, target).releaseRef();
 
@@ -265,6 +314,18 @@ struct HashAndUTF8CharactersTranslator {
     }
 };
 
+PassRefPtr<StringImpl> AtomicString::add(const LChar* s, unsigned length)
+{
+    if (!s)
+        return 0;
+
+    if (!length)
+        return StringImpl::empty();
+
+    LCharBuffer buffer = { s, length };
+    return addToStringTable<LCharBuffer, LCharBufferTranslator>(buffer);
+}
+
 PassRefPtr<StringImpl> AtomicString::add(const UChar* s, unsigned length)
 {
     if (!s)
@@ -62,7 +62,7 @@ void StringBuilder::resize(unsigned newSize)
     // If there is a buffer, we only need to duplicate it if it has more than one ref.
     if (m_buffer) {
         if (!m_buffer->hasOneRef())
-            allocateBuffer(m_buffer->characters(), m_buffer->length());
+            reallocateBuffer(m_buffer->length());
         m_length = newSize;
         m_string = String();
         return;
@@ -81,32 +81,72 @@ void StringBuilder::reserveCapacity(unsigned newCapacity)
     if (m_buffer) {
         // If there is already a buffer, then grow if necessary.
         if (newCapacity > m_buffer->length())
-            allocateBuffer(m_buffer->characters(), newCapacity);
+            reallocateBuffer(newCapacity);
     } else {
         // Grow the string, if necessary.
         if (newCapacity > m_length)
-            allocateBuffer(m_string.characters(), newCapacity);
+            reallocateBuffer(newCapacity);
     }
 }
 
 // Allocate a new buffer, copying in currentCharacters (these may come from either m_string
 // or m_buffer,  neither will be reassigned until the copy has completed).
+void StringBuilder::allocateBuffer(const LChar* currentCharacters, unsigned requiredLength)
+{
+    // Copy the existing data into a new buffer, set result to point to the end of the existing data.
+    RefPtr<StringImpl> buffer = StringImpl::createUninitialized(requiredLength, m_bufferCharacters8);
+    memcpy(m_bufferCharacters8, currentCharacters, static_cast<size_t>(m_length) * sizeof(LChar)); // This can't overflow.
+
+    // Update the builder state.
+    m_buffer = buffer.release();
+    m_string = String();
+    m_is8Bit = true;
+}
+
 void StringBuilder::allocateBuffer(const UChar* currentCharacters, unsigned requiredLength)
 {
     // Copy the existing data into a new buffer, set result to point to the end of the existing data.
-    RefPtr<StringImpl> buffer = StringImpl::createUninitialized(requiredLength, m_bufferCharacters);
-    memcpy(m_bufferCharacters, currentCharacters, static_cast<size_t>(m_length) * sizeof(UChar)); // This can't overflow.
+    RefPtr<StringImpl> buffer = StringImpl::createUninitialized(requiredLength, m_bufferCharacters16);
+    memcpy(m_bufferCharacters16, currentCharacters, static_cast<size_t>(m_length) * sizeof(UChar)); // This can't overflow.
 
     // Update the builder state.
     m_buffer = buffer.release();
     m_string = String();
+    m_is8Bit = false;
 }
 
-// Make 'length' additional capacity be available in m_buffer, update m_string & m_length,
+// Allocate a new 16-bit buffer, widening the 8-bit currentCharacters into it.
+void StringBuilder::allocateBufferUpConvert(const LChar* currentCharacters, unsigned requiredLength)
+{
+    ASSERT(m_is8Bit);
+    RefPtr<StringImpl> buffer = StringImpl::createUninitialized(requiredLength, m_bufferCharacters16);
+    StringImpl::copyChars(m_bufferCharacters16, currentCharacters, m_length);
+
+    m_buffer = buffer.release();
+    m_string = String();
+    m_is8Bit = false;
+}
+
+// Reallocate the buffer, or allocate one for the contents of m_string, at the current width.
+void StringBuilder::reallocateBuffer(unsigned requiredLength)
+{
+    if (m_buffer) {
+        if (m_is8Bit)
+            allocateBuffer(m_buffer->characters8(), requiredLength);
+        else
+            allocateBuffer(m_buffer->characters16(), requiredLength);
+    } else if (m_is8Bit)
+        allocateBuffer(m_length ? m_string.impl()->characters8() : 0, requiredLength);
+    else
+        allocateBuffer(m_string.characters(), requiredLength);
+}
+
+// Make 'length' additional capacity be available in the 8-bit m_buffer, update m_string & m_length,
 // return a pointer to the newly allocated storage.
-UChar* StringBuilder::appendUninitialized(unsigned length)
+LChar* StringBuilder::appendUninitialized8(unsigned length)
 {
     ASSERT(length);
+    ASSERT(m_is8Bit);
 
     // Calcuate the new size of the builder after appending.
     unsigned requiredLength = length + m_length;
@@ -122,17 +162,59 @@ UChar* StringBuilder::appendUninitialized(unsigned length)
             unsigned currentLength = m_length;
             m_string = String();
             m_length = requiredLength;
-            return m_bufferCharacters + currentLength;
+            return m_bufferCharacters8 + currentLength;
         }
 
         // We need to realloc the buffer.
-        allocateBuffer(m_buffer->characters(), std::max(requiredLength, m_buffer->length() * 2));
+        reallocateBuffer(std::max(requiredLength, m_buffer->length() * 2));
     } else {
         ASSERT(m_string.length() == m_length);
-        allocateBuffer(m_string.characters(), std::max(requiredLength, requiredLength * 2));
+        reallocateBuffer(std::max(requiredLength, requiredLength * 2));
     }
 
-    UChar* result = m_bufferCharacters + m_length;
+    LChar* result = m_bufferCharacters8 + m_length;
+    m_length = requiredLength;
+    return result;
+}
+
+// Make 'length' additional capacity be available in the 16-bit m_buffer, widening the
+// contents first if they are 8-bit, update m_string & m_length, return a pointer to the
+// newly allocated storage.
+UChar* StringBuilder::appendUninitialized16(unsigned length)
+{
+    ASSERT(length);
+
+    // Calcuate the new size of the builder after appending.
+    unsigned requiredLength = length + m_length;
+    if (requiredLength < length)
+        CRASH();
+
+    if (m_buffer) {
+        // If the buffer is valid it must be at least as long as the current builder contents!
+        ASSERT(m_buffer->length() >= m_length);
+
+        if (m_is8Bit) {
+            unsigned newLength = requiredLength <= m_buffer->length() ? m_buffer->length() : std::max(requiredLength, m_buffer->length() * 2);
+            allocateBufferUpConvert(m_buffer->characters8(), newLength);
+        } else if (requiredLength <= m_buffer->length()) {
+            // Check if the buffer already has sufficient capacity.
+            unsigned currentLength = m_length;
+            m_string = String();
+            m_length = requiredLength;
+            return m_bufferCharacters16 + currentLength;
+        } else {
+            // We need to realloc the buffer.
+            allocateBuffer(m_buffer->characters16(), std::max(requiredLength, m_buffer->length() * 2));
+        }
+    } else {
+        ASSERT(m_string.length() == m_length);
+        if (m_is8Bit)
+            allocateBufferUpConvert(m_length ? m_string.impl()->characters8() : 0, std::max(requiredLength, requiredLength * 2));
+        else
+            allocateBuffer(m_string.characters(), std::max(requiredLength, requiredLength * 2));
+    }
+
+    UChar* result = m_bufferCharacters16 + m_length;
     m_length = requiredLength;
     return result;
 }
@@ -143,28 +225,49 @@ void StringBuilder::append(const UChar* characters, unsigned length)
         return;
     ASSERT(characters);
 
-    memcpy(appendUninitialized(length), characters, static_cast<size_t>(length) * 2);
+    if (m_is8Bit) {
+        // Keep the contents 8-bit as long as the appended characters fit.
+        UChar ored = 0;
+        for (unsigned i = 0; i < length; ++i)
+            ored |= characters[i];
+        if (!(ored & 0xFF00)) {
+            LChar* dest = appendUninitialized8(length);
+            for (unsigned i = 0; i < length; ++i)
+                dest[i] = static_cast<LChar>(characters[i]);
+            return;
+        }
+    }
+
+    memcpy(appendUninitialized16(length), characters, static_cast<size_t>(length) * 2);
 }
 
-void StringBuilder::append(const char* characters, unsigned length)
+void StringBuilder::append(const LChar* characters, unsigned length)
 {
     if (!length)
         return;
     ASSERT(characters);
 
-    UChar* dest = appendUninitialized(length);
-    const char* end = characters + length;
-    while (characters < end)
-        *(dest++) = *(const unsigned char*)(characters++);
+    if (m_is8Bit) {
+        memcpy(appendUninitialized8(length), characters, length);
+        return;
+    }
+
+    StringImpl::copyChars(appendUninitialized16(length), characters, length);
 }
 
 void StringBuilder::shrinkToFit()
 {
     // If the buffer is at least 80% full, don't bother copying. Need to tune this heuristic!
     if (m_buffer && m_buffer->length() > (m_length + (m_length >> 2))) {
-        UChar* result;
-        m_string = StringImpl::createUninitialized(m_length, result);
-        memcpy(result, m_buffer->characters(), static_cast<size_t>(m_length) * 2); // This can't overflow.
+        if (m_is8Bit) {
+            LChar* result;
+            m_string = StringImpl::createUninitialized(m_length, result);
+            memcpy(result, m_buffer->characters8(), m_length); // This can't overflow.
+        } else {
+            UChar* result;
+            m_string = StringImpl::createUninitialized(m_length, result);
+            memcpy(result, m_buffer->characters16(), static_cast<size_t>(m_length) * 2); // This can't overflow.
+        }
         m_buffer = 0;
     }
 }
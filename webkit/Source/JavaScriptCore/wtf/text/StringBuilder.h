@@ -35,11 +35,14 @@ class StringBuilder {
 public:
     StringBuilder()
         : m_length(0)
+        , m_is8Bit(true)
+        , m_bufferCharacters8(0)
     {
     }
 
     void append(const UChar*, unsigned);
-    void append(const char*, unsigned);
+    void append(const LChar*, unsigned);
+    void append(const char* characters, unsigned length) { append(reinterpret_cast<const LChar*>(characters), length); }
 
     void append(const String& string)
     {
@@ -49,9 +52,13 @@ public:
         if (!m_length && !m_buffer) {
             m_string = string;
             m_length = string.length();
+            m_is8Bit = !m_length || string.is8Bit();
             return;
         }
-        append(string.characters(), string.length());
+        if (string.is8Bit())
+            append(string.impl()->characters8(), string.length());
+        else
+            append(string.characters(), string.length());
     }
 
     void append(const char* characters)
@@ -62,17 +69,27 @@ public:
 
     void append(UChar c)
     {
-        if (m_buffer && m_length < m_buffer->length() && m_string.isNull())
-            m_bufferCharacters[m_length++] = c;
-        else
-            append(&c, 1);
+        if (m_buffer && m_length < m_buffer->length() && m_string.isNull()) {
+            if (!m_is8Bit) {
+                m_bufferCharacters16[m_length++] = c;
+                return;
+            }
+            if (!(c & 0xFF00)) {
+                m_bufferCharacters8[m_length++] = static_cast<LChar>(c);
+                return;
+            }
+        }
+        append(&c, 1);
     }
 
     void append(char c)
     {
-        if (m_buffer && m_length < m_buffer->length() && m_string.isNull())
-            m_bufferCharacters[m_length++] = (unsigned char)c;
-        else
+        if (m_buffer && m_length < m_buffer->length() && m_string.isNull()) {
+            if (m_is8Bit)
+                m_bufferCharacters8[m_length++] = c;
+            else
+                m_bufferCharacters16[m_length++] = static_cast<unsigned char>(c);
+        } else
             append(&c, 1);
     }
 
@@ -111,7 +128,9 @@ public:
         if (!m_string.isNull())
             return m_string[i];
         ASSERT(m_buffer);
-        return m_buffer->characters()[i];
+        if (m_is8Bit)
+            return m_bufferCharacters8[i];
+        return m_bufferCharacters16[i];
     }
 
     void clear()
@@ -119,17 +138,28 @@ public:
         m_length = 0;
         m_string = String();
         m_buffer = 0;
+        m_is8Bit = true;
     }
 
 private:
+    void allocateBuffer(const LChar* currentCharacters, unsigned requiredLength);
     void allocateBuffer(const UChar* currentCharacters, unsigned requiredLength);
-    UChar* appendUninitialized(unsigned length);
+    void allocateBufferUpConvert(const LChar* currentCharacters, unsigned requiredLength);
+    void reallocateBuffer(unsigned requiredLength);
+    LChar* appendUninitialized8(unsigned length);
+    UChar* appendUninitialized16(unsigned length);
     void reifyString();
 
     unsigned m_length;
     String m_string;
     RefPtr<StringImpl> m_buffer;
-    UChar* m_bufferCharacters;
+    // The contents stay 8-bit until a character above 0xFF is appended. This
+    // is the width of m_buffer, or of m_string when there is no buffer.
+    bool m_is8Bit;
+    union {
+        LChar* m_bufferCharacters8;
+        UChar* m_bufferCharacters16;
+    };
 };
 
 } // namespace WTF
@@ -53,6 +53,14 @@ namespace WTF {
             if (aLength != bLength)
                 return false;
 
+            if (a->is8Bit()) {
+                if (b->is8Bit())
+                    return WTF::equal(a->characters8(), b->characters8(), aLength);
+                return WTF::equal(a->characters8(), b->characters16(), aLength);
+            }
+            if (b->is8Bit())
+                return WTF::equal(a->characters16(), b->characters8(), aLength);
+
             // FIXME: perhaps we should have a more abstract macro that indicates when
             // going 4 bytes at a time is unsafe
 #if CPU(ARM) || CPU(SH4) || CPU(MIPS)
@@ -109,6 +117,8 @@ namespace WTF {
 
         static unsigned hash(StringImpl* str)
         {
+            if (str->is8Bit())
+                return StringHasher::computeHash<LChar, foldCase<LChar> >(str->characters8(), str->length());
             return hash(str->characters(), str->length());
         }
 
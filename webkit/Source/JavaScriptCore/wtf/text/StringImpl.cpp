@@ -28,6 +28,7 @@
 #include "AtomicString.h"
 #include "StringBuffer.h"
 #include "StringHash.h"
+#include <wtf/Atomics.h>
 #include <wtf/StdLibExtras.h>
 #include <wtf/WTFThreadData.h>
 
@@ -54,11 +55,16 @@ StringImpl::~StringImpl()
     }
 #endif
 
+    // The UTF-16 copy of an 8-bit string is always owned by the string.
+    if (is8Bit() && m_data)
+        fastFree(const_cast<UChar*>(m_data));
+
     BufferOwnership ownership = bufferOwnership();
     if (ownership != BufferInternal) {
         if (ownership == BufferOwned) {
             ASSERT(!m_sharedBuffer);
             ASSERT(m_data);
+            ASSERT(!is8Bit());
             fastFree(const_cast<UChar*>(m_data));
         } else if (ownership == BufferSubstring) {
             ASSERT(m_substringBuffer);
@@ -90,6 +96,22 @@ PassRefPtr<StringImpl> StringImpl::createUninitialized(unsigned length, UChar*&
     return adoptRef(new (string) StringImpl(length));
 }
 
+PassRefPtr<StringImpl> StringImpl::createUninitialized(unsigned length, LChar*& data)
+{
+    if (!length) {
+        data = 0;
+        return empty();
+    }
+
+    if (length > ((std::numeric_limits<unsigned>::max() - sizeof(StringImpl)) / sizeof(LChar)))
+        CRASH();
+    size_t size = sizeof(StringImpl) + length * sizeof(LChar);
+    StringImpl* string = static_cast<StringImpl*>(fastMalloc(size));
+
+    data = reinterpret_cast<LChar*>(string + 1);
+    return adoptRef(new (string) StringImpl(length, Force8BitConstructor));
+}
+
 PassRefPtr<StringImpl> StringImpl::create(const UChar* characters, unsigned length)
 {
     if (!characters || !length)
@@ -101,20 +123,61 @@ PassRefPtr<StringImpl> StringImpl::create(const UChar* characters, unsigned leng
     return string.release();
 }
 
+PassRefPtr<StringImpl> StringImpl::create(const LChar* characters, unsigned length)
+{
+    if (!characters || !length)
+        return empty();
+
+    LChar* data;
+    RefPtr<StringImpl> string = createUninitialized(length, data);
+    memcpy(data, characters, length * sizeof(LChar));
+    return string.release();
+}
+
 PassRefPtr<StringImpl> StringImpl::create(const char* characters, unsigned length)
+{
+    return create(reinterpret_cast<const LChar*>(characters), length);
+}
+
+PassRefPtr<StringImpl> StringImpl::create8BitIfPossible(const UChar* characters, unsigned length)
 {
     if (!characters || !length)
         return empty();
 
-    UChar* data;
+    UChar ored = 0;
+    for (unsigned i = 0; i < length; ++i)
+        ored |= characters[i];
+    if (ored & 0xFF00)
+        return create(characters, length);
+
+    LChar* data;
     RefPtr<StringImpl> string = createUninitialized(length, data);
-    for (unsigned i = 0; i != length; ++i) {
-        unsigned char c = characters[i];
-        data[i] = c;
-    }
+    for (unsigned i = 0; i < length; ++i)
+        data[i] = static_cast<LChar>(characters[i]);
     return string.release();
 }
 
+const UChar* StringImpl::getData16SlowCase() const
+{
+    ASSERT(is8Bit());
+    UChar* data = static_cast<UChar*>(fastMalloc(m_length * sizeof(UChar)));
+    copyChars(data, characters8(), m_length);
+#if OS(ANDROID)
+    // Static strings are used by every thread. The release makes the copied
+    // characters visible before the pointer to them, and if another thread
+    // published its copy first, that one is used and ours freed.
+    COMPILE_ASSERT(sizeof(m_data) == sizeof(int32_t), android_atomic_cas_is_pointer_sized);
+    volatile int32_t* address = reinterpret_cast<volatile int32_t*>(&m_data);
+    if (android_atomic_release_cas(0, static_cast<int32_t>(reinterpret_cast<intptr_t>(data)), address)) {
+        fastFree(data);
+        return reinterpret_cast<const UChar*>(static_cast<intptr_t>(android_atomic_acquire_load(address)));
+    }
+#else
+    m_data = data;
+#endif
+    return data;
+}
+
 PassRefPtr<StringImpl> StringImpl::create(const char* string)
 {
     if (!string)
@@ -136,6 +199,9 @@ SharedUChar* StringImpl::sharedBuffer()
 {
     if (m_length < minLengthToShare)
         return 0;
+    // The shared buffer holds UTF-16 characters, 8-bit strings are copied instead.
+    if (is8Bit())
+        return 0;
     // All static strings are smaller that the minimim length to share.
     ASSERT(!isStatic());
 
@@ -161,6 +227,13 @@ bool StringImpl::containsOnlyWhitespace()
     // FIXME: The definition of whitespace here includes a number of characters
     // that are not whitespace from the point of view of RenderText; I wonder if
     // that's a problem in practice.
+    if (is8Bit()) {
+        const LChar* data8 = characters8();
+        for (unsigned i = 0; i < m_length; i++)
+            if (!isASCIISpace(data8[i]))
+                return false;
+        return true;
+    }
     for (unsigned i = 0; i < m_length; i++)
         if (!isASCIISpace(m_data[i]))
             return false;
@@ -177,15 +250,17 @@ PassRefPtr<StringImpl> StringImpl::substring(unsigned start, unsigned length)
             return this;
         length = maxLength;
     }
+    if (is8Bit())
+        return create(characters8() + start, length);
     return create(m_data + start, length);
 }
 
 UChar32 StringImpl::characterStartingAt(unsigned i)
 {
-    if (U16_IS_SINGLE(m_data[i]))
-        return m_data[i];
-    if (i + 1 < m_length && U16_IS_LEAD(m_data[i]) && U16_IS_TRAIL(m_data[i + 1]))
-        return U16_GET_SUPPLEMENTARY(m_data[i], m_data[i + 1]);
+    if (U16_IS_SINGLE(characters()[i]))
+        return characters()[i];
+    if (i + 1 < m_length && U16_IS_LEAD(characters()[i]) && U16_IS_TRAIL(characters()[i + 1]))
+        return U16_GET_SUPPLEMENTARY(characters()[i], characters()[i + 1]);
     return 0;
 }
 
@@ -193,12 +268,34 @@ PassRefPtr<StringImpl> StringImpl::lower()
 {
     // Note: This is a hot function in the Dromaeo benchmark, specifically the
     // no-op code path up through the first 'return' statement.
-    
+
+    if (is8Bit()) {
+        // Lowering ASCII stays within 8 bits, anything else takes the UTF-16 path.
+        const LChar* source8 = characters8();
+        LChar ored = 0;
+        bool noUpper = true;
+        for (unsigned i = 0; i < m_length; i++) {
+            if (UNLIKELY(isASCIIUpper(source8[i])))
+                noUpper = false;
+            ored |= source8[i];
+        }
+        if (noUpper && !(ored & ~0x7F))
+            return this;
+        if (!(ored & ~0x7F)) {
+            LChar* data8;
+            RefPtr<StringImpl> newImpl = createUninitialized(m_length, data8);
+            for (unsigned i = 0; i < m_length; i++)
+                data8[i] = toASCIILower(source8[i]);
+            return newImpl.release();
+        }
+    }
+    const UChar* source = characters();
+
     // First scan the string for uppercase and non-ASCII characters:
     UChar ored = 0;
     bool noUpper = true;
-    const UChar *end = m_data + m_length;
-    for (const UChar* chp = m_data; chp != end; chp++) {
+    const UChar *end = source + m_length;
+    for (const UChar* chp = source; chp != end; chp++) {
         if (UNLIKELY(isASCIIUpper(*chp)))
             noUpper = false;
         ored |= *chp;
@@ -218,7 +315,7 @@ PassRefPtr<StringImpl> StringImpl::lower()
     if (!(ored & ~0x7F)) {
         // Do a faster loop for the case where all the characters are ASCII.
         for (int i = 0; i < length; i++) {
-            UChar c = m_data[i];
+            UChar c = source[i];
             data[i] = toASCIILower(c);
         }
         return newImpl;
@@ -226,11 +323,11 @@ PassRefPtr<StringImpl> StringImpl::lower()
     
     // Do a slower implementation for cases that include non-ASCII characters.
     bool error;
-    int32_t realLength = Unicode::toLower(data, length, m_data, m_length, &error);
+    int32_t realLength = Unicode::toLower(data, length, source, m_length, &error);
     if (!error && realLength == length)
         return newImpl;
     newImpl = createUninitialized(realLength, data);
-    Unicode::toLower(data, realLength, m_data, m_length, &error);
+    Unicode::toLower(data, realLength, source, m_length, &error);
     if (error)
         return this;
     return newImpl;
@@ -251,7 +348,7 @@ PassRefPtr<StringImpl> StringImpl::upper()
     // Do a faster loop for the case where all the characters are ASCII.
     UChar ored = 0;
     for (int i = 0; i < length; i++) {
-        UChar c = m_data[i];
+        UChar c = characters()[i];
         ored |= c;
         data[i] = toASCIIUpper(c);
     }
@@ -260,11 +357,11 @@ PassRefPtr<StringImpl> StringImpl::upper()
 
     // Do a slower implementation for cases that include non-ASCII characters.
     bool error;
-    int32_t realLength = Unicode::toUpper(data, length, m_data, m_length, &error);
+    int32_t realLength = Unicode::toUpper(data, length, characters(), m_length, &error);
     if (!error && realLength == length)
         return newImpl;
     newImpl = createUninitialized(realLength, data);
-    Unicode::toUpper(data, realLength, m_data, m_length, &error);
+    Unicode::toUpper(data, realLength, characters(), m_length, &error);
     if (error)
         return this;
     return newImpl.release();
@@ -280,7 +377,7 @@ PassRefPtr<StringImpl> StringImpl::secure(UChar character, LastCharacterBehavior
     unsigned lastCharacterIndex = m_length - 1;
     for (unsigned i = 0; i < lastCharacterIndex; ++i)
         data[i] = character;
-    data[lastCharacterIndex] = (behavior == ObscureLastCharacter) ? character : m_data[lastCharacterIndex];
+    data[lastCharacterIndex] = (behavior == ObscureLastCharacter) ? character : characters()[lastCharacterIndex];
     return newImpl.release();
 }
 
@@ -296,7 +393,7 @@ PassRefPtr<StringImpl> StringImpl::foldCase()
     // Do a faster loop for the case where all the characters are ASCII.
     UChar ored = 0;
     for (int32_t i = 0; i < length; i++) {
-        UChar c = m_data[i];
+        UChar c = characters()[i];
         ored |= c;
         data[i] = toASCIILower(c);
     }
@@ -305,11 +402,11 @@ PassRefPtr<StringImpl> StringImpl::foldCase()
 
     // Do a slower implementation for cases that include non-ASCII characters.
     bool error;
-    int32_t realLength = Unicode::foldCase(data, length, m_data, m_length, &error);
+    int32_t realLength = Unicode::foldCase(data, length, characters(), m_length, &error);
     if (!error && realLength == length)
         return newImpl.release();
     newImpl = createUninitialized(realLength, data);
-    Unicode::foldCase(data, realLength, m_data, m_length, &error);
+    Unicode::foldCase(data, realLength, characters(), m_length, &error);
     if (error)
         return this;
     return newImpl.release();
@@ -324,7 +421,7 @@ PassRefPtr<StringImpl> StringImpl::stripWhiteSpace()
     unsigned end = m_length - 1;
     
     // skip white space from start
-    while (start <= end && isSpaceOrNewline(m_data[start]))
+    while (start <= end && isSpaceOrNewline(characters()[start]))
         start++;
     
     // only white space
@@ -332,17 +429,17 @@ PassRefPtr<StringImpl> StringImpl::stripWhiteSpace()
         return empty();
 
     // skip white space from end
-    while (end && isSpaceOrNewline(m_data[end]))
+    while (end && isSpaceOrNewline(characters()[end]))
         end--;
 
     if (!start && end == m_length - 1)
         return this;
-    return create(m_data + start, end + 1 - start);
+    return substring(start, end + 1 - start);
 }
 
 PassRefPtr<StringImpl> StringImpl::removeCharacters(CharacterMatchFunctionPtr findMatch)
 {
-    const UChar* from = m_data;
+    const UChar* from = characters();
     const UChar* fromend = from + m_length;
 
     // Assume the common case will not remove any characters
@@ -353,10 +450,10 @@ PassRefPtr<StringImpl> StringImpl::removeCharacters(CharacterMatchFunctionPtr fi
 
     StringBuffer data(m_length);
     UChar* to = data.characters();
-    unsigned outc = from - m_data;
+    unsigned outc = from - characters();
 
     if (outc)
-        memcpy(to, m_data, outc * sizeof(UChar));
+        memcpy(to, characters(), outc * sizeof(UChar));
 
     while (true) {
         while (from != fromend && findMatch(*from))
@@ -376,7 +473,7 @@ PassRefPtr<StringImpl> StringImpl::simplifyWhiteSpace()
 {
     StringBuffer data(m_length);
 
-    const UChar* from = m_data;
+    const UChar* from = characters();
     const UChar* fromend = from + m_length;
     int outc = 0;
     bool changedToSpace = false;
@@ -410,62 +507,62 @@ PassRefPtr<StringImpl> StringImpl::simplifyWhiteSpace()
 
 int StringImpl::toIntStrict(bool* ok, int base)
 {
-    return charactersToIntStrict(m_data, m_length, ok, base);
+    return charactersToIntStrict(characters(), m_length, ok, base);
 }
 
 unsigned StringImpl::toUIntStrict(bool* ok, int base)
 {
-    return charactersToUIntStrict(m_data, m_length, ok, base);
+    return charactersToUIntStrict(characters(), m_length, ok, base);
 }
 
 int64_t StringImpl::toInt64Strict(bool* ok, int base)
 {
-    return charactersToInt64Strict(m_data, m_length, ok, base);
+    return charactersToInt64Strict(characters(), m_length, ok, base);
 }
 
 uint64_t StringImpl::toUInt64Strict(bool* ok, int base)
 {
-    return charactersToUInt64Strict(m_data, m_length, ok, base);
+    return charactersToUInt64Strict(characters(), m_length, ok, base);
 }
 
 intptr_t StringImpl::toIntPtrStrict(bool* ok, int base)
 {
-    return charactersToIntPtrStrict(m_data, m_length, ok, base);
+    return charactersToIntPtrStrict(characters(), m_length, ok, base);
 }
 
 int StringImpl::toInt(bool* ok)
 {
-    return charactersToInt(m_data, m_length, ok);
+    return charactersToInt(characters(), m_length, ok);
 }
 
 unsigned StringImpl::toUInt(bool* ok)
 {
-    return charactersToUInt(m_data, m_length, ok);
+    return charactersToUInt(characters(), m_length, ok);
 }
 
 int64_t StringImpl::toInt64(bool* ok)
 {
-    return charactersToInt64(m_data, m_length, ok);
+    return charactersToInt64(characters(), m_length, ok);
 }
 
 uint64_t StringImpl::toUInt64(bool* ok)
 {
-    return charactersToUInt64(m_data, m_length, ok);
+    return charactersToUInt64(characters(), m_length, ok);
 }
 
 intptr_t StringImpl::toIntPtr(bool* ok)
 {
-    return charactersToIntPtr(m_data, m_length, ok);
+    return charactersToIntPtr(characters(), m_length, ok);
 }
 
 double StringImpl::toDouble(bool* ok, bool* didReadNumber)
 {
-    return charactersToDouble(m_data, m_length, ok, didReadNumber);
+    return charactersToDouble(characters(), m_length, ok, didReadNumber);
 }
 
 float StringImpl::toFloat(bool* ok, bool* didReadNumber)
 {
-    return charactersToFloat(m_data, m_length, ok, didReadNumber);
+    return charactersToFloat(characters(), m_length, ok, didReadNumber);
 }
 
 static bool equal(const UChar* a, const char* b, int length)
@@ -520,12 +617,22 @@ int codePointCompare(const StringImpl* s1, const StringImpl* s2)
 
 size_t StringImpl::find(UChar c, unsigned start)
 {
+    if (is8Bit()) {
+        if (c & 0xFF00)
+            return notFound;
+        const LChar* data8 = characters8();
+        for (; start < m_length; ++start) {
+            if (data8[start] == c)
+                return start;
+        }
+        return notFound;
+    }
     return WTF::find(m_data, m_length, c, start);
 }
 
 size_t StringImpl::find(CharacterMatchFunctionPtr matchFunction, unsigned start)
 {
-    return WTF::find(m_data, m_length, matchFunction, start);
+    return WTF::find(characters(), m_length, matchFunction, start);
 }
 
 size_t StringImpl::find(const char* matchString, unsigned index)
@@ -689,7 +796,7 @@ size_t StringImpl::findIgnoringCase(StringImpl* matchString, unsigned index)
 
 size_t StringImpl::reverseFind(UChar c, unsigned index)
 {
-    return WTF::reverseFind(m_data, m_length, c, index);
+    return WTF::reverseFind(characters(), m_length, c, index);
 }
 
 size_t StringImpl::reverseFind(StringImpl* matchString, unsigned index)
@@ -777,7 +884,7 @@ PassRefPtr<StringImpl> StringImpl::replace(UChar oldC, UChar newC)
         return this;
     unsigned i;
     for (i = 0; i != m_length; ++i)
-        if (m_data[i] == oldC)
+        if (characters()[i] == oldC)
             break;
     if (i == m_length)
         return this;
@@ -786,7 +893,7 @@ PassRefPtr<StringImpl> StringImpl::replace(UChar oldC, UChar newC)
     RefPtr<StringImpl> newImpl = createUninitialized(m_length, data);
 
     for (i = 0; i != m_length; ++i) {
-        UChar ch = m_data[i];
+        UChar ch = characters()[i];
         if (ch == oldC)
             ch = newC;
         data[i] = ch;
@@ -856,15 +963,15 @@ PassRefPtr<StringImpl> StringImpl::replace(UChar pattern, StringImpl* replacemen
     
     while ((srcSegmentEnd = find(pattern, srcSegmentStart)) != notFound) {
         srcSegmentLength = srcSegmentEnd - srcSegmentStart;
-        memcpy(data + dstOffset, m_data + srcSegmentStart, srcSegmentLength * sizeof(UChar));
+        memcpy(data + dstOffset, characters() + srcSegmentStart, srcSegmentLength * sizeof(UChar));
         dstOffset += srcSegmentLength;
-        memcpy(data + dstOffset, replacement->m_data, repStrLength * sizeof(UChar));
+        memcpy(data + dstOffset, replacement->characters(), repStrLength * sizeof(UChar));
         dstOffset += repStrLength;
         srcSegmentStart = srcSegmentEnd + 1;
     }
 
     srcSegmentLength = m_length - srcSegmentStart;
-    memcpy(data + dstOffset, m_data + srcSegmentStart, srcSegmentLength * sizeof(UChar));
+    memcpy(data + dstOffset, characters() + srcSegmentStart, srcSegmentLength * sizeof(UChar));
 
     ASSERT(dstOffset + srcSegmentLength == newImpl->length());
 
@@ -914,15 +1021,15 @@ PassRefPtr<StringImpl> StringImpl::replace(StringImpl* pattern, StringImpl* repl
     
     while ((srcSegmentEnd = find(pattern, srcSegmentStart)) != notFound) {
         srcSegmentLength = srcSegmentEnd - srcSegmentStart;
-        memcpy(data + dstOffset, m_data + srcSegmentStart, srcSegmentLength * sizeof(UChar));
+        memcpy(data + dstOffset, characters() + srcSegmentStart, srcSegmentLength * sizeof(UChar));
         dstOffset += srcSegmentLength;
-        memcpy(data + dstOffset, replacement->m_data, repStrLength * sizeof(UChar));
+        memcpy(data + dstOffset, replacement->characters(), repStrLength * sizeof(UChar));
         dstOffset += repStrLength;
         srcSegmentStart = srcSegmentEnd + patternLength;
     }
 
     srcSegmentLength = m_length - srcSegmentStart;
-    memcpy(data + dstOffset, m_data + srcSegmentStart, srcSegmentLength * sizeof(UChar));
+    memcpy(data + dstOffset, characters() + srcSegmentStart, srcSegmentLength * sizeof(UChar));
 
     ASSERT(dstOffset + srcSegmentLength == newImpl->length());
 
@@ -942,6 +1049,18 @@ bool equal(const StringImpl* a, const char* b)
         return !a;
 
     unsigned length = a->length();
+    if (a->is8Bit()) {
+        const LChar* as = a->characters8();
+        for (unsigned i = 0; i != length; ++i) {
+            LChar bc = b[i];
+            if (!bc)
+                return false;
+            if (as[i] != bc)
+                return false;
+        }
+        return !b[length];
+    }
+
     const UChar* as = a->characters();
     for (unsigned i = 0; i != length; ++i) {
         unsigned char bc = b[i];
@@ -1008,7 +1127,7 @@ bool equalIgnoringNullity(StringImpl* a, StringImpl* b)
 WTF::Unicode::Direction StringImpl::defaultWritingDirection(bool* hasStrongDirectionality)
 {
     for (unsigned i = 0; i < m_length; ++i) {
-        WTF::Unicode::Direction charDirection = WTF::Unicode::direction(m_data[i]);
+        WTF::Unicode::Direction charDirection = WTF::Unicode::direction(characters()[i]);
         if (charDirection == WTF::Unicode::LeftToRight) {
             if (hasStrongDirectionality)
                 *hasStrongDirectionality = true;
@@ -1056,7 +1175,7 @@ PassRefPtr<StringImpl> StringImpl::createWithTerminatingNullCharacter(const Stri
     if (length >= numeric_limits<unsigned>::max())
         CRASH();
     RefPtr<StringImpl> terminatedString = createUninitialized(length + 1, data);
-    memcpy(data, string.m_data, length * sizeof(UChar));
+    memcpy(data, string.characters(), length * sizeof(UChar));
     data[length] = 0;
     terminatedString->m_length--;
     terminatedString->m_hash = string.m_hash;
@@ -1066,6 +1185,8 @@ PassRefPtr<StringImpl> StringImpl::createWithTerminatingNullCharacter(const Stri
 
 PassRefPtr<StringImpl> StringImpl::threadsafeCopy() const
 {
+    if (is8Bit())
+        return create(characters8(), m_length);
     return create(m_data, m_length);
 }
 
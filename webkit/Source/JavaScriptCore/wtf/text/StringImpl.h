@@ -54,6 +54,7 @@ namespace WTF {
 struct CStringTranslator;
 struct HashAndCharactersTranslator;
 struct HashAndUTF8CharactersTranslator;
+struct LCharBufferTranslator;
 struct UCharBufferTranslator;
 
 enum TextCaseSensitivity { TextCaseSensitive, TextCaseInsensitive };
@@ -68,9 +69,12 @@ class StringImpl : public StringImplBase {
     friend struct WTF::CStringTranslator;
     friend struct WTF::HashAndCharactersTranslator;
     friend struct WTF::HashAndUTF8CharactersTranslator;
+    friend struct WTF::LCharBufferTranslator;
     friend struct WTF::UCharBufferTranslator;
     friend class AtomicStringImpl;
 private:
+    enum Force8Bit { Force8BitConstructor };
+
     // Used to construct static strings, which have an special refCount that can never hit zero.
     // This means that the static string will never be destroyed, which is important because
     // static strings will be shared across threads & ref-counted in a non-threadsafe manner.
@@ -120,6 +124,16 @@ private:
         ASSERT(m_substringBuffer->bufferOwnership() != BufferSubstring);
     }
 
+    // Create an 8-bit string with internal storage (BufferInternal)
+    StringImpl(unsigned length, Force8Bit)
+        : StringImplBase(length, BufferInternal)
+        , m_data(0)
+        , m_buffer(0)
+        , m_hash(0)
+    {
+        ASSERT(m_length);
+    }
+
     // Used to construct new strings sharing an existing SharedUChar (BufferShared)
     StringImpl(const UChar* characters, unsigned length, PassRefPtr<SharedUChar> sharedBuffer)
         : StringImplBase(length, BufferShared)
@@ -136,7 +150,7 @@ private:
     {
         ASSERT(!isStatic());
         ASSERT(!m_hash);
-        ASSERT(hash == StringHasher::computeHash(m_data, m_length));
+        ASSERT(hash == (is8Bit() ? StringHasher::computeHash(characters8(), m_length) : StringHasher::computeHash(m_data, m_length)));
         m_hash = hash;
     }
 
@@ -144,6 +158,9 @@ public:
     ~StringImpl();
 
     static PassRefPtr<StringImpl> create(const UChar*, unsigned length);
+    static PassRefPtr<StringImpl> create(const LChar*, unsigned length);
+    // Stores the characters in an 8-bit string if they are all Latin-1.
+    static PassRefPtr<StringImpl> create8BitIfPossible(const UChar*, unsigned length);
     static PassRefPtr<StringImpl> create(const char*, unsigned length);
     static PassRefPtr<StringImpl> create(const char*);
     static PassRefPtr<StringImpl> create(const UChar*, unsigned length, PassRefPtr<SharedUChar> sharedBuffer);
@@ -155,11 +172,16 @@ public:
         if (!length)
             return empty();
 
+        // 8-bit strings keep their characters inline, so their substrings
+        // are copies.
+        if (rep->is8Bit())
+            return create(rep->characters8() + offset, length);
         StringImpl* ownerRep = (rep->bufferOwnership() == BufferSubstring) ? rep->m_substringBuffer : rep.get();
         return adoptRef(new StringImpl(rep->m_data + offset, length, ownerRep));
     }
 
     static PassRefPtr<StringImpl> createUninitialized(unsigned length, UChar*& data);
+    static PassRefPtr<StringImpl> createUninitialized(unsigned length, LChar*& data);
     static ALWAYS_INLINE PassRefPtr<StringImpl> tryCreateUninitialized(unsigned length, UChar*& output)
     {
         if (!length) {
@@ -180,6 +202,7 @@ public:
         return adoptRef(new(resultImpl) StringImpl(length));
     }
 
+    // Only valid for 16-bit strings, 8-bit strings fill m_data in lazily.
     static unsigned dataOffset() { return OBJECT_OFFSETOF(StringImpl, m_data); }
     static PassRefPtr<StringImpl> createWithTerminatingNullCharacter(const StringImpl&);
     static PassRefPtr<StringImpl> createStrippingNullCharacters(const UChar*, unsigned length);
@@ -198,7 +221,20 @@ public:
     static PassRefPtr<StringImpl> adopt(StringBuffer&);
 
     SharedUChar* sharedBuffer();
-    const UChar* characters() const { return m_data; }
+
+    // 8-bit strings hold Latin-1 characters only, and are never empty.
+    bool is8Bit() const { return bufferOwnership() == BufferInternal && m_data != reinterpret_cast<const UChar*>(this + 1); }
+    const LChar* characters8() const { ASSERT(is8Bit()); return reinterpret_cast<const LChar*>(this + 1); }
+    const UChar* characters16() const { ASSERT(!is8Bit()); return m_data; }
+
+    // Widens an 8-bit string to UTF-16 the first time it is called, and
+    // keeps the copy for as long as the string lives.
+    const UChar* characters() const
+    {
+        if (m_data)
+            return m_data;
+        return getData16SlowCase();
+    }
 
     size_t cost()
     {
@@ -235,7 +271,12 @@ public:
             m_refCountAndFlags &= ~s_refCountFlagIsAtomic;
     }
 
-    unsigned hash() const { if (!m_hash) m_hash = StringHasher::computeHash(m_data, m_length); return m_hash; }
+    unsigned hash() const
+    {
+        if (!m_hash)
+            m_hash = is8Bit() ? StringHasher::computeHash(characters8(), m_length) : StringHasher::computeHash(m_data, m_length);
+        return m_hash;
+    }
     unsigned existingHash() const { ASSERT(m_hash); return m_hash; }
 
     ALWAYS_INLINE void deref() { m_refCountAndFlags -= s_refCountIncrement; if (!(m_refCountAndFlags & (s_refCountMask | s_refCountFlagStatic))) delete this; }
@@ -252,6 +293,12 @@ public:
             memcpy(destination, source, numCharacters * sizeof(UChar));
     }
 
+    static void copyChars(UChar* destination, const LChar* source, unsigned numCharacters)
+    {
+        for (unsigned i = 0; i < numCharacters; ++i)
+            destination[i] = source[i];
+    }
+
     // Returns a StringImpl suitable for use on another thread.
     PassRefPtr<StringImpl> crossThreadString();
     // Makes a deep copy. Helpful only if you need to use a String on another thread
@@ -261,7 +308,13 @@ public:
 
     PassRefPtr<StringImpl> substring(unsigned pos, unsigned len = UINT_MAX);
 
-    UChar operator[](unsigned i) { ASSERT(i < m_length); return m_data[i]; }
+    UChar operator[](unsigned i) const
+    {
+        ASSERT(i < m_length);
+        if (is8Bit())
+            return characters8()[i];
+        return m_data[i];
+    }
     UChar32 characterStartingAt(unsigned);
 
     bool containsOnlyWhitespace();
@@ -327,10 +380,16 @@ private:
     static const unsigned s_copyCharsInlineCutOff = 20;
 
     static PassRefPtr<StringImpl> createStrippingNullCharactersSlowCase(const UChar*, unsigned length);
+    const UChar* getData16SlowCase() const;
     
     BufferOwnership bufferOwnership() const { return static_cast<BufferOwnership>(m_refCountAndFlags & s_refCountMaskBufferOwnership); }
     bool isStatic() const { return m_refCountAndFlags & s_refCountFlagStatic; }
-    const UChar* m_data;
+    // 8-bit strings always keep their characters inline, after the
+    // StringImpl, which is how is8Bit() tells them from 16-bit strings
+    // without another field. m_data is null until characters() is first
+    // called, and then holds the widened copy, which can't be dropped while
+    // callers may still hold the pointer.
+    mutable const UChar* m_data;
     union {
         void* m_buffer;
         StringImpl* m_substringBuffer;
@@ -341,6 +400,27 @@ private:
 
 bool equal(const StringImpl*, const StringImpl*);
 bool equal(const StringImpl*, const char*);
+
+inline bool equal(const LChar* a, const LChar* b, unsigned length)
+{
+    return !memcmp(a, b, length);
+}
+
+inline bool equal(const LChar* a, const UChar* b, unsigned length)
+{
+    for (unsigned i = 0; i < length; ++i) {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+inline bool equal(const UChar* a, const LChar* b, unsigned length) { return equal(b, a, length); }
+
+inline bool equal(const UChar* a, const UChar* b, unsigned length)
+{
+    return !memcmp(a, b, length * sizeof(UChar));
+}
 inline bool equal(const char* a, StringImpl* b) { return equal(b, a); }
 
 bool equalIgnoringCase(StringImpl*, StringImpl*);
@@ -65,6 +65,7 @@ struct StringHash;
 
 // Declarations of string operations
 
+bool charactersAreAllASCII(const LChar*, size_t);
 bool charactersAreAllASCII(const UChar*, size_t);
 bool charactersAreAllLatin1(const UChar*, size_t);
 int charactersToIntStrict(const UChar*, size_t, bool* ok = 0, int base = 10);
@@ -139,6 +140,8 @@ public:
         return m_impl->characters();
     }
 
+    bool is8Bit() const { return m_impl && m_impl->is8Bit(); }
+
     CString ascii() const;
     CString latin1() const;
     CString utf8(bool strict = false) const;
@@ -147,7 +150,7 @@ public:
     {
         if (!m_impl || index >= m_impl->length())
             return 0;
-        return m_impl->characters()[index];
+        return (*m_impl)[index];
     }
 
     static String number(short);
@@ -340,8 +343,13 @@ public:
         return WTF::Unicode::LeftToRight;
     }
 
-    bool containsOnlyASCII() const { return charactersAreAllASCII(characters(), length()); }
-    bool containsOnlyLatin1() const { return charactersAreAllLatin1(characters(), length()); }
+    bool containsOnlyASCII() const
+    {
+        if (is8Bit())
+            return charactersAreAllASCII(m_impl->characters8(), length());
+        return charactersAreAllASCII(characters(), length());
+    }
+    bool containsOnlyLatin1() const { return is8Bit() || charactersAreAllLatin1(characters(), length()); }
 
     // Hash table deleted values, which are only constructed and never copied or destroyed.
     String(WTF::HashTableDeletedValueType) : m_impl(WTF::HashTableDeletedValue) { }
@@ -403,6 +411,14 @@ String::String(const Vector<UChar, inlineCapacity>& vector)
 inline NSString* nsStringNilIfEmpty(const String& str) {  return str.isEmpty() ? nil : (NSString*)str; }
 #endif
 
+inline bool charactersAreAllASCII(const LChar* characters, size_t length)
+{
+    LChar ored = 0;
+    for (size_t i = 0; i < length; ++i)
+        ored |= characters[i];
+    return !(ored & 0x80);
+}
+
 inline bool charactersAreAllASCII(const UChar* characters, size_t length)
 {
     UChar ored = 0;
@@ -131,6 +131,7 @@ LOCAL_SRC_FILES := $(LOCAL_SRC_FILES) \
 	dom/DeviceMotionData.cpp \
 	dom/DeviceMotionEvent.cpp \
 	dom/Document.cpp \
+	dom/DocumentArena.cpp \
 	dom/DocumentFragment.cpp \
 	dom/DocumentMarkerController.cpp \
 	dom/DocumentParser.cpp \
@@ -582,6 +583,7 @@ LOCAL_SRC_FILES := $(LOCAL_SRC_FILES) \
 	platform/android/PlatformTouchEventAndroid.cpp \
 	platform/android/PlatformTouchPointAndroid.cpp \
 	platform/android/PopupMenuAndroid.cpp \
+	platform/android/PurgeableBufferAndroid.cpp \
 	platform/android/RenderThemeAndroid.cpp \
 	platform/android/PackageNotifier.cpp \
 	platform/android/ScreenAndroid.cpp \
@@ -636,6 +638,7 @@ LOCAL_SRC_FILES := $(LOCAL_SRC_FILES) \
 	platform/graphics/android/GLWebViewState.cpp \
 	platform/graphics/android/ImageAndroid.cpp \
 	platform/graphics/android/ImageBufferAndroid.cpp \
+	platform/graphics/android/ImageDecodeQueue.cpp \
 	platform/graphics/android/ImageSourceAndroid.cpp \
 	platform/graphics/android/PathAndroid.cpp \
 	platform/graphics/android/PatternAndroid.cpp \
@@ -648,6 +651,7 @@ LOCAL_SRC_FILES := $(LOCAL_SRC_FILES) \
 	platform/graphics/android/context/PlatformGraphicsContextSkia.cpp \
 	platform/graphics/android/context/RecordingContextCanvasProxy.cpp \
 	platform/graphics/android/context/RTree.cpp \
+	platform/graphics/android/context/SerializedRecording.cpp \
 	\
 	platform/graphics/android/fonts/FontAndroid.cpp \
 	platform/graphics/android/fonts/FontCacheAndroid.cpp \
@@ -683,6 +687,7 @@ LOCAL_SRC_FILES := $(LOCAL_SRC_FILES) \
 	platform/graphics/android/rendering/ImagesManager.cpp \
 	platform/graphics/android/rendering/ImageTexture.cpp \
 	platform/graphics/android/rendering/InspectorCanvas.cpp \
+	platform/graphics/android/rendering/OperationQueue.cpp \
 	platform/graphics/android/rendering/PaintTileOperation.cpp \
 	platform/graphics/android/rendering/RasterRenderer.cpp \
 	platform/graphics/android/rendering/ShaderProgram.cpp \
@@ -749,6 +754,8 @@ LOCAL_SRC_FILES := $(LOCAL_SRC_FILES) \
 	platform/image-decoders/skia/ImageDecoderSkia.cpp \
 	platform/image-decoders/gif/GIFImageDecoder.cpp \
 	platform/image-decoders/gif/GIFImageReader.cpp \
+	platform/image-decoders/jpeg/JPEGImageDecoder.cpp \
+	platform/image-decoders/png/PNGImageDecoder.cpp \
 	\
 	platform/image-encoders/skia/JPEGImageEncoder.cpp \
 	\
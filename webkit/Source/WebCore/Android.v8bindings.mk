@@ -87,6 +87,7 @@ LOCAL_SRC_FILES += \
 	bindings/v8/V8NPUtils.cpp \
 	bindings/v8/V8NodeFilterCondition.cpp \
 	bindings/v8/V8Proxy.cpp \
+	bindings/v8/V8ScriptPreparser.cpp \
 	bindings/v8/V8Utilities.cpp \
 	bindings/v8/V8WindowErrorHandler.cpp \
 	bindings/v8/V8WorkerContextEventListener.cpp \
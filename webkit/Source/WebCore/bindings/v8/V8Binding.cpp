@@ -58,6 +58,7 @@ public:
         m_threadId = WTF::currentThread();
 #endif
         ASSERT(!string.isNull());
+        widenIfNeeded();
         v8::V8::AdjustAmountOfExternalAllocatedMemory(2 * string.length());
     }
 
@@ -69,6 +70,7 @@ public:
         m_threadId = WTF::currentThread();
 #endif
         ASSERT(!string.isNull());
+        widenIfNeeded();
         v8::V8::AdjustAmountOfExternalAllocatedMemory(2 * string.length());
     }
 
@@ -85,7 +87,9 @@ public:
 
     virtual const uint16_t* data() const
     {
-        return reinterpret_cast<const uint16_t*>(m_plainString.impl()->characters());
+        if (m_plainString.impl()->is8Bit())
+            return reinterpret_cast<const uint16_t*>(m_widenedCharacters.data());
+        return reinterpret_cast<const uint16_t*>(m_plainString.impl()->characters16());
     }
 
     virtual size_t length() const { return m_plainString.impl()->length(); }
@@ -112,6 +116,20 @@ public:
     }
 
 private:
+    // V8 needs UTF-16 for non ASCII strings. Widen 8-bit ones into a buffer that
+    // dies with the V8 string rather than caching a copy in the StringImpl.
+    void widenIfNeeded()
+    {
+        StringImpl* impl = m_plainString.impl();
+        if (!impl->is8Bit())
+            return;
+        const LChar* characters = impl->characters8();
+        unsigned length = impl->length();
+        m_widenedCharacters.reserveInitialCapacity(length);
+        for (unsigned i = 0; i < length; ++i)
+            m_widenedCharacters.uncheckedAppend(characters[i]);
+    }
+
     // A shallow copy of the string. Keeps the string buffer alive until the V8 engine garbage collects it.
     String m_plainString;
     // If this string is atomic or has been made atomic earlier the
@@ -120,12 +138,39 @@ private:
     // the original string alive because v8 may keep derived pointers
     // into that string.
     AtomicString m_atomicString;
+    Vector<UChar> m_widenedCharacters;
 
 #ifndef NDEBUG
     WTF::ThreadIdentifier m_threadId;
 #endif
 };
 
+// WebCoreAsciiStringResource hands the characters of an 8-bit ASCII string
+// to V8 as they are, so that exposing it to scripts does not widen it.
+class WebCoreAsciiStringResource : public v8::String::ExternalAsciiStringResource {
+public:
+    explicit WebCoreAsciiStringResource(const String& string)
+        : m_plainString(string)
+    {
+        ASSERT(string.impl()->is8Bit());
+        ASSERT(charactersAreAllASCII(string.impl()->characters8(), string.length()));
+        v8::V8::AdjustAmountOfExternalAllocatedMemory(string.length());
+    }
+
+    virtual ~WebCoreAsciiStringResource()
+    {
+        v8::V8::AdjustAmountOfExternalAllocatedMemory(-static_cast<int>(m_plainString.length()));
+    }
+
+    virtual const char* data() const { return reinterpret_cast<const char*>(m_plainString.impl()->characters8()); }
+
+    virtual size_t length() const { return m_plainString.impl()->length(); }
+
+private:
+    // Keeps the string buffer alive until the V8 engine garbage collects it.
+    String m_plainString;
+};
+
 String v8ValueToWebCoreString(v8::Handle<v8::Value> value)
 {
     if (value->IsString())
@@ -293,6 +338,8 @@ template <class S> struct StringTraits
     static S fromStringResource(WebCoreStringResource* resource);
 
     static S fromV8String(v8::Handle<v8::String> v8String, int length);
+
+    static S fromAsciiResource(const v8::String::ExternalAsciiStringResource* resource);
 };
 
 template<>
@@ -313,6 +360,11 @@ struct StringTraits<String>
         v8String->Write(reinterpret_cast<uint16_t*>(buffer), 0, length);
         return result;
     }
+
+    static String fromAsciiResource(const v8::String::ExternalAsciiStringResource* resource)
+    {
+        return String(resource->data(), resource->length());
+    }
 };
 
 template<>
@@ -337,6 +389,11 @@ struct StringTraits<AtomicString>
         v8String->Write(reinterpret_cast<uint16_t*>(buffer), 0, length);
         return AtomicString(tmp);
     }
+
+    static AtomicString fromAsciiResource(const v8::String::ExternalAsciiStringResource* resource)
+    {
+        return AtomicString(reinterpret_cast<const LChar*>(resource->data()), resource->length());
+    }
 };
 
 template <typename StringType>
@@ -352,6 +409,13 @@ StringType v8StringToWebCoreString(v8::Handle<v8::String> v8String, ExternalMode
         return StringImpl::empty();
     }
 
+    // ASCII external strings are not necessarily ours, so copy them rather than
+    // casting the resource back. The copy stays 8-bit.
+    if (v8String->IsExternalAscii()) {
+        const v8::String::ExternalAsciiStringResource* asciiResource = v8String->GetExternalAsciiStringResource();
+        return StringTraits<StringType>::fromAsciiResource(asciiResource);
+    }
+
     StringType result(StringTraits<StringType>::fromV8String(v8String, length));
 
     if (external == Externalize && v8String->CanMakeExternal()) {
@@ -438,6 +502,14 @@ void enableStringImplCache()
 
 static v8::Local<v8::String> makeExternalString(const String& string)
 {
+    if (string.impl()->is8Bit() && charactersAreAllASCII(string.impl()->characters8(), string.length())) {
+        WebCoreAsciiStringResource* asciiResource = new WebCoreAsciiStringResource(string);
+        v8::Local<v8::String> newString = v8::String::NewExternal(asciiResource);
+        if (newString.IsEmpty())
+            delete asciiResource;
+        return newString;
+    }
+
     WebCoreStringResource* stringResource = new WebCoreStringResource(string);
     v8::Local<v8::String> newString = v8::String::NewExternal(stringResource);
     if (newString.IsEmpty())
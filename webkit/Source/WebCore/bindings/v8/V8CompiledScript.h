@@ -0,0 +1,68 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef V8CompiledScript_h
+#define V8CompiledScript_h
+
+#include <v8.h>
+#include <wtf/FastAllocBase.h>
+#include <wtf/Noncopyable.h>
+#include <wtf/PassOwnPtr.h>
+#include <wtf/unicode/Unicode.h>
+
+namespace WebCore {
+
+// A context independent V8 script kept on its CachedScript, so that running
+// the same script again, in this or any other frame, skips compilation. The
+// lazily compiled code of its functions stays attached to the script as well.
+class V8CompiledScript {
+    WTF_MAKE_NONCOPYABLE(V8CompiledScript); WTF_MAKE_FAST_ALLOCATED;
+public:
+    static PassOwnPtr<V8CompiledScript> create(v8::Handle<v8::Script> script, size_t sourceLength)
+    {
+        return adoptPtr(new V8CompiledScript(script, sourceLength));
+    }
+
+    ~V8CompiledScript() { m_script.Dispose(); }
+
+    v8::Local<v8::Script> script() const { return v8::Local<v8::Script>::New(m_script); }
+
+    // The script keeps its source alive, account for at least that much.
+    size_t size() const { return m_sourceLength * sizeof(UChar); }
+
+private:
+    V8CompiledScript(v8::Handle<v8::Script> script, size_t sourceLength)
+        : m_script(v8::Persistent<v8::Script>::New(script))
+        , m_sourceLength(sourceLength)
+    {
+    }
+
+    v8::Persistent<v8::Script> m_script;
+    size_t m_sourceLength;
+};
+
+} // namespace WebCore
+
+#endif // V8CompiledScript_h
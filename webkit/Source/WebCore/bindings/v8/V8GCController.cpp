@@ -31,6 +31,11 @@
 #include "config.h"
 #include "V8GCController.h"
 
+#if PLATFORM(ANDROID)
+#define LOG_TAG "V8GCController"
+#include "AndroidLog.h"
+#endif
+
 #include "ActiveDOMObject.h"
 #include "Attr.h"
 #include "DOMDataStore.h"
@@ -54,6 +59,7 @@
 #include <algorithm>
 #include <utility>
 #include <v8-debug.h>
+#include <wtf/CurrentTime.h>
 #include <wtf/HashMap.h>
 #include <wtf/StdLibExtras.h>
 #include <wtf/UnusedParam.h>
@@ -211,6 +217,7 @@ public:
     GroupId(void* other) : m_type(OtherType), m_other(other) {}
     bool operator!() const { return m_type == NullType; }
     uintptr_t groupId() const { return m_groupId; }
+    Node* node() const { return m_type == NodeType ? m_node : 0; }
     RetainedObjectInfo* createRetainedObjectInfo() const
     {
         switch (m_type) {
@@ -258,6 +265,39 @@ bool operator<(const GrouperItem& a, const GrouperItem& b)
 
 typedef Vector<GrouperItem> GrouperList;
 
+// Maps nodes of detached trees to their root for the duration of one GC.
+typedef HashMap<Node*, Node*> DetachedRootCache;
+
+// Every node passed on the way up is remembered in |cache|, so the wrapped
+// nodes of a detached tree walk each ancestor once per GC rather than once
+// per wrapper.
+static Node* detachedRoot(Node* node, DetachedRootCache* cache)
+{
+    Node* root = node;
+    if (!cache) {
+        while (Node* parent = root->parentNode())
+            root = parent;
+        return root;
+    }
+
+    Vector<Node*, 16> path;
+    while (true) {
+        DetachedRootCache::iterator it = cache->find(root);
+        if (it != cache->end()) {
+            root = it->second;
+            break;
+        }
+        Node* parent = root->parentNode();
+        if (!parent)
+            break;
+        path.append(root);
+        root = parent;
+    }
+    for (size_t i = 0; i < path.size(); ++i)
+        cache->set(path[i], root);
+    return root;
+}
+
 // If the node is in document, put it in the ownerDocument's object group.
 //
 // If an image element was created by JavaScript "new Image",
@@ -266,7 +306,7 @@ typedef Vector<GrouperItem> GrouperList;
 //
 // Otherwise, the node is put in an object group identified by the root
 // element of the tree to which it belongs.
-static GroupId calculateGroupId(Node* node)
+static GroupId calculateGroupId(Node* node, DetachedRootCache* cache = 0)
 {
     if (node->inDocument() || (node->hasTagName(HTMLNames::imgTag) && !static_cast<HTMLImageElement*>(node)->haveFiredLoadEvent()))
         return GroupId(node->document());
@@ -278,10 +318,8 @@ static GroupId calculateGroupId(Node* node)
         // because it'll always be a group of 1.
         if (!root)
             return GroupId();
-    } else {
-        while (Node* parent = root->parentNode())
-            root = parent;
-    }
+    } else
+        root = detachedRoot(node, cache);
 
     return GroupId(root);
 }
@@ -324,12 +362,17 @@ static GroupId calculateGroupId(StyleBase* styleBase)
 
 class GrouperVisitor : public DOMWrapperMap<Node>::Visitor, public DOMWrapperMap<void>::Visitor {
 public:
+    GrouperVisitor()
+        : m_lastDocumentGroup(0)
+    {
+    }
+
     void visitDOMWrapper(DOMDataStore* store, Node* node, v8::Persistent<v8::Object> wrapper)
     {
-        GroupId groupId = calculateGroupId(node);
+        GroupId groupId = calculateGroupId(node, &m_detachedRoots);
         if (!groupId)
             return;
-        m_grouper.append(GrouperItem(groupId, wrapper));
+        append(groupId, wrapper);
     }
 
     void visitDOMWrapper(DOMDataStore* store, void* object, v8::Persistent<v8::Object> wrapper)
@@ -341,23 +384,23 @@ public:
             GroupId groupId(styleSheetList);
             if (Document* document = styleSheetList->document())
                 groupId = GroupId(document);
-            m_grouper.append(GrouperItem(groupId, wrapper));
+            append(groupId, wrapper);
 
         } else if (typeInfo->isSubclass(&V8DOMImplementation::info)) {
             DOMImplementation* domImplementation = static_cast<DOMImplementation*>(object);
             GroupId groupId(domImplementation);
             if (Document* document = domImplementation->ownerDocument())
                 groupId = GroupId(document);
-            m_grouper.append(GrouperItem(groupId, wrapper));
+            append(groupId, wrapper);
 
         } else if (typeInfo->isSubclass(&V8StyleSheet::info) || typeInfo->isSubclass(&V8CSSRule::info)) {
-            m_grouper.append(GrouperItem(calculateGroupId(static_cast<StyleBase*>(object)), wrapper));
+            append(calculateGroupId(static_cast<StyleBase*>(object)), wrapper);
 
         } else if (typeInfo->isSubclass(&V8CSSStyleDeclaration::info)) {
             CSSStyleDeclaration* cssStyleDeclaration = static_cast<CSSStyleDeclaration*>(object);
 
             GroupId groupId = calculateGroupId(cssStyleDeclaration);
-            m_grouper.append(GrouperItem(groupId, wrapper));
+            append(groupId, wrapper);
 
             // Keep alive "dirty" primitive values (i.e. the ones that
             // have user-added properties) by creating implicit
@@ -382,7 +425,13 @@ public:
 
     void applyGrouping()
     {
-        // Group by sorting by the group id.
+        for (size_t i = 0; i < m_documentGroups.size(); ++i) {
+            DocumentGroup& group = m_documentGroups[i];
+            if (group.m_wrappers.size() > 1)
+                v8::V8::AddObjectGroup(group.m_wrappers.data(), group.m_wrappers.size(), new RetainedDOMInfo(group.m_document));
+        }
+
+        // Group the rest by sorting by the group id.
         std::sort(m_grouper.begin(), m_grouper.end());
 
         for (size_t i = 0; i < m_grouper.size(); ) {
@@ -422,12 +471,82 @@ public:
     }
 
 private:
+    struct DocumentGroup {
+        explicit DocumentGroup(Document* document) : m_document(document) { }
+        Document* m_document;
+        Vector<v8::Persistent<v8::Value> > m_wrappers;
+    };
+
+    // Most wrappers belong to the group of their document, and there are only
+    // a few documents. Collecting those directly keeps them out of the sort.
+    void append(const GroupId& groupId, v8::Persistent<v8::Object> wrapper)
+    {
+        Node* node = groupId.node();
+        if (!node || !node->isDocumentNode()) {
+            m_grouper.append(GrouperItem(groupId, wrapper));
+            return;
+        }
+        if (wrapper.IsEmpty())
+            return;
+
+        Document* document = static_cast<Document*>(node);
+        if (m_lastDocumentGroup >= m_documentGroups.size() || m_documentGroups[m_lastDocumentGroup].m_document != document) {
+            size_t i = 0;
+            while (i < m_documentGroups.size() && m_documentGroups[i].m_document != document)
+                ++i;
+            if (i == m_documentGroups.size())
+                m_documentGroups.append(DocumentGroup(document));
+            m_lastDocumentGroup = i;
+        }
+        m_documentGroups[m_lastDocumentGroup].m_wrappers.append(wrapper);
+    }
+
     GrouperList m_grouper;
+    Vector<DocumentGroup> m_documentGroups;
+    size_t m_lastDocumentGroup;
+    DetachedRootCache m_detachedRoots;
 };
 
+#if PLATFORM(ANDROID)
+// Prologue times in log2 buckets of microseconds: bucket i counts the
+// prologues that took less than 2^i us, the last one everything longer.
+static const unsigned prologueHistogramBuckets = 20;
+static unsigned prologueHistogram[prologueHistogramBuckets];
+static unsigned prologueCount = 0;
+#endif
+
+static void recordPrologueTime(double seconds)
+{
+    int microseconds = static_cast<int>(seconds * 1000000);
+#if PLATFORM(CHROMIUM)
+    PlatformBridge::histogramCustomCounts("V8.GCPrologue", microseconds, 1, 1000000, 50);
+#elif PLATFORM(ANDROID)
+    unsigned bucket = 0;
+    while (bucket < prologueHistogramBuckets - 1 && (1 << bucket) <= microseconds)
+        ++bucket;
+    prologueHistogram[bucket]++;
+    if (++prologueCount % 16)
+        return;
+
+    char buffer[prologueHistogramBuckets * 24];
+    int length = 0;
+    for (unsigned i = 0; i < prologueHistogramBuckets; ++i) {
+        if (prologueHistogram[i])
+            length += snprintf(buffer + length, sizeof(buffer) - length, " <%uus:%u", 1u << i, prologueHistogram[i]);
+    }
+    buffer[length] = 0;
+    ALOGV("gcPrologue after %u GCs:%s", prologueCount, buffer);
+#else
+    UNUSED_PARAM(microseconds);
+#endif
+}
+
 // Create object groups for DOM tree nodes.
 void V8GCController::gcPrologue()
 {
+    // V8 only calls the global prologue before mark-compact collections,
+    // scavenges never see DOM wrapper groups.
+    double startTime = currentTime();
     v8::HandleScope scope;
 
 #ifndef NDEBUG
@@ -449,6 +568,8 @@ void V8GCController::gcPrologue()
     // Clean single element cache for string conversions.
     lastStringImpl = 0;
     lastV8String.Clear();
+
+    recordPrologueTime(currentTime() - startTime);
 }
 
 class GCEpilogueVisitor : public DOMWrapperMap<void>::Visitor {
@@ -50,6 +50,7 @@
 #include "V8Binding.h"
 #include "V8BindingState.h"
 #include "V8Collection.h"
+#include "V8CompiledScript.h"
 #include "V8DOMCoreException.h"
 #include "V8DOMMap.h"
 #include "V8DOMWindow.h"
@@ -59,6 +60,7 @@
 #include "V8IsolatedContext.h"
 #include "V8RangeException.h"
 #include "V8SQLException.h"
+#include "V8ScriptPreparser.h"
 #include "V8XMLHttpRequestException.h"
 #include "V8XPathException.h"
 #include "WorkerContext.h"
@@ -200,17 +202,41 @@ V8Proxy::~V8Proxy()
     windowShell()->destroyGlobal();
 }
 
-v8::Handle<v8::Script> V8Proxy::compileScript(v8::Handle<v8::String> code, const String& fileName, const TextPosition0& scriptStartPosition, v8::ScriptData* scriptData)
+static v8::ScriptOrigin scriptOrigin(const String& fileName, const TextPosition0& scriptStartPosition)
 {
     const uint16_t* fileNameString = fromWebCoreString(fileName);
     v8::Handle<v8::String> name = v8::String::New(fileNameString, fileName.length());
     v8::Handle<v8::Integer> line = v8::Integer::New(scriptStartPosition.m_line.zeroBasedInt());
     v8::Handle<v8::Integer> column = v8::Integer::New(scriptStartPosition.m_column.zeroBasedInt());
-    v8::ScriptOrigin origin(name, line, column);
+    return v8::ScriptOrigin(name, line, column);
+}
+
+v8::Handle<v8::Script> V8Proxy::compileScript(v8::Handle<v8::String> code, const String& fileName, const TextPosition0& scriptStartPosition, v8::ScriptData* scriptData)
+{
+    v8::ScriptOrigin origin = scriptOrigin(fileName, scriptStartPosition);
     v8::Handle<v8::Script> script = v8::Script::Compile(code, &origin, scriptData);
     return script;
 }
 
+#ifdef ANDROID_COMPILED_SCRIPT_CACHE
+v8::Handle<v8::Script> V8Proxy::compileCachedScript(const ScriptSourceCode& source)
+{
+    CachedScript* cachedScript = source.cachedScript();
+    if (V8CompiledScript* compiledScript = cachedScript->compiledScript())
+        return compiledScript->script();
+
+    // Compile a context independent script, it is bound to the current
+    // context every time it runs.
+    v8::Local<v8::String> code = v8ExternalString(source.source());
+    OwnPtr<v8::ScriptData> scriptData = precompileScript(code, cachedScript);
+    v8::ScriptOrigin origin = scriptOrigin(source.url(), WTF::toZeroBasedTextPosition(source.startPosition()));
+    v8::Local<v8::Script> script = v8::Script::New(code, &origin, scriptData.get());
+    if (!script.IsEmpty())
+        cachedScript->setCompiledScript(V8CompiledScript::create(script, source.source().length()));
+    return script;
+}
+#endif
+
 bool V8Proxy::handleOutOfMemory()
 {
     v8::Local<v8::Context> context = v8::Context::GetCurrent();
@@ -308,12 +334,8 @@ bool V8Proxy::setInjectedScriptContextDebugId(v8::Handle<v8::Context> targetCont
 
 PassOwnPtr<v8::ScriptData> V8Proxy::precompileScript(v8::Handle<v8::String> code, CachedScript* cachedScript)
 {
-    // A pseudo-randomly chosen ID used to store and retrieve V8 ScriptData from
-    // the CachedScript. If the format changes, this ID should be changed too.
-    static const unsigned dataTypeID = 0xECC13BD7;
-
-    // Very small scripts are not worth the effort to preparse.
-    static const int minPreparseLength = 1024;
+    static const unsigned dataTypeID = V8ScriptPreparser::dataTypeID;
+    static const int minPreparseLength = V8ScriptPreparser::minPreparseLength;
 
     if (!cachedScript || code->Length() < minPreparseLength)
         return 0;
@@ -322,10 +344,18 @@ PassOwnPtr<v8::ScriptData> V8Proxy::precompileScript(v8::Handle<v8::String> code
     if (cachedMetadata)
         return v8::ScriptData::New(cachedMetadata->data(), cachedMetadata->size());
 
+#ifdef ANDROID_BACKGROUND_PREPARSE
+    // Preparse data only speeds up compilation, so rather than preparsing on
+    // the main thread compile without it. The script is normally already
+    // queued from CachedScript::data(), this catches the ones that were not.
+    V8ScriptPreparser::shared().preparse(cachedScript);
+    return 0;
+#else
     OwnPtr<v8::ScriptData> scriptData(v8::ScriptData::PreCompile(code));
     cachedScript->setCachedMetadata(dataTypeID, scriptData->Data(), scriptData->Length());
 
     return scriptData.release();
+#endif
 }
 
 bool V8Proxy::executingScript() const
@@ -351,15 +381,26 @@ v8::Local<v8::Value> V8Proxy::evaluate(const ScriptSourceCode& source, Node* nod
         tryCatch.SetVerbose(true);
 
         // Compile the script.
-        v8::Local<v8::String> code = v8ExternalString(source.source());
 #if PLATFORM(CHROMIUM)
         PlatformBridge::traceEventBegin("v8.compile", node, "");
 #endif
+#ifdef ANDROID_COMPILED_SCRIPT_CACHE
+        v8::Handle<v8::Script> script;
+        if (source.cachedScript())
+            script = compileCachedScript(source);
+        else {
+            // Only scripts loaded through a CachedScript get preparse data.
+            v8::Local<v8::String> code = v8ExternalString(source.source());
+            script = compileScript(code, source.url(), WTF::toZeroBasedTextPosition(source.startPosition()));
+        }
+#else
+        v8::Local<v8::String> code = v8ExternalString(source.source());
         OwnPtr<v8::ScriptData> scriptData = precompileScript(code, source.cachedScript());
 
         // NOTE: For compatibility with WebCore, ScriptSourceCode's line starts at
         // 1, whereas v8 starts at 0.
         v8::Handle<v8::Script> script = compileScript(code, source.url(), WTF::toZeroBasedTextPosition(source.startPosition()), scriptData.get());
+#endif
 #if PLATFORM(CHROMIUM)
         PlatformBridge::traceEventEnd("v8.compile", node, "");
 
@@ -285,6 +285,11 @@ namespace WebCore {
         void resetIsolatedWorlds();
 
         PassOwnPtr<v8::ScriptData> precompileScript(v8::Handle<v8::String>, CachedScript*);
+#ifdef ANDROID_COMPILED_SCRIPT_CACHE
+        // Returns the script compiled earlier for the same CachedScript, or
+        // compiles it and keeps it on the CachedScript.
+        v8::Handle<v8::Script> compileCachedScript(const ScriptSourceCode&);
+#endif
 
         // Returns false when we're out of memory in V8.
         bool setInjectedScriptContextDebugId(v8::Handle<v8::Context> targetContext);
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "V8ScriptPreparser.h"
+
+#define LOG_TAG "V8ScriptPreparser"
+
+#include "AndroidLog.h"
+#include "CachedResourceHandle.h"
+#include "CachedScript.h"
+#include <v8.h>
+#include <wtf/MainThread.h>
+#include <wtf/OwnPtr.h>
+#include <wtf/PassOwnPtr.h>
+#include <wtf/StdLibExtras.h>
+#include <wtf/Vector.h>
+#include <wtf/text/WTFString.h>
+
+namespace WebCore {
+
+// The preparser recurses once per nesting level of the script, keep it well
+// within the default thread stack.
+static const size_t maxPreparseStackSize = 256 * 1024;
+
+class V8ScriptPreparser::Task {
+    WTF_MAKE_NONCOPYABLE(Task); WTF_MAKE_FAST_ALLOCATED;
+public:
+    Task(CachedScript* script, const String& source)
+        : m_script(script)
+        , m_source(source)
+    {
+    }
+
+    // Tasks are created and destroyed on the main thread, so both references
+    // only ever change there. The background thread only reads the characters
+    // of |m_source|, which cannot change while we hold it.
+    CachedResourceHandle<CachedScript> m_script;
+    String m_source;
+
+    // Filled in on the background thread.
+    Vector<char> m_data;
+};
+
+V8ScriptPreparser& V8ScriptPreparser::shared()
+{
+    DEFINE_STATIC_LOCAL(V8ScriptPreparser, preparser, ());
+    return preparser;
+}
+
+V8ScriptPreparser::V8ScriptPreparser()
+    : m_threadID(0)
+{
+}
+
+bool V8ScriptPreparser::start()
+{
+    ASSERT(isMainThread());
+    if (!m_threadID)
+        m_threadID = createThread(V8ScriptPreparser::threadEntryPointCallback, this, "WebCore: V8Preparser");
+    return m_threadID;
+}
+
+void V8ScriptPreparser::preparse(CachedScript* script)
+{
+    ASSERT(isMainThread());
+    if (!script || script->isLoading() || script->errorOccurred() || script->isPurgeable())
+        return;
+    if (m_pending.contains(script) || script->cachedMetadata(dataTypeID))
+        return;
+
+    const String& source = script->script();
+    if (source.length() < minPreparseLength || !start())
+        return;
+
+    m_pending.add(script);
+    m_queue.append(adoptPtr(new Task(script, source)));
+}
+
+void* V8ScriptPreparser::threadEntryPointCallback(void* preparser)
+{
+    return static_cast<V8ScriptPreparser*>(preparser)->threadEntryPoint();
+}
+
+void* V8ScriptPreparser::threadEntryPoint()
+{
+    ASSERT(!isMainThread());
+    while (OwnPtr<Task> task = m_queue.waitForMessage()) {
+        const String& source = task->m_source;
+        OwnPtr<v8::ScriptData> scriptData = adoptPtr(v8::ScriptData::PreCompile(
+            reinterpret_cast<const uint16_t*>(source.characters()), source.length(), maxPreparseStackSize));
+        if (scriptData && !scriptData->HasError())
+            task->m_data.append(scriptData->Data(), scriptData->Length());
+        else
+            ALOGV("could not preparse script of %u characters", source.length());
+        callOnMainThread(didPreparse, task.leakPtr());
+    }
+    return 0;
+}
+
+void V8ScriptPreparser::didPreparse(void* context)
+{
+    ASSERT(isMainThread());
+    OwnPtr<Task> task = adoptPtr(static_cast<Task*>(context));
+    CachedScript* script = task->m_script.get();
+    shared().m_pending.remove(script);
+
+    if (task->m_data.isEmpty() || script->cachedMetadata(dataTypeID))
+        return;
+    script->setCachedMetadata(dataTypeID, task->m_data.data(), task->m_data.size());
+}
+
+} // namespace WebCore
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef V8ScriptPreparser_h
+#define V8ScriptPreparser_h
+
+#include <wtf/HashSet.h>
+#include <wtf/MessageQueue.h>
+#include <wtf/Noncopyable.h>
+#include <wtf/Threading.h>
+
+namespace WebCore {
+
+class CachedScript;
+
+// V8ScriptPreparser runs the V8 preparser over downloaded scripts on a
+// background thread and stores the result as CachedMetadata on the
+// CachedScript, where V8Proxy::precompileScript() finds it. Queueing scripts
+// and storing the result happen on the main thread.
+class V8ScriptPreparser {
+    WTF_MAKE_NONCOPYABLE(V8ScriptPreparser);
+public:
+    // A pseudo-randomly chosen ID used to store and retrieve V8 ScriptData from
+    // the CachedScript. If the format changes, this ID should be changed too.
+    static const unsigned dataTypeID = 0xECC13BD7;
+
+    // Very small scripts are not worth the effort to preparse.
+    static const unsigned minPreparseLength = 1024;
+
+    static V8ScriptPreparser& shared();
+
+    // Queues |script| for preparsing, unless it is too small, already has
+    // preparse data or is already queued.
+    void preparse(CachedScript*);
+    bool isPending(CachedScript* script) const { return m_pending.contains(script); }
+
+private:
+    class Task;
+
+    V8ScriptPreparser();
+
+    bool start();
+
+    // Called on background thread.
+    static void* threadEntryPointCallback(void*);
+    void* threadEntryPoint();
+
+    // Called on main thread once a task has been preparsed.
+    static void didPreparse(void*);
+
+    ThreadIdentifier m_threadID;
+    MessageQueue<Task> m_queue;
+    HashSet<CachedScript*> m_pending;
+};
+
+} // namespace WebCore
+
+#endif // V8ScriptPreparser_h
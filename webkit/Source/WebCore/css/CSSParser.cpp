@@ -207,7 +207,12 @@ void CSSParser::setupParser(const char* prefix, const String& string, const char
     for (unsigned i = 0; i < strlen(prefix); i++)
         m_data[i] = prefix[i];
 
-    memcpy(m_data + strlen(prefix), string.characters(), string.length() * sizeof(UChar));
+    // Widen 8-bit strings (e.g. style attributes) straight into the buffer,
+    // characters() would keep a UTF-16 copy for the life of the string
+    if (string.is8Bit())
+        StringImpl::copyChars(m_data + strlen(prefix), string.impl()->characters8(), string.length());
+    else
+        memcpy(m_data + strlen(prefix), string.characters(), string.length() * sizeof(UChar));
 
     unsigned start = strlen(prefix) + string.length();
     unsigned end = start + strlen(suffix);
@@ -286,14 +291,26 @@ static inline bool isColorPropertyID(int propertyId)
     }
 }
 
+// The characters of |string|, widened into |buffer| if it is 8-bit so that
+// the string doesn't keep a UTF-16 copy of itself
+static const UChar* widenedCharacters(const String& string, Vector<UChar, 64>& buffer)
+{
+    if (!string.is8Bit())
+        return string.characters();
+    buffer.resize(string.length());
+    StringImpl::copyChars(buffer.data(), string.impl()->characters8(), string.length());
+    return buffer.data();
+}
+
 static bool parseColorValue(CSSMutableStyleDeclaration* declaration, int propertyId, const String& string, bool important, bool strict)
 {
     if (!string.length())
         return false;
     if (!isColorPropertyID(propertyId))
         return false;
+    Vector<UChar, 64> buffer;
     CSSParserString cssString;
-    cssString.characters = const_cast<UChar*>(string.characters());
+    cssString.characters = const_cast<UChar*>(widenedCharacters(string, buffer));
     cssString.length = string.length();
     int valueID = cssValueKeywordID(cssString);
     bool validPrimitive = false;
@@ -366,13 +383,14 @@ static inline bool isSimpleLengthPropertyID(int propertyId, bool& acceptsNegativ
 
 static bool parseSimpleLengthValue(CSSMutableStyleDeclaration* declaration, int propertyId, const String& string, bool important, bool strict)
 {
-    const UChar* characters = string.characters();
     unsigned length = string.length();
-    if (!characters || !length)
+    if (!length)
         return false;
     bool acceptsNegativeNumbers;
     if (!isSimpleLengthPropertyID(propertyId, acceptsNegativeNumbers))
         return false;
+    Vector<UChar, 64> buffer;
+    const UChar* characters = widenedCharacters(string, buffer);
 
     CSSPrimitiveValue::UnitTypes unit = CSSPrimitiveValue::CSS_NUMBER;
     if (length > 2 && characters[length - 2] == 'p' && characters[length - 1] == 'x') {
@@ -4296,7 +4314,8 @@ static inline bool mightBeRGB(const UChar* characters, unsigned length)
 
 bool CSSParser::parseColor(const String &name, RGBA32& rgb, bool strict)
 {
-    const UChar* characters = name.characters();
+    Vector<UChar, 64> buffer;
+    const UChar* characters = widenedCharacters(name, buffer);
     unsigned length = name.length();
     CSSPrimitiveValue::UnitTypes expect = CSSPrimitiveValue::CSS_UNKNOWN;
 
@@ -437,6 +437,10 @@ CSSStyleSelector::CSSStyleSelector(Document* document, StyleSheetList* styleShee
     , m_elementLinkState(NotInsideLink)
     , m_fontSelector(CSSFontSelector::create(document))
     , m_applyProperty(CSSStyleApplyProperty::sharedCSSStyleApplyProperty())
+#ifdef ANDROID_SHARED_STYLE_CACHE
+    , m_sharedStyleCacheHits(0)
+    , m_sharedStyleCacheMisses(0)
+#endif
 {
     m_matchAuthorAndUserStyles = matchAuthorAndUserStyles;
     
@@ -1166,6 +1170,132 @@ ALWAYS_INLINE RenderStyle* CSSStyleSelector::locateSharedStyle()
     return shareNode->renderStyle();
 }
 
+#ifdef ANDROID_SHARED_STYLE_CACHE
+// Mirrors the conditions of locateSharedStyle() and canShareStyleWithElement()
+// that don't depend on the element being shared with. Elements whose style
+// depends on more than their own attributes and states and their parent style
+// (mapped attributes, table attributes, form control states) don't use the cache.
+bool CSSStyleSelector::canUseSharedStyleCache() const
+{
+    if (!m_styledElement || !m_parentStyle || m_parentStyle == s_styleNotYetAvailable)
+        return false;
+    if (m_styledElement->inlineStyleDecl())
+        return false;
+    if (m_styledElement->hasMappedAttributes() || m_styledElement->canHaveAdditionalAttributeStyleDecls())
+        return false;
+    if (m_styledElement->hasID() && m_features.idsInRules.contains(m_styledElement->idForStyleResolution().impl()))
+        return false;
+    if (parentStylePreventsSharing(m_parentStyle))
+        return false;
+    if (m_element->isFormControlElement())
+        return false;
+    if (m_element == m_element->document()->cssTarget())
+        return false;
+#if USE(ACCELERATED_COMPOSITING)
+    if (m_element->hasTagName(iframeTag) || m_element->hasTagName(frameTag) || m_element->hasTagName(embedTag) || m_element->hasTagName(objectTag) || m_element->hasTagName(appletTag))
+        return false;
+#endif
+    if (equalIgnoringCase(m_element->fastGetAttribute(dirAttr), "auto"))
+        return false;
+    return true;
+}
+
+static inline unsigned addToSharedStyleHash(unsigned hash, unsigned value)
+{
+    return hash * 31 + value;
+}
+
+static inline unsigned atomicStringHash(const AtomicString& string)
+{
+    return string.isNull() ? 0 : string.impl()->hash();
+}
+
+unsigned CSSStyleSelector::sharedStyleCacheIndex() const
+{
+    unsigned hash = PtrHash<RenderStyle*>::hash(m_parentStyle);
+    hash = addToSharedStyleHash(hash, atomicStringHash(m_element->localName()));
+    if (m_element->hasClass())
+        hash = addToSharedStyleHash(hash, atomicStringHash(m_element->fastGetAttribute(classAttr)));
+    hash = addToSharedStyleHash(hash, m_element->hovered() | m_element->active() << 1 | m_element->focused() << 2 | m_elementLinkState << 3);
+    return hash % cSharedStyleCacheSize;
+}
+
+bool CSSStyleSelector::sharedStyleCacheEntryMatches(const SharedStyleCacheEntry& entry) const
+{
+    if (!entry.m_style || entry.m_parentStyle != m_parentStyle)
+        return false;
+    if (entry.m_tagName != m_element->tagQName())
+        return false;
+    if (entry.m_isLink != m_element->isLink() || entry.m_linkState != m_elementLinkState)
+        return false;
+    if (entry.m_hovered != m_element->hovered() || entry.m_active != m_element->active() || entry.m_focused != m_element->focused())
+        return false;
+    if (entry.m_className != (m_element->hasClass() ? m_element->fastGetAttribute(classAttr) : nullAtom))
+        return false;
+    if (entry.m_type != m_element->fastGetAttribute(typeAttr)
+        || entry.m_lang != m_element->fastGetAttribute(langAttr)
+        || entry.m_xmlLang != m_element->fastGetAttribute(XMLNames::langAttr)
+        || entry.m_readonly != m_element->fastGetAttribute(readonlyAttr))
+        return false;
+    if (entry.m_shadowPseudoId != m_element->shadowPseudoId())
+        return false;
+
+    // The style may have been made unique since it was cached
+    RenderStyle* style = entry.m_style.get();
+    return !style->unique() && !style->affectedByAttributeSelectors()
+        && !style->transitions() && !style->animations();
+}
+
+RenderStyle* CSSStyleSelector::findSharedStyleInCache(unsigned index)
+{
+    const SharedStyleCacheEntry& entry = m_sharedStyleCache[index];
+    if (!sharedStyleCacheEntryMatches(entry)) {
+        m_sharedStyleCacheMisses++;
+        return 0;
+    }
+    // Can't share if sibling rules apply, as in locateSharedStyle()
+    if (matchesSiblingRules() || parentStylePreventsSharing(m_parentStyle)) {
+        m_sharedStyleCacheMisses++;
+        return 0;
+    }
+    m_sharedStyleCacheHits++;
+    return entry.m_style.get();
+}
+
+void CSSStyleSelector::addSharedStyleToCache(unsigned index)
+{
+    RenderStyle* style = m_style.get();
+    if (style->unique() || style->affectedByAttributeSelectors() || style->transitions() || style->animations())
+        return;
+    // The declarations have been applied, matchesSiblingRules() needs them cleared
+    m_matchedDecls.clear();
+    if (matchesSiblingRules())
+        return;
+
+    SharedStyleCacheEntry& entry = m_sharedStyleCache[index];
+    entry.m_style = style;
+    entry.m_parentStyle = m_parentStyle;
+    entry.m_tagName = m_element->tagQName();
+    entry.m_className = m_element->hasClass() ? m_element->fastGetAttribute(classAttr) : nullAtom;
+    entry.m_type = m_element->fastGetAttribute(typeAttr);
+    entry.m_lang = m_element->fastGetAttribute(langAttr);
+    entry.m_xmlLang = m_element->fastGetAttribute(XMLNames::langAttr);
+    entry.m_readonly = m_element->fastGetAttribute(readonlyAttr);
+    entry.m_shadowPseudoId = m_element->shadowPseudoId();
+    entry.m_linkState = m_elementLinkState;
+    entry.m_isLink = m_element->isLink();
+    entry.m_hovered = m_element->hovered();
+    entry.m_active = m_element->active();
+    entry.m_focused = m_element->focused();
+}
+
+void CSSStyleSelector::clearSharedStyleCache()
+{
+    for (unsigned i = 0; i < cSharedStyleCacheSize; i++)
+        m_sharedStyleCache[i] = SharedStyleCacheEntry();
+}
+#endif
+
 void CSSStyleSelector::matchUARules(int& firstUARule, int& lastUARule)
 {
     // First we match rules from the user agent sheet.
@@ -1264,6 +1394,17 @@ PassRefPtr<RenderStyle> CSSStyleSelector::styleForElement(Element* e, RenderStyl
             return sharedStyle;
     }
 
+#ifdef ANDROID_SHARED_STYLE_CACHE
+    const bool useSharedStyleCache = allowSharing && !resolveForRootDefault && !matchVisitedPseudoClass
+        && canUseSharedStyleCache();
+    const unsigned sharedStyleCacheIndex = useSharedStyleCache ? this->sharedStyleCacheIndex() : 0;
+    if (useSharedStyleCache) {
+        RenderStyle* sharedStyle = findSharedStyleInCache(sharedStyleCacheIndex);
+        if (sharedStyle)
+            return sharedStyle;
+    }
+#endif
+
     // Compute our style allowing :visited to match first.
     RefPtr<RenderStyle> visitedStyle;
     if (!matchVisitedPseudoClass && m_parentStyle && (m_parentStyle->insideLink() || e->isLink()) && e->document()->usesLinkRules()) {
@@ -1500,6 +1641,11 @@ PassRefPtr<RenderStyle> CSSStyleSelector::styleForElement(Element* e, RenderStyl
         m_style->addCachedPseudoStyle(visitedStyle.release());
     }
 
+#ifdef ANDROID_SHARED_STYLE_CACHE
+    if (useSharedStyleCache)
+        addSharedStyleToCache(sharedStyleCacheIndex);
+#endif
+
     if (!matchVisitedPseudoClass)
         initElement(0); // Clear out for the next resolve.
 
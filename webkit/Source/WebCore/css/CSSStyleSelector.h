@@ -26,6 +26,7 @@
 #include "CSSRule.h"
 #include "LinkHash.h"
 #include "MediaQueryExp.h"
+#include "QualifiedName.h"
 #include "RenderStyle.h"
 #include <wtf/BloomFilter.h>
 #include <wtf/HashMap.h>
@@ -118,6 +119,14 @@ public:
         RenderStyle* parentStyle() const { return m_parentStyle; }
         Element* element() const { return m_element; }
 
+#ifdef ANDROID_SHARED_STYLE_CACHE
+        // Forgets the styles kept for sharing, as their inputs outside of the
+        // style sheets (fonts, settings) may have changed
+        void clearSharedStyleCache();
+        unsigned sharedStyleCacheHits() const { return m_sharedStyleCacheHits; }
+        unsigned sharedStyleCacheMisses() const { return m_sharedStyleCacheMisses; }
+#endif
+
     private:
         void initForStyleResolve(Element*, RenderStyle* parentStyle = 0, PseudoId = NOPSEUDO);
         void initElement(Element*);
@@ -126,6 +135,14 @@ public:
         Node* locateCousinList(Element* parent, unsigned& visitedNodeCount) const;
         Node* findSiblingForStyleSharing(Node*, unsigned& count) const;
         bool canShareStyleWithElement(Node*) const;
+#ifdef ANDROID_SHARED_STYLE_CACHE
+        struct SharedStyleCacheEntry;
+        bool canUseSharedStyleCache() const;
+        unsigned sharedStyleCacheIndex() const;
+        bool sharedStyleCacheEntryMatches(const SharedStyleCacheEntry&) const;
+        RenderStyle* findSharedStyleInCache(unsigned index);
+        void addSharedStyleToCache(unsigned index);
+#endif
         
         void pushParentStackFrame(Element* parent);
         void popParentStackFrame();
@@ -361,6 +378,39 @@ public:
         Vector<MediaQueryResult*> m_viewportDependentMediaQueryResults;
 
         const CSSStyleApplyProperty& m_applyProperty;
+
+#ifdef ANDROID_SHARED_STYLE_CACHE
+        // Styles that can be shared by elements anywhere in the document,
+        // unlike locateSharedStyle() which only looks at the siblings and
+        // cousins. An element can share the style of one with the same tag,
+        // classes and style relevant attributes and states, whose parent has
+        // the very same style. Since a style is only ever shared under these
+        // conditions, equal parent styles mean equivalent ancestors.
+        struct SharedStyleCacheEntry {
+            SharedStyleCacheEntry() : m_linkState(NotInsideLink), m_isLink(false), m_hovered(false), m_active(false), m_focused(false) { }
+
+            RefPtr<RenderStyle> m_style;
+            // Keeps the parent style alive so that it can't be reallocated
+            // at the same address for another style
+            RefPtr<RenderStyle> m_parentStyle;
+            QualifiedName m_tagName;
+            AtomicString m_className;
+            AtomicString m_type;
+            AtomicString m_lang;
+            AtomicString m_xmlLang;
+            AtomicString m_readonly;
+            AtomicString m_shadowPseudoId;
+            EInsideLink m_linkState;
+            bool m_isLink;
+            bool m_hovered;
+            bool m_active;
+            bool m_focused;
+        };
+        static const unsigned cSharedStyleCacheSize = 128;
+        SharedStyleCacheEntry m_sharedStyleCache[cSharedStyleCacheSize];
+        unsigned m_sharedStyleCacheHits;
+        unsigned m_sharedStyleCacheMisses;
+#endif
     };
 
 } // namespace WebCore
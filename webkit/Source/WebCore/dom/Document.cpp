@@ -440,6 +440,10 @@ Document::Document(Frame* frame, const KURL& url, bool isXHTML, bool isHTML)
 {
     m_document = this;
 
+#ifdef ANDROID_DOCUMENT_ARENA
+    m_arena = DocumentArena::create();
+#endif
+
     m_pageGroupUserSheetCacheValid = false;
 
     m_printing = false;
@@ -537,6 +541,11 @@ Document::~Document()
 
     m_renderArena.clear();
 
+#ifdef ANDROID_DOCUMENT_ARENA
+    // The nodes are gone by now, give their slabs back in one go
+    m_arena->documentDestroyed();
+#endif
+
     clearAXObjectCache();
 
     m_decoder = 0;
@@ -706,6 +715,9 @@ void Document::cacheDocumentElement() const
 
 PassRefPtr<Element> Document::createElement(const AtomicString& name, ExceptionCode& ec)
 {
+#ifdef ANDROID_DOCUMENT_ARENA
+    DocumentArena::Scope arenaScope(m_arena.get());
+#endif
     if (!isValidName(name)) {
         ec = INVALID_CHARACTER_ERR;
         return 0;
@@ -724,6 +736,9 @@ PassRefPtr<DocumentFragment> Document::createDocumentFragment()
 
 PassRefPtr<Text> Document::createTextNode(const String& data)
 {
+#ifdef ANDROID_DOCUMENT_ARENA
+    DocumentArena::Scope arenaScope(m_arena.get());
+#endif
     return Text::create(this, data);
 }
 
@@ -936,6 +951,9 @@ bool Document::hasPrefixNamespaceMismatch(const QualifiedName& qName)
 // FIXME: This should really be in a possible ElementFactory class
 PassRefPtr<Element> Document::createElement(const QualifiedName& qName, bool createdByParser)
 {
+#ifdef ANDROID_DOCUMENT_ARENA
+    DocumentArena::Scope arenaScope(m_arena.get());
+#endif
     RefPtr<Element> e;
 
     // FIXME: Use registered namespaces and look up in a hash to find the right factory.
@@ -1449,6 +1467,10 @@ void Document::recalcStyle(StyleChange change)
     
     if (m_inStyleRecalc)
         return; // Guard against re-entrancy. -dwh
+
+#ifdef ANDROID_DOCUMENT_ARENA
+    DocumentArena::Scope arenaScope(m_arena.get());
+#endif
     
     if (m_hasDirtyStyleSelector)
         recalcStyleSelector();
@@ -1475,6 +1497,10 @@ void Document::recalcStyle(StyleChange change)
     if (change == Force) {
         // style selector may set this again during recalc
         m_hasNodesWithPlaceholderStyle = false;
+#ifdef ANDROID_SHARED_STYLE_CACHE
+        if (m_styleSelector)
+            m_styleSelector->clearSharedStyleCache();
+#endif
         
         RefPtr<RenderStyle> documentStyle = CSSStyleSelector::styleForDocument(this);
         StyleChange ch = diff(documentStyle.get(), renderer()->style());
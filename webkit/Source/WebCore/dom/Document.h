@@ -546,6 +546,10 @@ public:
 
     RenderArena* renderArena() { return m_renderArena.get(); }
 
+#ifdef ANDROID_DOCUMENT_ARENA
+    DocumentArena* arena() const { return m_arena.get(); }
+#endif
+
     RenderView* renderView() const;
 
     void clearAXObjectCache();
@@ -1278,6 +1282,9 @@ private:
     RefPtr<Element> m_titleElement;
 
     OwnPtr<RenderArena> m_renderArena;
+#ifdef ANDROID_DOCUMENT_ARENA
+    RefPtr<DocumentArena> m_arena;
+#endif
 
 #if !PLATFORM(ANDROID)
     mutable AXObjectCache* m_axObjectCache;
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "DocumentArena.h"
+
+#include <malloc.h>
+#include <stdint.h>
+#include <wtf/Assertions.h>
+#include <wtf/FastMalloc.h>
+#include <wtf/MainThread.h>
+
+// Slabs are aligned to their size, so that an object's slab is found by
+// masking its address
+#define SLAB_SIZE (16 * 1024)
+#define SIZE_CLASS_STEP 8
+#define MAX_CELL_SIZE 256
+
+namespace WebCore {
+
+COMPILE_ASSERT(MAX_CELL_SIZE == 32 * SIZE_CLASS_STEP, size_classes_cover_cells);
+
+struct DocumentArena::Slab {
+    DocumentArena* arena;
+    // Links in the size class' list of slabs with free cells
+    Slab* previous;
+    Slab* next;
+    bool isAvailable;
+    // Freed cells, linked through their first word
+    void* freeList;
+    // Cells past this one have never been handed out, and are not touched
+    // until they are, so that a new slab costs no more RSS than it uses
+    char* unused;
+    char* end;
+    unsigned sizeClass;
+    unsigned cellSize;
+    unsigned liveCount;
+#ifndef NDEBUG
+    unsigned signature;
+#endif
+};
+
+#ifndef NDEBUG
+static const unsigned slabSignature = 0xDA5AB0A5;
+#endif
+
+static const size_t slabHeaderSize = (sizeof(DocumentArena::Slab) + SIZE_CLASS_STEP - 1) & ~(SIZE_CLASS_STEP - 1);
+
+static DocumentArena* gCurrentArena = 0;
+static bool gArenaEnabled = true;
+static DocumentArena::Stats gStats;
+
+static inline unsigned sizeClassFor(size_t size)
+{
+    return (size + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP - 1;
+}
+
+static inline DocumentArena::Slab* slabFor(void* p)
+{
+    return reinterpret_cast<DocumentArena::Slab*>(reinterpret_cast<uintptr_t>(p) & ~(SLAB_SIZE - 1));
+}
+
+DocumentArena::DocumentArena()
+    : m_documentDestroyed(false)
+{
+    for (unsigned i = 0; i < s_sizeClassCount; i++)
+        m_sizeClasses[i].available = 0;
+}
+
+DocumentArena::~DocumentArena()
+{
+#ifndef NDEBUG
+    // Every slab holds a ref, so all of them are gone by now
+    for (unsigned i = 0; i < s_sizeClassCount; i++)
+        ASSERT(!m_sizeClasses[i].available);
+#endif
+}
+
+void* DocumentArena::allocate(size_t size)
+{
+    if (!gArenaEnabled || !size || size > MAX_CELL_SIZE) {
+        gStats.liveObjects++;
+        gStats.totalObjects++;
+        gStats.systemMallocs++;
+        return fastMalloc(size);
+    }
+    return current()->allocateCell(sizeClassFor(size));
+}
+
+void DocumentArena::free(void* p, size_t size)
+{
+    if (!p)
+        return;
+    if (!gArenaEnabled || !size || size > MAX_CELL_SIZE) {
+        gStats.liveObjects--;
+        gStats.systemFrees++;
+        fastFree(p);
+        return;
+    }
+    Slab* slab = slabFor(p);
+    ASSERT(slab->signature == slabSignature);
+    ASSERT(slab->sizeClass == sizeClassFor(size));
+    slab->arena->freeCell(slab, p);
+}
+
+DocumentArena* DocumentArena::current()
+{
+    if (gCurrentArena)
+        return gCurrentArena;
+    // Nodes and styles created outside of any document's scope
+    static DocumentArena* sharedArena = create().leakRef();
+    return sharedArena;
+}
+
+DocumentArena::Scope::Scope(DocumentArena* arena)
+    : m_previous(gCurrentArena)
+{
+    ASSERT(isMainThread());
+    gCurrentArena = arena;
+}
+
+DocumentArena::Scope::~Scope()
+{
+    gCurrentArena = m_previous;
+}
+
+void DocumentArena::documentDestroyed()
+{
+    m_documentDestroyed = true;
+    for (unsigned i = 0; i < s_sizeClassCount; i++) {
+        Slab* slab = m_sizeClasses[i].available;
+        while (slab) {
+            Slab* next = slab->next;
+            if (!slab->liveCount)
+                releaseSlab(slab);
+            slab = next;
+        }
+    }
+}
+
+const DocumentArena::Stats& DocumentArena::stats()
+{
+    return gStats;
+}
+
+void DocumentArena::setEnabled(bool enabled)
+{
+    ASSERT(!gStats.totalObjects && !gStats.systemMallocs);
+    gArenaEnabled = enabled;
+}
+
+void* DocumentArena::allocateCell(unsigned sizeClass)
+{
+    ASSERT(isMainThread());
+    ASSERT(sizeClass < s_sizeClassCount);
+    Slab* slab = m_sizeClasses[sizeClass].available;
+    if (!slab)
+        slab = createSlab(sizeClass);
+
+    void* cell = slab->freeList;
+    if (cell)
+        slab->freeList = *static_cast<void**>(cell);
+    else {
+        cell = slab->unused;
+        slab->unused += slab->cellSize;
+    }
+    slab->liveCount++;
+    if (!slab->freeList && slab->unused + slab->cellSize > slab->end)
+        unlinkSlab(slab);
+
+    gStats.liveObjects++;
+    gStats.totalObjects++;
+    return cell;
+}
+
+void DocumentArena::freeCell(Slab* slab, void* cell)
+{
+    ASSERT(isMainThread());
+    ASSERT(slab->liveCount);
+    *static_cast<void**>(cell) = slab->freeList;
+    slab->freeList = cell;
+    slab->liveCount--;
+    gStats.liveObjects--;
+
+    if (!slab->isAvailable) {
+        SizeClass& sizeClass = m_sizeClasses[slab->sizeClass];
+        slab->previous = 0;
+        slab->next = sizeClass.available;
+        if (slab->next)
+            slab->next->previous = slab;
+        sizeClass.available = slab;
+        slab->isAvailable = true;
+    }
+
+    // Keep the last slab of a size class around while the document lives, so
+    // that freeing and allocating a single object does not churn slabs
+    if (!slab->liveCount && (m_documentDestroyed || slab->next || slab->previous))
+        releaseSlab(slab);
+}
+
+DocumentArena::Slab* DocumentArena::createSlab(unsigned sizeClass)
+{
+    Slab* slab = static_cast<Slab*>(memalign(SLAB_SIZE, SLAB_SIZE));
+    if (!slab)
+        CRASH();
+    gStats.systemMallocs++;
+    gStats.liveSlabs++;
+
+    slab->arena = this;
+    slab->previous = 0;
+    slab->next = m_sizeClasses[sizeClass].available;
+    if (slab->next)
+        slab->next->previous = slab;
+    m_sizeClasses[sizeClass].available = slab;
+    slab->isAvailable = true;
+    slab->freeList = 0;
+    slab->unused = reinterpret_cast<char*>(slab) + slabHeaderSize;
+    slab->end = reinterpret_cast<char*>(slab) + SLAB_SIZE;
+    slab->sizeClass = sizeClass;
+    slab->cellSize = (sizeClass + 1) * SIZE_CLASS_STEP;
+    slab->liveCount = 0;
+#ifndef NDEBUG
+    slab->signature = slabSignature;
+#endif
+    ref();
+    return slab;
+}
+
+void DocumentArena::releaseSlab(Slab* slab)
+{
+    ASSERT(!slab->liveCount);
+    unlinkSlab(slab);
+#ifndef NDEBUG
+    slab->signature = 0;
+#endif
+    ::free(slab);
+    gStats.systemFrees++;
+    gStats.liveSlabs--;
+    // May delete the arena, if this was the last slab of a destroyed document
+    deref();
+}
+
+void DocumentArena::unlinkSlab(Slab* slab)
+{
+    if (!slab->isAvailable)
+        return;
+    if (slab->previous)
+        slab->previous->next = slab->next;
+    else
+        m_sizeClasses[slab->sizeClass].available = slab->next;
+    if (slab->next)
+        slab->next->previous = slab->previous;
+    slab->previous = 0;
+    slab->next = 0;
+    slab->isAvailable = false;
+}
+
+} // namespace WebCore
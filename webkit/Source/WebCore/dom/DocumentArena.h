@@ -0,0 +1,116 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DocumentArena_h
+#define DocumentArena_h
+
+#include <wtf/Noncopyable.h>
+#include <wtf/PassRefPtr.h>
+#include <wtf/RefCounted.h>
+
+namespace WebCore {
+
+// Size class slab allocator for nodes and styles, which would otherwise each
+// be a separate system malloc (Android builds use USE_SYSTEM_MALLOC).
+//
+// Each Document owns an arena, and the objects allocated while a Scope for it
+// is active (parsing, script creating nodes, style recalc) share its slabs,
+// so that the slabs empty out and go back to the system together when the
+// document goes away instead of leaving holes between other pages' objects.
+// Every slab keeps a ref on its arena, and the arena is found from an object's
+// address, so objects may outlive their document (adopted nodes, shared
+// styles) and may be freed while any other arena is current.
+//
+// Objects larger than the largest size class use fastMalloc. The sized
+// operator delete is used to tell the two apart, so classes using the arena
+// must be deleted through their most derived type or a virtual destructor.
+class DocumentArena : public RefCounted<DocumentArena> {
+public:
+    static PassRefPtr<DocumentArena> create() { return adoptRef(new DocumentArena); }
+    ~DocumentArena();
+
+    // For operator new and delete of the classes using the arena. allocate()
+    // uses the current arena, free() the arena the object came from.
+    static void* allocate(size_t);
+    static void free(void*, size_t);
+
+    // The arena of the document being worked on, or a shared arena
+    static DocumentArena* current();
+
+    class Scope {
+        WTF_MAKE_NONCOPYABLE(Scope);
+    public:
+        Scope(DocumentArena*);
+        ~Scope();
+
+    private:
+        DocumentArena* m_previous;
+    };
+
+    // Called when the owning document is destroyed. Releases the empty slabs,
+    // and from then on every slab as soon as its last object is freed.
+    void documentDestroyed();
+
+    struct Stats {
+        size_t liveObjects;
+        size_t liveSlabs;
+        size_t totalObjects;
+        // System allocations made for the objects: one per slab and per large
+        // object, or one per object when the arena is disabled
+        size_t systemMallocs;
+        size_t systemFrees;
+    };
+    static const Stats& stats();
+
+    // Makes every allocation a fastMalloc, to compare against. Must be called
+    // before the first node or style is allocated.
+    static void setEnabled(bool);
+
+    // A slab of cells of one size class, see DocumentArena.cpp
+    struct Slab;
+
+private:
+    struct SizeClass {
+        // Slabs with free cells, the first one is allocated from
+        Slab* available;
+    };
+
+    DocumentArena();
+
+    void* allocateCell(unsigned sizeClass);
+    void freeCell(Slab*, void*);
+    Slab* createSlab(unsigned sizeClass);
+    void releaseSlab(Slab*);
+    void unlinkSlab(Slab*);
+
+    // Size classes are multiples of 8 bytes up to 256 bytes
+    static const unsigned s_sizeClassCount = 32;
+    SizeClass m_sizeClasses[s_sizeClassCount];
+    bool m_documentDestroyed;
+};
+
+} // namespace WebCore
+
+#endif // DocumentArena_h
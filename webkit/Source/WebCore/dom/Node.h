@@ -25,6 +25,7 @@
 #ifndef Node_h
 #define Node_h
 
+#include "DocumentArena.h"
 #include "EventTarget.h"
 #include "KURLHash.h"
 #include "RenderStyleConstants.h"
@@ -123,6 +124,12 @@ public:
 
     static bool isSupported(const String& feature, const String& version);
 
+#ifdef ANDROID_DOCUMENT_ARENA
+    // Nodes share the slabs of the document they are created for, see DocumentArena
+    void* operator new(size_t size) { return DocumentArena::allocate(size); }
+    void operator delete(void* p, size_t size) { DocumentArena::free(p, size); }
+#endif
+
     static void startIgnoringLeaks();
     static void stopIgnoringLeaks();
 
@@ -33,6 +33,12 @@ class CSSStyleSheet;
 
 class ProcessingInstruction : public ContainerNode, private CachedResourceClient {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // CachedResourceClient has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     static PassRefPtr<ProcessingInstruction> create(Document*, const String& target, const String& data);
     virtual ~ProcessingInstruction();
 
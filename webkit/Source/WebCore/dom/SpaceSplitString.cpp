@@ -29,30 +29,29 @@ using namespace WTF;
 
 namespace WebCore {
 
-static bool hasNonASCIIOrUpper(const String& string)
+template<typename CharacterType>
+static bool hasNonASCIIOrUpper(const CharacterType* characters, unsigned length)
 {
-    const UChar* characters = string.characters();
-    unsigned length = string.length();
     bool hasUpper = false;
-    UChar ored = 0;
+    CharacterType ored = 0;
     for (unsigned i = 0; i < length; i++) {
-        UChar c = characters[i];
+        CharacterType c = characters[i];
         hasUpper |= isASCIIUpper(c);
         ored |= c;
     }
     return hasUpper || (ored & ~0x7F);
 }
 
-void SpaceSplitStringData::createVector()
+static bool hasNonASCIIOrUpper(const String& string)
 {
-    ASSERT(!m_createdVector);
-    ASSERT(m_vector.isEmpty());
-
-    if (m_shouldFoldCase && hasNonASCIIOrUpper(m_string))
-        m_string = m_string.foldCase();
+    if (string.is8Bit())
+        return hasNonASCIIOrUpper(string.impl()->characters8(), string.length());
+    return hasNonASCIIOrUpper(string.characters(), string.length());
+}
 
-    const UChar* characters = m_string.characters();
-    unsigned length = m_string.length();
+template<typename CharacterType>
+static void appendSpaceSeparated(Vector<AtomicString, 8>& vector, const CharacterType* characters, unsigned length)
+{
     unsigned start = 0;
     while (true) {
         while (start < length && isHTMLSpace(characters[start]))
@@ -63,10 +62,25 @@ void SpaceSplitStringData::createVector()
         while (end < length && isNotHTMLSpace(characters[end]))
             ++end;
 
-        m_vector.append(AtomicString(characters + start, end - start));
+        vector.append(AtomicString(characters + start, end - start));
 
         start = end + 1;
     }
+}
+
+void SpaceSplitStringData::createVector()
+{
+    ASSERT(!m_createdVector);
+    ASSERT(m_vector.isEmpty());
+
+    if (m_shouldFoldCase && hasNonASCIIOrUpper(m_string))
+        m_string = m_string.foldCase();
+
+    // Most class attributes are 8-bit, split them without widening them
+    if (m_string.is8Bit())
+        appendSpaceSeparated(m_vector, m_string.impl()->characters8(), m_string.length());
+    else
+        appendSpaceSeparated(m_vector, m_string.characters(), m_string.length());
 
     m_string = String();
     m_createdVector = true;
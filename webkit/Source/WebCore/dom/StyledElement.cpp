@@ -210,16 +210,23 @@ bool StyledElement::mapToEntry(const QualifiedName& attrName, MappedAttributeEnt
     return true;
 }
 
-void StyledElement::classAttributeChanged(const AtomicString& newClassString)
+template<typename CharacterType>
+static bool containsNonHTMLSpace(const CharacterType* characters, unsigned length)
 {
-    const UChar* characters = newClassString.characters();
-    unsigned length = newClassString.length();
-    unsigned i;
-    for (i = 0; i < length; ++i) {
+    for (unsigned i = 0; i < length; ++i) {
         if (isNotHTMLSpace(characters[i]))
-            break;
+            return true;
     }
-    bool hasClass = i < length;
+    return false;
+}
+
+void StyledElement::classAttributeChanged(const AtomicString& newClassString)
+{
+    bool hasClass;
+    if (newClassString.string().is8Bit())
+        hasClass = containsNonHTMLSpace(newClassString.impl()->characters8(), newClassString.length());
+    else
+        hasClass = containsNonHTMLSpace(newClassString.characters(), newClassString.length());
     setHasClass(hasClass);
     if (hasClass) {
         attributes()->setClass(newClassString);
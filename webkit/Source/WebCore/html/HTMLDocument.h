@@ -35,6 +35,12 @@ class HTMLElement;
 
 class HTMLDocument : public Document, public CachedResourceClient {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // CachedResourceClient has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     static PassRefPtr<HTMLDocument> create(Frame* frame, const KURL& url)
     {
         return adoptRef(new HTMLDocument(frame, url));
@@ -37,6 +37,12 @@ class KURL;
 
 class HTMLLinkElement : public HTMLElement, public CachedResourceClient {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // CachedResourceClient has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     struct RelAttribute {
         bool m_isStyleSheet;
         bool m_isIcon;
@@ -31,6 +31,12 @@ namespace WebCore {
 
 class HTMLScriptElement : public HTMLElement, public ScriptElement {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // ScriptElement has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     static PassRefPtr<HTMLScriptElement> create(const QualifiedName&, Document*, bool wasInsertedByParser);
 
     String text() const { return scriptContent(); }
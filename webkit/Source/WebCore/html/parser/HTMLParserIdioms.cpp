@@ -32,9 +32,9 @@
 
 namespace WebCore {
 
-String stripLeadingAndTrailingHTMLSpaces(const String& string)
+template<typename CharacterType>
+static String stripLeadingAndTrailingHTMLSpaces(const String& string, const CharacterType* characters)
 {
-    const UChar* characters = string.characters();
     unsigned length = string.length();
 
     unsigned numLeadingSpaces;
@@ -57,6 +57,14 @@ String stripLeadingAndTrailingHTMLSpaces(const String& string)
     return string.substring(numLeadingSpaces, length - (numLeadingSpaces + numTrailingSpaces));
 }
 
+String stripLeadingAndTrailingHTMLSpaces(const String& string)
+{
+    // Reading 8-bit values through characters() would widen them for good
+    if (string.is8Bit())
+        return stripLeadingAndTrailingHTMLSpaces(string, string.impl()->characters8());
+    return stripLeadingAndTrailingHTMLSpaces(string, string.characters());
+}
+
 String serializeForNumberType(double number)
 {
     // According to HTML5, "the best representation of the number n as a floating
@@ -170,12 +178,11 @@ bool parseToDoubleForNumberTypeWithDecimalPlaces(const String& string, double *r
 }
 
 // http://www.whatwg.org/specs/web-apps/current-work/#rules-for-parsing-integers
-bool parseHTMLInteger(const String& input, int& value)
+template<typename CharacterType>
+static bool parseHTMLInteger(const CharacterType* position, const CharacterType* end, int& value)
 {
     // Step 1
     // Step 2
-    const UChar* position = input.characters();
-    const UChar* end = position + input.length();
 
     // Step 3
     int sign = 1;
@@ -219,4 +226,14 @@ bool parseHTMLInteger(const String& input, int& value)
     return true;
 }
 
+bool parseHTMLInteger(const String& input, int& value)
+{
+    if (input.is8Bit()) {
+        const LChar* characters = input.impl()->characters8();
+        return parseHTMLInteger(characters, characters + input.length(), value);
+    }
+    const UChar* characters = input.characters();
+    return parseHTMLInteger(characters, characters + input.length(), value);
+}
+
 }
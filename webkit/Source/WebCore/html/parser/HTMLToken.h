@@ -404,7 +404,7 @@ public:
             break;
         }
         case HTMLToken::Comment:
-            m_data = String(token.comment().data(), token.comment().size());
+            m_data = StringImpl::create8BitIfPossible(token.comment().data(), token.comment().size());
             break;
         case HTMLToken::Character:
             m_externalCharacters = &token.characters();
@@ -550,8 +550,10 @@ inline void AtomicHTMLToken::initializeAttributes(const HTMLToken::AttributeList
         ASSERT(attribute.m_valueRange.m_start);
         ASSERT(attribute.m_valueRange.m_end);
 
-        String name(attribute.m_name.data(), attribute.m_name.size());
-        String value(attribute.m_value.data(), attribute.m_value.size());
+        // Atomize straight from the token buffers so that Latin-1 names and
+        // values are stored in 8-bit strings.
+        AtomicString name(attribute.m_name.data(), attribute.m_name.size());
+        AtomicString value = attribute.m_value.isEmpty() ? emptyAtom : AtomicString(attribute.m_value.data(), attribute.m_value.size());
         m_attributes->insertAttribute(Attribute::createMapped(name, value), false);
     }
 }
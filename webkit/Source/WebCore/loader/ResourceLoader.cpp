@@ -448,6 +448,37 @@ void ResourceLoader::didReceiveData(ResourceHandle*, const char* data, int lengt
     InspectorInstrumentation::didReceiveResourceData(cookie);
 }
 
+#if PLATFORM(ANDROID)
+void ResourceLoader::didReceiveDataSegments(const Vector<RefPtr<SharedBufferSegment> >& segments)
+{
+    // Protect this in this delegate method since the additional processing can do
+    // anything including possibly derefing this; one example of this is Radar 3266216.
+    RefPtr<ResourceLoader> protector(this);
+
+    int length = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        SharedBufferSegment* segment = segments[i].get();
+        if (m_shouldBufferData) {
+            if (!m_resourceData)
+                m_resourceData = SharedBuffer::create();
+            m_resourceData->append(segment);
+        }
+        length += segment->size();
+    }
+
+    // The notifier only counts the bytes, tell it about the whole batch at once
+    if (length && m_sendResourceLoadCallbacks && m_frame)
+        frameLoader()->notifier()->didReceiveData(this, 0, length, length);
+}
+
+void ResourceLoader::didReceiveDataSegments(ResourceHandle*, const Vector<RefPtr<SharedBufferSegment> >& segments)
+{
+    InspectorInstrumentationCookie cookie = InspectorInstrumentation::willReceiveResourceData(m_frame.get(), identifier());
+    didReceiveDataSegments(segments);
+    InspectorInstrumentation::didReceiveResourceData(cookie);
+}
+#endif
+
 void ResourceLoader::didFinishLoading(ResourceHandle*, double finishTime)
 {
     didFinishLoading(finishTime);
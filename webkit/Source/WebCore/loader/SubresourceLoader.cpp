@@ -34,6 +34,7 @@
 #include "FrameLoader.h"
 #include "ResourceHandle.h"
 #include "SecurityOrigin.h"
+#include "SharedBuffer.h"
 #include "SubresourceLoaderClient.h"
 #include <wtf/RefCountedLeakCounter.h>
 
@@ -169,6 +170,31 @@ void SubresourceLoader::didReceiveData(const char* data, int length, long long e
         m_client->didReceiveData(this, data, length);
 }
 
+#if PLATFORM(ANDROID)
+void SubresourceLoader::didReceiveDataSegments(const Vector<RefPtr<SharedBufferSegment> >& segments)
+{
+    // Reference the object in this method since the additional processing can do
+    // anything including removing the last reference to this object; one example of this is 3266216.
+    RefPtr<SubresourceLoader> protect(this);
+
+    ResourceLoader::didReceiveDataSegments(segments);
+
+    // A subresource loader does not load multipart sections progressively.
+    // So don't deliver any data to the loader yet.
+    if (m_loadingMultipartContent || !m_client || segments.isEmpty())
+        return;
+
+    if (m_client->readsResourceData()) {
+        m_client->didReceiveData(this, segments.last()->data(), segments.last()->size());
+        return;
+    }
+    // The client may go away while handling a segment, see
+    // CachedResourceRequest::didFail()
+    for (size_t i = 0; i < segments.size() && m_client; ++i)
+        m_client->didReceiveData(this, segments[i]->data(), segments[i]->size());
+}
+#endif
+
 void SubresourceLoader::didReceiveCachedMetadata(const char* data, int length)
 {
     // Reference the object in this method since the additional processing can do
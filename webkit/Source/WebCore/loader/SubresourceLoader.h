@@ -65,6 +65,10 @@ namespace WebCore {
         virtual bool supportsDataArray() { return true; }
         virtual void didReceiveDataArray(CFArrayRef);
 #endif
+#if PLATFORM(ANDROID)
+        virtual bool supportsDataSegments() { return true; }
+        virtual void didReceiveDataSegments(const Vector<RefPtr<SharedBufferSegment> >&);
+#endif
 
         SubresourceLoaderClient* m_client;
         bool m_loadingMultipartContent;
@@ -47,6 +47,12 @@ public:
 
     virtual void didReceiveResponse(SubresourceLoader*, const ResourceResponse&) { }
     virtual void didReceiveData(SubresourceLoader*, const char*, int /*dataLength*/) { }
+#if PLATFORM(ANDROID)
+    // Clients reading the received data from SubresourceLoader::resourceData()
+    // rather than from didReceiveData() are only called once for a batch of
+    // data segments, with the last one
+    virtual bool readsResourceData() const { return false; }
+#endif
     virtual void didReceiveCachedMetadata(SubresourceLoader*, const char*, int /*dataLength*/) { }
     virtual void didFinishLoading(SubresourceLoader*, double /*finishTime*/) { }
     virtual void didFail(SubresourceLoader*, const ResourceError&) { }
@@ -38,6 +38,14 @@
 #include <parser/SourceProvider.h>
 #endif
 
+#if USE(V8) && defined(ANDROID_BACKGROUND_PREPARSE)
+#include "V8ScriptPreparser.h"
+#endif
+
+#if USE(V8) && defined(ANDROID_COMPILED_SCRIPT_CACHE)
+#include "V8CompiledScript.h"
+#endif
+
 namespace WebCore {
 
 CachedScript::CachedScript(const String& url, const String& charset)
@@ -86,7 +94,8 @@ const String& CachedScript::script()
     if (!m_script && m_data) {
         m_script = m_decoder->decode(m_data->data(), encodedSize());
         m_script += m_decoder->flush();
-        setDecodedSize(m_script.length() * sizeof(UChar));
+        // The decoded size may already hold the compiled script, add to it
+        setDecodedSize(decodedSize() + m_script.length() * sizeof(UChar));
     }
     m_decodedDataDeletionTimer.startOneShot(0);
     
@@ -101,6 +110,10 @@ void CachedScript::data(PassRefPtr<SharedBuffer> data, bool allDataReceived)
     m_data = data;
     setEncodedSize(m_data.get() ? m_data->size() : 0);
     setLoading(false);
+#if USE(V8) && defined(ANDROID_BACKGROUND_PREPARSE)
+    // Start preparsing before the clients get to run the script.
+    V8ScriptPreparser::shared().preparse(this);
+#endif
     checkNotify();
 }
 
@@ -121,6 +134,12 @@ void CachedScript::destroyDecodedData()
         m_sourceProviderCache->clear();
 
     extraSize = m_sourceProviderCache ? m_sourceProviderCache->byteSize() : 0;
+#endif
+#if USE(V8) && defined(ANDROID_COMPILED_SCRIPT_CACHE)
+    if (m_compiledScript && m_clients.isEmpty())
+        m_compiledScript.clear();
+
+    extraSize = m_compiledScript ? m_compiledScript->size() : 0;
 #endif
     setDecodedSize(extraSize);
     if (!MemoryCache::shouldMakeResourcePurgeableOnEviction() && isSafeToMakePurgeable())
@@ -146,4 +165,15 @@ void CachedScript::sourceProviderCacheSizeChanged(int delta)
 }
 #endif
 
+#if USE(V8) && defined(ANDROID_COMPILED_SCRIPT_CACHE)
+void CachedScript::setCompiledScript(PassOwnPtr<V8CompiledScript> compiledScript)
+{
+    int delta = -static_cast<int>(m_compiledScript ? m_compiledScript->size() : 0);
+    m_compiledScript = compiledScript;
+    if (m_compiledScript)
+        delta += m_compiledScript->size();
+    setDecodedSize(decodedSize() + delta);
+}
+#endif
+
 } // namespace WebCore
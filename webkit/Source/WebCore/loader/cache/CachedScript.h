@@ -39,6 +39,9 @@ namespace WebCore {
 
     class CachedResourceLoader;
     class TextResourceDecoder;
+#if USE(V8) && defined(ANDROID_COMPILED_SCRIPT_CACHE)
+    class V8CompiledScript;
+#endif
 
     class CachedScript : public CachedResource {
     public:
@@ -60,6 +63,11 @@ namespace WebCore {
         // Allows JSC to cache additional information about the source.
         JSC::SourceProviderCache* sourceProviderCache() const;
         void sourceProviderCacheSizeChanged(int delta);
+#endif
+#if USE(V8) && defined(ANDROID_COMPILED_SCRIPT_CACHE)
+        // Allows V8 to keep the compiled script around for the next run.
+        V8CompiledScript* compiledScript() const { return m_compiledScript.get(); }
+        void setCompiledScript(PassOwnPtr<V8CompiledScript>);
 #endif
     private:
         void decodedDataDeletionTimerFired(Timer<CachedScript>*);
@@ -70,6 +78,9 @@ namespace WebCore {
         Timer<CachedScript> m_decodedDataDeletionTimer;
 #if USE(JSC)        
         mutable OwnPtr<JSC::SourceProviderCache> m_sourceProviderCache;
+#endif
+#if USE(V8) && defined(ANDROID_COMPILED_SCRIPT_CACHE)
+        OwnPtr<V8CompiledScript> m_compiledScript;
 #endif
     };
 }
@@ -35,6 +35,7 @@
 #include "FrameView.h"
 #include "Image.h"
 #include "Logging.h"
+#include "PurgeableBuffer.h"
 #include "ResourceHandle.h"
 #include "SecurityOrigin.h"
 #include "SecurityOriginHash.h"
@@ -167,8 +168,14 @@ void MemoryCache::pruneLiveResources()
         return;
 
     unsigned capacity = liveCapacity();
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    // Decoded images have a budget of their own, see ImageSourceAndroid.cpp
+    if (capacity && m_liveSize <= capacity && !ImageSource::isOverDecodedImageBudget())
+        return;
+#else
     if (capacity && m_liveSize <= capacity)
         return;
+#endif
 
     unsigned targetSize = static_cast<unsigned>(capacity * cTargetPrunePercentage); // Cut by a percentage to avoid immediately pruning again.
     double currentTime = FrameView::currentPaintTimeStamp();
@@ -198,7 +205,11 @@ void MemoryCache::pruneLiveResources()
             // list in m_allResources.
             current->destroyDecodedData();
 
-            if (targetSize && m_liveSize <= targetSize)
+            if (targetSize && m_liveSize <= targetSize
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+                && !ImageSource::isOverDecodedImageBudget()
+#endif
+                )
                 return;
         }
         current = prev;
@@ -217,6 +228,10 @@ void MemoryCache::pruneDeadResources()
     unsigned targetSize = static_cast<unsigned>(capacity * cTargetPrunePercentage); // Cut by a percentage to avoid immediately pruning again.
     int size = m_allResources.size();
     
+    // Android's ashmem buffers only find out they were purged when they are
+    // pinned again. Rather than repinning all of them here, the loop below
+    // checks the purgeable resources it comes across, see makeResourcePurgeable().
+#if !PLATFORM(ANDROID)
     if (!m_inPruneDeadResources) {
         // See if we have any purged resources we can evict.
         for (int i = 0; i < size; i++) {
@@ -234,6 +249,7 @@ void MemoryCache::pruneDeadResources()
         if (targetSize && m_deadSize <= targetSize)
             return;
     }
+#endif
     
     bool canShrinkLRULists = true;
     m_inPruneDeadResources = true;
@@ -307,8 +323,15 @@ bool MemoryCache::makeResourcePurgeable(CachedResource* resource)
     if (!resource->inCache())
         return false;
 
-    if (resource->isPurgeable())
+    if (resource->isPurgeable()) {
+#if PLATFORM(ANDROID)
+        // A purged resource has nothing left to keep, evict it so its ashmem
+        // region is closed instead of holding one of the few we allow.
+        return !resource->m_purgeableData->checkPurged();
+#else
         return true;
+#endif
+    }
 
     if (!resource->isSafeToMakePurgeable())
         return false;
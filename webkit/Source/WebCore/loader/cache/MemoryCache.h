@@ -27,6 +27,9 @@
 
 #include "CachePolicy.h"
 #include "CachedResource.h"
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+#include "ImageSource.h"
+#endif
 #include "PlatformString.h"
 #include <wtf/HashMap.h>
 #include <wtf/HashSet.h>
@@ -133,7 +136,11 @@ public:
     void setPruneEnabled(bool enabled) { m_pruneEnabled = enabled; }
     void prune()
     {
-        if (m_liveSize + m_deadSize <= m_capacity && m_maxDeadCapacity && m_deadSize <= m_maxDeadCapacity) // Fast path.
+        if (m_liveSize + m_deadSize <= m_capacity && m_maxDeadCapacity && m_deadSize <= m_maxDeadCapacity // Fast path.
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+            && !ImageSource::isOverDecodedImageBudget()
+#endif
+            )
             return;
             
         pruneDeadResources(); // Prune dead first, in case it was "borrowing" capacity from live.
@@ -219,6 +226,10 @@ inline bool MemoryCache::shouldMakeResourcePurgeableOnEviction()
 {
 #if PLATFORM(IOS)
     return true;
+#elif PLATFORM(ANDROID) && ENABLE(PURGEABLE_MEMORY)
+    // Evicted resources move into unpinned ashmem that the kernel can reclaim
+    // under memory pressure (see PurgeableBufferAndroid.cpp).
+    return true;
 #else
     return false;
 #endif
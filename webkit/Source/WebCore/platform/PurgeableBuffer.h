@@ -50,10 +50,26 @@ namespace WebCore {
         bool wasPurged() const;
 
         bool makePurgeable(bool purgeable);
+
+#if PLATFORM(ANDROID)
+        // Repins a volatile buffer to find out whether it was purged, which
+        // wasPurged() only learns the next time the buffer is pinned.
+        bool checkPurged();
+#endif
         
     private:
+#if PLATFORM(ANDROID)
+        PurgeableBuffer(int fd, char* data, size_t);
+        // Unmaps and closes the region once its contents are purged.
+        void discard();
+#else
         PurgeableBuffer(char* data, size_t);
+#endif
     
+#if PLATFORM(ANDROID)
+        // The ashmem region backing m_data; pinning and unpinning go through it.
+        int m_fd;
+#endif
         char* m_data;
         size_t m_size;
         PurgePriority m_purgePriority;
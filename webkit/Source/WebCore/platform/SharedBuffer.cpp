@@ -57,19 +57,45 @@ static inline void freeSegment(char* p)
     fastFree(p);
 }
 
+#if PLATFORM(ANDROID)
+// Holds bytes appended with append(const char*, unsigned) after a segment has
+// been adopted, so that they stay behind it.
+class CopiedSegment : public SharedBufferSegment {
+public:
+    static PassRefPtr<CopiedSegment> create(const char* data, unsigned length) { return adoptRef(new CopiedSegment(data, length)); }
+
+    virtual const char* data() const { return m_data.data(); }
+    virtual unsigned size() const { return m_data.size(); }
+
+private:
+    CopiedSegment(const char* data, unsigned length) { m_data.append(data, length); }
+
+    Vector<char> m_data;
+};
+#endif
+
 SharedBuffer::SharedBuffer()
     : m_size(0)
+#if PLATFORM(ANDROID)
+    , m_dataSegmentsSize(0)
+#endif
 {
 }
 
 SharedBuffer::SharedBuffer(const char* data, int size)
     : m_size(0)
+#if PLATFORM(ANDROID)
+    , m_dataSegmentsSize(0)
+#endif
 {
     append(data, size);
 }
 
 SharedBuffer::SharedBuffer(const unsigned char* data, int size)
     : m_size(0)
+#if PLATFORM(ANDROID)
+    , m_dataSegmentsSize(0)
+#endif
 {
     append(reinterpret_cast<const char*>(data), size);
 }
@@ -122,6 +148,13 @@ void SharedBuffer::append(const char* data, unsigned length)
     ASSERT(!m_purgeableBuffer);
 
     maybeTransferPlatformData();
+
+#if PLATFORM(ANDROID)
+    if (!m_dataSegments.isEmpty()) {
+        append(CopiedSegment::create(data, length));
+        return;
+    }
+#endif
     
     unsigned positionInSegment = offsetInSegment(m_size - m_buffer.size());
     m_size += length;
@@ -170,12 +203,20 @@ void SharedBuffer::clear()
 #if HAVE(CFNETWORK_DATA_ARRAY_CALLBACK)
     m_dataArray.clear();
 #endif
+#if PLATFORM(ANDROID)
+    m_dataSegments.clear();
+    m_dataSegmentsSize = 0;
+#endif
 }
 
 PassRefPtr<SharedBuffer> SharedBuffer::copy() const
 {
     RefPtr<SharedBuffer> clone(adoptRef(new SharedBuffer));
-    if (m_purgeableBuffer || hasPlatformData()) {
+    if (m_purgeableBuffer || hasPlatformData()
+#if PLATFORM(ANDROID)
+        || !m_dataSegments.isEmpty()
+#endif
+        ) {
         clone->append(data(), size());
         return clone;
     }
@@ -201,6 +242,10 @@ const Vector<char>& SharedBuffer::buffer() const
         m_buffer.resize(m_size);
         char* destination = m_buffer.data() + bufferSize;
         unsigned bytesLeft = m_size - bufferSize;
+#if PLATFORM(ANDROID)
+        unsigned dataSegmentsSize = m_dataSegmentsSize;
+        bytesLeft -= dataSegmentsSize;
+#endif
         for (unsigned i = 0; i < m_segments.size(); ++i) {
             unsigned bytesToCopy = min(bytesLeft, segmentSize);
             memcpy(destination, m_segments[i], bytesToCopy);
@@ -211,6 +256,9 @@ const Vector<char>& SharedBuffer::buffer() const
         m_segments.clear();
 #if HAVE(CFNETWORK_DATA_ARRAY_CALLBACK)
         copyDataArrayAndClear(destination, bytesLeft);
+#endif
+#if PLATFORM(ANDROID)
+        copyDataSegmentsAndClear(destination, dataSegmentsSize);
 #endif
     }
     return m_buffer;
@@ -236,6 +284,11 @@ unsigned SharedBuffer::getSomeData(const char*& someData, unsigned position) con
  
     position -= consecutiveSize;
     unsigned segmentedSize = m_size - consecutiveSize;
+#if PLATFORM(ANDROID)
+    segmentedSize -= m_dataSegmentsSize;
+    if (position >= segmentedSize)
+        return getSomeDataFromSegments(someData, position - segmentedSize);
+#endif
     unsigned segments = m_segments.size();
     unsigned segment = segmentIndex(position);
     ASSERT(segment < segments);
@@ -245,6 +298,59 @@ unsigned SharedBuffer::getSomeData(const char*& someData, unsigned position) con
     return segment == segments - 1 ? segmentedSize - position : segmentSize - positionInSegment;
 }
 
+#if PLATFORM(ANDROID)
+
+void SharedBuffer::append(PassRefPtr<SharedBufferSegment> prpSegment)
+{
+    ASSERT(!m_purgeableBuffer);
+
+    RefPtr<SharedBufferSegment> segment = prpSegment;
+    unsigned length = segment->size();
+    if (!length)
+        return;
+
+    m_dataSegments.append(segment.release());
+    m_dataSegmentsSize += length;
+    m_size += length;
+}
+
+void SharedBuffer::copyDataSegmentsAndClear(char* destination, unsigned bytesToCopy) const
+{
+    if (m_dataSegments.isEmpty())
+        return;
+
+    unsigned bytesLeft = bytesToCopy;
+    Vector<RefPtr<SharedBufferSegment> >::const_iterator end = m_dataSegments.end();
+    for (Vector<RefPtr<SharedBufferSegment> >::const_iterator it = m_dataSegments.begin(); it != end; ++it) {
+        unsigned dataLength = (*it)->size();
+        ASSERT(bytesLeft >= dataLength);
+        memcpy(destination, (*it)->data(), dataLength);
+        destination += dataLength;
+        bytesLeft -= dataLength;
+    }
+    m_dataSegments.clear();
+    m_dataSegmentsSize = 0;
+}
+
+unsigned SharedBuffer::getSomeDataFromSegments(const char*& someData, unsigned position) const
+{
+    Vector<RefPtr<SharedBufferSegment> >::const_iterator end = m_dataSegments.end();
+    for (Vector<RefPtr<SharedBufferSegment> >::const_iterator it = m_dataSegments.begin(); it != end; ++it) {
+        unsigned dataLength = (*it)->size();
+        if (position < dataLength) {
+            someData = (*it)->data() + position;
+            return dataLength - position;
+        }
+        position -= dataLength;
+    }
+
+    ASSERT_NOT_REACHED();
+    someData = 0;
+    return 0;
+}
+
+#endif
+
 #if !USE(CF) || PLATFORM(QT)
 
 inline void SharedBuffer::clearPlatformData()
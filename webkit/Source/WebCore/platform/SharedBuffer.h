@@ -32,6 +32,11 @@
 #include <wtf/RefCounted.h>
 #include <wtf/Vector.h>
 
+#if PLATFORM(ANDROID)
+#include <wtf/RefPtr.h>
+#include <wtf/ThreadSafeRefCounted.h>
+#endif
+
 #if USE(CF)
 #include <wtf/RetainPtr.h>
 #endif
@@ -49,6 +54,18 @@ namespace WebCore {
     
 class PurgeableBuffer;
 
+#if PLATFORM(ANDROID)
+// A block of bytes owned outside of SharedBuffer, such as a network read
+// buffer, that can be appended without copying. Segments are filled on the
+// network thread and handed over to the main thread.
+class SharedBufferSegment : public ThreadSafeRefCounted<SharedBufferSegment> {
+public:
+    virtual ~SharedBufferSegment() { }
+    virtual const char* data() const = 0;
+    virtual unsigned size() const = 0;
+};
+#endif
+
 class SharedBuffer : public RefCounted<SharedBuffer> {
 public:
     static PassRefPtr<SharedBuffer> create() { return adoptRef(new SharedBuffer); }
@@ -100,6 +117,10 @@ public:
 #if HAVE(CFNETWORK_DATA_ARRAY_CALLBACK)
     void append(CFDataRef);
 #endif
+#if PLATFORM(ANDROID)
+    // Keeps a reference to the segment rather than copying its bytes.
+    void append(PassRefPtr<SharedBufferSegment>);
+#endif
 
     PassRefPtr<SharedBuffer> copy() const;
     
@@ -146,6 +167,14 @@ private:
     mutable Vector<RetainPtr<CFDataRef> > m_dataArray;
     void copyDataArrayAndClear(char *destination, unsigned bytesToCopy) const;
 #endif
+#if PLATFORM(ANDROID)
+    // Once a segment has been adopted, later appends are kept as segments too
+    // so that the bytes stay in order.
+    mutable Vector<RefPtr<SharedBufferSegment> > m_dataSegments;
+    mutable unsigned m_dataSegmentsSize;
+    void copyDataSegmentsAndClear(char* destination, unsigned bytesToCopy) const;
+    unsigned getSomeDataFromSegments(const char*& data, unsigned position) const;
+#endif
 #if USE(CF)
     SharedBuffer(CFDataRef);
     RetainPtr<CFDataRef> m_cfData;
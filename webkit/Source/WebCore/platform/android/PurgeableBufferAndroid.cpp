@@ -0,0 +1,159 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#if ENABLE(PURGEABLE_MEMORY)
+
+#include "PurgeableBuffer.h"
+
+#include <cutils/ashmem.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wtf/Assertions.h>
+
+namespace WebCore {
+
+// Like the Mac implementation, purgeable buffers are page granular, so they are
+// only worth it for larger resources. Set our minimum size to 16KB.
+static const size_t minPurgeableBufferSize = 4 * 4096;
+
+// Every buffer keeps its ashmem region open until it is found purged, so cap
+// the number of them to leave most of the process file descriptors to sockets
+// and files. Once the cap is reached the memory cache falls back to freeing
+// evicted resources.
+static const unsigned maxPurgeableBufferCount = 64;
+static unsigned purgeableBufferCount = 0;
+
+PurgeableBuffer::PurgeableBuffer(int fd, char* data, size_t size)
+    : m_fd(fd)
+    , m_data(data)
+    , m_size(size)
+    , m_purgePriority(PurgeDefault)
+    , m_state(NonVolatile)
+{
+    ++purgeableBufferCount;
+}
+
+PurgeableBuffer::~PurgeableBuffer()
+{
+    if (m_fd >= 0)
+        discard();
+}
+
+PassOwnPtr<PurgeableBuffer> PurgeableBuffer::create(const char* data, size_t size)
+{
+    if (size < minPurgeableBufferSize || purgeableBufferCount >= maxPurgeableBufferCount)
+        return PassOwnPtr<PurgeableBuffer>();
+
+    int fd = ashmem_create_region("WebCore purgeable", size);
+    if (fd < 0)
+        return PassOwnPtr<PurgeableBuffer>();
+
+    void* buffer = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (buffer == MAP_FAILED) {
+        close(fd);
+        return PassOwnPtr<PurgeableBuffer>();
+    }
+
+    // New ashmem regions start out pinned, which matches NonVolatile.
+    memcpy(buffer, data, size);
+    return adoptPtr(new PurgeableBuffer(fd, static_cast<char*>(buffer), size));
+}
+
+// The contents are gone, so give back the mapping and the region right away
+// rather than when the memory cache gets to evict the resource.
+void PurgeableBuffer::discard()
+{
+    munmap(m_data, m_size);
+    close(m_fd);
+    m_data = 0;
+    m_fd = -1;
+    m_state = Purged;
+    --purgeableBufferCount;
+}
+
+bool PurgeableBuffer::makePurgeable(bool purgeable)
+{
+    if (purgeable) {
+        if (m_state != NonVolatile)
+            return true;
+
+        // ashmem has no notion of purge priority; the kernel reclaims unpinned
+        // regions in the order they were unpinned, so m_purgePriority is ignored.
+        if (ashmem_unpin_region(m_fd, 0, 0) < 0) {
+            // If that failed we have no clue what state we are in so assume purged.
+            discard();
+            return true;
+        }
+
+        m_state = Volatile;
+        return true;
+    }
+
+    if (m_state == NonVolatile)
+        return true;
+    if (m_state == Purged)
+        return false;
+
+    int ret = ashmem_pin_region(m_fd, 0, 0);
+    if (ret < 0 || ret == ASHMEM_WAS_PURGED) {
+        // If pinning failed we have no clue what state we are in so assume purged.
+        discard();
+        return false;
+    }
+
+    m_state = NonVolatile;
+    return true;
+}
+
+// ashmem only tells whether a region was purged when pinning it, and pinning
+// to find out would cost two system calls per buffer on every prune. So this
+// only knows about the purges makePurgeable(false) found.
+bool PurgeableBuffer::wasPurged() const
+{
+    return m_state == Purged;
+}
+
+bool PurgeableBuffer::checkPurged()
+{
+    if (m_state != Volatile)
+        return m_state == Purged;
+
+    if (makePurgeable(false))
+        makePurgeable(true);
+    return m_state == Purged;
+}
+
+const char* PurgeableBuffer::data() const
+{
+    ASSERT(m_state == NonVolatile);
+    return m_data;
+}
+
+}
+
+#endif // ENABLE(PURGEABLE_MEMORY)
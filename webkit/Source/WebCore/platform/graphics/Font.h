@@ -154,6 +154,11 @@ public:
     static void setShouldUseSmoothing(bool);
     static bool shouldUseSmoothing();
 
+#ifdef ANDROID_SHAPED_RUN_CACHE
+    // Frees the complex script runs kept for reshaping, see FontAndroid.cpp
+    static void clearShapedRunCache();
+#endif
+
     enum CodePath { Auto, Simple, Complex, SimpleWithGlyphOverflow };
 
 private:
@@ -324,6 +324,10 @@ void FontCache::purgeInactiveFontData(int count)
     if (it == end) {
         // Removed everything
         gInactiveFontData->clear();
+#ifdef ANDROID_SHAPED_RUN_CACHE
+        // Also drop the runs shaped with the purged fonts
+        Font::clearShapedRunCache();
+#endif
     } else {
         for (int i = 0; i < count; ++i)
             gInactiveFontData->remove(gInactiveFontData->begin());
@@ -89,12 +89,19 @@ typedef QPixmap* NativeImagePtr;
 #ifdef ANDROID_ANIMATED_GIF
 class GIFImageDecoder;
 #endif
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+class ImageDecoder;
+#endif
 struct NativeImageSourcePtr {
     SkString m_url;
     PrivateAndroidImageSourceRec* m_image;
 #ifdef ANDROID_ANIMATED_GIF
     GIFImageDecoder* m_gifDecoder;
 #endif
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+    // Decodes a JPEG or PNG as its data arrives, until all of it has
+    ImageDecoder* m_partialDecoder;
+#endif
 };
 typedef const Vector<char>* NativeBytePtr;
 typedef SkBitmapRef* NativeImagePtr;
@@ -210,6 +217,18 @@ public:
 #if PLATFORM(ANDROID)
     void clearURL();
     void setURL(const String& url);
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    // Called as the image is drawn, with the size the whole image covers on
+    // screen. May decode the image again at another sample size.
+    void setDisplaySize(const IntSize&, SharedBuffer* data);
+
+    // The scale content is drawn to the screen at. Returns true if that is a
+    // zoom in and some images are subsampled below the resolution they could
+    // have, so should be drawn again.
+    static bool setDisplayScale(float);
+    static float displayScale();
+    static bool isOverDecodedImageBudget();
+#endif
 #endif
 
 private:
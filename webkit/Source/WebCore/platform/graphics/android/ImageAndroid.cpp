@@ -28,8 +28,12 @@
 #include "TransformationMatrix.h"
 #include "BitmapImage.h"
 #include "Image.h"
+#include "AffineTransform.h"
 #include "FloatRect.h"
 #include "GraphicsContext.h"
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+#include "ImageDecodeQueue.h"
+#endif
 #include "PlatformGraphicsContext.h"
 #include "PlatformString.h"
 #include "SharedBuffer.h"
@@ -182,6 +186,19 @@ void BitmapImage::draw(GraphicsContext* gc, const FloatRect& dstRect,
         return;
     }
 
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    // Let the source pick the resolution to decode at from the size the
+    // whole image covers on screen (e.g. an <img> scaled by RenderImage).
+    if (!srcRect.isEmpty()) {
+        AffineTransform ctm = gc->getCTM();
+        float scale = ImageSource::displayScale();
+        float scaleX = dstRect.width() / srcRect.width() * ctm.xScale() * scale;
+        float scaleY = dstRect.height() / srcRect.height() * ctm.yScale() * scale;
+        m_source.setDisplaySize(IntSize(ceilf(size().width() * scaleX),
+                                        ceilf(size().height() * scaleY)), data());
+    }
+#endif
+
     // in case we get called with an incomplete bitmap
     const SkBitmap& bitmap = image->bitmap();
     if (bitmap.getPixels() == NULL && bitmap.pixelRef() == NULL) {
@@ -208,6 +225,11 @@ void BitmapImage::draw(GraphicsContext* gc, const FloatRect& dstRect,
         return;
     }
 
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+    // the image is being painted, so its decode is no longer speculative
+    ImageDecodeQueue::instance()->prioritize(bitmap.pixelRef());
+#endif
+
     gc->platformContext()->drawBitmapRect(bitmap, &srcR, dstR, compositeOp);
 
 #ifdef TRACE_SUBSAMPLED_BITMAPS
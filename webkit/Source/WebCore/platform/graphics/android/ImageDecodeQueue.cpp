@@ -0,0 +1,185 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "ImageDecodeQueue"
+#define LOG_NDEBUG 1
+
+#include "config.h"
+#include "ImageDecodeQueue.h"
+
+#include "AndroidLog.h"
+#include "SkPixelRef.h"
+
+#include <cutils/atomic.h>
+
+namespace WebCore {
+
+ImageDecodeQueue* ImageDecodeQueue::instance()
+{
+    static ImageDecodeQueue* queue = new ImageDecodeQueue();
+    return queue;
+}
+
+ImageDecodeQueue::ImageDecodeQueue()
+    : m_running(0)
+    , m_busyTime(0)
+    , m_backgroundCount(0)
+{
+    m_worker = new Worker(this);
+    m_worker->run("ImageDecodeQueue", android::PRIORITY_BACKGROUND);
+}
+
+bool ImageDecodeQueue::take(WTF::Vector<SkPixelRef*>& queue, SkPixelRef* pixelRef)
+{
+    size_t index = queue.find(pixelRef);
+    if (index == WTF::notFound)
+        return false;
+    queue.remove(index);
+    return true;
+}
+
+// Must be called with m_lock held, whenever m_background changes.
+void ImageDecodeQueue::backgroundChanged()
+{
+    android_atomic_release_store(m_background.size(), &m_backgroundCount);
+}
+
+void ImageDecodeQueue::decode(SkPixelRef* pixelRef, Priority priority)
+{
+    if (!pixelRef)
+        return;
+
+    SkPixelRef* dropped = 0;
+    {
+        android::Mutex::Autolock lock(m_lock);
+        if (pixelRef == m_running || m_visible.contains(pixelRef) || m_background.contains(pixelRef))
+            return;
+
+        if (m_visible.size() + m_background.size() >= maxQueuedDecodes) {
+            if (m_background.isEmpty()) {
+                ALOGV("queue full, not queueing %p", pixelRef);
+                return;
+            }
+            dropped = m_background[0];
+            m_background.remove(0);
+        }
+
+        pixelRef->ref();
+        if (priority == Visible)
+            m_visible.append(pixelRef);
+        else
+            m_background.append(pixelRef);
+        backgroundChanged();
+    }
+    m_queuedCond.signal();
+
+    if (dropped) {
+        ALOGV("queue full, dropping %p", dropped);
+        dropped->unref();
+    }
+}
+
+void ImageDecodeQueue::prioritize(SkPixelRef* pixelRef)
+{
+    // Racing with a decode() of the image only misses the hint, the image is
+    // then decoded in its background turn, or by its draw.
+    if (!android_atomic_acquire_load(&m_backgroundCount))
+        return;
+
+    android::Mutex::Autolock lock(m_lock);
+    if (take(m_background, pixelRef)) {
+        m_visible.append(pixelRef);
+        backgroundChanged();
+    }
+}
+
+void ImageDecodeQueue::cancel(SkPixelRef* pixelRef)
+{
+    bool cancelled;
+    {
+        android::Mutex::Autolock lock(m_lock);
+        cancelled = take(m_visible, pixelRef) || take(m_background, pixelRef);
+        backgroundChanged();
+    }
+    if (cancelled) {
+        ALOGV("cancelled %p", pixelRef);
+        pixelRef->unref();
+    }
+}
+
+bool ImageDecodeQueue::isPending(SkPixelRef* pixelRef)
+{
+    android::Mutex::Autolock lock(m_lock);
+    return pixelRef == m_running || m_visible.contains(pixelRef) || m_background.contains(pixelRef);
+}
+
+void ImageDecodeQueue::waitUntilIdle()
+{
+    android::Mutex::Autolock lock(m_lock);
+    while (m_running || !m_visible.isEmpty() || !m_background.isEmpty())
+        m_idleCond.wait(m_lock);
+}
+
+nsecs_t ImageDecodeQueue::busyTime()
+{
+    android::Mutex::Autolock lock(m_lock);
+    return m_busyTime;
+}
+
+bool ImageDecodeQueue::runDecode()
+{
+    SkPixelRef* pixelRef;
+    {
+        android::Mutex::Autolock lock(m_lock);
+        while (m_visible.isEmpty() && m_background.isEmpty())
+            m_queuedCond.wait(m_lock);
+
+        WTF::Vector<SkPixelRef*>& queue = m_visible.isEmpty() ? m_background : m_visible;
+        pixelRef = queue[0];
+        queue.remove(0);
+        backgroundChanged();
+        m_running = pixelRef;
+    }
+
+    // Locking the pixels of an image ref decodes them; they stay around after
+    // the unlock until the allocator's pool or the kernel reclaims them.
+    nsecs_t start = systemTime(SYSTEM_TIME_THREAD);
+    pixelRef->lockPixels();
+    pixelRef->unlockPixels();
+    nsecs_t decodeTime = systemTime(SYSTEM_TIME_THREAD) - start;
+    ALOGV("decoded %p", pixelRef);
+
+    {
+        android::Mutex::Autolock lock(m_lock);
+        m_busyTime += decodeTime;
+        m_running = 0;
+        if (m_visible.isEmpty() && m_background.isEmpty())
+            m_idleCond.broadcast();
+    }
+    pixelRef->unref();
+    return true;
+}
+
+} // namespace WebCore
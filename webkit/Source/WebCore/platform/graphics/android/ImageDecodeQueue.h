@@ -0,0 +1,118 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ImageDecodeQueue_h
+#define ImageDecodeQueue_h
+
+#include "TestExport.h"
+#include <utils/Timers.h>
+#include <utils/threads.h>
+#include <wtf/Vector.h>
+
+class SkPixelRef;
+
+namespace WebCore {
+
+// Decodes images on a worker thread ahead of their first draw.
+//
+// Image pixel refs decode lazily the first time their pixels are locked, which
+// stalls whichever thread draws them first: a tile generator, or the WebCore
+// thread for direct draws such as canvas. Once all of an image's data has
+// arrived, ImageSource queues its pixel ref here so that the worker locks (and
+// so decodes) the pixels first. Drawing before the decode is done still works:
+// it waits for the decode in progress, or does it itself.
+//
+// The queue is bounded: when it is full, the oldest background decode is
+// dropped, and such an image is simply decoded lazily as before.
+class TEST_EXPORT ImageDecodeQueue {
+public:
+    enum Priority {
+        // The image is being painted, e.g. it is in the viewport.
+        Visible,
+        Background
+    };
+
+    static ImageDecodeQueue* instance();
+
+    // Takes a reference on pixelRef until its decode is done or cancelled.
+    void decode(SkPixelRef* pixelRef, Priority priority);
+
+    // Moves a queued decode to the Visible priority. This is called for every
+    // image draw, so it doesn't lock when no background decode is queued.
+    void prioritize(SkPixelRef* pixelRef);
+
+    // Drops a queued decode. A decode that is already running completes.
+    void cancel(SkPixelRef* pixelRef);
+
+    bool isPending(SkPixelRef* pixelRef);
+
+    // Blocks until nothing is queued or running.
+    void waitUntilIdle();
+
+    // The time the worker has spent decoding, for benchmarks.
+    nsecs_t busyTime();
+
+    static const size_t maxQueuedDecodes = 32;
+
+private:
+    ImageDecodeQueue();
+
+    class Worker : public android::Thread {
+    public:
+        Worker(ImageDecodeQueue* queue)
+            : Thread(false)
+            , m_queue(queue)
+        {}
+
+        virtual bool threadLoop() { return m_queue->runDecode(); }
+
+    private:
+        ImageDecodeQueue* m_queue;
+    };
+
+    friend class Worker;
+
+    bool runDecode();
+    static bool take(WTF::Vector<SkPixelRef*>& queue, SkPixelRef* pixelRef);
+    void backgroundChanged();
+
+    // Both queues are in request order and hold a reference on their entries.
+    // They, and m_running, are protected by m_lock.
+    WTF::Vector<SkPixelRef*> m_visible;
+    WTF::Vector<SkPixelRef*> m_background;
+    SkPixelRef* m_running;
+    nsecs_t m_busyTime;
+    // The size of m_background, read without the lock by prioritize().
+    volatile int32_t m_backgroundCount;
+
+    android::Mutex m_lock;
+    android::Condition m_queuedCond;
+    android::Condition m_idleCond;
+    android::sp<Worker> m_worker;
+};
+
+} // namespace WebCore
+
+#endif // ImageDecodeQueue_h
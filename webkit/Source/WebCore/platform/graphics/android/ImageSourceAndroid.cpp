@@ -29,6 +29,13 @@
 
 #include "AndroidLog.h"
 #include "BitmapAllocatorAndroid.h"
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+#include "ImageDecodeQueue.h"
+#endif
+#if defined(ANDROID_PROGRESSIVE_IMAGE_DECODE)
+#include "JPEGImageDecoder.h"
+#include "PNGImageDecoder.h"
+#endif
 #include "ImageSource.h"
 #include "IntSize.h"
 #include "NotImplemented.h"
@@ -100,18 +107,84 @@
 size_t computeMaxBitmapSizeForCache() {
     return MAX_SIZE_BEFORE_SUBSAMPLE;
 }
+
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+// Smaller images decode quickly enough on first draw (same as the ashmem
+// cutoff in BitmapAllocatorAndroid)
+#define MIN_BACKGROUND_DECODE_SIZE  (32*1024)
+#endif
+
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+/*  Once the images that have been drawn add up to more decoded bytes than
+    this, images are subsampled down to the size they are displayed at, and
+    MemoryCache::pruneLiveResources() drops the decoded pixels of the least
+    recently drawn ones. Below it, images keep the resolution
+    computeSampleSize() allows, as before.
+*/
+#ifdef ANDROID_LARGE_MEMORY_DEVICE
+    #define DECODED_IMAGE_BUDGET    (64*1024*1024)
+#else
+    #define DECODED_IMAGE_BUDGET    (12*1024*1024)
+#endif
+
+// All of these are only used on the WebCore thread
+static size_t gDecodedImageBytes = 0;
+// images decoded at a larger sample size than computeSampleSize() allows
+static int gSubsampledImageCount = 0;
+static float gDisplayScale = 1;
+#endif
 ///////////////////////////////////////////////////////////////////////////////
 
 class PrivateAndroidImageSourceRec : public SkBitmapRef {
 public:
     PrivateAndroidImageSourceRec(const SkBitmap& bm, int origWidth,
                                  int origHeight, int sampleSize)
-            : SkBitmapRef(bm), fSampleSize(sampleSize), fAllDataReceived(false) {
+            : SkBitmapRef(bm), fSampleSize(sampleSize), fAllDataReceived(false)
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+            , fMinSampleSize(sampleSize), fDisplayWidth(0), fDisplayHeight(0)
+            , fBudgetBytes(0)
+#endif
+    {
         this->setOrigSize(origWidth, origHeight);
     }
 
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    virtual ~PrivateAndroidImageSourceRec() {
+        if (fSampleSize > fMinSampleSize)
+            gSubsampledImageCount--;
+        gDecodedImageBytes -= fBudgetBytes;
+    }
+
+    // Replaces the bitmap with one decoded at another sample size
+    void setBitmap(const SkBitmap& bm, int sampleSize) {
+        if (fSampleSize > fMinSampleSize)
+            gSubsampledImageCount--;
+        if (sampleSize > fMinSampleSize)
+            gSubsampledImageCount++;
+        fSampleSize = sampleSize;
+        this->bitmap() = bm;
+        if (fBudgetBytes)
+            this->setDrawn(true);
+    }
+
+    // Drawn images count against the budget, until their pixels are dropped
+    void setDrawn(bool drawn) {
+        gDecodedImageBytes -= fBudgetBytes;
+        fBudgetBytes = drawn ? this->bitmap().getSize() : 0;
+        gDecodedImageBytes += fBudgetBytes;
+    }
+#endif
+
     int  fSampleSize;
     bool fAllDataReceived;
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    // the sample size computeSampleSize() picked, the lowest we decode at
+    int  fMinSampleSize;
+    // the largest size the image has been displayed at, in screen pixels
+    int  fDisplayWidth;
+    int  fDisplayHeight;
+    size_t fBudgetBytes;
+#endif
 };
 
 namespace WebCore {
@@ -124,13 +197,23 @@ ImageSource::ImageSource(AlphaOption alphaOption, GammaAndColorProfileOption gam
 #ifdef ANDROID_ANIMATED_GIF
     m_decoder.m_gifDecoder = 0;
 #endif
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+    m_decoder.m_partialDecoder = 0;
+#endif
 }
 
 ImageSource::~ImageSource() {
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+    if (m_decoder.m_image)
+        ImageDecodeQueue::instance()->cancel(m_decoder.m_image->bitmap().pixelRef());
+#endif
     delete m_decoder.m_image;
 #ifdef ANDROID_ANIMATED_GIF
     delete m_decoder.m_gifDecoder;
 #endif
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+    delete m_decoder.m_partialDecoder;
+#endif
 }
 
 bool ImageSource::initialized() const {
@@ -161,6 +244,101 @@ static int computeSampleSize(const SkBitmap& bitmap) {
     return sampleSize;
 }
 
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+// Returns the largest sample size that still decodes the image at least as
+// large as it is displayed.
+static int computeDisplaySampleSize(int origWidth, int origHeight,
+                                    int displayWidth, int displayHeight) {
+    int sampleSize = 1;
+    while (origWidth / (sampleSize << 1) >= displayWidth
+            && origHeight / (sampleSize << 1) >= displayHeight)
+        sampleSize <<= 1;
+    return sampleSize;
+}
+
+// Gives the image a new, not yet decoded, pixel ref at the sample size. The
+// recordings drawing the old one keep it until they are recorded again.
+static bool resampleImage(PrivateAndroidImageSourceRec* decoder,
+                          SharedBuffer* data, int sampleSize,
+                          const SkString& url) {
+    SkBitmap tmp;
+
+    SkMemoryStream stream(data->data(), data->size(), false);
+    SkImageDecoder* codec = SkImageDecoder::Factory(&stream);
+    if (!codec)
+        return false;
+
+    SkAutoTDelete<SkImageDecoder> ad(codec);
+#if ENABLE(OLD_SKIA)
+    codec->setPrefConfigTable(gPrefConfigTable);
+#endif
+    codec->setSampleSize(sampleSize);
+    if (!codec->decode(&stream, &tmp, SkImageDecoder::kDecodeBounds_Mode))
+        return false;
+
+    BitmapAllocatorAndroid alloc(data, sampleSize);
+    if (!alloc.allocPixelRef(&tmp, NULL))
+        return false;
+    SkPixelRef* ref = tmp.pixelRef();
+    ref->setImmutable();
+    ref->setURI(url);
+
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+    ImageDecodeQueue::instance()->cancel(decoder->bitmap().pixelRef());
+#endif
+#ifdef TRACE_SUBSAMPLE_BITMAPS
+    ALOGD("------- resample [%d %d] sampleSize %d -> %d decoded %d\n",
+             decoder->origWidth(), decoder->origHeight(), decoder->fSampleSize,
+             sampleSize, gDecodedImageBytes);
+#endif
+    decoder->setBitmap(tmp, sampleSize);
+    return true;
+}
+
+bool ImageSource::setDisplayScale(float scale)
+{
+    bool zoomedIn = scale > gDisplayScale;
+    gDisplayScale = scale;
+    return zoomedIn && gSubsampledImageCount;
+}
+
+float ImageSource::displayScale()
+{
+    return gDisplayScale;
+}
+
+bool ImageSource::isOverDecodedImageBudget()
+{
+    return gDecodedImageBytes > DECODED_IMAGE_BUDGET;
+}
+
+void ImageSource::setDisplaySize(const IntSize& displaySize, SharedBuffer* data)
+{
+    PrivateAndroidImageSourceRec* decoder = m_decoder.m_image;
+    if (!decoder || !decoder->fAllDataReceived || !data || displaySize.isEmpty())
+        return;
+#ifdef ANDROID_ANIMATED_GIF
+    if (m_decoder.m_gifDecoder)
+        return;
+#endif
+
+    decoder->fDisplayWidth = std::max(decoder->fDisplayWidth, displaySize.width());
+    decoder->fDisplayHeight = std::max(decoder->fDisplayHeight, displaySize.height());
+    int sampleSize = std::max(decoder->fMinSampleSize,
+            computeDisplaySampleSize(decoder->origWidth(), decoder->origHeight(),
+                                     decoder->fDisplayWidth, decoder->fDisplayHeight));
+
+    // Always go back up in resolution when zoomed in, but only trade
+    // resolution for memory once the budget is used up.
+    if (sampleSize < decoder->fSampleSize
+            || (sampleSize > decoder->fSampleSize && isOverDecodedImageBudget()))
+        resampleImage(decoder, data, sampleSize, m_decoder.m_url);
+
+    if (!decoder->fBudgetBytes)
+        decoder->setDrawn(true);
+}
+#endif
+
 void ImageSource::clearURL() 
 {
     m_decoder.m_url.reset(); 
@@ -188,6 +366,26 @@ static bool should_use_animated_gif(int width, int height) {
 }
 #endif
 
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+// Returns a decoder that shows the image while its data arrives, for the
+// formats WebCore has incremental decoders for. It holds a full size 32bit
+// frame until the image has loaded, so images we would subsample are left
+// to the lazy decode.
+static ImageDecoder* createPartialDecoder(SharedBuffer* data, int width, int height,
+        int sampleSize, ImageSource::AlphaOption alphaOption,
+        ImageSource::GammaAndColorProfileOption gammaAndColorProfileOption) {
+    if (sampleSize > 1 || (size_t)width * height * 4 > computeMaxBitmapSizeForCache())
+        return 0;
+
+    const char* contents = data->data();
+    if (data->size() > 3 && !memcmp(contents, "\xFF\xD8\xFF", 3))
+        return new JPEGImageDecoder(alphaOption, gammaAndColorProfileOption);
+    if (data->size() > 8 && !memcmp(contents, "\x89PNG\r\n\x1A\n", 8))
+        return new PNGImageDecoder(alphaOption, gammaAndColorProfileOption);
+    return 0;
+}
+#endif
+
 void ImageSource::setData(SharedBuffer* data, bool allDataReceived)
 {
 #ifdef ANDROID_ANIMATED_GIF
@@ -202,6 +400,18 @@ void ImageSource::setData(SharedBuffer* data, bool allDataReceived)
         delete m_decoder.m_gifDecoder;
         m_decoder.m_gifDecoder = 0;
     }
+#endif
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+    if (m_decoder.m_partialDecoder) {
+        if (!allDataReceived && !m_decoder.m_partialDecoder->failed()) {
+            m_decoder.m_partialDecoder->setData(data, false);
+            return;
+        }
+        // The complete image is decoded lazily like any other, into purgeable
+        // and possibly 16bit pixels, so the partial frame can go.
+        delete m_decoder.m_partialDecoder;
+        m_decoder.m_partialDecoder = 0;
+    }
 #endif
     if (NULL == m_decoder.m_image
 #ifdef ANDROID_ANIMATED_GIF
@@ -263,6 +473,15 @@ void ImageSource::setData(SharedBuffer* data, bool allDataReceived)
 
         m_decoder.m_image = new PrivateAndroidImageSourceRec(tmp, origW, origH,
                                                      sampleSize);
+
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+        if (!allDataReceived) {
+            m_decoder.m_partialDecoder = createPartialDecoder(data, origW, origH,
+                    sampleSize, m_alphaOption, m_gammaAndColorProfileOption);
+            if (m_decoder.m_partialDecoder)
+                m_decoder.m_partialDecoder->setData(data, false);
+        }
+#endif
         
 //        ALOGD("----- started: [%d %d] %s\n", origW, origH, m_decoder.m_url.c_str());
     }
@@ -283,6 +502,16 @@ void ImageSource::setData(SharedBuffer* data, bool allDataReceived)
         ref->setImmutable();
         // give it the URL if we have one
         ref->setURI(m_decoder.m_url);
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+        // decode ahead of the first draw, off the WebCore thread
+        if (bm->getSize() >= MIN_BACKGROUND_DECODE_SIZE
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+                // unless the first draw is likely to subsample it
+                && !isOverDecodedImageBudget()
+#endif
+                )
+            ImageDecodeQueue::instance()->decode(ref, ImageDecodeQueue::Background);
+#endif
     }
 }
 
@@ -347,6 +576,15 @@ SkBitmapRef* ImageSource::createFrameAtIndex(size_t index)
     }
 #else
     SkASSERT(index == 0);
+#endif
+#ifdef ANDROID_PROGRESSIVE_IMAGE_DECODE
+    if (m_decoder.m_partialDecoder) {
+        // the rows decoded so far, the rest is transparent
+        ImageFrame* buffer = m_decoder.m_partialDecoder->frameBufferAtIndex(0);
+        if (!buffer || buffer->status() == ImageFrame::FrameEmpty)
+            return 0;
+        return new SkBitmapRef(buffer->bitmap());
+    }
 #endif
     SkASSERT(m_decoder.m_image != NULL);
     m_decoder.m_image->ref();
@@ -432,7 +670,25 @@ void ImageSource::clear(bool destroyAll, size_t clearBeforeFrame, SharedBuffer*
     if (data)
         setData(data, allDataReceived);
 #endif
-    // do nothing, since the cache is managed elsewhere
+#if defined(ANDROID_BACKGROUND_IMAGE_DECODE)
+    // the decoded data is being dropped, so don't decode it ahead either
+    if (destroyAll && m_decoder.m_image)
+        ImageDecodeQueue::instance()->cancel(m_decoder.m_image->bitmap().pixelRef());
+#endif
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    // MemoryCache::pruneLiveResources() is evicting us to get back under the
+    // budget, so drop the decoded pixels and pick the sample size again from
+    // the next draw.
+    PrivateAndroidImageSourceRec* decoder = m_decoder.m_image;
+    if (destroyAll && decoder && decoder->fBudgetBytes && data
+            && isOverDecodedImageBudget()
+            && resampleImage(decoder, data, decoder->fSampleSize, m_decoder.m_url)) {
+        decoder->setDrawn(false);
+        decoder->fDisplayWidth = 0;
+        decoder->fDisplayHeight = 0;
+    }
+#endif
+    // otherwise do nothing, since the cache is managed elsewhere
 }
 
 IntSize ImageSource::frameSizeAtIndex(size_t index) const
@@ -28,6 +28,7 @@
 #include "GraphicsOperation.h"
 
 #include "AndroidLog.h"
+#include "SerializedRecording.h"
 #include <utils/LinearAllocator.h>
 
 namespace WebCore {
@@ -51,5 +52,445 @@ void Operation::operator delete(void*)
     CRASH();
 }
 
+bool FillRect::canMergeWith(Operation* next)
+{
+    if (next->type() != FillRectOperation)
+        return false;
+    FillRect* other = static_cast<FillRect*>(next);
+    if (other->m_hasColor != m_hasColor)
+        return false;
+    return !m_hasColor || other->m_color == m_color;
+}
+
+void FillRect::mergeRun(Operation* const* next, size_t count,
+                        android::LinearAllocator* allocator)
+{
+    size_t total = m_mergedCount;
+    for (size_t i = 0; i < count; i++)
+        total += 1 + static_cast<FillRect*>(next[i])->m_mergedCount;
+
+    FloatRect* rects = (FloatRect*) allocator->alloc(total * sizeof(FloatRect));
+    size_t index = 0;
+    for (size_t i = 0; i < m_mergedCount; i++)
+        rects[index++] = m_mergedRects[i];
+
+    // The merged operation covers at least the largest of the opaque areas
+    IntRect largestOpaqueRect = *opaqueRect();
+    for (size_t i = 0; i < count; i++) {
+        FillRect* other = static_cast<FillRect*>(next[i]);
+        rects[index++] = other->m_rect;
+        for (size_t j = 0; j < other->m_mergedCount; j++)
+            rects[index++] = other->m_mergedRects[j];
+        const IntRect* otherOpaqueRect = other->opaqueRect();
+        if (otherOpaqueRect->width() * otherOpaqueRect->height()
+                > largestOpaqueRect.width() * largestOpaqueRect.height())
+            largestOpaqueRect = *otherOpaqueRect;
+    }
+    m_mergedRects = rects;
+    m_mergedCount = total;
+    setOpaqueRect(largestOpaqueRect);
+}
+
+void DrawPosText::mergeRun(Operation* const* next, size_t count,
+                           android::LinearAllocator* allocator)
+{
+    size_t byteLength = m_byteLength;
+    size_t glyphCount = m_paint->countText(m_text, m_byteLength);
+    for (size_t i = 0; i < count; i++) {
+        DrawPosText* other = static_cast<DrawPosText*>(next[i]);
+        byteLength += other->m_byteLength;
+        glyphCount += m_paint->countText(other->m_text, other->m_byteLength);
+    }
+
+    char* text = (char*) allocator->alloc(byteLength);
+    SkPoint* pos = (SkPoint*) allocator->alloc(glyphCount * sizeof(SkPoint));
+    size_t textOffset = m_byteLength;
+    size_t posOffset = m_paint->countText(m_text, m_byteLength);
+    memcpy(text, m_text, textOffset);
+    memcpy(pos, m_pos, posOffset * sizeof(SkPoint));
+    for (size_t i = 0; i < count; i++) {
+        DrawPosText* other = static_cast<DrawPosText*>(next[i]);
+        size_t otherGlyphCount = m_paint->countText(other->m_text, other->m_byteLength);
+        memcpy(text + textOffset, other->m_text, other->m_byteLength);
+        memcpy(pos + posOffset, other->m_pos, otherGlyphCount * sizeof(SkPoint));
+        textOffset += other->m_byteLength;
+        posOffset += otherGlyphCount;
+    }
+    m_text = text;
+    m_byteLength = byteLength;
+    m_pos = pos;
+}
+
+//**************************************
+// Serialization
+//**************************************
+
+bool ConcatCTM::write(RecordingWriter* writer)
+{
+    writer->writeDouble(m_matrix.a());
+    writer->writeDouble(m_matrix.b());
+    writer->writeDouble(m_matrix.c());
+    writer->writeDouble(m_matrix.d());
+    writer->writeDouble(m_matrix.e());
+    writer->writeDouble(m_matrix.f());
+    return true;
+}
+
+bool Rotate::write(RecordingWriter* writer)
+{
+    writer->writeFloat(m_angle);
+    return true;
+}
+
+bool Scale::write(RecordingWriter* writer)
+{
+    writer->writeFloat(m_scale.width());
+    writer->writeFloat(m_scale.height());
+    return true;
+}
+
+bool Translate::write(RecordingWriter* writer)
+{
+    writer->writeFloat(m_x);
+    writer->writeFloat(m_y);
+    return true;
+}
+
+bool InnerRoundedRectClip::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    writer->writeInt(m_thickness);
+    return true;
+}
+
+bool Clip::write(RecordingWriter* writer)
+{
+    writer->writeFloatRect(m_rect);
+    return true;
+}
+
+bool ClipPath::write(RecordingWriter* writer)
+{
+    writer->writePath(m_path);
+    writer->writeBool(m_clipOut);
+    writer->writeBool(m_hasWindRule);
+    writer->writeInt(m_hasWindRule ? m_windRule : RULE_NONZERO);
+    return true;
+}
+
+bool ClipOut::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    return true;
+}
+
+bool ClearRect::write(RecordingWriter* writer)
+{
+    writer->writeFloatRect(m_rect);
+    return true;
+}
+
+bool DrawBitmapPattern::write(RecordingWriter* writer)
+{
+    if (!writer->writeBitmap(m_bitmap))
+        return false;
+    writer->writeMatrix(m_matrix);
+    writer->writeInt(m_operator);
+    writer->writeFloatRect(m_destRect);
+    return true;
+}
+
+bool DrawBitmapRect::write(RecordingWriter* writer)
+{
+    if (!writer->writeBitmap(m_bitmap))
+        return false;
+    writer->writeIntRect(IntRect(m_srcR));
+    writer->writeFloatRect(m_dstR);
+    writer->writeInt(m_operator);
+    return true;
+}
+
+bool DrawConvexPolygonQuad::write(RecordingWriter* writer)
+{
+    for (int i = 0; i < 4; i++)
+        writer->writeFloatPoint(m_points[i]);
+    writer->writeBool(m_shouldAntiAlias);
+    return true;
+}
+
+bool DrawEllipse::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    return true;
+}
+
+bool DrawFocusRing::write(RecordingWriter* writer)
+{
+    writer->writeInt(m_rects.size());
+    for (size_t i = 0; i < m_rects.size(); i++)
+        writer->writeIntRect(m_rects[i]);
+    writer->writeInt(m_width);
+    writer->writeInt(m_offset);
+    writer->writeColor(m_color);
+    return true;
+}
+
+bool DrawLine::write(RecordingWriter* writer)
+{
+    writer->writeIntPoint(m_point1);
+    writer->writeIntPoint(m_point2);
+    return true;
+}
+
+bool DrawLineForText::write(RecordingWriter* writer)
+{
+    writer->writeFloatPoint(m_point);
+    writer->writeFloat(m_width);
+    return true;
+}
+
+bool DrawLineForTextChecking::write(RecordingWriter* writer)
+{
+    writer->writeFloatPoint(m_point);
+    writer->writeFloat(m_width);
+    writer->writeInt(m_lineStyle);
+    return true;
+}
+
+bool DrawRect::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    return true;
+}
+
+bool FillPath::write(RecordingWriter* writer)
+{
+    writer->writePath(m_path);
+    writer->writeInt(m_fillRule);
+    return true;
+}
+
+bool FillRect::write(RecordingWriter* writer)
+{
+    writer->writeFloatRect(m_rect);
+    writer->writeBool(m_hasColor);
+    writer->writeColor(m_color);
+    writer->writeData(m_mergedRects, m_mergedCount * sizeof(FloatRect));
+    return true;
+}
+
+bool FillRoundedRect::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    writer->writeIntSize(m_topLeft);
+    writer->writeIntSize(m_topRight);
+    writer->writeIntSize(m_bottomLeft);
+    writer->writeIntSize(m_bottomRight);
+    writer->writeColor(m_color);
+    return true;
+}
+
+bool StrokeArc::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    writer->writeInt(m_startAngle);
+    writer->writeInt(m_angleSpan);
+    return true;
+}
+
+bool StrokePath::write(RecordingWriter* writer)
+{
+    writer->writePath(m_path);
+    return true;
+}
+
+bool StrokeRect::write(RecordingWriter* writer)
+{
+    writer->writeFloatRect(m_rect);
+    writer->writeFloat(m_lineWidth);
+    return true;
+}
+
+bool DrawMediaButton::write(RecordingWriter* writer)
+{
+    writer->writeIntRect(m_rect);
+    writer->writeIntRect(m_thumb);
+    writer->writeInt(m_buttonType);
+    writer->writeBool(m_translucent);
+    writer->writeBool(m_drawBackground);
+    return true;
+}
+
+bool DrawPosText::write(RecordingWriter* writer)
+{
+    writer->writePaint(m_paint);
+    writer->writeData(m_text, m_byteLength);
+    writer->writeData(m_pos, m_paint->countText(m_text, m_byteLength) * sizeof(SkPoint));
+    return true;
+}
+
+#define NEW_OP(X) new (allocator) X
+
+Operation* readOperation(RecordingReader* reader, android::LinearAllocator* allocator)
+{
+    switch (reader->readInt()) {
+    // Matrix operations
+    case Operation::ConcatCTMOperation: {
+        double a = reader->readDouble();
+        double b = reader->readDouble();
+        double c = reader->readDouble();
+        double d = reader->readDouble();
+        double e = reader->readDouble();
+        double f = reader->readDouble();
+        return NEW_OP(ConcatCTM)(AffineTransform(a, b, c, d, e, f));
+    }
+    case Operation::ScaleOperation: {
+        float width = reader->readFloat();
+        float height = reader->readFloat();
+        return NEW_OP(Scale)(FloatSize(width, height));
+    }
+    case Operation::RotateOperation:
+        return NEW_OP(Rotate)(reader->readFloat());
+    case Operation::TranslateOperation: {
+        float x = reader->readFloat();
+        float y = reader->readFloat();
+        return NEW_OP(Translate)(x, y);
+    }
+    // Clipping
+    case Operation::InnerRoundedRectClipOperation: {
+        IntRect rect = reader->readIntRect();
+        return NEW_OP(InnerRoundedRectClip)(rect, reader->readInt());
+    }
+    case Operation::ClipOperation:
+        return NEW_OP(Clip)(reader->readFloatRect());
+    case Operation::ClipPathOperation: {
+        Path path;
+        reader->readPath(&path);
+        bool clipOut = reader->readBool();
+        bool hasWindRule = reader->readBool();
+        WindRule windRule = static_cast<WindRule>(reader->readInt());
+        ClipPath* operation = NEW_OP(ClipPath)(path, clipOut);
+        if (hasWindRule)
+            operation->setWindRule(windRule);
+        return operation;
+    }
+    case Operation::ClipOutOperation:
+        return NEW_OP(ClipOut)(reader->readIntRect());
+    case Operation::ClearRectOperation:
+        return NEW_OP(ClearRect)(reader->readFloatRect());
+    // Drawing
+    case Operation::DrawBitmapPatternOperation: {
+        const SkBitmap& bitmap = reader->readBitmap();
+        SkMatrix matrix;
+        reader->readMatrix(&matrix);
+        CompositeOperator op = static_cast<CompositeOperator>(reader->readInt());
+        return NEW_OP(DrawBitmapPattern)(bitmap, matrix, op, reader->readFloatRect());
+    }
+    case Operation::DrawBitmapRectOperation: {
+        const SkBitmap& bitmap = reader->readBitmap();
+        SkIRect src = reader->readIntRect();
+        SkRect dst = reader->readFloatRect();
+        CompositeOperator op = static_cast<CompositeOperator>(reader->readInt());
+        return NEW_OP(DrawBitmapRect)(bitmap, src, dst, op);
+    }
+    case Operation::DrawConvexPolygonQuadOperation: {
+        FloatPoint points[4];
+        for (int i = 0; i < 4; i++)
+            points[i] = reader->readFloatPoint();
+        return NEW_OP(DrawConvexPolygonQuad)(points, reader->readBool());
+    }
+    case Operation::DrawEllipseOperation:
+        return NEW_OP(DrawEllipse)(reader->readIntRect());
+    case Operation::DrawFocusRingOperation: {
+        Vector<IntRect> rects(reader->readCount(4 * sizeof(int32_t)));
+        for (size_t i = 0; i < rects.size(); i++)
+            rects[i] = reader->readIntRect();
+        int width = reader->readInt();
+        int offset = reader->readInt();
+        return NEW_OP(DrawFocusRing)(rects, width, offset, reader->readColor());
+    }
+    case Operation::DrawLineOperation: {
+        IntPoint point1 = reader->readIntPoint();
+        return NEW_OP(DrawLine)(point1, reader->readIntPoint());
+    }
+    case Operation::DrawLineForTextOperation: {
+        FloatPoint point = reader->readFloatPoint();
+        return NEW_OP(DrawLineForText)(point, reader->readFloat());
+    }
+    case Operation::DrawLineForTextCheckingOperation: {
+        FloatPoint point = reader->readFloatPoint();
+        float width = reader->readFloat();
+        GraphicsContext::TextCheckingLineStyle lineStyle =
+            static_cast<GraphicsContext::TextCheckingLineStyle>(reader->readInt());
+        return NEW_OP(DrawLineForTextChecking)(point, width, lineStyle);
+    }
+    case Operation::DrawRectOperation:
+        return NEW_OP(DrawRect)(reader->readIntRect());
+    case Operation::FillPathOperation: {
+        Path path;
+        reader->readPath(&path);
+        return NEW_OP(FillPath)(path, static_cast<WindRule>(reader->readInt()));
+    }
+    case Operation::FillRectOperation: {
+        FillRect* operation = NEW_OP(FillRect)(reader->readFloatRect());
+        bool hasColor = reader->readBool();
+        Color color = reader->readColor();
+        if (hasColor)
+            operation->setColor(color);
+        size_t length;
+        const void* mergedRects = reader->readData(&length);
+        operation->setMergedRects(static_cast<const FloatRect*>(mergedRects),
+                                  length / sizeof(FloatRect));
+        return operation;
+    }
+    case Operation::FillRoundedRectOperation: {
+        IntRect rect = reader->readIntRect();
+        IntSize topLeft = reader->readIntSize();
+        IntSize topRight = reader->readIntSize();
+        IntSize bottomLeft = reader->readIntSize();
+        IntSize bottomRight = reader->readIntSize();
+        return NEW_OP(FillRoundedRect)(rect, topLeft, topRight, bottomLeft, bottomRight,
+                                       reader->readColor());
+    }
+    case Operation::StrokeArcOperation: {
+        IntRect rect = reader->readIntRect();
+        int startAngle = reader->readInt();
+        return NEW_OP(StrokeArc)(rect, startAngle, reader->readInt());
+    }
+    case Operation::StrokePathOperation: {
+        Path path;
+        reader->readPath(&path);
+        return NEW_OP(StrokePath)(path);
+    }
+    case Operation::StrokeRectOperation: {
+        FloatRect rect = reader->readFloatRect();
+        return NEW_OP(StrokeRect)(rect, reader->readFloat());
+    }
+    case Operation::DrawMediaButtonOperation: {
+        IntRect rect = reader->readIntRect();
+        IntRect thumb = reader->readIntRect();
+        RenderSkinMediaButton::MediaButton buttonType =
+            static_cast<RenderSkinMediaButton::MediaButton>(reader->readInt());
+        bool translucent = reader->readBool();
+        bool drawBackground = reader->readBool();
+        return NEW_OP(DrawMediaButton)(rect, buttonType, translucent, drawBackground, thumb);
+    }
+    // Text
+    case Operation::DrawPosTextOperation: {
+        const SkPaint* paint = reader->readPaint();
+        size_t byteLength;
+        const void* text = reader->readData(&byteLength);
+        size_t posLength;
+        const SkPoint* pos = static_cast<const SkPoint*>(reader->readData(&posLength));
+        if (posLength < paint->countText(text, byteLength) * sizeof(SkPoint))
+            return 0;
+        return NEW_OP(DrawPosText)(text, byteLength, pos, paint);
+    }
+    default:
+        break;
+    }
+    return 0;
+}
+
 } // namespace GraphicsOperation
 } // namespace WebCore
@@ -42,13 +42,7 @@
 
 #define TYPE_CASE(type) case type: return #type;
 
-#define DEBUG_GRAPHICS_OPERATIONS false
-
-#if DEBUG_GRAPHICS_OPERATIONS
 #define TYPE(x) virtual OperationType type() { return x; }
-#else
-#define TYPE(x)
-#endif
 
 namespace android {
 class LinearAllocator;
@@ -57,9 +51,23 @@ class LinearAllocator;
 namespace WebCore {
 
 class CanvasState;
+class RecordingReader;
+class RecordingWriter;
 
 namespace GraphicsOperation {
 
+// SkPath computes its bounds and convexity lazily on first use. Recorded
+// paths can be replayed from several threads at once, so compute them
+// while recording instead.
+static inline void primePathCaches(const Path& path)
+{
+    SkPath* skPath = path.platformPath();
+    if (!skPath)
+        return;
+    skPath->getBounds();
+    skPath->getConvexity();
+}
+
 class Operation {
 public:
     Operation()
@@ -91,7 +99,18 @@ public:
     virtual bool isOpaque() { return false; }
     virtual void setOpaqueRect(const IntRect& bounds) {}
 
-#if DEBUG_GRAPHICS_OPERATIONS
+    // Merging -- when a recording is finished, runs of adjacent operations
+    // sharing the same state are combined into the first one of the run.
+    // canMergeWith() is only called with operations that directly follow
+    // this one and have the same state and canvas state.
+    virtual bool canMergeWith(Operation* next) { return false; }
+    virtual void mergeRun(Operation* const* next, size_t count,
+                          android::LinearAllocator* allocator) {}
+
+    // Serialization -- writes the data of the operation for readOperation(),
+    // see SerializedRecording. Returns false if it can't be serialized.
+    virtual bool write(RecordingWriter* writer) { return false; }
+
     typedef enum { UndefinedOperation
                   // Matrix operations
                   , ConcatCTMOperation
@@ -123,11 +142,12 @@ public:
                   , DrawMediaButtonOperation
                   // Text
                   , DrawPosTextOperation
+                  , OperationTypeCount
     } OperationType;
 
-    const char* name()
+    static const char* name(OperationType type)
     {
-        switch (type()) {
+        switch (type) {
             TYPE_CASE(UndefinedOperation)
             // Matrix operations
             TYPE_CASE(ConcatCTMOperation)
@@ -159,10 +179,14 @@ public:
             TYPE_CASE(DrawMediaButtonOperation)
             // Text
             TYPE_CASE(DrawPosTextOperation)
+            default:
+                break;
         }
         return "Undefined";
     }
-#endif
+
+    const char* name() { return name(type()); }
+
     TYPE(UndefinedOperation)
 };
 
@@ -186,6 +210,7 @@ public:
         context->concatCTM(m_matrix);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(ConcatCTMOperation)
 private:
     AffineTransform m_matrix;
@@ -198,6 +223,7 @@ public:
         context->rotate(m_angle);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(RotateOperation)
 private:
     float m_angle;
@@ -210,6 +236,16 @@ public:
         context->scale(m_scale);
         return true;
     }
+    virtual bool canMergeWith(Operation* next) { return next->type() == ScaleOperation; }
+    virtual void mergeRun(Operation* const* next, size_t count,
+                          android::LinearAllocator* allocator) {
+        for (size_t i = 0; i < count; i++) {
+            const FloatSize& scale = static_cast<Scale*>(next[i])->m_scale;
+            m_scale = FloatSize(m_scale.width() * scale.width(),
+                                m_scale.height() * scale.height());
+        }
+    }
+    virtual bool write(RecordingWriter* writer);
     TYPE(ScaleOperation)
 private:
     FloatSize m_scale;
@@ -222,6 +258,15 @@ public:
         context->translate(m_x, m_y);
         return true;
     }
+    virtual bool canMergeWith(Operation* next) { return next->type() == TranslateOperation; }
+    virtual void mergeRun(Operation* const* next, size_t count,
+                          android::LinearAllocator* allocator) {
+        for (size_t i = 0; i < count; i++) {
+            m_x += static_cast<Translate*>(next[i])->m_x;
+            m_y += static_cast<Translate*>(next[i])->m_y;
+        }
+    }
+    virtual bool write(RecordingWriter* writer);
     TYPE(TranslateOperation)
 private:
     float m_x;
@@ -240,6 +285,7 @@ public:
         context->addInnerRoundedRectClip(m_rect, m_thickness);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(InnerRoundedRectClipOperation)
 private:
     IntRect m_rect;
@@ -252,6 +298,7 @@ public:
     virtual bool applyImpl(PlatformGraphicsContext* context) {
         return context->clip(m_rect);
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(ClipOperation)
 private:
     const FloatRect m_rect;
@@ -260,7 +307,10 @@ private:
 class ClipPath : public Operation {
 public:
     ClipPath(const Path& path, bool clipout = false)
-        : m_path(path), m_clipOut(clipout), m_hasWindRule(false) {}
+        : m_path(path), m_clipOut(clipout), m_hasWindRule(false)
+    {
+        primePathCaches(m_path);
+    }
     void setWindRule(WindRule rule) { m_windRule = rule; m_hasWindRule = true; }
     virtual bool applyImpl(PlatformGraphicsContext* context) {
         if (m_hasWindRule) {
@@ -271,6 +321,7 @@ public:
         else
             return context->clip(m_path);
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(ClipPathOperation)
 private:
     const Path m_path;
@@ -285,6 +336,7 @@ public:
     virtual bool applyImpl(PlatformGraphicsContext* context) {
         return context->clipOut(m_rect);
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(ClipOutOperation)
 private:
     const IntRect m_rect;
@@ -297,6 +349,7 @@ public:
         context->clearRect(m_rect);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(ClearRectOperation)
 private:
     FloatRect m_rect;
@@ -316,6 +369,7 @@ public:
         return true;
     }
     virtual bool isOpaque() { return m_bitmap.isOpaque(); }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawBitmapPatternOperation)
 
 private:
@@ -335,6 +389,7 @@ public:
         return true;
     }
     virtual bool isOpaque() { return m_bitmap.isOpaque(); }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawBitmapRectOperation)
 private:
     SkBitmap m_bitmap;
@@ -354,6 +409,7 @@ public:
         context->drawConvexPolygon(4, m_points, m_shouldAntiAlias);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawConvexPolygonQuadOperation)
 private:
     bool m_shouldAntiAlias;
@@ -367,6 +423,7 @@ public:
         context->drawEllipse(m_rect);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawEllipseOperation)
 private:
     IntRect m_rect;
@@ -384,6 +441,7 @@ public:
         context->drawFocusRing(m_rects, m_width, m_offset, m_color);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawFocusRingOperation)
 private:
     Vector<IntRect> m_rects;
@@ -400,6 +458,7 @@ public:
         context->drawLine(m_point1, m_point2);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawLineOperation)
 private:
     IntPoint m_point1;
@@ -414,6 +473,7 @@ public:
         context->drawLineForText(m_point, m_width);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawLineForTextOperation)
 private:
     FloatPoint m_point;
@@ -429,6 +489,7 @@ public:
         context->drawLineForTextChecking(m_point, m_width, m_lineStyle);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawLineForTextCheckingOperation)
 private:
     FloatPoint m_point;
@@ -443,6 +504,7 @@ public:
         context->drawRect(m_rect);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawRectOperation)
 private:
     IntRect m_rect;
@@ -451,11 +513,20 @@ private:
 class FillPath : public Operation {
 public:
     FillPath(const Path& pathToFill, WindRule fillRule)
-        : m_path(pathToFill), m_fillRule(fillRule) {}
+        : m_path(pathToFill), m_fillRule(fillRule)
+    {
+        // Set the fill type now so that replaying doesn't modify the path
+        if (SkPath* path = m_path.platformPath()) {
+            path->setFillType(fillRule == RULE_EVENODD
+                    ? SkPath::kEvenOdd_FillType : SkPath::kWinding_FillType);
+        }
+        primePathCaches(m_path);
+    }
     virtual bool applyImpl(PlatformGraphicsContext* context) {
         context->fillPath(m_path, m_fillRule);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(FillPathOperation)
 private:
     Path m_path;
@@ -464,22 +535,40 @@ private:
 
 class FillRect : public PossiblyOpaqueOperation {
 public:
-    FillRect(const FloatRect& rect) : m_rect(rect), m_hasColor(false) {}
+    FillRect(const FloatRect& rect)
+        : m_rect(rect), m_hasColor(false), m_mergedRects(0), m_mergedCount(0) {}
     void setColor(Color c) { m_color = c; m_hasColor = true; }
+    void setMergedRects(const FloatRect* rects, size_t count) {
+        m_mergedRects = rects;
+        m_mergedCount = count;
+    }
     virtual bool applyImpl(PlatformGraphicsContext* context) {
-        if (m_hasColor)
-             context->fillRect(m_rect, m_color);
-        else
-             context->fillRect(m_rect);
+        fill(context, m_rect);
+        for (size_t i = 0; i < m_mergedCount; i++)
+            fill(context, m_mergedRects[i]);
         return true;
     }
     virtual bool isOpaque() { return (m_hasColor && !m_color.hasAlpha())
             || (!m_hasColor && SkColorGetA(m_state->fillColor) == 0xFF); }
+    virtual bool canMergeWith(Operation* next);
+    virtual void mergeRun(Operation* const* next, size_t count,
+                          android::LinearAllocator* allocator);
+    virtual bool write(RecordingWriter* writer);
     TYPE(FillRectOperation)
 private:
+    void fill(PlatformGraphicsContext* context, const FloatRect& rect) {
+        if (m_hasColor)
+             context->fillRect(rect, m_color);
+        else
+             context->fillRect(rect);
+    }
+
     FloatRect m_rect;
     Color m_color;
     bool m_hasColor;
+    // Rects of the FillRect operations merged into this one, in order
+    const FloatRect* m_mergedRects;
+    size_t m_mergedCount;
 };
 
 class FillRoundedRect : public Operation {
@@ -503,6 +592,7 @@ public:
                                  m_color);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(FillRoundedRectOperation)
 private:
     IntRect m_rect;
@@ -524,6 +614,7 @@ public:
         context->strokeArc(m_rect, m_startAngle, m_angleSpan);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(StrokeArcOperation)
 private:
     IntRect m_rect;
@@ -533,11 +624,15 @@ private:
 
 class StrokePath : public Operation {
 public:
-    StrokePath(const Path& path) : m_path(path) {}
+    StrokePath(const Path& path) : m_path(path)
+    {
+        primePathCaches(m_path);
+    }
     virtual bool applyImpl(PlatformGraphicsContext* context) {
         context->strokePath(m_path);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(StrokePathOperation)
 private:
     Path m_path;
@@ -552,6 +647,7 @@ public:
         context->strokeRect(m_rect, m_lineWidth);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(StrokeRectOperation)
 private:
     FloatRect m_rect;
@@ -573,6 +669,7 @@ public:
         context->drawMediaButton(m_rect, m_buttonType, m_translucent, m_drawBackground, m_thumb);
         return true;
     }
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawMediaButtonOperation)
 private:
     IntRect m_rect;
@@ -599,6 +696,14 @@ public:
         context->drawPosText(m_text, m_byteLength, m_pos, *m_paint);
         return true;
     }
+    virtual bool canMergeWith(Operation* next) {
+        // Paints are shared by the recording, so equal paints are the same pointer
+        return next->type() == DrawPosTextOperation
+            && static_cast<DrawPosText*>(next)->m_paint == m_paint;
+    }
+    virtual void mergeRun(Operation* const* next, size_t count,
+                          android::LinearAllocator* allocator);
+    virtual bool write(RecordingWriter* writer);
     TYPE(DrawPosTextOperation)
 private:
     const void* m_text;
@@ -607,6 +712,11 @@ private:
     const SkPaint* m_paint;
 };
 
+// Decodes an operation written with Operation::write(), returns 0 if it
+// isn't a known operation or its data doesn't add up. Whether the data was
+// all there is left to |reader|, see RecordingReader::isValid().
+Operation* readOperation(RecordingReader* reader, android::LinearAllocator* allocator);
+
 }
 
 }
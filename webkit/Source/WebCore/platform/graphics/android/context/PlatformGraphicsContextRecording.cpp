@@ -37,9 +37,11 @@
 #include "GraphicsOperation.h"
 #include "PlatformGraphicsContextSkia.h"
 #include "RTree.h"
+#include "SerializedRecording.h"
 #include "SkDevice.h"
 
 #include "wtf/NonCopyingSort.h"
+#include "wtf/HashMap.h"
 #include "wtf/HashSet.h"
 #include "wtf/StringHasher.h"
 
@@ -49,6 +51,9 @@
 
 #define USE_CLIPPING_PAINTER true
 
+// Cull, merge and collapse operations once a recording is finished
+#define OPTIMIZE_RECORDINGS true
+
 // Operations smaller than this area aren't considered opaque, and thus don't
 // clip operations below. Chosen empirically.
 #define MIN_TRACKED_OPAQUE_AREA 750
@@ -56,6 +61,15 @@
 // Cap on ClippingPainter's recursive depth. Chosen empirically.
 #define MAX_CLIPPING_RECURSION_COUNT 400
 
+// Number of opaque areas kept to cull the operations they cover, only the
+// largest are kept past that.
+#define MAX_CULLING_OCCLUDERS 32
+
+// Adjacent drawing operations are only merged if the bounds of the result
+// aren't more than this many times the area of the merged operations, so
+// that tiles don't end up replaying operations that are far outside of them.
+#define MAX_MERGED_AREA_RATIO 2
+
 namespace WebCore {
 
 static FloatRect approximateTextBounds(size_t numGlyphs,
@@ -146,7 +160,7 @@ public:
         m_operations.clear();
     }
 
-    bool isParentOf(CanvasState* other) {
+    bool isParentOf(const CanvasState* other) const {
         while (other->m_parent) {
             if (other->m_parent == this)
                 return true;
@@ -157,7 +171,17 @@ public:
 
     void playback(PlatformGraphicsContext* context, size_t fromId, size_t toId) const {
         ALOGV("playback %p from %d->%d", this, fromId, toId);
-        for (size_t i = 0; i < m_operations.size(); i++) {
+        // Operations are sorted by m_orderBy, skip the ones already played
+        size_t low = 0;
+        size_t high = m_operations.size();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (m_operations[mid]->m_orderBy < fromId)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        for (size_t i = low; i < m_operations.size(); i++) {
             RecordingData *data = m_operations[i];
             if (data->m_orderBy < fromId)
                 continue;
@@ -169,9 +193,11 @@ public:
         }
     }
 
-    CanvasState* parent() { return m_parent; }
+    CanvasState* parent() const { return m_parent; }
+    void setParent(CanvasState* parent) { m_parent = parent; }
+    bool hasOperations() const { return !m_operations.isEmpty(); }
 
-    void enterState(PlatformGraphicsContext* context) {
+    void enterState(PlatformGraphicsContext* context) const {
         ALOGV("enterState %p", this);
         if (m_isTransparencyLayer)
             context->beginTransparencyLayer(m_opacity);
@@ -179,7 +205,7 @@ public:
             context->save();
     }
 
-    void exitState(PlatformGraphicsContext* context) {
+    void exitState(PlatformGraphicsContext* context) const {
         ALOGV("exitState %p", this);
         if (m_isTransparencyLayer)
             context->endTransparencyLayer();
@@ -191,15 +217,64 @@ public:
         m_operations.append(data);
     }
 
-    bool isTransparencyLayer() {
+    bool isTransparencyLayer() const {
         return m_isTransparencyLayer;
     }
 
+    float opacity() const { return m_opacity; }
+    const Vector<RecordingData*>& operations() const { return m_operations; }
+
+    // Merges runs of state operations that no drawing operation is replayed
+    // in between, |drawingOrder| is the sorted m_orderBy of all the drawing
+    // operations in the recording. Returns the number of operations removed.
+    size_t mergeOperations(const Vector<size_t>& drawingOrder,
+                           android::LinearAllocator* allocator) {
+        Vector<GraphicsOperation::Operation*> run;
+        size_t merged = 0;
+        size_t count = 0;
+        size_t i = 0;
+        while (i < m_operations.size()) {
+            RecordingData* first = m_operations[i];
+            size_t end = i + 1;
+            run.shrink(0);
+            while (end < m_operations.size()
+                   && first->m_operation->canMergeWith(m_operations[end]->m_operation)
+                   && !hasDrawingBetween(drawingOrder, m_operations[end - 1]->m_orderBy,
+                                         m_operations[end]->m_orderBy)) {
+                run.append(m_operations[end]->m_operation);
+                end++;
+            }
+            if (run.size()) {
+                first->m_operation->mergeRun(run.data(), run.size(), allocator);
+                for (size_t j = i + 1; j < end; j++)
+                    m_operations[j]->~RecordingData();
+                merged += run.size();
+            }
+            m_operations[count++] = first;
+            i = end;
+        }
+        m_operations.shrink(count);
+        return merged;
+    }
+
     void* operator new(size_t size, android::LinearAllocator* la) {
         return la->alloc(size);
     }
 
 private:
+    static bool hasDrawingBetween(const Vector<size_t>& drawingOrder, size_t from, size_t to) {
+        size_t low = 0;
+        size_t high = drawingOrder.size();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (drawingOrder[mid] <= from)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low < drawingOrder.size() && drawingOrder[low] < to;
+    }
+
     CanvasState *m_parent;
     bool m_isTransparencyLayer;
     float m_opacity;
@@ -213,16 +288,59 @@ private:
     // the last thing destroyed.
     android::LinearAllocator m_heap;
 public:
+    struct Splice {
+        IntRect m_area;
+        // Operations from this one on were recorded for the splice
+        size_t m_firstOrderBy;
+    };
+
     RecordingImpl()
         : m_tree(&m_heap)
         , m_nodeCount(0)
+        , m_base(0)
+    {
+        // Operations are indexed all at once when recording finishes
+        m_tree.beginBulkLoad();
+    }
+
+    // Starts a recording that replaces |area| of |base|. Only what is
+    // recorded for |area| goes into this recording's tree, the rest is
+    // drawn from |base|, which is kept alive and left untouched.
+    RecordingImpl(Recording* base, const IntRect& area)
+        : m_tree(&m_heap)
+        , m_nodeCount(0)
+        , m_base(base)
     {
+        SkSafeRef(m_base);
+        m_tree.beginBulkLoad();
+        const RecordingImpl* baseImpl = base->recording();
+        m_nodeCount = baseImpl->m_nodeCount;
+        m_splices = baseImpl->m_splices;
+        Splice splice = { area, static_cast<size_t>(m_nodeCount) };
+        m_splices.append(splice);
     }
 
     ~RecordingImpl() {
         clearStates();
         clearCanvasStates();
         clearSkPaints();
+        SkSafeUnref(m_base);
+    }
+
+    const Vector<Splice>& splices() const { return m_splices; }
+
+    // Appends the operations overlapping |clip|, of this recording and of
+    // the ones it was spliced onto. Those entirely inside the area of a
+    // later splice are left out, as they would be clipped out anyway.
+    void search(const IntRect& clip, Vector<RecordingData*>& list) const {
+        Vector<IntRect> hidden;
+        search(clip, hidden, list);
+    }
+
+    // Same for all the operations, with their bounds
+    void collect(Vector<RTree::PackedTree::Element>& list) const {
+        Vector<IntRect> hidden;
+        collect(hidden, list);
     }
 
     PlatformGraphicsContext::State* getState(PlatformGraphicsContext::State* inState) {
@@ -260,7 +378,7 @@ public:
 
     void applyState(PlatformGraphicsContext* context,
                     CanvasState* fromState, size_t fromId,
-                    CanvasState* toState, size_t toId) {
+                    CanvasState* toState, size_t toId) const {
         ALOGV("applyState(%p->%p, %d-%d)", fromState, toState, fromId, toId);
         if (fromState != toState && fromState) {
             if (fromState->isParentOf(toState)) {
@@ -299,7 +417,64 @@ public:
         m_heap.dumpMemoryStats(PREFIX);
     }
 
+#if OPTIMIZE_RECORDINGS
+    struct OptimizationStats {
+        OptimizationStats()
+            : m_recordedOperations(0)
+            , m_culledOperations(0)
+            , m_mergedOperations(0)
+            , m_mergedStateOperations(0)
+            , m_collapsedStates(0)
+        {}
+
+        void add(const OptimizationStats& other) {
+            m_recordedOperations += other.m_recordedOperations;
+            m_culledOperations += other.m_culledOperations;
+            m_mergedOperations += other.m_mergedOperations;
+            m_mergedStateOperations += other.m_mergedStateOperations;
+            m_collapsedStates += other.m_collapsedStates;
+        }
+
+        void dump(const char* prefix) const {
+            ALOGD("%s%d drawing operations recorded, %d replayed (%d culled, %d merged), "
+                  "%d state operations merged, %d canvas states collapsed", prefix,
+                  m_recordedOperations, m_recordedOperations - m_culledOperations - m_mergedOperations,
+                  m_culledOperations, m_mergedOperations,
+                  m_mergedStateOperations, m_collapsedStates);
+        }
+
+        size_t m_recordedOperations;
+        size_t m_culledOperations;
+        size_t m_mergedOperations;
+        size_t m_mergedStateOperations;
+        size_t m_collapsedStates;
+    };
+
+    // Called once recording is finished, before the operations are indexed
+    void optimize();
+
+    void dumpOptimizationStats() {
+        static const char* PREFIX = "  ";
+        ALOGD("Optimizations:");
+        m_optimizationStats.dump(PREFIX);
+        ALOGD("Optimizations, all recordings:");
+        s_totalOptimizationStats.dump(PREFIX);
+    }
+#endif
+
 private:
+#if OPTIMIZE_RECORDINGS
+    typedef RTree::PackedTree::Element Element;
+
+    void cullOccludedOperations(Vector<Element>& elements);
+    void mergeDrawingOperations(Vector<Element>& elements, const Vector<bool>& followsPrevious);
+    void mergeRun(Vector<Element>& elements, const Vector<size_t>& run);
+    void collapseCanvasStates(Vector<Element>& elements);
+    void mergeStateOperations(Vector<Element>& elements);
+
+    OptimizationStats m_optimizationStats;
+    static OptimizationStats s_totalOptimizationStats;
+#endif
 
     void clearStates() {
         StateHashSet::iterator end = m_states.end();
@@ -324,8 +499,235 @@ private:
     StateHashSet m_states;
     SkPaintHashSet m_paints;
     Vector<CanvasState*> m_canvasStates;
+
+    void search(const IntRect& clip, Vector<IntRect>& hidden,
+                Vector<RecordingData*>& list) const {
+        m_tree.search(clip, hidden, list);
+        if (!m_base)
+            return;
+        hidden.append(m_splices.last().m_area);
+        m_base->recording()->search(clip, hidden, list);
+    }
+
+    void collect(Vector<IntRect>& hidden, Vector<RTree::PackedTree::Element>& list) const {
+        size_t first = list.size();
+        m_tree.collect(list);
+        size_t count = first;
+        for (size_t i = first; i < list.size(); i++) {
+            const RTree::PackedTree::Element& e = list[i];
+            bool isHidden = false;
+            for (size_t j = 0; j < hidden.size() && !isHidden; j++) {
+                isHidden = hidden[j].x() <= e.m_minX && hidden[j].y() <= e.m_minY
+                    && hidden[j].maxX() >= e.m_maxX && hidden[j].maxY() >= e.m_maxY;
+            }
+            if (!isHidden)
+                list[count++] = e;
+        }
+        list.shrink(count);
+        if (!m_base)
+            return;
+        hidden.append(m_splices.last().m_area);
+        m_base->recording()->collect(hidden, list);
+    }
+
+    // The recording a splice was made onto, which draws everything outside
+    // of the splice's area
+    Recording* m_base;
+    Vector<Splice> m_splices;
 };
 
+#if OPTIMIZE_RECORDINGS
+RecordingImpl::OptimizationStats RecordingImpl::s_totalOptimizationStats;
+
+static bool s_optimizationsEnabled = true;
+
+static inline float area(int width, int height)
+{
+    return static_cast<float>(width) * height;
+}
+
+static inline float area(const IntRect& rect)
+{
+    return area(rect.width(), rect.height());
+}
+
+void RecordingImpl::optimize()
+{
+    Vector<Element>& elements = m_tree.pendingElements();
+    m_optimizationStats.m_recordedOperations = elements.size();
+
+    // Whether each drawing operation directly follows the previous one with
+    // no state operation in between, needed to merge them. Computed first,
+    // as culling leaves gaps in the ordering.
+    Vector<bool> followsPrevious(elements.size());
+    for (size_t i = 0; i < elements.size(); i++) {
+        followsPrevious[i] = i
+            && elements[i].m_payload->m_orderBy == elements[i - 1].m_payload->m_orderBy + 1;
+    }
+
+    cullOccludedOperations(elements);
+    mergeDrawingOperations(elements, followsPrevious);
+
+    size_t count = 0;
+    for (size_t i = 0; i < elements.size(); i++) {
+        if (elements[i].m_payload)
+            elements[count++] = elements[i];
+    }
+    elements.shrink(count);
+
+    collapseCanvasStates(elements);
+    mergeStateOperations(elements);
+
+    s_totalOptimizationStats.add(m_optimizationStats);
+}
+
+void RecordingImpl::cullOccludedOperations(Vector<Element>& elements)
+{
+    // Walk down from the topmost operation, keeping track of the opaque areas
+    // drawn above. Operations entirely inside of one of them can't be seen.
+    Vector<IntRect> occluders;
+    for (int i = static_cast<int>(elements.size()) - 1; i >= 0; i--) {
+        Element& e = elements[i];
+        bool occluded = false;
+        for (size_t j = 0; j < occluders.size() && !occluded; j++) {
+            const IntRect& rect = occluders[j];
+            occluded = rect.x() <= e.m_minX && rect.y() <= e.m_minY
+                && rect.maxX() >= e.m_maxX && rect.maxY() >= e.m_maxY;
+        }
+        if (occluded) {
+            e.m_payload->~RecordingData();
+            e.m_payload = 0;
+            m_optimizationStats.m_culledOperations++;
+            continue;
+        }
+
+        const IntRect* opaqueRect = e.m_payload->m_operation->opaqueRect();
+        if (!opaqueRect || opaqueRect->isEmpty())
+            continue;
+        if (occluders.size() < MAX_CULLING_OCCLUDERS) {
+            occluders.append(*opaqueRect);
+            continue;
+        }
+        size_t smallest = 0;
+        for (size_t j = 1; j < occluders.size(); j++) {
+            if (area(occluders[j]) < area(occluders[smallest]))
+                smallest = j;
+        }
+        if (area(*opaqueRect) > area(occluders[smallest]))
+            occluders[smallest] = *opaqueRect;
+    }
+}
+
+void RecordingImpl::mergeDrawingOperations(Vector<Element>& elements,
+                                           const Vector<bool>& followsPrevious)
+{
+    // Indices of the operations in the current run, the first one is the
+    // operation the others get merged into
+    Vector<size_t> run;
+    float runArea = 0;
+    for (size_t i = 0; i < elements.size(); i++) {
+        if (!followsPrevious[i]) {
+            mergeRun(elements, run);
+            run.shrink(0);
+        }
+        Element& e = elements[i];
+        if (!e.m_payload)
+            continue;
+        GraphicsOperation::Operation* op = e.m_payload->m_operation;
+        float opArea = area(e.m_maxX - e.m_minX, e.m_maxY - e.m_minY);
+        if (run.size()) {
+            Element& first = elements[run[0]];
+            GraphicsOperation::Operation* firstOp = first.m_payload->m_operation;
+            int minX = std::min(first.m_minX, e.m_minX);
+            int minY = std::min(first.m_minY, e.m_minY);
+            int maxX = std::max(first.m_maxX, e.m_maxX);
+            int maxY = std::max(first.m_maxY, e.m_maxY);
+            if (op->m_state == firstOp->m_state
+                    && op->m_canvasState == firstOp->m_canvasState
+                    && firstOp->canMergeWith(op)
+                    && area(maxX - minX, maxY - minY) <= MAX_MERGED_AREA_RATIO * (runArea + opArea)) {
+                first.m_minX = minX;
+                first.m_minY = minY;
+                first.m_maxX = maxX;
+                first.m_maxY = maxY;
+                runArea += opArea;
+                run.append(i);
+                continue;
+            }
+            mergeRun(elements, run);
+            run.shrink(0);
+        }
+        // Shadows are drawn under each operation, merging would draw some
+        // of them above the operations preceding them instead
+        if (!SkColorGetA(op->m_state->shadow.color)) {
+            run.append(i);
+            runArea = opArea;
+        }
+    }
+    mergeRun(elements, run);
+}
+
+void RecordingImpl::mergeRun(Vector<Element>& elements, const Vector<size_t>& run)
+{
+    if (run.size() < 2)
+        return;
+    Vector<GraphicsOperation::Operation*> operations(run.size() - 1);
+    for (size_t i = 1; i < run.size(); i++)
+        operations[i - 1] = elements[run[i]].m_payload->m_operation;
+    elements[run[0]].m_payload->m_operation->mergeRun(operations.data(), operations.size(), heap());
+    for (size_t i = 1; i < run.size(); i++) {
+        elements[run[i]].m_payload->~RecordingData();
+        elements[run[i]].m_payload = 0;
+    }
+    m_optimizationStats.m_mergedOperations += operations.size();
+}
+
+static CanvasState* collapsedParent(CanvasState* state)
+{
+    // Only drawing was recorded between the save() and the restore() of a
+    // state without operations, so it can be drawn in its parent instead
+    while (state->parent() && !state->isTransparencyLayer() && !state->hasOperations())
+        state = state->parent();
+    return state;
+}
+
+void RecordingImpl::collapseCanvasStates(Vector<Element>& elements)
+{
+    for (size_t i = 0; i < elements.size(); i++) {
+        GraphicsOperation::Operation* op = elements[i].m_payload->m_operation;
+        op->m_canvasState = collapsedParent(op->m_canvasState);
+    }
+
+    Vector<CanvasState*> collapsed;
+    size_t count = 0;
+    for (size_t i = 0; i < m_canvasStates.size(); i++) {
+        CanvasState* state = m_canvasStates[i];
+        if (collapsedParent(state) != state)
+            collapsed.append(state);
+        else {
+            if (state->parent())
+                state->setParent(collapsedParent(state->parent()));
+            m_canvasStates[count++] = state;
+        }
+    }
+    m_canvasStates.shrink(count);
+    // Destroyed last, the states kept needed their parent chains intact
+    for (size_t i = 0; i < collapsed.size(); i++)
+        collapsed[i]->~CanvasState();
+    m_optimizationStats.m_collapsedStates += collapsed.size();
+}
+
+void RecordingImpl::mergeStateOperations(Vector<Element>& elements)
+{
+    // The elements are in recording order
+    Vector<size_t> drawingOrder(elements.size());
+    for (size_t i = 0; i < elements.size(); i++)
+        drawingOrder[i] = elements[i].m_payload->m_orderBy;
+    for (size_t i = 0; i < m_canvasStates.size(); i++)
+        m_optimizationStats.m_mergedStateOperations += m_canvasStates[i]->mergeOperations(drawingOrder, heap());
+}
+#endif // OPTIMIZE_RECORDINGS
+
 Recording::~Recording()
 {
     delete m_recording;
@@ -350,20 +752,21 @@ static IntRect enclosedIntRect(const FloatRect& rect)
 #if USE_CLIPPING_PAINTER
 class ClippingPainter {
 public:
-    ClippingPainter(RecordingImpl* recording,
+    ClippingPainter(const RecordingImpl* recording,
                     PlatformGraphicsContextSkia& context,
                     const SkMatrix& initialMatrix,
-                    Vector<RecordingData*> &nodes)
+                    RecordingData* const* nodes, size_t count)
         : m_recording(recording)
         , m_context(context)
         , m_initialMatrix(initialMatrix)
         , m_nodes(nodes)
+        , m_count(count)
         , m_lastOperationId(0)
         , m_currState(0)
     {}
 
     void draw(const SkIRect& bounds) {
-        drawWithClipRecursive(static_cast<int>(m_nodes.size()) - 1, bounds, 0);
+        drawWithClipRecursive(static_cast<int>(m_count) - 1, bounds, 0);
 
         while (m_currState) {
             m_currState->exitState(&m_context);
@@ -420,16 +823,68 @@ private:
             drawOperation(recordingData, uncovered);
     }
 
-    RecordingImpl* m_recording;
+    const RecordingImpl* m_recording;
     PlatformGraphicsContextSkia& m_context;
     const SkMatrix& m_initialMatrix;
-    const Vector<RecordingData*>& m_nodes;
+    RecordingData* const* m_nodes;
+    size_t m_count;
     size_t m_lastOperationId;
     CanvasState* m_currState;
 };
 #endif // USE_CLIPPING_PAINTER
 
-void Recording::draw(SkCanvas* canvas)
+void Recording::draw(SkCanvas* canvas) const
+{
+    RecordingReplayContext replayContext;
+    draw(canvas, &replayContext);
+}
+
+static void drawNodes(const RecordingImpl* recording, SkCanvas* canvas,
+                      RecordingData* const* nodes, size_t count)
+{
+    int saveCount = canvas->getSaveCount();
+    PlatformGraphicsContextSkia context(canvas);
+#if USE_CLIPPING_PAINTER
+#if ENABLE(OLD_SKIA)
+    if (canvas->getDevice() && canvas->getDevice()->config() != SkBitmap::kNo_Config
+        && count < MAX_CLIPPING_RECURSION_COUNT) {
+#else
+    if (canvas->getDevice() && canvas->getDevice()->accessBitmap(false).config() != SkBitmap::kNo_Config
+        && count < MAX_CLIPPING_RECURSION_COUNT) {
+#endif
+        ClippingPainter painter(recording, context, canvas->getTotalMatrix(), nodes, count);
+#if ENABLE(OLD_SKIA)
+        painter.draw(canvas->getTotalClip().getBounds());
+#else
+        SkIRect bounds;
+        canvas->getClipDeviceBounds(&bounds);
+        painter.draw(bounds);
+#endif
+    } else
+#endif
+    {
+        CanvasState* currState = 0;
+        size_t lastOperationId = 0;
+        for (size_t i = 0; i < count; i++) {
+            GraphicsOperation::Operation* op = nodes[i]->m_operation;
+            recording->applyState(&context, currState, lastOperationId,
+                                  op->m_canvasState, nodes[i]->m_orderBy);
+            currState = op->m_canvasState;
+            lastOperationId = nodes[i]->m_orderBy;
+            // ALOGV("apply: %p->%s()", op, op->name());
+            op->apply(&context);
+        }
+        while (currState) {
+            currState->exitState(&context);
+            currState = currState->parent();
+        }
+    }
+    if (saveCount != canvas->getSaveCount()) {
+        ALOGW("Save/restore mismatch! %d vs. %d", saveCount, canvas->getSaveCount());
+    }
+}
+
+void Recording::draw(SkCanvas* canvas, RecordingReplayContext* replayContext) const
 {
     if (!m_recording) {
         ALOGW("No recording!");
@@ -440,58 +895,153 @@ void Recording::draw(SkCanvas* canvas)
         ALOGW("Empty clip!");
         return;
     }
-    Vector<RecordingData*> nodes;
+    Vector<RecordingData*>& nodes = replayContext->m_nodes;
+    nodes.shrink(0);
 
     WebCore::IntRect iclip = enclosingIntRect(clip);
-    m_recording->m_tree.search(iclip, nodes);
+    m_recording->search(iclip, nodes);
 
     size_t count = nodes.size();
     ALOGV("Drawing %d nodes out of %d", count, m_recording->m_nodeCount);
-    if (count) {
-        int saveCount = canvas->getSaveCount();
-        nonCopyingSort(nodes.begin(), nodes.end(), CompareRecordingDataOrder);
-        PlatformGraphicsContextSkia context(canvas);
-#if USE_CLIPPING_PAINTER
-#if ENABLE(OLD_SKIA)
-        if (canvas->getDevice() && canvas->getDevice()->config() != SkBitmap::kNo_Config
-            && count < MAX_CLIPPING_RECURSION_COUNT) {
-#else
-        if (canvas->getDevice() && canvas->getDevice()->accessBitmap(false).config() != SkBitmap::kNo_Config
-            && count < MAX_CLIPPING_RECURSION_COUNT) {
-#endif
-            ClippingPainter painter(recording(), context, canvas->getTotalMatrix(), nodes);
-#if ENABLE(OLD_SKIA)
-            painter.draw(canvas->getTotalClip().getBounds());
-#else
-            SkIRect bounds;
-            canvas->getClipDeviceBounds(&bounds);
-            painter.draw(bounds);
-#endif
+    if (!count)
+        return;
+    nonCopyingSort(nodes.begin(), nodes.end(), CompareRecordingDataOrder);
+
+    const Vector<RecordingImpl::Splice>& splices = m_recording->splices();
+    if (splices.isEmpty()) {
+        drawNodes(m_recording, canvas, nodes.data(), count);
+        return;
+    }
+
+    // Each splice is drawn clipped to its area, on top of the operations
+    // recorded before it, which are clipped out of it
+    size_t begin = 0;
+    for (size_t i = 0; i <= splices.size(); i++) {
+        size_t end = begin;
+        if (i < splices.size()) {
+            while (end < count && nodes[end]->m_orderBy < splices[i].m_firstOrderBy)
+                end++;
         } else
-#endif
-        {
-            CanvasState* currState = 0;
-            size_t lastOperationId = 0;
-            for (size_t i = 0; i < count; i++) {
-                GraphicsOperation::Operation* op = nodes[i]->m_operation;
-                m_recording->applyState(&context, currState, lastOperationId,
-                                        op->m_canvasState, nodes[i]->m_orderBy);
-                currState = op->m_canvasState;
-                lastOperationId = nodes[i]->m_orderBy;
-                // ALOGV("apply: %p->%s()", op, op->name());
-                op->apply(&context);
-            }
-            while (currState) {
-                currState->exitState(&context);
-                currState = currState->parent();
-            }
-        }
-        if (saveCount != canvas->getSaveCount()) {
-            ALOGW("Save/restore mismatch! %d vs. %d", saveCount, canvas->getSaveCount());
-        }
+            end = count;
+        if (end == begin)
+            continue;
+
+        int saved = canvas->save(SkCanvas::kClip_SaveFlag);
+        if (i)
+            canvas->clipRect(splices[i - 1].m_area);
+        for (size_t j = i; j < splices.size(); j++)
+            canvas->clipRect(splices[j].m_area, SkRegion::kDifference_Op);
+        if (!canvas->quickReject(clip))
+            drawNodes(m_recording, canvas, nodes.data() + begin, end - begin);
+        canvas->restoreToCount(saved);
+        begin = end;
     }
 }
 
+size_t Recording::spliceCount() const
+{
+    return m_recording ? m_recording->splices().size() : 0;
+}
+
+size_t Recording::recordedOperationCount() const
+{
+    if (!m_recording)
+        return 0;
+    const Vector<RecordingImpl::Splice>& splices = m_recording->splices();
+    size_t first = splices.isEmpty() ? 0 : splices.last().m_firstOrderBy;
+    return m_recording->m_nodeCount - first;
+}
+
+size_t Recording::recordedBytes() const
+{
+    return m_recording ? m_recording->heap()->usedSize() : 0;
+}
+
+static bool CompareElementOrder(const RTree::PackedTree::Element& a,
+                                const RTree::PackedTree::Element& b)
+{
+    return a.m_payload->m_orderBy < b.m_payload->m_orderBy;
+}
+
+// Adds |state|, after its parents, with its state operations. Their order
+// is offset by |firstOrderBy|.
+static int serializeCanvasState(RecordingWriter& writer, HashMap<const CanvasState*, int>& indices,
+                                const CanvasState* state, size_t firstOrderBy)
+{
+    HashMap<const CanvasState*, int>::iterator it = indices.find(state);
+    if (it != indices.end())
+        return it->second;
+    int parent = -1;
+    if (state->parent()) {
+        parent = serializeCanvasState(writer, indices, state->parent(), firstOrderBy);
+        if (parent < 0)
+            return -1;
+    }
+    int index = writer.addCanvasState(parent, state->isTransparencyLayer(), state->opacity());
+    const Vector<RecordingData*>& operations = state->operations();
+    for (size_t i = 0; i < operations.size(); i++) {
+        if (!writer.addStateOperation(operations[i]->m_operation,
+                                      firstOrderBy + operations[i]->m_orderBy))
+            return -1;
+    }
+    indices.set(state, index);
+    return index;
+}
+
+// Adds the operations and splices of |recording|, ordered after the
+// |firstOrderBy| operations already written. Operations drawn from the
+// base of a splice are written as well, the serialized recording doesn't
+// depend on other recordings.
+static bool serializeRecording(RecordingWriter& writer, const RecordingImpl* recording,
+                               size_t firstOrderBy)
+{
+    Vector<RTree::PackedTree::Element> elements;
+    recording->collect(elements);
+    nonCopyingSort(elements.begin(), elements.end(), CompareElementOrder);
+
+    HashMap<const CanvasState*, int> canvasStates;
+    for (size_t i = 0; i < elements.size(); i++) {
+        const RTree::PackedTree::Element& e = elements[i];
+        GraphicsOperation::Operation* op = e.m_payload->m_operation;
+        int canvasState = serializeCanvasState(writer, canvasStates, op->m_canvasState, firstOrderBy);
+        IntRect bounds(e.m_minX, e.m_minY, e.m_maxX - e.m_minX, e.m_maxY - e.m_minY);
+        if (canvasState < 0
+            || !writer.addDrawingOperation(op, firstOrderBy + e.m_payload->m_orderBy,
+                                           canvasState, bounds))
+            return false;
+    }
+    const Vector<RecordingImpl::Splice>& splices = recording->splices();
+    for (size_t i = 0; i < splices.size(); i++)
+        writer.addSplice(splices[i].m_area, firstOrderBy + splices[i].m_firstOrderBy);
+    return true;
+}
+
+bool Recording::serialize(SkWStream* stream) const
+{
+    if (!m_recording)
+        return false;
+    RecordingWriter writer;
+    return serializeRecording(writer, m_recording, 0) && writer.finish(stream);
+}
+
+bool Recording::serialize(const Vector<const Recording*>& recordings,
+                          const Vector<IntRect>& areas, SkWStream* stream)
+{
+    // Each recording is a splice of its area over the previous ones
+    RecordingWriter writer;
+    size_t firstOrderBy = 0;
+    for (size_t i = 0; i < recordings.size(); i++) {
+        const RecordingImpl* recording = recordings[i]->m_recording;
+        if (!recording)
+            return false;
+        writer.addSplice(areas[i], firstOrderBy);
+        if (!serializeRecording(writer, recording, firstOrderBy))
+            return false;
+        firstOrderBy += recording->m_nodeCount;
+    }
+    return writer.finish(stream);
+}
+
 void Recording::setRecording(RecordingImpl* impl)
 {
     if (m_recording == impl)
@@ -522,11 +1072,48 @@ PlatformGraphicsContextRecording::PlatformGraphicsContextRecording(Recording* re
     pushStateOperation(new (heap()) CanvasState(0));
 }
 
+PlatformGraphicsContextRecording::PlatformGraphicsContextRecording(Recording* recording,
+        Recording* base, const IntRect& spliceArea)
+    : PlatformGraphicsContext()
+    , mPicture(0)
+    , mRecording(recording)
+    , mOperationState(0)
+    , m_maxZoomScale(1)
+    , m_isEmpty(true)
+    , m_canvasProxy(this)
+{
+    ALOGV("RECORDING: begin splice " INT_RECT_FORMAT, INT_RECT_ARGS(spliceArea));
+    mRecording->setRecording(new RecordingImpl(base, spliceArea));
+    mMatrixStack.append(SkMatrix::I());
+    mCurrentMatrix = &(mMatrixStack.last());
+    pushStateOperation(new (heap()) CanvasState(0));
+    // Anything outside of the splice is drawn from the base recording
+    clipState(spliceArea);
+}
+
 PlatformGraphicsContextRecording::~PlatformGraphicsContextRecording()
 {
     ALOGV("RECORDING: end");
-    IF_ALOGV()
+    if (mRecording) {
+#if OPTIMIZE_RECORDINGS
+        if (s_optimizationsEnabled)
+            mRecording->recording()->optimize();
+#endif
+        mRecording->recording()->m_tree.endBulkLoad();
+    }
+    IF_ALOGV() {
         mRecording->recording()->dumpMemoryStats();
+#if OPTIMIZE_RECORDINGS
+        mRecording->recording()->dumpOptimizationStats();
+#endif
+    }
+}
+
+void PlatformGraphicsContextRecording::setOptimizationsEnabled(bool enabled)
+{
+#if OPTIMIZE_RECORDINGS
+    s_optimizationsEnabled = enabled;
+#endif
 }
 
 bool PlatformGraphicsContextRecording::isPaintingDisabled()
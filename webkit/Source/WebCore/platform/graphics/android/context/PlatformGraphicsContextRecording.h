@@ -30,6 +30,10 @@
 
 #include "RecordingContextCanvasProxy.h"
 #include "SkRefCnt.h"
+#include "TestExport.h"
+#include <wtf/Vector.h>
+
+class SkWStream;
 
 namespace android {
 class LinearAllocator;
@@ -45,27 +49,66 @@ class RecordingImpl;
 class PlatformGraphicsContextSkia;
 class RecordingData;
 
-class Recording : public SkRefCnt {
+// Scratch state used while replaying a Recording. Each thread drawing a
+// Recording needs its own context; reusing one across draws on the same
+// thread avoids reallocating the search results every time.
+class RecordingReplayContext {
+public:
+    RecordingReplayContext() {}
+
+private:
+    Vector<RecordingData*> m_nodes;
+
+    friend class Recording;
+};
+
+class TEST_EXPORT Recording : public SkRefCnt {
 public:
     Recording()
         : m_recording(0)
     {}
     ~Recording();
 
-    void draw(SkCanvas* canvas);
+    // Replay is read-only: once recording is finished, the same Recording
+    // can be drawn from several threads at once, each with its own context.
+    void draw(SkCanvas* canvas, RecordingReplayContext* replayContext) const;
+    void draw(SkCanvas* canvas) const;
     void setRecording(RecordingImpl* impl);
     RecordingImpl* recording() { return m_recording; }
 
+    // Number of splices made since the last complete recording
+    size_t spliceCount() const;
+    // Operations and bytes recorded for this Recording, not counting what
+    // it shares with the Recording it was spliced from
+    size_t recordedOperationCount() const;
+    size_t recordedBytes() const;
+
+    // Writes the recording in the format read by SerializedRecording.
+    // Returns false if it holds something that can't be serialized.
+    bool serialize(SkWStream* stream) const;
+    // Writes |recordings| as one, each drawn clipped to its area over the
+    // ones before it, the way PicturePile draws its pictures
+    static bool serialize(const Vector<const Recording*>& recordings,
+                          const Vector<IntRect>& areas, SkWStream* stream);
+
 private:
     RecordingImpl* m_recording;
 };
 
-class PlatformGraphicsContextRecording : public PlatformGraphicsContext {
+class TEST_EXPORT PlatformGraphicsContextRecording : public PlatformGraphicsContext {
 public:
     PlatformGraphicsContextRecording(Recording* picture);
+    // Records |spliceArea| only; |picture| will draw the rest from |base|.
+    // |base| must be a finished recording.
+    PlatformGraphicsContextRecording(Recording* picture, Recording* base,
+                                     const IntRect& spliceArea);
     virtual ~PlatformGraphicsContextRecording();
     virtual bool isPaintingDisabled();
 
+    // Finished recordings are culled, merged and collapsed unless this is
+    // turned off, as tests do to compare with the operations as recorded
+    static void setOptimizationsEnabled(bool enabled);
+
     virtual SkCanvas* recordingCanvas();
     virtual void setTextOffset(FloatSize offset) { m_textOffset = offset; }
 
@@ -507,17 +507,21 @@ void PlatformGraphicsContextSkia::drawRect(const IntRect& rect)
 
 void PlatformGraphicsContextSkia::fillPath(const Path& pathToFill, WindRule fillRule)
 {
-    SkPath* path = pathToFill.platformPath();
+    const SkPath* path = pathToFill.platformPath();
     if (!path)
         return;
 
-    switch (fillRule) {
-    case RULE_NONZERO:
-        path->setFillType(SkPath::kWinding_FillType);
-        break;
-    case RULE_EVENODD:
-        path->setFillType(SkPath::kEvenOdd_FillType);
-        break;
+    SkPath::FillType fillType = fillRule == RULE_EVENODD
+            ? SkPath::kEvenOdd_FillType : SkPath::kWinding_FillType;
+
+    // Recorded paths may be replayed on several threads at once, so never
+    // modify the path in place. Recorded paths already have the right
+    // fill type, so the copy only happens for direct drawing.
+    SkPath copy;
+    if (path->getFillType() != fillType) {
+        copy = *path;
+        copy.setFillType(fillType);
+        path = &copy;
     }
 
     SkPaint paint;
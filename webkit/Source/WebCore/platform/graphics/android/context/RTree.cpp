@@ -31,6 +31,9 @@
 #include "RTree.h"
 
 #include "AndroidLog.h"
+#include <algorithm>
+#include <limits.h>
+#include <math.h>
 #include <utils/LinearAllocator.h>
 
 namespace WebCore {
@@ -134,6 +137,7 @@ int computeDeltaArea(Node* node, int& minx, int& miny,
 
 RTree::RTree(android::LinearAllocator* allocator, int M)
     : m_allocator(allocator)
+    , m_bulkLoading(false)
 {
     m_maxChildren = M;
     m_listA = new ElementList(M);
@@ -146,23 +150,124 @@ RTree::~RTree()
     delete m_listA;
     delete m_listB;
     deleteNode(m_root);
+    for (unsigned i = 0; i < m_pendingElements.size(); i++)
+        m_pendingElements[i].m_payload->~RecordingData();
+    m_packedTree.destroyPayloads();
 }
 
 void RTree::insert(WebCore::IntRect& bounds, WebCore::RecordingData* payload)
 {
+    if (m_bulkLoading) {
+        PackedTree::Element element;
+        element.m_minX = bounds.x();
+        element.m_minY = bounds.y();
+        element.m_maxX = bounds.maxX();
+        element.m_maxY = bounds.maxY();
+        element.m_payload = payload;
+        element.m_firstChild = 0;
+        element.m_nbChildren = 0;
+        m_pendingElements.append(element);
+        return;
+    }
     Node* e = Node::create(this, bounds.x(), bounds.y(),
                            bounds.maxX(), bounds.maxY(), payload);
     m_root->insert(e);
 }
 
-void RTree::search(WebCore::IntRect& clip, Vector<WebCore::RecordingData*>&list)
+static bool overlaps(const PackedTree::Element& e, int minx, int miny, int maxx, int maxy)
 {
-    m_root->search(clip.x(), clip.y(), clip.maxX(), clip.maxY(), list);
+    return !(minx > e.m_maxX || maxx < e.m_minX || maxy < e.m_minY || miny > e.m_maxY);
+}
+
+static bool isHidden(int minx, int miny, int maxx, int maxy,
+                     const Vector<WebCore::IntRect>* hidden)
+{
+    if (!hidden)
+        return false;
+    for (unsigned i = 0; i < hidden->size(); i++) {
+        const WebCore::IntRect& rect = hidden->at(i);
+        if (rect.x() <= minx && rect.y() <= miny && rect.maxX() >= maxx && rect.maxY() >= maxy)
+            return true;
+    }
+    return false;
+}
+
+static void searchTree(int minx, int miny, int maxx, int maxy,
+                       const PackedTree& packedTree,
+                       const Vector<PackedTree::Element>& pendingElements,
+                       const Node* root, Vector<WebCore::RecordingData*>& list,
+                       const Vector<WebCore::IntRect>* hidden)
+{
+    packedTree.search(minx, miny, maxx, maxy, list, hidden);
+    // Only while still bulk loading, as the elements aren't indexed yet
+    for (unsigned i = 0; i < pendingElements.size(); i++) {
+        const PackedTree::Element& e = pendingElements[i];
+        if (overlaps(e, minx, miny, maxx, maxy)
+            && !isHidden(e.m_minX, e.m_minY, e.m_maxX, e.m_maxY, hidden))
+            list.append(e.m_payload);
+    }
+    root->search(minx, miny, maxx, maxy, list, hidden);
+}
+
+void RTree::search(const WebCore::IntRect& clip, Vector<WebCore::RecordingData*>&list) const
+{
+    searchTree(clip.x(), clip.y(), clip.maxX(), clip.maxY(),
+               m_packedTree, m_pendingElements, m_root, list, 0);
+}
+
+void RTree::search(const WebCore::IntRect& clip, const Vector<WebCore::IntRect>& hidden,
+                   Vector<WebCore::RecordingData*>& list) const
+{
+    searchTree(clip.x(), clip.y(), clip.maxX(), clip.maxY(),
+               m_packedTree, m_pendingElements, m_root, list,
+               hidden.isEmpty() ? 0 : &hidden);
 }
 
 void RTree::remove(WebCore::IntRect& clip)
 {
-    m_root->remove(clip.x(), clip.y(), clip.maxX(), clip.maxY());
+    int minx = clip.x();
+    int miny = clip.y();
+    int maxx = clip.maxX();
+    int maxy = clip.maxY();
+    m_packedTree.remove(minx, miny, maxx, maxy);
+    for (unsigned i = 0; i < m_pendingElements.size();) {
+        PackedTree::Element& e = m_pendingElements[i];
+        if (minx <= e.m_minX && maxx >= e.m_maxX && miny <= e.m_minY && maxy >= e.m_maxY) {
+            e.m_payload->~RecordingData();
+            m_pendingElements.remove(i);
+        } else
+            i++;
+    }
+    m_root->remove(minx, miny, maxx, maxy);
+}
+
+void RTree::collect(Vector<PackedTree::Element>& list) const
+{
+    m_packedTree.collect(list);
+    list.append(m_pendingElements);
+    m_root->collect(list);
+}
+
+void RTree::beginBulkLoad()
+{
+    m_bulkLoading = true;
+}
+
+void RTree::endBulkLoad()
+{
+    if (!m_bulkLoading)
+        return;
+    m_bulkLoading = false;
+    if (m_packedTree.size()) {
+        // Already packed once, fall back to the dynamic tree
+        for (unsigned i = 0; i < m_pendingElements.size(); i++) {
+            PackedTree::Element& e = m_pendingElements[i];
+            m_root->insert(Node::create(this, e.m_minX, e.m_minY,
+                                        e.m_maxX, e.m_maxY, e.m_payload));
+        }
+    } else
+        m_packedTree.build(m_pendingElements, m_maxChildren);
+    m_pendingElements.clear();
 }
 
 void RTree::display()
@@ -183,6 +288,252 @@ void RTree::deleteNode(Node* n)
         n->~Node();
 }
 
+//////////////////////////////////////////////////////////////////////
+// PackedTree
+//
+// Sort-Tile-Recursive packing works one level at a time, starting with the
+// elements: sort them by the x coordinate of their center, cut them into
+// S = ceil(sqrt(n / M)) vertical slices, sort each slice by the y coordinate
+// of the center, and group each run of M elements into a parent node.
+// The parents then form the next level, until a single root is left.
+//
+//////////////////////////////////////////////////////////////////////
+
+static bool compareCenterX(const PackedTree::Element& a, const PackedTree::Element& b)
+{
+    return a.m_minX + a.m_maxX < b.m_minX + b.m_maxX;
+}
+
+static bool compareCenterY(const PackedTree::Element& a, const PackedTree::Element& b)
+{
+    return a.m_minY + a.m_maxY < b.m_minY + b.m_maxY;
+}
+
+static void sortTileRecursive(Vector<PackedTree::Element>& level, unsigned maxChildren)
+{
+    const unsigned size = level.size();
+    unsigned nbNodes = (size + maxChildren - 1) / maxChildren;
+    unsigned nbSlices = static_cast<unsigned>(ceilf(sqrtf(nbNodes)));
+    unsigned sliceSize = nbSlices * maxChildren;
+
+    std::sort(level.begin(), level.end(), compareCenterX);
+    for (unsigned i = 0; i < size; i += sliceSize) {
+        PackedTree::Element* end = level.begin() + std::min(size, i + sliceSize);
+        std::sort(level.begin() + i, end, compareCenterY);
+    }
+}
+
+void PackedTree::append(const Element& element)
+{
+    m_minX.append(element.m_minX);
+    m_minY.append(element.m_minY);
+    m_maxX.append(element.m_maxX);
+    m_maxY.append(element.m_maxY);
+    if (element.m_payload)
+        m_payloads.append(element.m_payload);
+    else {
+        m_firstChild.append(element.m_firstChild);
+        m_nbChildren.append(element.m_nbChildren);
+    }
+}
+
+void PackedTree::build(Vector<Element>& elements, unsigned maxChildren)
+{
+    m_nbElements = elements.size();
+    if (!m_nbElements)
+        return;
+
+    // Reserve for the elements, plus ~1/(M-1) internal nodes
+    unsigned capacity = m_nbElements + m_nbElements / (maxChildren - 1) + 2;
+    m_minX.reserveCapacity(capacity);
+    m_minY.reserveCapacity(capacity);
+    m_maxX.reserveCapacity(capacity);
+    m_maxY.reserveCapacity(capacity);
+    m_payloads.reserveCapacity(m_nbElements);
+
+    Vector<Element>* level = &elements;
+    Vector<Element> parents;
+    Vector<Element> nextLevel;
+    do {
+        sortTileRecursive(*level, maxChildren);
+        unsigned levelStart = m_minX.size();
+        for (unsigned i = 0; i < level->size(); i++)
+            append(level->at(i));
+
+        parents.clear();
+        for (unsigned i = 0; i < level->size(); i += maxChildren) {
+            unsigned count = std::min(maxChildren, static_cast<unsigned>(level->size()) - i);
+            Element parent = level->at(i);
+            for (unsigned j = 1; j < count; j++) {
+                const Element& child = level->at(i + j);
+                parent.m_minX = std::min(parent.m_minX, child.m_minX);
+                parent.m_minY = std::min(parent.m_minY, child.m_minY);
+                parent.m_maxX = std::max(parent.m_maxX, child.m_maxX);
+                parent.m_maxY = std::max(parent.m_maxY, child.m_maxY);
+            }
+            parent.m_payload = 0;
+            parent.m_firstChild = levelStart + i;
+            parent.m_nbChildren = count;
+            parents.append(parent);
+        }
+        nextLevel.swap(parents);
+        level = &nextLevel;
+    } while (level->size() > 1);
+
+    append(level->at(0));
+    m_root = m_minX.size() - 1;
+    ALOGV("Packed %d elements in %d nodes", m_nbElements, m_minX.size());
+}
+
+// Calls visitor(index) for each element overlapping the bounds
+template<typename Visitor>
+static void searchPacked(const PackedTree::View& tree, int minx, int miny, int maxx, int maxy,
+                         Visitor& visitor)
+{
+    if (tree.m_root < 0)
+        return;
+    unsigned root = tree.m_root;
+    if (minx > tree.m_maxX[root] || maxx < tree.m_minX[root]
+        || maxy < tree.m_minY[root] || miny > tree.m_maxY[root])
+        return;
+
+    Vector<unsigned, 64> stack;
+    stack.append(root);
+    while (!stack.isEmpty()) {
+        unsigned node = stack.last();
+        stack.removeLast();
+        unsigned first = tree.m_firstChild[node - tree.m_nbElements];
+        unsigned last = first + tree.m_nbChildren[node - tree.m_nbElements];
+        for (unsigned i = first; i < last; i++) {
+            if (minx > tree.m_maxX[i] || maxx < tree.m_minX[i]
+                || maxy < tree.m_minY[i] || miny > tree.m_maxY[i])
+                continue;
+            if (i < tree.m_nbElements)
+                visitor(i);
+            else
+                stack.append(i);
+        }
+    }
+}
+
+class PayloadCollector {
+public:
+    PayloadCollector(const PackedTree::View& tree,
+                     const Vector<WebCore::RecordingData*>& payloads,
+                     Vector<WebCore::RecordingData*>& list,
+                     const Vector<WebCore::IntRect>* hidden)
+        : m_tree(tree), m_payloads(payloads), m_list(list), m_hidden(hidden) {}
+    void operator()(unsigned index)
+    {
+        if (!isHidden(m_tree.m_minX[index], m_tree.m_minY[index],
+                      m_tree.m_maxX[index], m_tree.m_maxY[index], m_hidden))
+            m_list.append(m_payloads[index]);
+    }
+private:
+    const PackedTree::View& m_tree;
+    const Vector<WebCore::RecordingData*>& m_payloads;
+    Vector<WebCore::RecordingData*>& m_list;
+    const Vector<WebCore::IntRect>* m_hidden;
+};
+
+class IndexCollector {
+public:
+    IndexCollector(Vector<unsigned>& list) : m_list(list) {}
+    void operator()(unsigned index) { m_list.append(index); }
+private:
+    Vector<unsigned>& m_list;
+};
+
+PackedTree::View PackedTree::view() const
+{
+    View view;
+    view.m_minX = m_minX.data();
+    view.m_minY = m_minY.data();
+    view.m_maxX = m_maxX.data();
+    view.m_maxY = m_maxY.data();
+    view.m_firstChild = m_firstChild.data();
+    view.m_nbChildren = m_nbChildren.data();
+    view.m_nbElements = m_nbElements;
+    view.m_root = m_root;
+    return view;
+}
+
+void PackedTree::View::search(int minx, int miny, int maxx, int maxy,
+                              Vector<unsigned>& list) const
+{
+    IndexCollector collector(list);
+    searchPacked(*this, minx, miny, maxx, maxy, collector);
+}
+
+void PackedTree::search(int minx, int miny, int maxx, int maxy,
+                        Vector<WebCore::RecordingData*>& list,
+                        const Vector<WebCore::IntRect>* hidden) const
+{
+    View tree = view();
+    PayloadCollector collector(tree, m_payloads, list, hidden);
+    searchPacked(tree, minx, miny, maxx, maxy, collector);
+}
+
+void PackedTree::remove(int minx, int miny, int maxx, int maxy)
+{
+    if (m_root < 0)
+        return;
+
+    Vector<unsigned, 64> stack;
+    stack.append(m_root);
+    while (!stack.isEmpty()) {
+        unsigned node = stack.last();
+        stack.removeLast();
+        unsigned first = m_firstChild[node - m_nbElements];
+        unsigned last = first + m_nbChildren[node - m_nbElements];
+        for (unsigned i = first; i < last; i++) {
+            if (minx > m_maxX[i] || maxx < m_minX[i]
+                || maxy < m_minY[i] || miny > m_maxY[i])
+                continue;
+            if (i >= m_nbElements) {
+                stack.append(i);
+                continue;
+            }
+            if (minx <= m_minX[i] && maxx >= m_maxX[i]
+                && miny <= m_minY[i] && maxy >= m_maxY[i]) {
+                m_payloads[i]->~RecordingData();
+                m_payloads[i] = 0;
+                // empty bounds never overlap anything
+                m_minX[i] = m_minY[i] = INT_MAX;
+                m_maxX[i] = m_maxY[i] = INT_MIN;
+            }
+        }
+    }
+}
+
+void PackedTree::collect(Vector<Element>& list) const
+{
+    for (unsigned i = 0; i < m_nbElements; i++) {
+        if (!m_payloads[i])
+            continue;
+        Element element;
+        element.m_minX = m_minX[i];
+        element.m_minY = m_minY[i];
+        element.m_maxX = m_maxX[i];
+        element.m_maxY = m_maxY[i];
+        element.m_payload = m_payloads[i];
+        element.m_firstChild = 0;
+        element.m_nbChildren = 0;
+        list.append(element);
+    }
+}
+
+void PackedTree::destroyPayloads()
+{
+    for (unsigned i = 0; i < m_payloads.size(); i++) {
+        if (m_payloads[i])
+            m_payloads[i]->~RecordingData();
+    }
+    m_payloads.clear();
+    m_nbElements = 0;
+    m_root = -1;
+}
+
 //////////////////////////////////////////////////////////////////////
 // ElementList
 
@@ -360,7 +711,7 @@ void Node::remove(Node* node)
 
 void Node::destroy(int index)
 {
-    delete m_children[index];
+    m_tree->deleteNode(m_children[index]);
     // compact
     for (unsigned int i = index; i < m_nbChildren - 1; i++)
         m_children[i] = m_children[i + 1];
@@ -558,7 +909,7 @@ void Node::display(int level)
 }
 #endif
 
-bool Node::overlap(int minx, int miny, int maxx, int maxy)
+bool Node::overlap(int minx, int miny, int maxx, int maxy) const
 {
     return ! (minx > m_maxX
            || maxx < m_minX
@@ -566,15 +917,34 @@ bool Node::overlap(int minx, int miny, int maxx, int maxy)
            || miny > m_maxY);
 }
 
-void Node::search(int minx, int miny, int maxx, int maxy, Vector<WebCore::RecordingData*>& list)
+void Node::search(int minx, int miny, int maxx, int maxy, Vector<WebCore::RecordingData*>& list,
+                  const Vector<WebCore::IntRect>* hidden) const
 {
-    if (isElement() && overlap(minx, miny, maxx, maxy))
+    if (isElement() && overlap(minx, miny, maxx, maxy)
+        && !isHidden(m_minX, m_minY, m_maxX, m_maxY, hidden))
         list.append(this->m_payload);
 
     for (unsigned int i = 0; i < m_nbChildren; i++) {
         if (m_children[i]->overlap(minx, miny, maxx, maxy))
-            m_children[i]->search(minx, miny, maxx, maxy, list);
+            m_children[i]->search(minx, miny, maxx, maxy, list, hidden);
+    }
+}
+
+void Node::collect(Vector<PackedTree::Element>& list) const
+{
+    if (isElement()) {
+        PackedTree::Element element;
+        element.m_minX = m_minX;
+        element.m_minY = m_minY;
+        element.m_maxX = m_maxX;
+        element.m_maxY = m_maxY;
+        element.m_payload = m_payload;
+        element.m_firstChild = 0;
+        element.m_nbChildren = 0;
+        list.append(element);
     }
+    for (unsigned int i = 0; i < m_nbChildren; i++)
+        m_children[i]->collect(list);
 }
 
 bool Node::inside(int minx, int miny, int maxx, int maxy)
@@ -587,11 +957,15 @@ bool Node::inside(int minx, int miny, int maxx, int maxy)
 
 void Node::remove(int minx, int miny, int maxx, int maxy)
 {
-    for (unsigned int i = 0; i < m_nbChildren; i++) {
-        if (m_children[i]->inside(minx, miny, maxx, maxy))
+    for (unsigned int i = 0; i < m_nbChildren;) {
+        if (m_children[i]->inside(minx, miny, maxx, maxy)) {
+            // destroy() compacts the children, don't skip the next one
             destroy(i);
-        else if (m_children[i]->overlap(minx, miny, maxx, maxy))
+            continue;
+        }
+        if (m_children[i]->overlap(minx, miny, maxx, maxy))
             m_children[i]->remove(minx, miny, maxx, maxy);
+        i++;
     }
 }
 
@@ -29,6 +29,7 @@
 #include <Vector.h>
 #include "IntRect.h"
 #include "GraphicsOperation.h"
+#include "TestExport.h"
 
 namespace android {
 class LinearAllocator;
@@ -36,7 +37,7 @@ class LinearAllocator;
 
 namespace WebCore {
 
-class RecordingData {
+class TEST_EXPORT RecordingData {
 public:
     RecordingData(GraphicsOperation::Operation* ops, size_t orderBy)
         : m_orderBy(orderBy)
@@ -63,20 +64,105 @@ namespace RTree {
 class ElementList;
 class Node;
 
-class RTree {
+// Static R-Tree built in one pass with Sort-Tile-Recursive packing
+// ("STR: A Simple and Efficient Algorithm for R-Tree Packing",
+// Leutenegger et al.(97)). Nodes are stored level by level in flat arrays,
+// leaves first, and the children of a node are contiguous, so searching only
+// walks arrays of bounds. Removed elements are left in place as empty bounds.
+class TEST_EXPORT PackedTree {
+public:
+    struct Element {
+        int m_minX;
+        int m_minY;
+        int m_maxX;
+        int m_maxY;
+        WebCore::RecordingData* m_payload;
+        unsigned m_firstChild;
+        unsigned m_nbChildren;
+    };
+
+    // Read-only view of the node arrays of a PackedTree, which can also
+    // point to a copy of them, e.g. in a memory mapped file. Elements are
+    // identified by their index, below m_nbElements.
+    struct View {
+        const int* m_minX;
+        const int* m_minY;
+        const int* m_maxX;
+        const int* m_maxY;
+        const unsigned* m_firstChild;
+        const unsigned* m_nbChildren;
+        unsigned m_nbElements;
+        int m_root;
+
+        // Appends the indices of the elements overlapping the bounds
+        void search(int minx, int miny, int maxx, int maxy, Vector<unsigned>& list) const;
+    };
+
+    PackedTree() : m_nbElements(0), m_root(-1) {}
+
+    // Takes ownership of the payloads of the elements (the vector is reordered)
+    void build(Vector<Element>& elements, unsigned maxChildren);
+    // Elements entirely inside one of |hidden|, if given, are left out
+    void search(int minx, int miny, int maxx, int maxy,
+                Vector<WebCore::RecordingData*>& list,
+                const Vector<WebCore::IntRect>* hidden = 0) const;
+    void remove(int minx, int miny, int maxx, int maxy);
+    void collect(Vector<Element>& list) const;
+    void destroyPayloads();
+    unsigned size() const { return m_nbElements; }
+
+    // Valid until the tree is modified
+    View view() const;
+    // Number of entries in each of the arrays of the view
+    unsigned nodeCount() const { return m_minX.size(); }
+    WebCore::RecordingData* payload(unsigned index) const { return m_payloads[index]; }
+
+private:
+    void append(const Element& element);
+
+    Vector<int> m_minX;
+    Vector<int> m_minY;
+    Vector<int> m_maxX;
+    Vector<int> m_maxY;
+    // children ranges, for nodes at index m_nbElements and above
+    Vector<unsigned> m_firstChild;
+    Vector<unsigned> m_nbChildren;
+    // payloads, for nodes below index m_nbElements
+    Vector<WebCore::RecordingData*> m_payloads;
+    unsigned m_nbElements;
+    int m_root;
+};
+
+class TEST_EXPORT RTree {
 public:
     // M -- max number of children per node
     RTree(android::LinearAllocator* allocator, int M = 10);
     ~RTree();
 
     void insert(WebCore::IntRect& bounds, WebCore::RecordingData* payload);
-    // Does an overlap search
-    void search(WebCore::IntRect& clip, Vector<WebCore::RecordingData*>& list);
+    // Does an overlap search. The tree isn't modified, so concurrent
+    // searches are safe as long as nothing is inserted or removed.
+    void search(const WebCore::IntRect& clip, Vector<WebCore::RecordingData*>& list) const;
+    // Same, but leaves out the elements entirely inside one of |hidden|,
+    // e.g. the areas that splices made on top of a recording draw instead
+    void search(const WebCore::IntRect& clip, const Vector<WebCore::IntRect>& hidden,
+                Vector<WebCore::RecordingData*>& list) const;
     // Does an inclusive remove -- all elements fully inside the clip will
     // be removed from the tree
     void remove(WebCore::IntRect& clip);
+    // Appends all the elements of the tree, in no particular order
+    void collect(Vector<PackedTree::Element>& list) const;
     void display();
 
+    // Bulk loading -- between beginBulkLoad() and endBulkLoad(), insert()
+    // only queues the elements, which are then packed all at once into a
+    // PackedTree. Elements inserted afterwards go into the dynamic tree.
+    void beginBulkLoad();
+    void endBulkLoad();
+    // The elements queued since beginBulkLoad(), in insertion order. They
+    // can still be modified or dropped until endBulkLoad() packs them.
+    Vector<PackedTree::Element>& pendingElements() { return m_pendingElements; }
+
     void* allocateNode();
     void deleteNode(Node* n);
 
@@ -88,6 +174,10 @@ private:
     ElementList* m_listB;
     android::LinearAllocator* m_allocator;
 
+    bool m_bulkLoading;
+    Vector<PackedTree::Element> m_pendingElements;
+    PackedTree m_packedTree;
+
     friend class Node;
 };
 
@@ -131,8 +221,10 @@ public:
     ~Node();
 
     void insert(Node* n);
-    void search(int minx, int miny, int maxx, int maxy, Vector<WebCore::RecordingData*>& list);
+    void search(int minx, int miny, int maxx, int maxy, Vector<WebCore::RecordingData*>& list,
+                const Vector<WebCore::IntRect>* hidden) const;
     void remove(int minx, int miny, int maxx, int maxy);
+    void collect(Vector<PackedTree::Element>& list) const;
 
     // Intentionally not implemented as Node* is custom allocated, we don't want to use this
     void operator delete(void*);
@@ -153,10 +245,10 @@ private:
     bool updateBounds();
     int delta(Node* n);
 
-    bool overlap(int minx, int miny, int maxx, int maxy);
+    bool overlap(int minx, int miny, int maxx, int maxy) const;
     bool inside(int minx, int miny, int maxx, int maxy);
 
-    bool isElement() { return m_payload; }
+    bool isElement() const { return m_payload; }
     bool isRoot();
 
 private:
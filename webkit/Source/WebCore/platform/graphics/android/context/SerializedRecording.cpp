@@ -0,0 +1,1127 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "SerializedRecording"
+#define LOG_NDEBUG 1
+
+#include "config.h"
+#include "SerializedRecording.h"
+
+#include "AndroidLog.h"
+#include "Color.h"
+#include "FloatPoint.h"
+#include "FloatRect.h"
+#include "GraphicsOperation.h"
+#include "IntPoint.h"
+#include "IntSize.h"
+#include "Path.h"
+#include "PlatformGraphicsContextRecording.h"
+#include "PlatformGraphicsContextSkia.h"
+#include "SkData.h"
+#include "SkOrderedReadBuffer.h"
+#include "SkOrderedWriteBuffer.h"
+#include "SkPathEffect.h"
+#include "SkPtrRecorder.h"
+#include "SkStream.h"
+#include "SkTypeface.h"
+
+#include "wtf/NonCopyingSort.h"
+#include "wtf/StringHasher.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/LinearAllocator.h>
+
+// Same fan out as the RTree of a Recording
+#define TREE_MAX_CHILDREN 10
+
+namespace WebCore {
+
+//**************************************
+// RecordingWriter
+//**************************************
+
+RecordingWriter::RecordingWriter()
+    : m_data(16 * 1024)
+    , m_flattenables(new SkOrderedWriteBuffer(1024))
+    , m_factories(new SkFactorySet())
+    , m_typefaces(new SkRefCntSet())
+    , m_pixelDataSize(0)
+{
+    m_flattenables->setFlags(SkFlattenableWriteBuffer::kCrossProcess_Flag);
+    m_flattenables->setFactoryRecorder(m_factories);
+    m_flattenables->setTypefaceRecorder(m_typefaces);
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    delete m_flattenables;
+    m_factories->unref();
+    m_typefaces->unref();
+}
+
+int RecordingWriter::addCanvasState(int parent, bool isTransparencyLayer, float opacity)
+{
+    SerializedRecording::CanvasStateRecord record;
+    record.m_parent = parent;
+    record.m_isTransparencyLayer = isTransparencyLayer;
+    record.m_opacity = isTransparencyLayer ? opacity : 1;
+    record.m_firstStateOperation = m_stateOperations.size();
+    record.m_stateOperationCount = 0;
+    m_canvasStates.append(record);
+    return m_canvasStates.size() - 1;
+}
+
+bool RecordingWriter::addStateOperation(GraphicsOperation::Operation* operation, size_t orderBy)
+{
+    SerializedRecording::OperationRecord record;
+    if (!writeOperation(operation, orderBy, &record))
+        return false;
+    m_stateOperations.append(record);
+    m_canvasStates.last().m_stateOperationCount++;
+    return true;
+}
+
+bool RecordingWriter::addDrawingOperation(GraphicsOperation::Operation* operation, size_t orderBy,
+                                          int canvasState, const IntRect& bounds)
+{
+    SerializedRecording::DrawingOperationRecord record;
+    if (!writeOperation(operation, orderBy, &record.m_operation))
+        return false;
+    record.m_canvasState = canvasState;
+    record.m_state = stateIndex(operation->m_state);
+    m_drawingOperations.append(record);
+    m_drawingBounds.append(bounds);
+    return true;
+}
+
+void RecordingWriter::addSplice(const IntRect& area, size_t firstOrderBy)
+{
+    SerializedRecording::SpliceRecord record;
+    record.m_x = area.x();
+    record.m_y = area.y();
+    record.m_width = area.width();
+    record.m_height = area.height();
+    record.m_firstOrderBy = firstOrderBy;
+    m_splices.append(record);
+}
+
+bool RecordingWriter::writeOperation(GraphicsOperation::Operation* operation, size_t orderBy,
+                                     SerializedRecording::OperationRecord* record)
+{
+    record->m_orderBy = orderBy;
+    record->m_offset = m_data.size();
+    m_data.writeInt(operation->type());
+    if (!operation->write(this)) {
+        ALOGV("Can't serialize %s", operation->name());
+        return false;
+    }
+    return true;
+}
+
+int32_t RecordingWriter::flatten(SkFlattenable* flattenable)
+{
+    if (!flattenable)
+        return -1;
+    int32_t offset = m_flattenables->size();
+    m_flattenables->writeFlattenable(flattenable);
+    return offset;
+}
+
+int32_t RecordingWriter::stateIndex(PlatformGraphicsContext::State* state)
+{
+    HashMap<PlatformGraphicsContext::State*, int32_t>::iterator it = m_stateIndices.find(state);
+    if (it != m_stateIndices.end())
+        return it->second;
+
+    SerializedRecording::StateRecord record;
+    record.m_pathEffect = flatten(state->pathEffect);
+    record.m_fillShader = flatten(state->fillShader);
+    record.m_strokeShader = flatten(state->strokeShader);
+    record.m_miterLimit = state->miterLimit;
+    record.m_alpha = state->alpha;
+    record.m_strokeThickness = state->strokeThickness;
+    record.m_lineCap = state->lineCap;
+    record.m_lineJoin = state->lineJoin;
+    record.m_mode = state->mode;
+    record.m_dashRatio = state->dashRatio;
+    record.m_shadowBlur = state->shadow.blur;
+    record.m_shadowDx = state->shadow.dx;
+    record.m_shadowDy = state->shadow.dy;
+    record.m_shadowColor = state->shadow.color;
+    record.m_fillColor = state->fillColor;
+    record.m_strokeColor = state->strokeColor;
+    record.m_useAA = state->useAA;
+    record.m_strokeStyle = state->strokeStyle;
+    m_states.append(record);
+    int32_t index = m_states.size() - 1;
+    m_stateIndices.set(state, index);
+    return index;
+}
+
+void RecordingWriter::writeData(const void* data, size_t length)
+{
+    m_data.write32(length);
+    m_data.writePad(data, length);
+}
+
+void RecordingWriter::writeIntPoint(const IntPoint& point)
+{
+    m_data.writeInt(point.x());
+    m_data.writeInt(point.y());
+}
+
+void RecordingWriter::writeIntSize(const IntSize& size)
+{
+    m_data.writeInt(size.width());
+    m_data.writeInt(size.height());
+}
+
+void RecordingWriter::writeIntRect(const IntRect& rect)
+{
+    m_data.writeInt(rect.x());
+    m_data.writeInt(rect.y());
+    m_data.writeInt(rect.width());
+    m_data.writeInt(rect.height());
+}
+
+void RecordingWriter::writeFloatPoint(const FloatPoint& point)
+{
+    m_data.writeScalar(point.x());
+    m_data.writeScalar(point.y());
+}
+
+void RecordingWriter::writeFloatRect(const FloatRect& rect)
+{
+    m_data.writeScalar(rect.x());
+    m_data.writeScalar(rect.y());
+    m_data.writeScalar(rect.width());
+    m_data.writeScalar(rect.height());
+}
+
+void RecordingWriter::writeColor(const Color& color)
+{
+    m_data.writeBool(color.isValid());
+    m_data.write32(color.rgb());
+}
+
+void RecordingWriter::writeMatrix(const SkMatrix& matrix)
+{
+    for (int i = 0; i < 9; i++)
+        m_data.writeScalar(matrix[i]);
+}
+
+// Written as verbs and points rather than with SkPath::writeToMemory(),
+// which can't be read back safely from untrusted data
+void RecordingWriter::writePath(const Path& path)
+{
+    const SkPath& skPath = *path.platformPath();
+    m_data.writeInt(skPath.getFillType());
+    Vector<uint8_t> verbs(skPath.countVerbs());
+    skPath.getVerbs(verbs.data(), verbs.size());
+    writeData(verbs.data(), verbs.size());
+    Vector<SkPoint> points(skPath.countPoints());
+    skPath.getPoints(points.data(), points.size());
+    writeData(points.data(), points.size() * sizeof(SkPoint));
+}
+
+void RecordingWriter::writePaint(const SkPaint* paint)
+{
+    HashMap<const SkPaint*, int32_t>::iterator it = m_paintIndices.find(paint);
+    if (it != m_paintIndices.end()) {
+        m_data.writeInt(it->second);
+        return;
+    }
+    m_paints.append(m_flattenables->size());
+    m_flattenables->writePaint(*paint);
+    int32_t index = m_paints.size() - 1;
+    m_paintIndices.set(paint, index);
+    m_data.writeInt(index);
+}
+
+static bool sameBitmap(const SkBitmap& a, const SkBitmap& b)
+{
+    if (a.config() != b.config() || a.width() != b.width() || a.height() != b.height()
+        || a.rowBytes() != b.rowBytes() || a.isOpaque() != b.isOpaque())
+        return false;
+    if (a.pixelRef() == b.pixelRef() && a.pixelRefOffset() == b.pixelRefOffset()
+        && a.getGenerationID() == b.getGenerationID())
+        return true;
+    SkAutoLockPixels lockA(a);
+    SkAutoLockPixels lockB(b);
+    return a.getPixels() && b.getPixels() && !memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+bool RecordingWriter::writeBitmap(const SkBitmap& bitmap)
+{
+    switch (bitmap.config()) {
+    case SkBitmap::kA8_Config:
+    case SkBitmap::kRGB_565_Config:
+    case SkBitmap::kARGB_4444_Config:
+    case SkBitmap::kARGB_8888_Config:
+        break;
+    default:
+        // Color tables and compressed pixels aren't supported
+        return false;
+    }
+    if (!bitmap.pixelRef())
+        return false;
+
+    int32_t index = -1;
+    HashMap<const SkPixelRef*, int32_t>::iterator it = m_bitmapsByPixelRef.find(bitmap.pixelRef());
+    if (it != m_bitmapsByPixelRef.end() && sameBitmap(bitmap, m_bitmaps[it->second]))
+        index = it->second;
+
+    if (index < 0) {
+        SkAutoLockPixels lock(bitmap);
+        if (!bitmap.getPixels())
+            return false;
+        // The same image is often decoded in several places
+        unsigned hash = StringHasher::hashMemory(bitmap.getPixels(), bitmap.getSize() & ~1);
+        HashMap<unsigned, Vector<int32_t> >::iterator candidates = m_bitmapsByHash.find(hash);
+        if (candidates != m_bitmapsByHash.end()) {
+            for (size_t i = 0; i < candidates->second.size() && index < 0; i++) {
+                if (sameBitmap(bitmap, m_bitmaps[candidates->second[i]]))
+                    index = candidates->second[i];
+            }
+        }
+        if (index < 0) {
+            SerializedRecording::BitmapRecord record;
+            record.m_config = bitmap.config();
+            record.m_width = bitmap.width();
+            record.m_height = bitmap.height();
+            record.m_rowBytes = bitmap.rowBytes();
+            record.m_isOpaque = bitmap.isOpaque();
+            record.m_pixelOffset = m_pixelDataSize;
+            m_pixelDataSize += SkAlign4(bitmap.getSize());
+            m_bitmapRecords.append(record);
+            // Keeps the pixels alive until they are written
+            m_bitmaps.append(bitmap);
+            index = m_bitmaps.size() - 1;
+            m_bitmapsByHash.add(hash, Vector<int32_t>()).first->second.append(index);
+        }
+    }
+    m_bitmapsByPixelRef.set(bitmap.pixelRef(), index);
+    m_data.writeInt(index);
+    return true;
+}
+
+template<typename T>
+static void writeRecords(SkWriter32& out, const Vector<T>& records)
+{
+    out.write32(records.size());
+    out.write(records.data(), records.size() * sizeof(T));
+}
+
+bool RecordingWriter::finish(SkWStream* stream)
+{
+    SkWriter32 out(64 * 1024);
+    out.write32(SerializedRecording::s_magic);
+    out.write32(SerializedRecording::s_version);
+
+    // Factories, by name
+    Vector<SkFlattenable::Factory> factories(m_factories->count());
+    m_factories->copyToArray(factories.data());
+    out.write32(factories.size());
+    for (size_t i = 0; i < factories.size(); i++) {
+        const char* name = SkFlattenable::FactoryToName(factories[i]);
+        if (!name) {
+            ALOGW("Can't serialize an unregistered flattenable");
+            return false;
+        }
+        out.writeString(name);
+    }
+
+    Vector<SkRefCnt*> typefaces(m_typefaces->count());
+    m_typefaces->copyToArray(typefaces.data());
+    out.write32(typefaces.size());
+    for (size_t i = 0; i < typefaces.size(); i++) {
+        SkDynamicMemoryWStream typeface;
+        static_cast<SkTypeface*>(typefaces[i])->serialize(&typeface);
+        out.write32(typeface.bytesWritten());
+        typeface.copyTo(out.reservePad(typeface.bytesWritten()));
+    }
+
+    out.write32(m_flattenables->size());
+    m_flattenables->writeToMemory(out.reserve(m_flattenables->size()));
+    writeRecords(out, m_paints);
+    writeRecords(out, m_states);
+    writeRecords(out, m_bitmapRecords);
+    writeRecords(out, m_canvasStates);
+    writeRecords(out, m_stateOperations);
+    writeRecords(out, m_drawingOperations);
+    writeRecords(out, m_splices);
+
+    // The tree is packed here, its elements are the drawing operations
+    android::LinearAllocator heap;
+    Vector<RTree::PackedTree::Element> elements(m_drawingBounds.size());
+    for (size_t i = 0; i < elements.size(); i++) {
+        RTree::PackedTree::Element& e = elements[i];
+        e.m_minX = m_drawingBounds[i].x();
+        e.m_minY = m_drawingBounds[i].y();
+        e.m_maxX = m_drawingBounds[i].maxX();
+        e.m_maxY = m_drawingBounds[i].maxY();
+        e.m_payload = new (&heap) RecordingData(0, i);
+    }
+    RTree::PackedTree tree;
+    tree.build(elements, TREE_MAX_CHILDREN);
+    RTree::PackedTree::View view = tree.view();
+    unsigned nodeCount = tree.nodeCount();
+    unsigned parentCount = nodeCount - tree.size();
+    out.write32(tree.size());
+    out.writeInt(view.m_root);
+    out.write32(nodeCount);
+    out.write(view.m_minX, nodeCount * sizeof(int));
+    out.write(view.m_minY, nodeCount * sizeof(int));
+    out.write(view.m_maxX, nodeCount * sizeof(int));
+    out.write(view.m_maxY, nodeCount * sizeof(int));
+    out.write(view.m_firstChild, parentCount * sizeof(unsigned));
+    out.write(view.m_nbChildren, parentCount * sizeof(unsigned));
+    for (unsigned i = 0; i < tree.size(); i++)
+        out.write32(tree.payload(i)->m_orderBy);
+    // The payloads hold no operation, they go away with |heap|
+
+    out.write32(m_data.size());
+    if (!out.writeToStream(stream) || !m_data.writeToStream(stream))
+        return false;
+
+    // Pixels last, so that they can be used straight from the mapped file
+    uint32_t pixelDataSize = m_pixelDataSize;
+    if (!stream->write(&pixelDataSize, sizeof(pixelDataSize)))
+        return false;
+    static const uint32_t zero = 0;
+    for (size_t i = 0; i < m_bitmaps.size(); i++) {
+        const SkBitmap& bitmap = m_bitmaps[i];
+        SkAutoLockPixels lock(bitmap);
+        size_t size = bitmap.getSize();
+        if (!bitmap.getPixels() || !stream->write(bitmap.getPixels(), size)
+            || !stream->write(&zero, SkAlign4(size) - size))
+            return false;
+    }
+    return true;
+}
+
+//**************************************
+// RecordingReader
+//**************************************
+
+double RecordingReader::readDouble()
+{
+    double value = 0;
+    if (canRead(sizeof(value)))
+        m_data.read(&value, sizeof(value));
+    return value;
+}
+
+size_t RecordingReader::readCount(size_t elementSize)
+{
+    uint32_t count = readInt();
+    if (count > m_data.available() / elementSize)
+        m_isValid = false;
+    return m_isValid ? count : 0;
+}
+
+const void* RecordingReader::readData(size_t* length)
+{
+    *length = readInt();
+    if (*length > m_data.available() || !canRead(SkAlign4(*length))) {
+        m_isValid = false;
+        *length = 0;
+        return 0;
+    }
+    return m_data.skip(*length);
+}
+
+IntPoint RecordingReader::readIntPoint()
+{
+    int x = readInt();
+    int y = readInt();
+    return IntPoint(x, y);
+}
+
+IntSize RecordingReader::readIntSize()
+{
+    int width = readInt();
+    int height = readInt();
+    return IntSize(width, height);
+}
+
+IntRect RecordingReader::readIntRect()
+{
+    int x = readInt();
+    int y = readInt();
+    int width = readInt();
+    int height = readInt();
+    return IntRect(x, y, width, height);
+}
+
+FloatPoint RecordingReader::readFloatPoint()
+{
+    float x = readFloat();
+    float y = readFloat();
+    return FloatPoint(x, y);
+}
+
+FloatRect RecordingReader::readFloatRect()
+{
+    float x = readFloat();
+    float y = readFloat();
+    float width = readFloat();
+    float height = readFloat();
+    return FloatRect(x, y, width, height);
+}
+
+Color RecordingReader::readColor()
+{
+    bool valid = readBool();
+    RGBA32 rgb = readInt();
+    return valid ? Color(rgb) : Color();
+}
+
+void RecordingReader::readMatrix(SkMatrix* matrix)
+{
+    for (int i = 0; i < 9; i++)
+        matrix->set(i, readFloat());
+}
+
+void RecordingReader::readPath(Path* path)
+{
+    SkPath* skPath = path->platformPath();
+    skPath->reset();
+    int32_t fillType = readInt();
+    size_t verbCount;
+    const uint8_t* verbs = static_cast<const uint8_t*>(readData(&verbCount));
+    size_t pointsLength;
+    const SkPoint* points = static_cast<const SkPoint*>(readData(&pointsLength));
+    if (!m_isValid || fillType < SkPath::kWinding_FillType
+        || fillType > SkPath::kInverseEvenOdd_FillType) {
+        m_isValid = false;
+        return;
+    }
+    skPath->setFillType(static_cast<SkPath::FillType>(fillType));
+
+    // Rebuilt verb by verb, checking there are enough points for each
+    size_t pointCount = pointsLength / sizeof(SkPoint);
+    size_t next = 0;
+    for (size_t i = 0; i < verbCount && m_isValid; i++) {
+        static const size_t verbPoints[] = { 1, 1, 2, 3, 0 };
+        if (verbs[i] > SkPath::kClose_Verb || verbPoints[verbs[i]] > pointCount - next) {
+            m_isValid = false;
+            break;
+        }
+        const SkPoint* p = points + next;
+        next += verbPoints[verbs[i]];
+        switch (verbs[i]) {
+        case SkPath::kMove_Verb:
+            skPath->moveTo(p[0]);
+            break;
+        case SkPath::kLine_Verb:
+            skPath->lineTo(p[0]);
+            break;
+        case SkPath::kQuad_Verb:
+            skPath->quadTo(p[0], p[1]);
+            break;
+        case SkPath::kCubic_Verb:
+            skPath->cubicTo(p[0], p[1], p[2]);
+            break;
+        case SkPath::kClose_Verb:
+            skPath->close();
+            break;
+        }
+    }
+    if (!m_isValid || next != pointCount) {
+        m_isValid = false;
+        skPath->reset();
+    }
+}
+
+const SkBitmap& RecordingReader::readBitmap()
+{
+    static const SkBitmap empty;
+    uint32_t index = readInt();
+    if (index >= m_recording->m_bitmaps.size()) {
+        m_isValid = false;
+        return empty;
+    }
+    return m_recording->m_bitmaps[index];
+}
+
+const SkPaint* RecordingReader::readPaint()
+{
+    static const SkPaint empty;
+    uint32_t index = readInt();
+    if (index >= m_recording->m_paints.size()) {
+        m_isValid = false;
+        return &empty;
+    }
+    return m_recording->m_paints[index];
+}
+
+//**************************************
+// SerializedRecording
+//**************************************
+
+// Replays drawing operations the way Recording does, decoding each operation
+// when it is needed. Not shared between threads.
+class SerializedRecording::Player {
+public:
+    Player(const SerializedRecording* recording, PlatformGraphicsContext* context)
+        : m_recording(recording)
+        , m_context(context)
+        , m_currentState(-1)
+        , m_lastOrderBy(0)
+    {}
+
+    void draw(const uint32_t* operations, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const DrawingOperationRecord& record = m_recording->m_drawingOperations[operations[i]];
+            applyState(m_currentState, m_lastOrderBy, record.m_canvasState,
+                       record.m_operation.m_orderBy);
+            m_currentState = record.m_canvasState;
+            m_lastOrderBy = record.m_operation.m_orderBy;
+            apply(record.m_operation, m_recording->m_states[record.m_state]);
+        }
+        while (m_currentState >= 0) {
+            exitState(m_currentState);
+            m_currentState = m_recording->m_canvasStates[m_currentState].m_parent;
+        }
+        m_lastOrderBy = 0;
+    }
+
+private:
+    // State operations are applied without a state
+    void apply(const OperationRecord& record, PlatformGraphicsContext::State* state) {
+        GraphicsOperation::Operation* operation = m_recording->readOperation(record, !state,
+                                                                             &m_allocator);
+        if (!operation)
+            return;
+        operation->m_state = state;
+        operation->apply(m_context);
+        operation->~Operation();
+    }
+
+    int parent(int state) const {
+        return m_recording->m_canvasStates[state].m_parent;
+    }
+
+    bool isParentOf(int state, int other) const {
+        while (parent(other) >= 0) {
+            if (parent(other) == state)
+                return true;
+            other = parent(other);
+        }
+        return false;
+    }
+
+    void enterState(int state) {
+        const CanvasStateRecord& record = m_recording->m_canvasStates[state];
+        if (record.m_isTransparencyLayer)
+            m_context->beginTransparencyLayer(record.m_opacity);
+        else
+            m_context->save();
+    }
+
+    void exitState(int state) {
+        if (m_recording->m_canvasStates[state].m_isTransparencyLayer)
+            m_context->endTransparencyLayer();
+        else
+            m_context->restore();
+    }
+
+    void playback(int state, size_t fromId, size_t toId) {
+        const CanvasStateRecord& record = m_recording->m_canvasStates[state];
+        const OperationRecord* operations = m_recording->m_stateOperations + record.m_firstStateOperation;
+        size_t low = 0;
+        size_t high = record.m_stateOperationCount;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (operations[mid].m_orderBy < fromId)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        for (size_t i = low; i < record.m_stateOperationCount; i++) {
+            if (operations[i].m_orderBy > toId)
+                break;
+            apply(operations[i], 0);
+        }
+    }
+
+    // Same as RecordingImpl::applyState(), on canvas state indices
+    void applyState(int fromState, size_t fromId, int toState, size_t toId) {
+        if (fromState != toState && fromState >= 0) {
+            if (isParentOf(fromState, toState)) {
+                applyState(fromState, fromId, parent(toState), toId);
+                enterState(toState);
+            } else if (isParentOf(toState, fromState)) {
+                while (fromState != toState) {
+                    exitState(fromState);
+                    fromState = parent(fromState);
+                }
+            } else {
+                exitState(fromState);
+                applyState(parent(fromState), fromId, toState, toId);
+                return;
+            }
+        } else if (fromState < 0) {
+            if (parent(toState) >= 0)
+                applyState(fromState, fromId, parent(toState), toId);
+            enterState(toState);
+        }
+        playback(toState, fromId, toId);
+    }
+
+    const SerializedRecording* m_recording;
+    PlatformGraphicsContext* m_context;
+    // Decoded operations
+    android::LinearAllocator m_allocator;
+    int m_currentState;
+    size_t m_lastOrderBy;
+};
+
+SerializedRecording::SerializedRecording(SkData* data)
+    : m_data(data)
+    , m_flattenables(0)
+    , m_flattenablesSize(0)
+    , m_canvasStates(0)
+    , m_canvasStateCount(0)
+    , m_stateOperations(0)
+    , m_stateOperationCount(0)
+    , m_drawingOperations(0)
+    , m_drawingOperationCount(0)
+    , m_splices(0)
+    , m_spliceCount(0)
+    , m_treeOperations(0)
+    , m_operationData(0)
+    , m_operationDataSize(0)
+{
+    m_data->ref();
+    memset(&m_tree, 0, sizeof(m_tree));
+    m_tree.m_root = -1;
+}
+
+SerializedRecording::~SerializedRecording()
+{
+    for (size_t i = 0; i < m_paints.size(); i++)
+        delete m_paints[i];
+    for (size_t i = 0; i < m_states.size(); i++)
+        delete m_states[i];
+    for (size_t i = 0; i < m_typefaces.size(); i++)
+        SkSafeUnref(m_typefaces[i]);
+    m_data->unref();
+}
+
+SerializedRecording* SerializedRecording::create(SkData* data)
+{
+    SerializedRecording* recording = new SerializedRecording(data);
+    if (!recording->parse()) {
+        ALOGW("Invalid serialized recording");
+        recording->unref();
+        return 0;
+    }
+    return recording;
+}
+
+static void unmapData(const void* address, size_t length, void*)
+{
+    munmap(const_cast<void*>(address), length);
+}
+
+SerializedRecording* SerializedRecording::createFromFile(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    struct stat info;
+    void* address = MAP_FAILED;
+    if (!fstat(fd, &info) && info.st_size > 0)
+        address = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+        return 0;
+    SkData* data = SkData::NewWithProc(address, info.st_size, unmapData, 0);
+    SerializedRecording* recording = create(data);
+    data->unref();
+    return recording;
+}
+
+bool SerializedRecording::writeToFile(const Recording* recording, const char* path)
+{
+    bool written;
+    {
+        SkFILEWStream stream(path);
+        written = stream.isValid() && recording->serialize(&stream);
+    }
+    if (!written)
+        unlink(path);
+    return written;
+}
+
+bool SerializedRecording::writeToFile(const Vector<const Recording*>& recordings,
+                                      const Vector<IntRect>& areas, const char* path)
+{
+    bool written;
+    {
+        SkFILEWStream stream(path);
+        written = stream.isValid() && Recording::serialize(recordings, areas, &stream);
+    }
+    if (!written)
+        unlink(path);
+    return written;
+}
+
+size_t SerializedRecording::byteSize() const
+{
+    return m_data->size();
+}
+
+// Validates the size of each part before pointing to it
+template<typename T>
+static const T* readRecords(SkReader32& reader, size_t* count)
+{
+    if (!reader.isAvailable(sizeof(uint32_t)))
+        return 0;
+    *count = reader.readU32();
+    if (*count > reader.available() / sizeof(T))
+        return 0;
+    return static_cast<const T*>(reader.skip(*count * sizeof(T)));
+}
+
+static const void* readBlock(SkReader32& reader, size_t* size)
+{
+    if (!reader.isAvailable(sizeof(uint32_t)))
+        return 0;
+    *size = reader.readU32();
+    if (SkAlign4(*size) > reader.available())
+        return 0;
+    return reader.skip(SkAlign4(*size));
+}
+
+// Reads a string written by SkWriter32::writeString()
+static const char* readString(SkReader32& reader)
+{
+    if (!reader.isAvailable(sizeof(uint32_t)))
+        return 0;
+    size_t length = reader.readU32();
+    if (length >= reader.available() || !reader.isAvailable(SkAlign4(length + 1)))
+        return 0;
+    const char* string = static_cast<const char*>(reader.skip(SkAlign4(length + 1)));
+    return string[length] ? 0 : string;
+}
+
+SkFlattenable* SerializedRecording::readFlattenable(int32_t offset) const
+{
+    if (offset < 0 || static_cast<size_t>(offset) >= m_flattenablesSize)
+        return 0;
+    SkOrderedReadBuffer buffer(m_flattenables + offset, m_flattenablesSize - offset);
+    buffer.setFlags(SkFlattenableReadBuffer::kCrossProcess_Flag);
+    buffer.setFactoryPlayback(const_cast<SkFlattenable::Factory*>(m_factories.data()),
+                              m_factories.size());
+    buffer.setTypefaceArray(const_cast<SkTypeface**>(m_typefaces.data()), m_typefaces.size());
+    return buffer.readFlattenable();
+}
+
+PlatformGraphicsContext::State* SerializedRecording::readState(const StateRecord& record) const
+{
+    PlatformGraphicsContext::State* state = new PlatformGraphicsContext::State();
+    state->pathEffect = static_cast<SkPathEffect*>(readFlattenable(record.m_pathEffect));
+    state->fillShader = static_cast<SkShader*>(readFlattenable(record.m_fillShader));
+    state->strokeShader = static_cast<SkShader*>(readFlattenable(record.m_strokeShader));
+    state->miterLimit = record.m_miterLimit;
+    state->alpha = record.m_alpha;
+    state->strokeThickness = record.m_strokeThickness;
+    state->lineCap = static_cast<SkPaint::Cap>(record.m_lineCap);
+    state->lineJoin = static_cast<SkPaint::Join>(record.m_lineJoin);
+    state->mode = static_cast<SkXfermode::Mode>(record.m_mode);
+    state->dashRatio = record.m_dashRatio;
+    state->shadow = PlatformGraphicsContext::ShadowRec(record.m_shadowBlur, record.m_shadowDx,
+                                                      record.m_shadowDy, record.m_shadowColor);
+    state->fillColor = record.m_fillColor;
+    state->strokeColor = record.m_strokeColor;
+    state->useAA = record.m_useAA;
+    state->strokeStyle = static_cast<StrokeStyle>(record.m_strokeStyle);
+    return state;
+}
+
+GraphicsOperation::Operation* SerializedRecording::readOperation(const OperationRecord& record,
+                                                                 bool isStateOperation,
+                                                                 android::LinearAllocator* allocator) const
+{
+    // The data is read as 4-byte words
+    if (record.m_offset >= m_operationDataSize || record.m_offset & 3)
+        return 0;
+    RecordingReader reader(this, m_operationData + record.m_offset,
+                           m_operationDataSize - record.m_offset);
+    GraphicsOperation::Operation* operation = GraphicsOperation::readOperation(&reader, allocator);
+    if (!operation)
+        return 0;
+    // State operations are the matrix and clipping ones, they are applied
+    // without a state
+    int type = operation->type();
+    bool isState = type >= GraphicsOperation::Operation::ConcatCTMOperation
+        && type <= GraphicsOperation::Operation::ClipOutOperation;
+    if (!reader.isValid() || isState != isStateOperation) {
+        ALOGW("Skipping invalid serialized operation at %d", record.m_offset);
+        operation->~Operation();
+        return 0;
+    }
+    return operation;
+}
+
+bool SerializedRecording::parse()
+{
+    SkReader32 reader(m_data->data(), m_data->size() & ~3);
+    if (!reader.isAvailable(2 * sizeof(uint32_t)) || reader.readU32() != s_magic)
+        return false;
+    if (reader.readU32() != s_version) {
+        ALOGV("Serialized recording version mismatch");
+        return false;
+    }
+
+    if (!reader.isAvailable(sizeof(uint32_t)))
+        return false;
+    size_t factoryCount = reader.readU32();
+    for (size_t i = 0; i < factoryCount; i++) {
+        const char* name = readString(reader);
+        if (!name)
+            return false;
+        // An unknown factory only skips the flattenables it made
+        m_factories.append(SkFlattenable::NameToFactory(name));
+    }
+
+    if (!reader.isAvailable(sizeof(uint32_t)))
+        return false;
+    size_t typefaceCount = reader.readU32();
+    for (size_t i = 0; i < typefaceCount; i++) {
+        size_t size;
+        const void* data = readBlock(reader, &size);
+        if (!data)
+            return false;
+        SkMemoryStream stream(data, size);
+        m_typefaces.append(SkTypeface::Deserialize(&stream));
+    }
+
+    m_flattenables = static_cast<const char*>(readBlock(reader, &m_flattenablesSize));
+    if (!m_flattenables)
+        return false;
+
+    size_t paintCount;
+    const uint32_t* paints = readRecords<uint32_t>(reader, &paintCount);
+    size_t stateCount;
+    const StateRecord* states = readRecords<StateRecord>(reader, &stateCount);
+    size_t bitmapCount;
+    const BitmapRecord* bitmaps = readRecords<BitmapRecord>(reader, &bitmapCount);
+    m_canvasStates = readRecords<CanvasStateRecord>(reader, &m_canvasStateCount);
+    m_stateOperations = readRecords<OperationRecord>(reader, &m_stateOperationCount);
+    m_drawingOperations = readRecords<DrawingOperationRecord>(reader, &m_drawingOperationCount);
+    m_splices = readRecords<SpliceRecord>(reader, &m_spliceCount);
+    if (!paints || !states || !bitmaps || !m_canvasStates || !m_stateOperations
+        || !m_drawingOperations || !m_splices)
+        return false;
+
+    if (!reader.isAvailable(3 * sizeof(uint32_t)))
+        return false;
+    m_tree.m_nbElements = reader.readU32();
+    m_tree.m_root = reader.readInt();
+    size_t nodeCount = reader.readU32();
+    // PackedTree::build() puts a parent root last, above its elements
+    if (m_tree.m_nbElements != m_drawingOperationCount
+        || (nodeCount && nodeCount <= m_tree.m_nbElements)
+        || (!nodeCount && m_tree.m_nbElements)
+        || m_tree.m_root != static_cast<int>(nodeCount) - 1)
+        return false;
+    size_t parentCount = nodeCount - m_tree.m_nbElements;
+    size_t treeSize = (4 * nodeCount + 2 * parentCount + m_tree.m_nbElements) * sizeof(int);
+    if (nodeCount > reader.available() / sizeof(int) || !reader.isAvailable(treeSize))
+        return false;
+    m_tree.m_minX = static_cast<const int*>(reader.skip(nodeCount * sizeof(int)));
+    m_tree.m_minY = static_cast<const int*>(reader.skip(nodeCount * sizeof(int)));
+    m_tree.m_maxX = static_cast<const int*>(reader.skip(nodeCount * sizeof(int)));
+    m_tree.m_maxY = static_cast<const int*>(reader.skip(nodeCount * sizeof(int)));
+    m_tree.m_firstChild = static_cast<const unsigned*>(reader.skip(parentCount * sizeof(unsigned)));
+    m_tree.m_nbChildren = static_cast<const unsigned*>(reader.skip(parentCount * sizeof(unsigned)));
+    m_treeOperations = static_cast<const uint32_t*>(reader.skip(m_tree.m_nbElements * sizeof(uint32_t)));
+    // The children of each parent follow those of the previous parent and
+    // come before it, so every node but the root has exactly one parent and
+    // searching the tree visits each node at most once
+    size_t nextChild = 0;
+    for (size_t i = 0; i < parentCount; i++) {
+        unsigned firstChild = m_tree.m_firstChild[i];
+        unsigned nbChildren = m_tree.m_nbChildren[i];
+        size_t parent = m_tree.m_nbElements + i;
+        if (firstChild != nextChild || !nbChildren || nbChildren > parent - firstChild)
+            return false;
+        nextChild = firstChild + nbChildren;
+    }
+    if (parentCount && nextChild != nodeCount - 1)
+        return false;
+    for (size_t i = 0; i < m_tree.m_nbElements; i++) {
+        if (m_treeOperations[i] >= m_drawingOperationCount)
+            return false;
+    }
+
+    m_operationData = static_cast<const char*>(readBlock(reader, &m_operationDataSize));
+    size_t pixelDataSize;
+    const char* pixelData = static_cast<const char*>(readBlock(reader, &pixelDataSize));
+    if (!m_operationData || !pixelData)
+        return false;
+
+    // Check all the indices the replay relies on
+    for (size_t i = 0; i < m_canvasStateCount; i++) {
+        const CanvasStateRecord& record = m_canvasStates[i];
+        if (record.m_parent < -1 || record.m_parent >= static_cast<int>(i)
+            || record.m_firstStateOperation > m_stateOperationCount
+            || record.m_stateOperationCount > m_stateOperationCount - record.m_firstStateOperation)
+            return false;
+    }
+    for (size_t i = 0; i < m_drawingOperationCount; i++) {
+        const DrawingOperationRecord& record = m_drawingOperations[i];
+        if (record.m_canvasState < 0 || record.m_canvasState >= static_cast<int>(m_canvasStateCount)
+            || record.m_state < 0 || record.m_state >= static_cast<int>(stateCount))
+            return false;
+    }
+
+    for (size_t i = 0; i < bitmapCount; i++) {
+        const BitmapRecord& record = bitmaps[i];
+        // Only the configs RecordingWriter writes, the others need a color
+        // table or aren't plain pixels
+        switch (record.m_config) {
+        case SkBitmap::kA8_Config:
+        case SkBitmap::kRGB_565_Config:
+        case SkBitmap::kARGB_4444_Config:
+        case SkBitmap::kARGB_8888_Config:
+            break;
+        default:
+            return false;
+        }
+        SkBitmap::Config config = static_cast<SkBitmap::Config>(record.m_config);
+        int minRowBytes = SkBitmap::ComputeRowBytes(config, record.m_width);
+        if (record.m_width < 0 || record.m_height < 0 || (record.m_width && !minRowBytes)
+            || record.m_rowBytes < static_cast<uint32_t>(minRowBytes)
+            || record.m_rowBytes % SkBitmap::ComputeBytesPerPixel(config)
+            || (record.m_height && record.m_rowBytes > pixelDataSize / record.m_height))
+            return false;
+        SkBitmap bitmap;
+        bitmap.setConfig(config, record.m_width, record.m_height, record.m_rowBytes);
+        if (record.m_pixelOffset > pixelDataSize
+            || bitmap.getSize() > pixelDataSize - record.m_pixelOffset)
+            return false;
+        // The pixels aren't copied, nor owned by the bitmap
+        bitmap.setPixels(const_cast<char*>(pixelData + record.m_pixelOffset));
+        bitmap.setIsOpaque(record.m_isOpaque);
+        bitmap.setImmutable();
+        m_bitmaps.append(bitmap);
+    }
+
+    for (size_t i = 0; i < paintCount; i++) {
+        if (paints[i] >= m_flattenablesSize)
+            return false;
+        SkOrderedReadBuffer buffer(m_flattenables + paints[i], m_flattenablesSize - paints[i]);
+        buffer.setFlags(SkFlattenableReadBuffer::kCrossProcess_Flag);
+        buffer.setFactoryPlayback(m_factories.data(), m_factories.size());
+        buffer.setTypefaceArray(m_typefaces.data(), m_typefaces.size());
+        SkPaint* paint = new SkPaint();
+        paint->unflatten(buffer);
+        m_paints.append(paint);
+    }
+    for (size_t i = 0; i < stateCount; i++)
+        m_states.append(readState(states[i]));
+
+
+    ALOGV("Loaded %d operations, %d bitmaps, %d paints, %d states", m_drawingOperationCount,
+          m_bitmaps.size(), m_paints.size(), m_states.size());
+    return true;
+}
+
+IntRect SerializedRecording::bounds() const
+{
+    if (m_tree.m_root < 0)
+        return IntRect();
+    int root = m_tree.m_root;
+    return IntRect(m_tree.m_minX[root], m_tree.m_minY[root],
+                   m_tree.m_maxX[root] - m_tree.m_minX[root],
+                   m_tree.m_maxY[root] - m_tree.m_minY[root]);
+}
+
+size_t SerializedRecording::draw(SkCanvas* canvas) const
+{
+    SkRect clip;
+    if (!canvas->getClipBounds(&clip))
+        return 0;
+    IntRect iclip = enclosingIntRect(clip);
+    Vector<unsigned> elements;
+    m_tree.search(iclip.x(), iclip.y(), iclip.maxX(), iclip.maxY(), elements);
+    size_t count = elements.size();
+    if (!count)
+        return 0;
+    // Drawing operations are stored in recording order
+    Vector<uint32_t> operations(count);
+    for (size_t i = 0; i < count; i++)
+        operations[i] = m_treeOperations[elements[i]];
+    std::sort(operations.begin(), operations.end());
+
+    int saveCount = canvas->getSaveCount();
+    PlatformGraphicsContextSkia context(canvas);
+    Player player(this, &context);
+
+    // Splices are drawn as Recording::draw() does
+    size_t replayed = 0;
+    size_t begin = 0;
+    for (size_t i = 0; i <= m_spliceCount; i++) {
+        size_t end = begin;
+        if (i < m_spliceCount) {
+            while (end < count
+                   && m_drawingOperations[operations[end]].m_operation.m_orderBy < m_splices[i].m_firstOrderBy)
+                end++;
+        } else
+            end = count;
+        if (end == begin)
+            continue;
+
+        int saved = canvas->save(SkCanvas::kClip_SaveFlag);
+        if (i) {
+            const SpliceRecord& splice = m_splices[i - 1];
+            canvas->clipRect(IntRect(splice.m_x, splice.m_y, splice.m_width, splice.m_height));
+        }
+        for (size_t j = i; j < m_spliceCount; j++) {
+            const SpliceRecord& splice = m_splices[j];
+            canvas->clipRect(IntRect(splice.m_x, splice.m_y, splice.m_width, splice.m_height),
+                             SkRegion::kDifference_Op);
+        }
+        if (!canvas->quickReject(clip)) {
+            player.draw(operations.data() + begin, end - begin);
+            replayed += end - begin;
+        }
+        canvas->restoreToCount(saved);
+        begin = end;
+    }
+    if (saveCount != canvas->getSaveCount())
+        ALOGW("Save/restore mismatch! %d vs. %d", saveCount, canvas->getSaveCount());
+    return replayed;
+}
+
+} // namespace WebCore
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SerializedRecording_h
+#define SerializedRecording_h
+
+#include "IntRect.h"
+#include "PlatformGraphicsContext.h"
+#include "RTree.h"
+#include "SkBitmap.h"
+#include "SkFlattenable.h"
+#include "SkPaint.h"
+#include "SkReader32.h"
+#include "SkRefCnt.h"
+#include "SkWriter32.h"
+#include "TestExport.h"
+
+#include <wtf/HashMap.h>
+#include <wtf/Vector.h>
+
+class SkCanvas;
+class SkData;
+class SkFactorySet;
+class SkOrderedWriteBuffer;
+class SkRefCntSet;
+class SkTypeface;
+class SkWStream;
+
+namespace android {
+class LinearAllocator;
+}
+
+namespace WebCore {
+
+namespace GraphicsOperation {
+class Operation;
+}
+
+class Color;
+class FloatPoint;
+class FloatRect;
+class IntPoint;
+class IntSize;
+class Path;
+class Recording;
+
+// Serialized form of a Recording: a versioned, 4-byte aligned blob meant to
+// be written once and memory mapped back, by a process of the same build.
+// It holds, in order:
+//  - the flattenable factory names and typefaces used by the paints,
+//  - the paints and states of the operations,
+//  - the bitmaps, deduplicated by content,
+//  - the canvas state tree, with the state operations of each canvas state,
+//  - the drawing operations in recording order and the splices,
+//  - the packed RTree of the drawing operations,
+//  - the data of the operations, then the pixels of the bitmaps.
+// Paints and states are unflattened when loading, and every operation is
+// decoded once to check it stays within its data. The tree is searched and
+// the pixels are drawn in place, and operations are only kept decoded while
+// being drawn.
+//
+// PicturePile::writeRecording() captures pages in this format for the tools
+// in tests/. The view state saved by ViewStateSerializer is still an
+// SkPicture: it outlives the build that wrote it, which this format doesn't.
+class TEST_EXPORT SerializedRecording : public SkRefCnt {
+public:
+    // Returns 0 if |data| isn't a valid serialized recording
+    static SerializedRecording* create(SkData* data);
+    static SerializedRecording* createFromFile(const char* path);
+    static bool writeToFile(const Recording* recording, const char* path);
+    // Writes several recordings as one, see Recording::serialize()
+    static bool writeToFile(const Vector<const Recording*>& recordings,
+                            const Vector<IntRect>& areas, const char* path);
+
+    ~SerializedRecording();
+
+    // Like Recording::draw(), can be called from several threads at once.
+    // Returns the number of drawing operations replayed.
+    size_t draw(SkCanvas* canvas) const;
+
+    // Bounds of all the drawing operations, empty if there are none
+    IntRect bounds() const;
+
+    size_t operationCount() const { return m_drawingOperationCount; }
+    size_t bitmapCount() const { return m_bitmaps.size(); }
+    size_t byteSize() const;
+
+    static const uint32_t s_magic = 0x52535257; // "WRSR"
+    static const uint32_t s_version = 2;
+
+    // Fixed size records of the format
+    struct StateRecord {
+        // Offsets of the flattened effects, -1 for none
+        int32_t m_pathEffect;
+        int32_t m_fillShader;
+        int32_t m_strokeShader;
+        float m_miterLimit;
+        float m_alpha;
+        float m_strokeThickness;
+        int32_t m_lineCap;
+        int32_t m_lineJoin;
+        int32_t m_mode;
+        int32_t m_dashRatio;
+        float m_shadowBlur;
+        float m_shadowDx;
+        float m_shadowDy;
+        uint32_t m_shadowColor;
+        uint32_t m_fillColor;
+        uint32_t m_strokeColor;
+        int32_t m_useAA;
+        int32_t m_strokeStyle;
+    };
+
+    struct BitmapRecord {
+        int32_t m_config;
+        int32_t m_width;
+        int32_t m_height;
+        uint32_t m_rowBytes;
+        int32_t m_isOpaque;
+        // Offset of the pixels from the start of the pixel data
+        uint32_t m_pixelOffset;
+    };
+
+    struct CanvasStateRecord {
+        int32_t m_parent;
+        int32_t m_isTransparencyLayer;
+        float m_opacity;
+        uint32_t m_firstStateOperation;
+        uint32_t m_stateOperationCount;
+    };
+
+    struct OperationRecord {
+        uint32_t m_orderBy;
+        // Offset of the data from the start of the operation data
+        uint32_t m_offset;
+    };
+
+    struct DrawingOperationRecord {
+        OperationRecord m_operation;
+        int32_t m_canvasState;
+        int32_t m_state;
+    };
+
+    struct SpliceRecord {
+        int32_t m_x;
+        int32_t m_y;
+        int32_t m_width;
+        int32_t m_height;
+        uint32_t m_firstOrderBy;
+    };
+
+private:
+    class Player;
+
+    SerializedRecording(SkData* data);
+    bool parse();
+    // Decodes the operation of |record| when it is replayed, returns 0 unless
+    // it was read entirely from its data and is a state or drawing operation
+    // as expected. Operations aren't checked when parsing, only those drawn
+    // are ever decoded.
+    GraphicsOperation::Operation* readOperation(const OperationRecord& record,
+                                                bool isStateOperation,
+                                                android::LinearAllocator* allocator) const;
+    SkFlattenable* readFlattenable(int32_t offset) const;
+    PlatformGraphicsContext::State* readState(const StateRecord& record) const;
+
+    SkData* m_data;
+
+    const char* m_flattenables;
+    size_t m_flattenablesSize;
+    Vector<SkFlattenable::Factory> m_factories;
+    Vector<SkTypeface*> m_typefaces;
+    Vector<SkPaint*> m_paints;
+    Vector<PlatformGraphicsContext::State*> m_states;
+    Vector<SkBitmap> m_bitmaps;
+
+    const CanvasStateRecord* m_canvasStates;
+    size_t m_canvasStateCount;
+    const OperationRecord* m_stateOperations;
+    size_t m_stateOperationCount;
+    const DrawingOperationRecord* m_drawingOperations;
+    size_t m_drawingOperationCount;
+    const SpliceRecord* m_splices;
+    size_t m_spliceCount;
+    // The elements of the tree are indices in m_treeOperations, which gives
+    // the index of their drawing operation
+    RTree::PackedTree::View m_tree;
+    const uint32_t* m_treeOperations;
+    const char* m_operationData;
+    size_t m_operationDataSize;
+
+    friend class RecordingReader;
+};
+
+// Writes the parts of a Recording. Operations write their own data through
+// it, see GraphicsOperation::Operation::write().
+class RecordingWriter {
+public:
+    RecordingWriter();
+    ~RecordingWriter();
+
+    // Canvas states must be added after their parent, each directly followed
+    // by its state operations. Returns the index of the canvas state.
+    int addCanvasState(int parent, bool isTransparencyLayer, float opacity);
+    bool addStateOperation(GraphicsOperation::Operation* operation, size_t orderBy);
+    // Drawing operations must be added in recording order
+    bool addDrawingOperation(GraphicsOperation::Operation* operation, size_t orderBy,
+                             int canvasState, const IntRect& bounds);
+    void addSplice(const IntRect& area, size_t firstOrderBy);
+
+    // Returns false if something recorded couldn't be serialized
+    bool finish(SkWStream* stream);
+
+    // Operation data
+    void writeInt(int32_t value) { m_data.writeInt(value); }
+    void writeBool(bool value) { m_data.writeBool(value); }
+    void writeFloat(float value) { m_data.writeScalar(value); }
+    void writeDouble(double value) { m_data.write(&value, sizeof(value)); }
+    // Written with its length, padded to 4 bytes
+    void writeData(const void* data, size_t length);
+    void writeIntPoint(const IntPoint& point);
+    void writeIntSize(const IntSize& size);
+    void writeIntRect(const IntRect& rect);
+    void writeFloatPoint(const FloatPoint& point);
+    void writeFloatRect(const FloatRect& rect);
+    void writeColor(const Color& color);
+    void writeMatrix(const SkMatrix& matrix);
+    void writePath(const Path& path);
+    bool writeBitmap(const SkBitmap& bitmap);
+    void writePaint(const SkPaint* paint);
+
+private:
+    int32_t flatten(SkFlattenable* flattenable);
+    int32_t stateIndex(PlatformGraphicsContext::State* state);
+    bool writeOperation(GraphicsOperation::Operation* operation, size_t orderBy,
+                        SerializedRecording::OperationRecord* record);
+
+    SkWriter32 m_data;
+    SkOrderedWriteBuffer* m_flattenables;
+    SkFactorySet* m_factories;
+    SkRefCntSet* m_typefaces;
+
+    HashMap<const SkPaint*, int32_t> m_paintIndices;
+    Vector<uint32_t> m_paints;
+    HashMap<PlatformGraphicsContext::State*, int32_t> m_stateIndices;
+    Vector<SerializedRecording::StateRecord> m_states;
+
+    // Bitmaps are matched by pixel ref, then by content
+    HashMap<const SkPixelRef*, int32_t> m_bitmapsByPixelRef;
+    HashMap<unsigned, Vector<int32_t> > m_bitmapsByHash;
+    Vector<SkBitmap> m_bitmaps;
+    Vector<SerializedRecording::BitmapRecord> m_bitmapRecords;
+    uint32_t m_pixelDataSize;
+
+    Vector<SerializedRecording::CanvasStateRecord> m_canvasStates;
+    Vector<SerializedRecording::OperationRecord> m_stateOperations;
+    Vector<SerializedRecording::DrawingOperationRecord> m_drawingOperations;
+    Vector<IntRect> m_drawingBounds;
+    Vector<SerializedRecording::SpliceRecord> m_splices;
+};
+
+// Reads back what operations wrote with RecordingWriter. Nothing is read
+// past the end of the data: once the data is exhausted, or holds an index
+// or a count that is out of range, the reader is no longer valid and
+// returns zeros and empty values.
+class RecordingReader {
+public:
+    RecordingReader(const SerializedRecording* recording, const void* data, size_t size)
+        : m_recording(recording), m_data(data, size), m_isValid(true) {}
+
+    bool isValid() const { return m_isValid; }
+
+    int32_t readInt() { return canRead(sizeof(int32_t)) ? m_data.readInt() : 0; }
+    bool readBool() { return canRead(sizeof(int32_t)) ? m_data.readBool() : false; }
+    float readFloat() { return canRead(sizeof(float)) ? m_data.readScalar() : 0; }
+    double readDouble();
+    // Reads a count of elements of |elementSize| bytes that follow it,
+    // 0 if there isn't room for them
+    size_t readCount(size_t elementSize);
+    // Points to the serialized data, no copy is made
+    const void* readData(size_t* length);
+    IntPoint readIntPoint();
+    IntSize readIntSize();
+    IntRect readIntRect();
+    FloatPoint readFloatPoint();
+    FloatRect readFloatRect();
+    Color readColor();
+    void readMatrix(SkMatrix* matrix);
+    void readPath(Path* path);
+    const SkBitmap& readBitmap();
+    const SkPaint* readPaint();
+
+private:
+    bool canRead(size_t size) {
+        if (m_isValid && !m_data.isAvailable(size))
+            m_isValid = false;
+        return m_isValid;
+    }
+
+    const SerializedRecording* m_recording;
+    SkReader32 m_data;
+    bool m_isValid;
+};
+
+} // namespace WebCore
+
+#endif // SerializedRecording_h
@@ -430,6 +430,286 @@ static int truncateFixedPointToInteger(HB_Fixed value)
     return value >> 6;
 }
 
+#ifdef ANDROID_SHAPED_RUN_CACHE
+// ShapedRunCache keeps the output of HB_ShapeItem() for recently shaped script
+// runs. Layout measures the same words over and over and painting shapes them
+// once more, so on complex script pages most runs are found here instead of
+// going through Harfbuzz again. Only the shaper output is kept: word spacing,
+// padding and positions are applied afterwards by setGlyphPositions(), so they
+// are not part of the key. Like the fallback font hash in setupComplexFont(),
+// this is only used on the WebCore thread.
+struct ShapedRunKey {
+    ShapedRunKey()
+        : m_fontID(0)
+        , m_textSize(0)
+        , m_fontFlags(0)
+        , m_script(0)
+        , m_bidiLevel(0)
+        , m_contextBefore(0)
+        , m_runLength(0)
+    {
+    }
+
+    ShapedRunKey(WTF::HashTableDeletedValueType) : m_text(WTF::HashTableDeletedValue) { }
+    bool isHashTableDeletedValue() const { return m_text.isHashTableDeletedValue(); }
+
+    bool operator==(const ShapedRunKey& other) const
+    {
+        return m_fontID == other.m_fontID && m_textSize == other.m_textSize
+            && m_fontFlags == other.m_fontFlags && m_script == other.m_script
+            && m_bidiLevel == other.m_bidiLevel && m_contextBefore == other.m_contextBefore
+            && m_runLength == other.m_runLength && m_text == other.m_text;
+    }
+
+    unsigned hash() const
+    {
+        unsigned hashCodes[5] = {
+            m_text.impl() ? m_text.impl()->hash() : 0,
+            m_fontID,
+            *reinterpret_cast<const uint32_t*>(&m_textSize),
+            m_fontFlags,
+            static_cast<unsigned>(m_script) << 16 | static_cast<unsigned>(m_bidiLevel) << 8
+                | m_contextBefore << 7 | m_runLength
+        };
+        return StringHasher::hashMemory<sizeof(hashCodes)>(hashCodes);
+    }
+
+    // The run together with the characters around it that the shapers look
+    // at: Arabic joining depends on the previous character and on the next
+    // one that is not a non-spacing mark.
+    String m_text;
+    uint32_t m_fontID;
+    float m_textSize;
+    unsigned m_fontFlags;
+    int m_script;
+    int m_bidiLevel;
+    unsigned m_contextBefore;
+    unsigned m_runLength;
+};
+
+struct ShapedRunKeyHash {
+    static unsigned hash(const ShapedRunKey& key) { return key.hash(); }
+    static bool equal(const ShapedRunKey& a, const ShapedRunKey& b) { return a == b; }
+    static const bool safeToCompareToEmptyOrDeleted = true;
+};
+
+struct ShapedRunKeyTraits : WTF::SimpleClassHashTraits<ShapedRunKey> { };
+
+// A shaped run lives in a single allocation: the header is followed by the
+// offsets, glyphs, advances, attributes and log clusters arrays.
+struct ShapedRun {
+    ShapedRunKey m_key;
+    ShapedRun* m_prev; // more recently used
+    ShapedRun* m_next; // less recently used
+    size_t m_bytes;
+    unsigned m_numGlyphs;
+    unsigned m_numClusters;
+
+    HB_FixedPoint* offsets() { return reinterpret_cast<HB_FixedPoint*>(this + 1); }
+    HB_Glyph* glyphs() { return reinterpret_cast<HB_Glyph*>(offsets() + m_numGlyphs); }
+    HB_Fixed* advances() { return reinterpret_cast<HB_Fixed*>(glyphs() + m_numGlyphs); }
+    HB_GlyphAttributes* attributes() { return reinterpret_cast<HB_GlyphAttributes*>(advances() + m_numGlyphs); }
+    unsigned short* logClusters() { return reinterpret_cast<unsigned short*>(attributes() + m_numGlyphs); }
+
+    static size_t bytesFor(unsigned numGlyphs, unsigned numClusters)
+    {
+        return sizeof(ShapedRun)
+            + numGlyphs * (sizeof(HB_FixedPoint) + sizeof(HB_Glyph) + sizeof(HB_Fixed) + sizeof(HB_GlyphAttributes))
+            + numClusters * sizeof(unsigned short);
+    }
+};
+
+class ShapedRunCache {
+public:
+    static ShapedRunCache& instance()
+    {
+        DEFINE_STATIC_LOCAL(ShapedRunCache, cache, ());
+        return cache;
+    }
+
+    ShapedRunCache()
+        : m_head(0)
+        , m_tail(0)
+        , m_bytes(0)
+        , m_hits(0)
+        , m_misses(0)
+    {
+    }
+
+    static bool makeKey(const HB_ShaperItem&, ShapedRunKey&);
+    // Copies a cached shaping of |item| into it, returns false on a miss.
+    bool lookup(const ShapedRunKey&, HB_ShaperItem&);
+    void add(const ShapedRunKey&, const HB_ShaperItem&);
+    void clear();
+
+private:
+    typedef HashMap<ShapedRunKey, ShapedRun*, ShapedRunKeyHash, ShapedRunKeyTraits> RunMap;
+
+    // Runs larger than this are shaped every time rather than evicting
+    // a good part of the cache.
+    static const unsigned s_maxRunLength = 127;
+    // The farthest the shapers look past the end of the run, see makeKey().
+    static const unsigned s_maxContextAfter = 8;
+    static const size_t s_byteBudget = 256 * 1024;
+
+    void unlink(ShapedRun*);
+    void pushFront(ShapedRun*);
+    void destroy(ShapedRun*);
+    void logStats();
+
+    RunMap m_runs;
+    ShapedRun* m_head;
+    ShapedRun* m_tail;
+    size_t m_bytes;
+    unsigned m_hits;
+    unsigned m_misses;
+};
+
+bool ShapedRunCache::makeKey(const HB_ShaperItem& item, ShapedRunKey& key)
+{
+    const FontPlatformData* font = reinterpret_cast<FontPlatformData*>(item.font->userData);
+    if (!font || !font->typeface() || item.shaperFlags || !item.item.length
+        || item.item.length > s_maxRunLength)
+        return false;
+
+    unsigned start = item.item.pos;
+    unsigned end = start + item.item.length;
+    unsigned contextBefore = start ? 1 : 0;
+    unsigned contextAfter = 0;
+    while (end + contextAfter < item.stringLength) {
+        if (contextAfter == s_maxContextAfter)
+            return false;
+        UChar c = item.string[end + contextAfter++];
+        if (u_charType(c) != U_NON_SPACING_MARK)
+            break;
+    }
+
+    key.m_text = String(reinterpret_cast<const UChar*>(item.string) + start - contextBefore,
+        contextBefore + item.item.length + contextAfter);
+    key.m_fontID = font->uniqueID();
+    key.m_textSize = font->size();
+    key.m_fontFlags = static_cast<unsigned>(font->isFakeBold()) << 1 | font->isFakeItalic();
+    key.m_script = item.item.script;
+    key.m_bidiLevel = item.item.bidiLevel;
+    key.m_contextBefore = contextBefore;
+    key.m_runLength = item.item.length;
+    return true;
+}
+
+bool ShapedRunCache::lookup(const ShapedRunKey& key, HB_ShaperItem& item)
+{
+    ShapedRun* run = m_runs.get(key);
+    if (!run || run->m_numGlyphs > item.num_glyphs) {
+        // A miss, or our arrays are too small and HB_ShapeItem() has to tell
+        // the caller how much to grow them.
+        m_misses++;
+        logStats();
+        return false;
+    }
+
+    m_hits++;
+    logStats();
+    if (run != m_head) {
+        unlink(run);
+        pushFront(run);
+    }
+
+    unsigned numGlyphs = run->m_numGlyphs;
+    item.num_glyphs = numGlyphs;
+    memcpy(item.offsets, run->offsets(), numGlyphs * sizeof(HB_FixedPoint));
+    memcpy(item.glyphs, run->glyphs(), numGlyphs * sizeof(HB_Glyph));
+    memcpy(item.advances, run->advances(), numGlyphs * sizeof(HB_Fixed));
+    memcpy(item.attributes, run->attributes(), numGlyphs * sizeof(HB_GlyphAttributes));
+    memcpy(item.log_clusters, run->logClusters(), run->m_numClusters * sizeof(unsigned short));
+    return true;
+}
+
+void ShapedRunCache::add(const ShapedRunKey& key, const HB_ShaperItem& item)
+{
+    unsigned numGlyphs = item.num_glyphs;
+    unsigned numClusters = item.item.length;
+    size_t bytes = ShapedRun::bytesFor(numGlyphs, numClusters);
+
+    while (m_tail && m_bytes + bytes > s_byteBudget)
+        destroy(m_tail);
+
+    ShapedRun* run = static_cast<ShapedRun*>(fastMalloc(bytes));
+    new (run) ShapedRun;
+    run->m_key = key;
+    run->m_bytes = bytes;
+    run->m_numGlyphs = numGlyphs;
+    run->m_numClusters = numClusters;
+    memcpy(run->offsets(), item.offsets, numGlyphs * sizeof(HB_FixedPoint));
+    memcpy(run->glyphs(), item.glyphs, numGlyphs * sizeof(HB_Glyph));
+    memcpy(run->advances(), item.advances, numGlyphs * sizeof(HB_Fixed));
+    memcpy(run->attributes(), item.attributes, numGlyphs * sizeof(HB_GlyphAttributes));
+    memcpy(run->logClusters(), item.log_clusters, numClusters * sizeof(unsigned short));
+
+    std::pair<RunMap::iterator, bool> result = m_runs.add(key, run);
+    if (!result.second) {
+        // Only possible when lookup() bailed out on small arrays.
+        destroy(result.first->second);
+        m_runs.set(key, run);
+    }
+    pushFront(run);
+    m_bytes += bytes;
+}
+
+void ShapedRunCache::clear()
+{
+    while (m_tail)
+        destroy(m_tail);
+}
+
+void Font::clearShapedRunCache()
+{
+    ShapedRunCache::instance().clear();
+}
+
+void ShapedRunCache::unlink(ShapedRun* run)
+{
+    if (run->m_prev)
+        run->m_prev->m_next = run->m_next;
+    else
+        m_head = run->m_next;
+    if (run->m_next)
+        run->m_next->m_prev = run->m_prev;
+    else
+        m_tail = run->m_prev;
+}
+
+void ShapedRunCache::pushFront(ShapedRun* run)
+{
+    run->m_prev = 0;
+    run->m_next = m_head;
+    if (m_head)
+        m_head->m_prev = run;
+    else
+        m_tail = run;
+    m_head = run;
+}
+
+void ShapedRunCache::destroy(ShapedRun* run)
+{
+    unlink(run);
+    m_bytes -= run->m_bytes;
+    RunMap::iterator it = m_runs.find(run->m_key);
+    if (it != m_runs.end() && it->second == run)
+        m_runs.remove(it);
+    run->~ShapedRun();
+    fastFree(run);
+}
+
+void ShapedRunCache::logStats()
+{
+    unsigned total = m_hits + m_misses;
+    if (total % 1000)
+        return;
+    ALOGV("shaped run cache: %u hits, %u misses, %u runs, %u bytes",
+        m_hits, m_misses, m_runs.size(), static_cast<unsigned>(m_bytes));
+}
+#endif // ANDROID_SHAPED_RUN_CACHE
+
 // TextRunWalker walks a TextRun and presents each script run in sequence. A
 // TextRun is a sequence of code-points with the same embedding level (i.e. they
 // are all left-to-right or right-to-left). A script run is a subsequence where
@@ -845,6 +1125,12 @@ void TextRunWalker::shapeGlyphs()
     // So, we need to reset the num_glyphs to the capacity of the array.
     m_item.num_glyphs = m_glyphsArrayCapacity;
     resetGlyphArrays();
+#ifdef ANDROID_SHAPED_RUN_CACHE
+    ShapedRunKey key;
+    bool cacheable = ShapedRunCache::makeKey(m_item, key);
+    if (cacheable && ShapedRunCache::instance().lookup(key, m_item))
+        return;
+#endif
     while (!HB_ShapeItem(&m_item)) {
         // We overflowed our arrays. Resize and retry.
         // HB_ShapeItem fills in m_item.num_glyphs with the needed size.
@@ -852,6 +1138,10 @@ void TextRunWalker::shapeGlyphs()
         createGlyphArrays(m_item.num_glyphs << 1);
         resetGlyphArrays();
     }
+#ifdef ANDROID_SHAPED_RUN_CACHE
+    if (cacheable)
+        ShapedRunCache::instance().add(key, m_item);
+#endif
 }
 
 void TextRunWalker::setGlyphPositions(bool isRTL)
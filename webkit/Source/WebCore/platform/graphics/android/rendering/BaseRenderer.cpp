@@ -44,6 +44,7 @@
 #include "Tile.h"
 #include "TilesManager.h"
 
+#include <utils/threads.h>
 #include <wtf/text/CString.h>
 
 #define UPDATE_COUNT_MASK 0xFF // displayed count wraps at 256
@@ -53,6 +54,11 @@ namespace WebCore {
 
 BaseRenderer::RendererType BaseRenderer::g_currentType = BaseRenderer::Raster;
 
+// Tiles are painted by several raster workers at once, so the debug typeface
+// is created under a lock.
+static SkTypeface* s_typeface = 0;
+static android::Mutex s_typefaceLock;
+
 BaseRenderer* BaseRenderer::createRenderer()
 {
     if (g_currentType == Raster)
@@ -72,9 +78,13 @@ void BaseRenderer::swapRendererIfNeeded(BaseRenderer*& renderer)
 void BaseRenderer::drawTileInfo(SkCanvas* canvas,
         const TileRenderInfo& renderInfo, int updateCount, double renderDuration)
 {
-    static SkTypeface* s_typeface = 0;
-    if (!s_typeface)
-        s_typeface = SkTypeface::CreateFromName("", SkTypeface::kBold);
+    SkTypeface* typeface;
+    {
+        android::Mutex::Autolock lock(s_typefaceLock);
+        if (!s_typeface)
+            s_typeface = SkTypeface::CreateFromName("", SkTypeface::kBold);
+        typeface = s_typeface;
+    }
     SkPaint paint;
     paint.setTextSize(17);
     char str[256];
@@ -83,7 +93,7 @@ void BaseRenderer::drawTileInfo(SkCanvas* canvas,
     paint.setARGB(128, 255, 255, 255);
     canvas->drawRectCoords(0, 0, renderInfo.tileSize.fWidth, 17, paint);
     paint.setARGB(255, 255, 0, 0);
-    paint.setTypeface(s_typeface);
+    paint.setTypeface(typeface);
     canvas->drawText(str, strlen(str), 20, 15, paint);
 }
 
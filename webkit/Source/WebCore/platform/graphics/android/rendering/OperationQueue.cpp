@@ -0,0 +1,153 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "OperationQueue"
+#define LOG_NDEBUG 1
+
+#include "config.h"
+#include "OperationQueue.h"
+
+#include "AndroidLog.h"
+#include "QueuedOperation.h"
+
+namespace WebCore {
+
+QueuedOperation* OperationQueue::get(void* key) const
+{
+    WTF::HashMap<void*, unsigned>::const_iterator it = m_indices.find(key);
+    if (it == m_indices.end())
+        return 0;
+    return m_heap[it->second].operation;
+}
+
+void OperationQueue::push(QueuedOperation* operation, int priority)
+{
+    Entry entry;
+    entry.operation = operation;
+    entry.key = operation->uniquePtr();
+    entry.priority = priority;
+    entry.sequence = m_sequence++;
+
+    m_heap.append(entry);
+    m_indices.set(entry.key, m_heap.size() - 1);
+    siftUp(m_heap.size() - 1);
+}
+
+QueuedOperation* OperationQueue::pop()
+{
+    return removeAt(0);
+}
+
+QueuedOperation* OperationQueue::take(void* key)
+{
+    WTF::HashMap<void*, unsigned>::iterator it = m_indices.find(key);
+    if (it == m_indices.end())
+        return 0;
+    return removeAt(it->second);
+}
+
+void OperationQueue::updatePriority(void* key, int priority)
+{
+    WTF::HashMap<void*, unsigned>::iterator it = m_indices.find(key);
+    if (it == m_indices.end())
+        return;
+
+    unsigned index = it->second;
+    int oldPriority = m_heap[index].priority;
+    m_heap[index].priority = priority;
+    if (priority < oldPriority)
+        siftUp(index);
+    else if (priority > oldPriority)
+        siftDown(index);
+}
+
+void OperationQueue::updatePriorities()
+{
+    for (unsigned i = 0; i < m_heap.size(); i++)
+        m_heap[i].priority = m_heap[i].operation->priority();
+
+    // bottom-up heap construction
+    for (int i = m_heap.size() / 2 - 1; i >= 0; i--)
+        siftDown(i);
+}
+
+void OperationQueue::set(unsigned index, const Entry& entry)
+{
+    m_heap[index] = entry;
+    m_indices.set(entry.key, index);
+}
+
+void OperationQueue::siftUp(unsigned index)
+{
+    Entry entry = m_heap[index];
+    while (index) {
+        unsigned parent = (index - 1) / 2;
+        if (!lessThan(entry, m_heap[parent]))
+            break;
+        set(index, m_heap[parent]);
+        index = parent;
+    }
+    set(index, entry);
+}
+
+void OperationQueue::siftDown(unsigned index)
+{
+    const unsigned size = m_heap.size();
+    Entry entry = m_heap[index];
+    while (true) {
+        unsigned child = 2 * index + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && lessThan(m_heap[child + 1], m_heap[child]))
+            child++;
+        if (!lessThan(m_heap[child], entry))
+            break;
+        set(index, m_heap[child]);
+        index = child;
+    }
+    set(index, entry);
+}
+
+QueuedOperation* OperationQueue::removeAt(unsigned index)
+{
+    QueuedOperation* operation = m_heap[index].operation;
+    m_indices.remove(m_heap[index].key);
+
+    unsigned last = m_heap.size() - 1;
+    if (index != last) {
+        Entry moved = m_heap[last];
+        m_heap.removeLast();
+        set(index, moved);
+        if (index && lessThan(moved, m_heap[(index - 1) / 2]))
+            siftUp(index);
+        else
+            siftDown(index);
+    } else
+        m_heap.removeLast();
+
+    return operation;
+}
+
+} // namespace WebCore
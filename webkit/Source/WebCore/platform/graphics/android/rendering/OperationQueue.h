@@ -0,0 +1,101 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OperationQueue_h
+#define OperationQueue_h
+
+#include "TestExport.h"
+#include <wtf/HashMap.h>
+#include <wtf/Vector.h>
+
+namespace WebCore {
+
+class QueuedOperation;
+
+// Binary min-heap of QueuedOperations, indexed by their uniquePtr() so that an
+// operation can be found, re-prioritized or removed in O(log n). Lower
+// priorities come out first; operations with equal priorities come out in
+// insertion order.
+//
+// The queue only knows about the priority an operation had when it was last
+// keyed, callers are responsible for calling updatePriority() or
+// updatePriorities() when priorities may have changed.
+class TEST_EXPORT OperationQueue {
+public:
+    OperationQueue() : m_sequence(0) {}
+
+    unsigned size() const { return m_heap.size(); }
+    bool isEmpty() const { return m_heap.isEmpty(); }
+    bool contains(void* key) const { return m_indices.contains(key); }
+    QueuedOperation* get(void* key) const;
+
+    // Entries in heap order, for iteration only.
+    QueuedOperation* at(unsigned index) const { return m_heap[index].operation; }
+
+    // The key of the operation is its uniquePtr(), which must not already be
+    // in the queue.
+    void push(QueuedOperation* operation, int priority);
+
+    QueuedOperation* top() const { return m_heap[0].operation; }
+    int topPriority() const { return m_heap[0].priority; }
+    QueuedOperation* pop();
+
+    // Removes the operation with the given key, returning it (or 0 if absent).
+    QueuedOperation* take(void* key);
+
+    // Moves the operation up or down the queue to match its new priority.
+    void updatePriority(void* key, int priority);
+
+    // Re-keys every operation with its current priority(), in O(n).
+    void updatePriorities();
+
+private:
+    struct Entry {
+        QueuedOperation* operation;
+        void* key;
+        int priority;
+        unsigned sequence;
+    };
+
+    static bool lessThan(const Entry& a, const Entry& b)
+    {
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+        return a.sequence < b.sequence;
+    }
+
+    void set(unsigned index, const Entry& entry);
+    void siftUp(unsigned index);
+    void siftDown(unsigned index);
+    QueuedOperation* removeAt(unsigned index);
+
+    WTF::Vector<Entry> m_heap;
+    WTF::HashMap<void*, unsigned> m_indices;
+    unsigned m_sequence;
+};
+
+} // namespace WebCore
+
+#endif // OperationQueue_h
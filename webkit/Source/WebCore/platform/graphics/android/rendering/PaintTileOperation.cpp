@@ -90,6 +90,17 @@ void PaintTileOperation::run(BaseRenderer* renderer)
     }
 }
 
+void PaintTileOperation::supersede()
+{
+    // The replacement already counts as a pending repaint of the tile, it
+    // took its own count when it was created. Hand the tile over to it by
+    // dropping ours now, so that deleting this operation leaves the tile alone.
+    if (m_tile) {
+        m_tile->setRepaintPending(false);
+        m_tile = 0;
+    }
+}
+
 int PaintTileOperation::priority()
 {
     if (!m_tile)
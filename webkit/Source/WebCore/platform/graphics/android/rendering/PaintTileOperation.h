@@ -43,6 +43,7 @@ public:
     virtual ~PaintTileOperation();
     virtual bool operator==(const QueuedOperation* operation);
     virtual void run(BaseRenderer* renderer);
+    virtual void supersede();
     virtual void* uniquePtr() { return m_tile; }
     // returns a rendering priority for m_tile, lower values are processed faster
     virtual int priority();
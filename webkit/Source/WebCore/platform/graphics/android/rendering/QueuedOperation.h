@@ -37,6 +37,9 @@ public:
     virtual bool operator==(const QueuedOperation* operation) = 0;
     virtual void* uniquePtr() = 0;
     virtual int priority() = 0;
+    // called instead of run() when a newer operation for the same
+    // uniquePtr() replaces this one in the queue, just before it is deleted
+    virtual void supersede() {}
 };
 
 class OperationFilter {
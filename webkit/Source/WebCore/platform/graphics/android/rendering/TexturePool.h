@@ -0,0 +1,247 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TexturePool_h
+#define TexturePool_h
+
+#include <wtf/Vector.h>
+
+namespace WebCore {
+
+// Keeps the tile textures within a memory budget in bytes, shared by the base
+// and layer tiles. When the budget is reached, the textures least recently
+// used by either kind of tile are recycled or destroyed first.
+//
+// The pool only decides which textures to create and destroy, the textures
+// themselves are handled by an Allocator. TilesManager uses one creating
+// TileTextures, tests use one that doesn't need GL.
+//
+// Not thread safe, TilesManager calls it under its textures lock.
+template<typename Texture>
+class TexturePool {
+public:
+    enum Usage {
+        BaseUsage,
+        LayerUsage
+    };
+
+    class Allocator {
+    public:
+        virtual ~Allocator() {}
+        // Returns 0 if the texture can't be created
+        virtual Texture* createTexture(int width, int height) = 0;
+        // Frees the texture and its backing memory
+        virtual void destroyTexture(Texture* texture) = 0;
+        // Detaches the texture from its owner so it can be used by another
+        // kind of tile, keeping its backing memory
+        virtual void recycleTexture(Texture* texture) = 0;
+        // Time the texture was last used (e.g. a draw count), 0 if unused
+        virtual unsigned long long lastUsed(Texture* texture) = 0;
+    };
+
+    // Spares no texture when passed as |sparedSince|
+    static const unsigned long long s_spareNone = ~0ULL;
+
+    TexturePool(Allocator* allocator, size_t budget)
+        : m_allocator(allocator)
+        , m_budget(budget)
+        , m_usedBytes(0)
+    {
+    }
+
+    ~TexturePool()
+    {
+        for (size_t i = 0; i < m_entries.size(); i++)
+            m_allocator->destroyTexture(m_entries[i].m_texture);
+    }
+
+    size_t budget() const { return m_budget; }
+    size_t usedBytes() const { return m_usedBytes; }
+
+    unsigned count(Usage usage) const
+    {
+        unsigned count = 0;
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (m_entries[i].m_usage == usage)
+                count++;
+        }
+        return count;
+    }
+
+    void textures(Usage usage, Vector<Texture*>& list) const
+    {
+        list.clear();
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (m_entries[i].m_usage == usage)
+                list.append(m_entries[i].m_texture);
+        }
+    }
+
+    bool contains(Texture* texture) const
+    {
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (m_entries[i].m_texture == texture)
+                return true;
+        }
+        return false;
+    }
+
+    // Destroys the least recently used textures if the budget shrinks,
+    // sparing those used since |sparedSince|. Spared textures keep the pool
+    // over budget until grow() can make room with them.
+    void setBudget(size_t budget, unsigned long long sparedSince)
+    {
+        m_budget = budget;
+        trim(budget, sparedSince);
+    }
+
+    // Adds textures of the given size until |usage| has |count| of them,
+    // after trimming the pool back to its budget. Past the budget, the least
+    // recently used textures last used before |sparedSince| make room: those
+    // of the other usage in the same size class are recycled, others are
+    // destroyed. Returns the number of
+    // textures of |usage|, less than |count| if the budget ran out.
+    unsigned grow(Usage usage, unsigned count, int width, int height,
+                  unsigned long long sparedSince)
+    {
+        // get back within the budget first if it shrank under used textures
+        trim(m_budget, sparedSince);
+
+        const size_t bytes = sizeClassBytes(width, height);
+        unsigned current = this->count(usage);
+        while (current < count) {
+            if (m_usedBytes + bytes > m_budget) {
+                int index = leastRecentlyUsed(sparedSince, usage);
+                if (index < 0)
+                    break;
+                Entry& entry = m_entries[index];
+                if (entry.m_bytes == bytes) {
+                    m_allocator->recycleTexture(entry.m_texture);
+                    entry.m_usage = usage;
+                    current++;
+                } else
+                    destroy(index);
+                continue;
+            }
+
+            Texture* texture = m_allocator->createTexture(width, height);
+            if (!texture)
+                break;
+            Entry entry = { texture, usage, bytes };
+            m_entries.append(entry);
+            m_usedBytes += bytes;
+            current++;
+        }
+        return current;
+    }
+
+    // Destroys the least recently used textures until at most |targetBytes|
+    // are used, sparing those used since |sparedSince|. Returns the number
+    // of textures destroyed.
+    unsigned trim(size_t targetBytes, unsigned long long sparedSince)
+    {
+        unsigned destroyed = 0;
+        while (m_usedBytes > targetBytes) {
+            int index = leastRecentlyUsed(sparedSince);
+            if (index < 0)
+                break;
+            destroy(index);
+            destroyed++;
+        }
+        return destroyed;
+    }
+
+    // Destroys the textures of |usage| not used since |sparedSince|.
+    // Returns the number of textures destroyed.
+    unsigned release(Usage usage, unsigned long long sparedSince)
+    {
+        unsigned destroyed = 0;
+        for (int i = m_entries.size() - 1; i >= 0; i--) {
+            if (m_entries[i].m_usage == usage
+                && m_allocator->lastUsed(m_entries[i].m_texture) < sparedSince) {
+                destroy(i);
+                destroyed++;
+            }
+        }
+        return destroyed;
+    }
+
+    // Bytes accounted for a texture, its dimensions rounded up to powers of
+    // two as GL drivers commonly do. Textures of the same size class can
+    // replace one another.
+    static size_t sizeClassBytes(int width, int height)
+    {
+        return roundUpToPowerOfTwo(width) * roundUpToPowerOfTwo(height) * 4;
+    }
+
+private:
+    struct Entry {
+        Texture* m_texture;
+        Usage m_usage;
+        size_t m_bytes;
+    };
+
+    static size_t roundUpToPowerOfTwo(int value)
+    {
+        size_t result = 1;
+        while (result < static_cast<size_t>(value))
+            result <<= 1;
+        return result;
+    }
+
+    // Index of the least recently used texture last used before
+    // |sparedSince|, skipping those of |skippedUsage| if given. -1 if none.
+    int leastRecentlyUsed(unsigned long long sparedSince, int skippedUsage = -1) const
+    {
+        int index = -1;
+        unsigned long long oldest = sparedSince;
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (m_entries[i].m_usage == skippedUsage)
+                continue;
+            unsigned long long lastUsed = m_allocator->lastUsed(m_entries[i].m_texture);
+            if (lastUsed < oldest) {
+                oldest = lastUsed;
+                index = i;
+            }
+        }
+        return index;
+    }
+
+    void destroy(size_t index)
+    {
+        m_usedBytes -= m_entries[index].m_bytes;
+        m_allocator->destroyTexture(m_entries[index].m_texture);
+        m_entries.remove(index);
+    }
+
+    Allocator* m_allocator;
+    size_t m_budget;
+    size_t m_usedBytes;
+    Vector<Entry> m_entries;
+};
+
+} // namespace WebCore
+
+#endif // TexturePool_h
@@ -40,38 +40,84 @@
 
 namespace WebCore {
 
-TexturesGenerator::TexturesGenerator(TilesManager* instance)
-  : Thread(false)
-  , m_tilesManager(instance)
+TexturesGenerator::TexturesGenerator(TilesManager* instance, int workerCount)
+  : m_tilesManager(instance)
+  , m_prioritizedDrawCount(0)
   , m_deferredMode(false)
-  , m_renderer(0)
+  , m_exiting(false)
 {
+    for (int i = 0; i < workerCount; i++) {
+        sp<Worker> worker = new Worker(this);
+        ALOGD("Starting TG worker #%d, %p", i, worker.get());
+        worker->run("TexturesGenerator");
+        m_workers.append(worker);
+    }
 }
 
 TexturesGenerator::~TexturesGenerator()
+{
+    {
+        android::Mutex::Autolock lock(mRequestedOperationsLock);
+        m_exiting = true;
+    }
+    mRequestedOperationsCond.broadcast();
+    for (unsigned int i = 0; i < m_workers.size(); i++)
+        m_workers[i]->requestExitAndWait();
+}
+
+TexturesGenerator::Worker::~Worker()
 {
     delete m_renderer;
 }
 
+status_t TexturesGenerator::Worker::readyToRun()
+{
+    m_renderer = BaseRenderer::createRenderer();
+    return NO_ERROR;
+}
+
 bool TexturesGenerator::tryUpdateOperationWithPainter(Tile* tile, TilePainter* painter)
 {
     android::Mutex::Autolock lock(mRequestedOperationsLock);
-    if (!mRequestedOperationsHash.contains(tile))
+    QueuedOperation* operation = mRequestedOperations.get(tile);
+    for (unsigned int i = 0; !operation && i < m_blockedOperations.size(); i++) {
+        if (m_blockedOperations[i]->uniquePtr() == tile)
+            operation = m_blockedOperations[i];
+    }
+    if (!operation)
         return false;
 
-    static_cast<PaintTileOperation*>(mRequestedOperationsHash.get(tile))->updatePainter(painter);
+    static_cast<PaintTileOperation*>(operation)->updatePainter(painter);
     return true;
 }
 
+// Must be called from within a lock!
+int TexturesGenerator::enqueue(QueuedOperation* operation)
+{
+    QueuedOperation* replaced = mRequestedOperations.take(operation->uniquePtr());
+    if (replaced) {
+        ALOGV("operation %p replaces queued operation %p", operation, replaced);
+        replaced->supersede();
+        delete replaced;
+    }
+    int priority = operation->priority();
+    mRequestedOperations.push(operation, priority);
+    return priority;
+}
+
 void TexturesGenerator::scheduleOperation(QueuedOperation* operation)
 {
     bool signal = false;
     {
         android::Mutex::Autolock lock(mRequestedOperationsLock);
-        mRequestedOperations.append(operation);
-        mRequestedOperationsHash.set(operation->uniquePtr(), operation);
+        if (m_runningOperations.contains(operation->uniquePtr())) {
+            // a worker is already running an operation for the same target,
+            // wait for it to complete before making this one available
+            m_blockedOperations.append(operation);
+            return;
+        }
 
-        bool deferrable = operation->priority() >= gDeferPriorityCutoff;
+        bool deferrable = enqueue(operation) >= gDeferPriorityCutoff;
         m_deferredMode &= deferrable;
 
         // signal if we weren't in deferred mode, or if we can no longer defer
@@ -87,11 +133,19 @@ void TexturesGenerator::removeOperationsForFilter(OperationFilter* filter)
         return;
 
     android::Mutex::Autolock lock(mRequestedOperationsLock);
-    for (unsigned int i = 0; i < mRequestedOperations.size();) {
-        QueuedOperation* operation = mRequestedOperations[i];
+    WTF::Vector<void*> removedKeys;
+    for (unsigned int i = 0; i < mRequestedOperations.size(); i++) {
+        QueuedOperation* operation = mRequestedOperations.at(i);
+        if (filter->check(operation))
+            removedKeys.append(operation->uniquePtr());
+    }
+    for (unsigned int i = 0; i < removedKeys.size(); i++)
+        delete mRequestedOperations.take(removedKeys[i]);
+
+    for (unsigned int i = 0; i < m_blockedOperations.size();) {
+        QueuedOperation* operation = m_blockedOperations[i];
         if (filter->check(operation)) {
-            mRequestedOperations.remove(i);
-            mRequestedOperationsHash.remove(operation->uniquePtr());
+            m_blockedOperations.remove(i);
             delete operation;
         } else {
             i++;
@@ -99,42 +153,27 @@ void TexturesGenerator::removeOperationsForFilter(OperationFilter* filter)
     }
 }
 
-status_t TexturesGenerator::readyToRun()
-{
-    m_renderer = BaseRenderer::createRenderer();
-    return NO_ERROR;
-}
-
 // Must be called from within a lock!
 QueuedOperation* TexturesGenerator::popNext()
 {
-    // Priority can change between when it was added and now
-    // Hence why the entire queue is rescanned
-    QueuedOperation* current = mRequestedOperations.last();
-    int currentPriority = current->priority();
-    if (currentPriority < 0) {
-        mRequestedOperations.removeLast();
-        mRequestedOperationsHash.remove(current->uniquePtr());
-        return current;
+    // Priority can change between when it was added and now. Re-key the whole
+    // queue once per drawn frame, as that is when tiles' draw counts and the
+    // scrolling direction change.
+    unsigned long long drawCount = m_tilesManager->getDrawGLCount();
+    if (drawCount != m_prioritizedDrawCount) {
+        mRequestedOperations.updatePriorities();
+        m_prioritizedDrawCount = drawCount;
     }
-    int currentIndex = mRequestedOperations.size() - 1;
-    // Scan from the back to make removing faster (less items to copy)
-    for (int i = mRequestedOperations.size() - 2; i >= 0; i--) {
-        QueuedOperation *next = mRequestedOperations[i];
-        int nextPriority = next->priority();
-        if (nextPriority < 0) {
-            // Found a very high priority item, go ahead and just handle it now
-            mRequestedOperations.remove(i);
-            mRequestedOperationsHash.remove(next->uniquePtr());
-            return next;
-        }
-        // pick items preferrably by priority, or if equal, by order of
-        // insertion (as we add items at the back of the queue)
-        if (nextPriority <= currentPriority) {
-            current = next;
-            currentPriority = nextPriority;
-            currentIndex = i;
-        }
+
+    // Make sure the best candidate is still up to date, in case it changed
+    // within the frame. Bounded, as each pass re-keys one operation.
+    QueuedOperation* current = mRequestedOperations.top();
+    int currentPriority = current->priority();
+    for (unsigned int i = 0; i < mRequestedOperations.size()
+             && currentPriority != mRequestedOperations.topPriority(); i++) {
+        mRequestedOperations.updatePriority(current->uniquePtr(), currentPriority);
+        current = mRequestedOperations.top();
+        currentPriority = current->priority();
     }
 
     if (!m_deferredMode && currentPriority >= gDeferPriorityCutoff) {
@@ -143,47 +182,79 @@ QueuedOperation* TexturesGenerator::popNext()
         return 0;
     }
 
-    mRequestedOperations.remove(currentIndex);
-    mRequestedOperationsHash.remove(current->uniquePtr());
-    return current;
+    return mRequestedOperations.pop();
 }
 
-bool TexturesGenerator::threadLoop()
+// Must be called from within a lock!
+void TexturesGenerator::operationCompleted(void* uniquePtr)
+{
+    m_runningOperations.remove(uniquePtr);
+
+    // make operations that were waiting on this one available to the workers
+    bool unblocked = false;
+    for (unsigned int i = 0; i < m_blockedOperations.size();) {
+        QueuedOperation* blocked = m_blockedOperations[i];
+        if (blocked->uniquePtr() == uniquePtr) {
+            m_blockedOperations.remove(i);
+            enqueue(blocked);
+            unblocked = true;
+        } else {
+            i++;
+        }
+    }
+    if (unblocked) {
+        m_deferredMode = false;
+        mRequestedOperationsCond.signal();
+    }
+}
+
+bool TexturesGenerator::runOperations(BaseRenderer*& renderer)
 {
     // Check if we have any pending operations.
     mRequestedOperationsLock.lock();
 
     if (!m_deferredMode) {
         // if we aren't currently deferring work, wait for new work to arrive
-        while (!mRequestedOperations.size())
+        while (!mRequestedOperations.size() && !m_exiting)
             mRequestedOperationsCond.wait(mRequestedOperationsLock);
     } else {
         // if we only have deferred work, wait for better work, or a timeout
         mRequestedOperationsCond.waitRelative(mRequestedOperationsLock, gDeferNsecs);
     }
 
+    bool exiting = m_exiting;
     mRequestedOperationsLock.unlock();
+    if (exiting)
+        return false;
 
     bool stop = false;
     while (!stop) {
         QueuedOperation* currentOperation = 0;
+        void* uniquePtr = 0;
 
         mRequestedOperationsLock.lock();
-        ALOGV("threadLoop, %d operations in the queue", mRequestedOperations.size());
+        ALOGV("runOperations, %d operations in the queue", mRequestedOperations.size());
 
         if (mRequestedOperations.size())
             currentOperation = popNext();
+        if (currentOperation) {
+            // the operation may forget its target once run, so grab it now
+            uniquePtr = currentOperation->uniquePtr();
+            m_runningOperations.add(uniquePtr);
+        }
         mRequestedOperationsLock.unlock();
 
         if (currentOperation) {
-            ALOGV("threadLoop, painting the request with priority %d",
+            ALOGV("runOperations, painting the request with priority %d",
                   currentOperation->priority());
             // swap out the renderer if necessary
-            BaseRenderer::swapRendererIfNeeded(m_renderer);
-            currentOperation->run(m_renderer);
+            BaseRenderer::swapRendererIfNeeded(renderer);
+            currentOperation->run(renderer);
         }
 
         mRequestedOperationsLock.lock();
+        if (currentOperation)
+            operationCompleted(uniquePtr);
         if (m_deferredMode && !currentOperation)
             stop = true;
         if (!mRequestedOperations.size()) {
@@ -195,7 +266,7 @@ bool TexturesGenerator::threadLoop()
         if (currentOperation)
             delete currentOperation; // delete outside lock
     }
-    ALOGV("threadLoop empty");
+    ALOGV("runOperations empty");
 
     return true;
 }
@@ -28,9 +28,10 @@
 
 #if USE(ACCELERATED_COMPOSITING)
 
+#include "OperationQueue.h"
 #include "QueuedOperation.h"
 #include "TransferQueue.h"
-#include <wtf/HashMap.h>
+#include <wtf/HashSet.h>
 #include <wtf/Vector.h>
 
 #include <utils/threads.h>
@@ -41,12 +42,17 @@ using namespace android;
 
 class TilesManager;
 
-class TexturesGenerator : public Thread {
+// The TexturesGenerator owns a single queue of operations shared by a pool of
+// worker threads. Each worker has its own renderer, and pulls the best
+// operation available from the queue. Operations sharing the same
+// uniquePtr() (i.e. the same Tile) are never run concurrently: while one is
+// running, any other operation for it is parked until the first completes.
+// A texture can move between tiles while they paint, so the paint itself is
+// also serialized on the texture, see TileTexture::paintLock().
+class TexturesGenerator {
 public:
-    TexturesGenerator(TilesManager* instance);
-    virtual ~TexturesGenerator();
-
-    virtual status_t readyToRun();
+    TexturesGenerator(TilesManager* instance, int workerCount);
+    ~TexturesGenerator();
 
     bool tryUpdateOperationWithPainter(Tile* tile, TilePainter* painter);
 
@@ -54,21 +60,53 @@ public:
 
     void scheduleOperation(QueuedOperation* operation);
 
+    int workerCount() { return m_workers.size(); }
+
     // low res tiles are put at or above this cutoff when not scrolling,
     // signifying that they should be deferred
     static const int gDeferPriorityCutoff = 500000000;
 
 private:
+    class Worker : public Thread {
+    public:
+        Worker(TexturesGenerator* generator)
+            : Thread(false)
+            , m_generator(generator)
+            , m_renderer(0)
+        {}
+        virtual ~Worker();
+
+        virtual status_t readyToRun();
+        virtual bool threadLoop() { return m_generator->runOperations(m_renderer); }
+
+    private:
+        TexturesGenerator* m_generator;
+        BaseRenderer* m_renderer;
+    };
+
+    friend class Worker;
+
+    int enqueue(QueuedOperation* operation);
     QueuedOperation* popNext();
-    virtual bool threadLoop();
-    WTF::Vector<QueuedOperation*> mRequestedOperations;
-    WTF::HashMap<void*, QueuedOperation*> mRequestedOperationsHash;
+    bool runOperations(BaseRenderer*& renderer);
+    void operationCompleted(void* uniquePtr);
+    OperationQueue mRequestedOperations;
     android::Mutex mRequestedOperationsLock;
     android::Condition mRequestedOperationsCond;
     TilesManager* m_tilesManager;
 
+    // draw count at which the queue's priorities were last recomputed
+    unsigned long long m_prioritizedDrawCount;
+
+    // uniquePtr() of the operations currently being run by a worker, and the
+    // operations waiting on them. Both are protected by mRequestedOperationsLock.
+    WTF::HashSet<void*> m_runningOperations;
+    WTF::Vector<QueuedOperation*> m_blockedOperations;
+
+    WTF::Vector<sp<Worker> > m_workers;
+
     bool m_deferredMode;
-    BaseRenderer* m_renderer;
+    bool m_exiting;
 
     // defer painting for one second if best in queue has priority
     // QueuedOperation::gDeferPriorityCutoff or higher
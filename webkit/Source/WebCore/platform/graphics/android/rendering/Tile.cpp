@@ -38,6 +38,8 @@
 #include "TileTexture.h"
 #include "TilesManager.h"
 
+#include <wtf/RefPtr.h>
+
 // If the dirty portion of a tile exceeds this ratio, fully repaint.
 // Lower values give fewer partial repaints, thus fewer front-to-back
 // texture copies (cost will vary by device). It's a tradeoff between
@@ -217,6 +219,7 @@ void Tile::setRepaintPending(bool pending)
 {
     android::AutoMutex lock(m_atomicSync);
     m_repaintsPending += pending ? 1 : -1;
+    ASSERT(m_repaintsPending >= 0);
 }
 
 bool Tile::drawGL(float opacity, const SkRect& rect, float scale,
@@ -301,7 +304,9 @@ void Tile::paintBitmap(TilePainter* painter, BaseRenderer* renderer)
     // can be updated by other threads without consequence.
     m_atomicSync.lock();
     bool dirty = m_dirty;
-    TileTexture* texture = m_backTexture;
+    // keep the texture alive while painting, the pool may destroy it as soon
+    // as we release the lock
+    RefPtr<TileTexture> texture = m_backTexture;
     SkRegion dirtyArea = m_dirtyArea;
     float scale = m_scale;
     const int x = m_x;
@@ -319,8 +324,10 @@ void Tile::paintBitmap(TilePainter* painter, BaseRenderer* renderer)
     TextureInfo* textureInfo = texture->getTextureInfo();
     m_atomicSync.unlock();
 
-    // at this point we can safely check the ownership (if the texture got
-    // transferred to another Tile under us)
+    // The texture may have been handed to another tile since, whose paint
+    // could already be running. Only one of them paints it at a time, and
+    // only the one that owns it once the previous paint completed.
+    android::AutoMutex paintLock(texture->paintLock());
     if (texture->owner() != this) {
         return;
     }
@@ -355,12 +362,12 @@ void Tile::paintBitmap(TilePainter* painter, BaseRenderer* renderer)
 
         m_dirtyArea.setEmpty();
 
-        ALOGV("painted tile %p (%d, %d), texture %p, dirty=%d", this, x, y, texture, m_dirty);
+        ALOGV("painted tile %p (%d, %d), texture %p, dirty=%d", this, x, y, texture.get(), m_dirty);
 
         validatePaint();
     } else {
         ALOGV("tile %p no longer owns texture %p, m_state %d. ft %p bt %p",
-              this, texture, m_state, m_frontTexture, m_backTexture);
+              this, texture.get(), m_state, m_frontTexture, m_backTexture);
     }
 
     m_atomicSync.unlock();
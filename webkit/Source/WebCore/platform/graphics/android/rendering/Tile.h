@@ -159,7 +159,8 @@ private:
     // redrawn in the backTexture
     bool m_dirty;
 
-    // number of repaints pending
+    // number of PaintTileOperations holding this tile, each one takes a count
+    // when created and gives it back once run, superseded or deleted
     int m_repaintsPending;
 
     // store the dirty region
@@ -34,6 +34,8 @@
 #include "TextureInfo.h"
 
 #include <GLES2/gl2.h>
+#include <utils/threads.h>
+#include <wtf/ThreadSafeRefCounted.h>
 
 class SkCanvas;
 
@@ -43,7 +45,10 @@ class TextureOwner;
 class Tile;
 class TransformationMatrix;
 
-class TileTexture {
+// The texture pool holds one reference to each texture. The texture
+// generation threads hold another one while they paint into it, so the pool
+// can destroy a texture under a running paint, the last deref() deletes it.
+class TileTexture : public ThreadSafeRefCounted<TileTexture> {
 public:
     // This object is to be constructed on the consumer's thread and must have
     // a width and height greater than 0.
@@ -59,7 +64,7 @@ public:
     bool setOwner(TextureOwner* owner);
 
     // private member accessor functions
-    TextureOwner* owner() { return m_owner; } // only used by the consumer thread
+    TextureOwner* owner() { return m_owner; } // set by the consumer thread, checked by painters under paintLock()
 
     const SkSize& getSize() const { return m_size; }
 
@@ -73,6 +78,11 @@ public:
 
     TextureInfo* getTextureInfo() { return &m_ownTextureInfo; }
 
+    // Held by a generator thread for the whole time it paints into the
+    // texture. Tiles do not share painting operations, so two tiles the
+    // texture was handed between would otherwise paint it at the same time.
+    android::Mutex& paintLock() { return m_paintLock; }
+
     // Make sure the following pureColor getter/setter are only read/written
     // in UI thread. Therefore no need for a lock.
     void setPure(bool pure) { m_isPureColor = pure; }
@@ -90,6 +100,8 @@ private:
     // Tile owning the texture, only modified by UI thread
     TextureOwner* m_owner;
 
+    android::Mutex m_paintLock;
+
     // When the whole tile is single color, skip the transfer queue and draw
     // it directly through shader.
     bool m_isPureColor;
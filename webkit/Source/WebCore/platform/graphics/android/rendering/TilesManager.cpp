@@ -36,6 +36,7 @@
 #include "SkCanvas.h"
 #include "SkDevice.h"
 #include "SkPaint.h"
+#include "TextureOwner.h"
 #include "Tile.h"
 #include "TileTexture.h"
 #include "TransferQueue.h"
@@ -44,6 +45,7 @@
 #include <cutils/atomic.h>
 #include <gui/GLConsumer.h>
 #include <gui/Surface.h>
+#include <unistd.h>
 #include <wtf/CurrentTime.h>
 
 // Important: We need at least twice as many textures as is needed to cover
@@ -53,6 +55,8 @@
 // In our case, we use 256*256 textures. Both base and layers can use up to
 // MAX_TEXTURE_ALLOCATION textures, which is 224MB GPU memory in total.
 // For low end graphics systems, we cut this upper limit to half.
+// Unless set with setTextureBudget(), the budget of the texture pool is the
+// memory of that many textures, for base and layers together.
 // We've found the viewport dependent value m_currentTextureCount is a reasonable
 // number to cap the layer tile texturs, it worked on both phones and tablets.
 // TODO: after merge the pool of base tiles and layer tiles, we should revisit
@@ -65,12 +69,57 @@
 
 #define LAYER_TEXTURES_DESTROY_TIMEOUT 60 // If we do not need layers for 60 seconds, free the textures
 
-// Eventually this should be dynamically be determined, and smart scheduling
-// between the generators should be implemented
-#define NUM_TEXTURES_GENERATORS 1
-
 namespace WebCore {
 
+// Creates the TileTextures of the pool. Their GL memory is only allocated
+// once they are painted, see TileTexture::requireGLTexture().
+class GLTileTextureAllocator : public TexturePool<TileTexture>::Allocator {
+public:
+    GLTileTextureAllocator(TilesManager* manager)
+        : m_manager(manager)
+    {
+    }
+
+    virtual TileTexture* createTexture(int width, int height)
+    {
+        TileTexture* texture = new TileTexture(width, height);
+        // the atomic load ensures that the texture has been fully initialized
+        // before we pass a pointer for other threads to operate on
+        return reinterpret_cast<TileTexture*>(
+            android_atomic_acquire_load(reinterpret_cast<int32_t*>(&texture)));
+    }
+
+    virtual void destroyTexture(TileTexture* texture)
+    {
+        // make the transfer queue forget the texture before it goes away,
+        // pending uploads into it are then dropped as obsolete
+        m_manager->transferQueue()->removeTexture(texture);
+        texture->discardGLTexture();
+        // drop the pool's reference, a paint still running into the texture
+        // keeps it alive until it's done
+        texture->deref();
+    }
+
+    virtual void recycleTexture(TileTexture* texture)
+    {
+        TextureOwner* owner = texture->owner();
+        if (owner) {
+            // clear both Tile->Texture and Texture->Tile links
+            owner->removeTexture(texture);
+            texture->release(owner);
+        }
+    }
+
+    virtual unsigned long long lastUsed(TileTexture* texture)
+    {
+        TextureOwner* owner = texture->owner();
+        return owner ? owner->drawCount() : 0;
+    }
+
+private:
+    TilesManager* m_manager;
+};
+
 int TilesManager::getMaxTextureAllocation()
 {
     if (m_maxTextureAllocation == -1) {
@@ -81,6 +130,12 @@ int TilesManager::getMaxTextureAllocation()
         m_maxTextureAllocation = std::min(MAX_TEXTURE_ALLOCATION, glMaxTextureSize / 2);
         if (!m_highEndGfx)
             m_maxTextureAllocation = m_maxTextureAllocation / 2;
+        if (!m_hasTextureBudget) {
+            android::Mutex::Autolock lock(m_texturesLock);
+            m_texturePool->setBudget(2 * m_maxTextureAllocation
+                * TileTexturePool::sizeClassBytes(TILE_WIDTH, TILE_HEIGHT),
+                getDrawGLCount() - 1);
+        }
     }
     return m_maxTextureAllocation;
 }
@@ -91,6 +146,9 @@ TilesManager::TilesManager()
     , m_currentTextureCount(0)
     , m_currentLayerTextureCount(0)
     , m_maxTextureAllocation(-1)
+    , m_textureAllocator(new GLTileTextureAllocator(this))
+    , m_texturePool(new TileTexturePool(m_textureAllocator, 0))
+    , m_hasTextureBudget(false)
     , m_generatorReady(false)
     , m_showVisualIndicator(false)
     , m_invertedScreen(false)
@@ -110,57 +168,80 @@ TilesManager::TilesManager()
     m_tilesTextures.reserveCapacity(MAX_TEXTURE_ALLOCATION / 2);
     m_availableTilesTextures.reserveCapacity(MAX_TEXTURE_ALLOCATION / 2);
 
-    m_textureGenerators = new sp<TexturesGenerator>[NUM_TEXTURES_GENERATORS];
-    for (int i = 0; i < NUM_TEXTURES_GENERATORS; i++) {
-        m_textureGenerators[i] = new TexturesGenerator(this);
-        ALOGD("Starting TG #%d, %p", i, m_textureGenerators[i].get());
-        m_textureGenerators[i]->run("TexturesGenerator");
-    }
+    m_texturesGenerator = new TexturesGenerator(this, texturesGeneratorWorkerCount());
 }
 
 TilesManager::~TilesManager()
 {
-    delete[] m_textureGenerators;
+    delete m_texturesGenerator;
+    delete m_texturePool;
+    delete m_textureAllocator;
+}
+
+int TilesManager::texturesGeneratorWorkerCount()
+{
+    // One raster worker per online core, leaving one to the UI and WebCore
+    // threads. Each worker keeps its own tile sized bitmap to paint into.
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores <= 1)
+        return 1;
+    return cores - 1;
 }
 
 
-void TilesManager::allocateTextures()
+void TilesManager::syncTexturesWithPool()
 {
-    int nbTexturesToAllocate = m_currentTextureCount - m_textures.size();
-    ALOGV("%d tiles to allocate (%d textures planned)", nbTexturesToAllocate, m_currentTextureCount);
-    int nbTexturesAllocated = 0;
-    for (int i = 0; i < nbTexturesToAllocate; i++) {
-        TileTexture* texture = new TileTexture(
-            tileWidth(), tileHeight());
-        // the atomic load ensures that the texture has been fully initialized
-        // before we pass a pointer for other threads to operate on
-        TileTexture* loadedTexture =
-            reinterpret_cast<TileTexture*>(
-            android_atomic_acquire_load(reinterpret_cast<int32_t*>(&texture)));
-        m_textures.append(loadedTexture);
-        nbTexturesAllocated++;
+    m_texturePool->textures(TileTexturePool::BaseUsage, m_textures);
+    m_texturePool->textures(TileTexturePool::LayerUsage, m_tilesTextures);
+
+    // The pool may have destroyed textures, or recycled them for the other
+    // kind of tiles, since they were gathered for this frame
+    for (int i = m_availableTextures.size() - 1; i >= 0; i--) {
+        if (m_textures.find(m_availableTextures[i]) == WTF::notFound)
+            m_availableTextures.remove(i);
+    }
+    for (int i = m_availableTilesTextures.size() - 1; i >= 0; i--) {
+        if (m_tilesTextures.find(m_availableTilesTextures[i]) == WTF::notFound)
+            m_availableTilesTextures.remove(i);
     }
 
-    int nbLayersTexturesToAllocate = m_currentLayerTextureCount - m_tilesTextures.size();
-    ALOGV("%d layers tiles to allocate (%d textures planned)",
-          nbLayersTexturesToAllocate, m_currentLayerTextureCount);
-    int nbLayersTexturesAllocated = 0;
-    for (int i = 0; i < nbLayersTexturesToAllocate; i++) {
-        TileTexture* texture = new TileTexture(
-            tileWidth(), tileHeight());
-        // the atomic load ensures that the texture has been fully initialized
-        // before we pass a pointer for other threads to operate on
-        TileTexture* loadedTexture =
-            reinterpret_cast<TileTexture*>(
-            android_atomic_acquire_load(reinterpret_cast<int32_t*>(&texture)));
-        m_tilesTextures.append(loadedTexture);
-        nbLayersTexturesAllocated++;
+    int textureCount = m_textures.size();
+    if (textureCount < m_currentTextureCount) {
+        ALOGV("reset currentTextureCount for base tiles from %d to %d",
+              m_currentTextureCount, textureCount);
+        m_currentTextureCount = textureCount;
+    }
+    int layerTextureCount = m_tilesTextures.size();
+    if (layerTextureCount < m_currentLayerTextureCount) {
+        ALOGV("reset currentTextureCount for layer tiles from %d to %d",
+              m_currentLayerTextureCount, layerTextureCount);
+        m_currentLayerTextureCount = layerTextureCount;
     }
-    ALOGV("allocated %d textures for base (total: %d, %d Mb), %d textures for layers (total: %d, %d Mb)",
-          nbTexturesAllocated, m_textures.size(),
-          m_textures.size() * TILE_WIDTH * TILE_HEIGHT * 4 / 1024 / 1024,
-          nbLayersTexturesAllocated, m_tilesTextures.size(),
-          m_tilesTextures.size() * tileWidth() * tileHeight() * 4 / 1024 / 1024);
+
+    ALOGV("%d textures for base, %d textures for layers, %d Kb (budget %d Kb)",
+          m_textures.size(), m_tilesTextures.size(),
+          m_texturePool->usedBytes() / 1024, m_texturePool->budget() / 1024);
+}
+
+void TilesManager::setTextureBudget(size_t bytes)
+{
+    android::Mutex::Autolock lock(m_texturesLock);
+    m_hasTextureBudget = true;
+    // textures drawn in the last frame are on screen, don't destroy them
+    m_texturePool->setBudget(bytes, getDrawGLCount() - 1);
+    syncTexturesWithPool();
+}
+
+size_t TilesManager::textureBudget()
+{
+    android::Mutex::Autolock lock(m_texturesLock);
+    return m_texturePool->budget();
+}
+
+size_t TilesManager::textureBytes()
+{
+    android::Mutex::Autolock lock(m_texturesLock);
+    return m_texturePool->usedBytes();
 }
 
 void TilesManager::discardTextures(bool allTextures, bool glTextures)
@@ -177,8 +258,33 @@ void TilesManager::discardTextures(bool allTextures, bool glTextures)
                 sparedDrawCount = std::max(sparedDrawCount, owner->drawCount());
         }
     }
-    discardTexturesVector(sparedDrawCount, m_textures, glTextures);
-    discardTexturesVector(sparedDrawCount, m_tilesTextures, glTextures);
+
+    if (glTextures) {
+        // deallocate textures' gl memory, but not that of the textures on
+        // screen, the pool can't tell whether they are still drawn
+        sparedDrawCount = std::min(sparedDrawCount, getDrawGLCount() - 1);
+        android::Mutex::Autolock lock(m_texturesLock);
+        int dealloc = m_texturePool->release(TileTexturePool::BaseUsage, sparedDrawCount);
+        dealloc += m_texturePool->release(TileTexturePool::LayerUsage, sparedDrawCount);
+        syncTexturesWithPool();
+        ALOGV("Discarded %d gl textures", dealloc);
+        return;
+    }
+
+    discardTexturesVector(sparedDrawCount, m_textures);
+    discardTexturesVector(sparedDrawCount, m_tilesTextures);
+}
+
+void TilesManager::trimTextures(size_t targetBytes, bool spareVisible)
+{
+    android::Mutex::Autolock lock(m_texturesLock);
+    unsigned long long sparedDrawCount = TileTexturePool::s_spareNone;
+    if (spareVisible)
+        sparedDrawCount = getDrawGLCount() - 1;
+    int dealloc = m_texturePool->trim(targetBytes, sparedDrawCount);
+    syncTexturesWithPool();
+    ALOGV("Trimmed %d gl textures to %d Kb (target %d Kb)", dealloc,
+          m_texturePool->usedBytes() / 1024, targetBytes / 1024);
 }
 
 void TilesManager::markAllGLTexturesZero()
@@ -190,47 +296,21 @@ void TilesManager::markAllGLTexturesZero()
 }
 
 void TilesManager::discardTexturesVector(unsigned long long sparedDrawCount,
-                                         WTF::Vector<TileTexture*>& textures,
-                                         bool deallocateGLTextures)
+                                         WTF::Vector<TileTexture*>& textures)
 {
     const unsigned int max = textures.size();
     int dealloc = 0;
-    WTF::Vector<int> discardedIndex;
     for (unsigned int i = 0; i < max; i++) {
         TextureOwner* owner = textures[i]->owner();
-        if (!owner || owner->drawCount() < sparedDrawCount) {
-            if (deallocateGLTextures) {
-                // deallocate textures' gl memory
-                textures[i]->discardGLTexture();
-                discardedIndex.append(i);
-            } else if (owner) {
-                // simply detach textures from owner
-                static_cast<Tile*>(owner)->discardTextures();
-            }
+        if (owner && owner->drawCount() < sparedDrawCount) {
+            // simply detach textures from owner
+            static_cast<Tile*>(owner)->discardTextures();
             dealloc++;
         }
     }
 
-    bool base = textures == m_textures;
-    // Clean up the vector of TileTextures and reset the max texture count.
-    if (discardedIndex.size()) {
-        android::Mutex::Autolock lock(m_texturesLock);
-        for (int i = discardedIndex.size() - 1; i >= 0; i--)
-            textures.remove(discardedIndex[i]);
-
-        int remainedTextureNumber = textures.size();
-        int* countPtr = base ? &m_currentTextureCount : &m_currentLayerTextureCount;
-        if (remainedTextureNumber < *countPtr) {
-            ALOGV("reset currentTextureCount for %s tiles from %d to %d",
-                  base ? "base" : "layer", *countPtr, remainedTextureNumber);
-            *countPtr = remainedTextureNumber;
-        }
-
-    }
-
-    ALOGV("Discarded %d %s textures (out of %d %s tiles)",
-          dealloc, (deallocateGLTextures ? "gl" : ""),
-          max, base ? "base" : "layer");
+    ALOGV("Discarded %d textures (out of %d %s tiles)",
+          dealloc, max, textures == m_textures ? "base" : "layer");
 }
 
 void TilesManager::gatherTexturesNumbers(int* nbTextures, int* nbAllocatedTextures,
@@ -414,9 +494,11 @@ void TilesManager::setCurrentTextureCount(int newTextureCount)
         return;
 
     android::Mutex::Autolock lock(m_texturesLock);
-    m_currentTextureCount = std::min(newTextureCount, maxTextureAllocation);
-
-    allocateTextures();
+    // Past the budget, textures not drawn in the last frame make room
+    m_currentTextureCount = m_texturePool->grow(TileTexturePool::BaseUsage,
+                                                std::min(newTextureCount, maxTextureAllocation),
+                                                tileWidth(), tileHeight(), getDrawGLCount() - 1);
+    syncTexturesWithPool();
 }
 
 void TilesManager::setCurrentLayerTextureCount(int newTextureCount)
@@ -427,9 +509,9 @@ void TilesManager::setCurrentLayerTextureCount(int newTextureCount)
     if (!newTextureCount && m_hasLayerTextures) {
         double secondsSinceLayersUsed = WTF::currentTime() - m_lastTimeLayersUsed;
         if (secondsSinceLayersUsed > LAYER_TEXTURES_DESTROY_TIMEOUT) {
-            unsigned long long sparedDrawCount = ~0; // by default, spare no textures
-            bool deleteGLTextures = true;
-            discardTexturesVector(sparedDrawCount, m_tilesTextures, deleteGLTextures);
+            android::Mutex::Autolock lock(m_texturesLock);
+            m_texturePool->release(TileTexturePool::LayerUsage, getDrawGLCount() - 1);
+            syncTexturesWithPool();
             m_hasLayerTextures = false;
         }
         return;
@@ -440,9 +522,10 @@ void TilesManager::setCurrentLayerTextureCount(int newTextureCount)
         return;
 
     android::Mutex::Autolock lock(m_texturesLock);
-    m_currentLayerTextureCount = std::min(newTextureCount, maxTextureAllocation);
-
-    allocateTextures();
+    m_currentLayerTextureCount = m_texturePool->grow(TileTexturePool::LayerUsage,
+                                                     std::min(newTextureCount, maxTextureAllocation),
+                                                     tileWidth(), tileHeight(), getDrawGLCount() - 1);
+    syncTexturesWithPool();
     m_hasLayerTextures = true;
 }
 
@@ -505,25 +588,18 @@ void TilesManager::updateTilesIfContextVerified()
 
 void TilesManager::removeOperationsForFilter(OperationFilter* filter)
 {
-    for (int i = 0; i < NUM_TEXTURES_GENERATORS; i++)
-        m_textureGenerators[i]->removeOperationsForFilter(filter);
+    m_texturesGenerator->removeOperationsForFilter(filter);
     delete filter;
 }
 
 bool TilesManager::tryUpdateOperationWithPainter(Tile* tile, TilePainter* painter)
 {
-    for (int i = 0; i < NUM_TEXTURES_GENERATORS; i++) {
-        if (m_textureGenerators[i]->tryUpdateOperationWithPainter(tile, painter))
-            return true;
-    }
-    return false;
+    return m_texturesGenerator->tryUpdateOperationWithPainter(tile, painter);
 }
 
 void TilesManager::scheduleOperation(QueuedOperation* operation)
 {
-    // TODO: painter awareness, store prefer awareness, store preferred thread into painter
-    m_scheduleThread = (m_scheduleThread + 1) % NUM_TEXTURES_GENERATORS;
-    m_textureGenerators[m_scheduleThread]->scheduleOperation(operation);
+    m_texturesGenerator->scheduleOperation(operation);
 }
 
 int TilesManager::tileWidth()
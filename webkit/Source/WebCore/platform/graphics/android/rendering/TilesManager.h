@@ -30,6 +30,7 @@
 
 #include "LayerAndroid.h"
 #include "ShaderProgram.h"
+#include "TexturePool.h"
 #include "TexturesGenerator.h"
 #include "TilesProfiler.h"
 #include "VideoLayerManager.h"
@@ -83,11 +84,21 @@ public:
     static int tileWidth();
     static int tileHeight();
 
-    void allocateTextures();
+    // Memory budget in bytes shared by the base and layer textures. Defaults
+    // to one derived from the maximum texture allocation.
+    void setTextureBudget(size_t bytes);
+    size_t textureBudget();
+    size_t textureBytes();
 
     // remove all tiles from textures (and optionally deallocate gl memory)
     void discardTextures(bool allTextures, bool glTextures);
 
+    // Deallocates the least recently drawn textures until at most
+    // |targetBytes| are used, sparing those drawn in the last frame if
+    // |spareVisible| is set. Only clear it while the UI is hidden, those
+    // textures are on screen otherwise.
+    void trimTextures(size_t targetBytes, bool spareVisible);
+
     bool getShowVisualIndicator()
     {
         return m_showVisualIndicator;
@@ -159,14 +170,18 @@ public:
 private:
     TilesManager();
     ~TilesManager();
-    int m_scheduleThread;
+
+    // number of raster workers sharing the texture generator queue
+    static int texturesGeneratorWorkerCount();
 
     void discardTexturesVector(unsigned long long sparedDrawCount,
-                               WTF::Vector<TileTexture*>& textures,
-                               bool deallocateGLTextures);
+                               WTF::Vector<TileTexture*>& textures);
     void dirtyTexturesVector(WTF::Vector<TileTexture*>& textures);
     void markAllGLTexturesZero();
     int getMaxTextureAllocation();
+    // Updates the texture vectors after the pool changed, must be called
+    // with m_texturesLock held
+    void syncTexturesWithPool();
 
     WTF::Vector<TileTexture*> m_textures;
     WTF::Vector<TileTexture*> m_availableTextures;
@@ -180,6 +195,11 @@ private:
     int m_currentLayerTextureCount;
     int m_maxTextureAllocation;
 
+    typedef TexturePool<TileTexture> TileTexturePool;
+    TileTexturePool::Allocator* m_textureAllocator;
+    TileTexturePool* m_texturePool;
+    bool m_hasTextureBudget;
+
     bool m_generatorReady;
 
     bool m_showVisualIndicator;
@@ -191,7 +211,7 @@ private:
     unsigned int m_contentUpdates; // nr of successful tiled paints
     unsigned int m_webkitContentUpdates; // nr of paints from webkit
 
-    sp<TexturesGenerator>* m_textureGenerators;
+    TexturesGenerator* m_texturesGenerator;
 
     android::Mutex m_texturesLock;
 
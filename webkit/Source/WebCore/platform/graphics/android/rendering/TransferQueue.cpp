@@ -241,13 +241,14 @@ bool TransferQueue::readyForUpdate()
 {
     if (!getHasGLContext())
         return false;
-    // Don't use a while loop since when the WebView tear down, the emptyCount
-    // will still be 0, and we bailed out b/c of GL context lost.
-    if (!m_emptyItemCount)
+    // Several TexturesGenerator workers may be waiting for an empty item, so
+    // check again after waking up. When the WebView tears down, the emptyCount
+    // will still be 0, and we bail out b/c of GL context lost.
+    while (!m_emptyItemCount) {
         m_transferQueueItemCond.wait(m_transferQueueItemLocks);
-
-    if (!getHasGLContext())
-        return false;
+        if (!getHasGLContext())
+            return false;
+    }
 
     return true;
 }
@@ -307,7 +308,7 @@ void TransferQueue::setPendingDiscard()
 
     // Only signal once when GL context lost.
     if (GLContextExisted)
-        m_transferQueueItemCond.signal();
+        m_transferQueueItemCond.broadcast();
 }
 
 void TransferQueue::clearPureColorQueue()
@@ -415,7 +416,7 @@ void TransferQueue::updateDirtyTiles()
     }
 
     m_emptyItemCount = m_transferQueueSize;
-    m_transferQueueItemCond.signal();
+    m_transferQueueItemCond.broadcast();
 }
 
 void TransferQueue::updateQueueWithBitmap(const TileRenderInfo* renderInfo,
@@ -476,6 +477,22 @@ void TransferQueue::addItemInPureColorQueue(const TileRenderInfo* renderInfo)
     m_pureColorTileQueue.append(data);
 }
 
+// Called on the UI thread, when the texture pool destroys a texture.
+void TransferQueue::removeTexture(TileTexture* texture)
+{
+    android::Mutex::Autolock lock(m_transferQueueItemLocks);
+    // a null texture never matches the tile's back texture, so checkObsolete()
+    // will drop the items instead of blitting into the deleted texture
+    for (int i = 0; i < m_transferQueueSize; i++) {
+        if (m_transferQueue[i].savedTileTexturePtr == texture)
+            m_transferQueue[i].savedTileTexturePtr = 0;
+    }
+    for (unsigned int i = 0; i < m_pureColorTileQueue.size(); i++) {
+        if (m_pureColorTileQueue[i].savedTileTexturePtr == texture)
+            m_pureColorTileQueue[i].savedTileTexturePtr = 0;
+    }
+}
+
 void TransferQueue::clearItemInTranferQueue(int index)
 {
     m_transferQueue[index].savedTilePtr = 0;
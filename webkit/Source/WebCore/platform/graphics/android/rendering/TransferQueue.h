@@ -129,6 +129,9 @@ public:
 
     void addItemInPureColorQueue(const TileRenderInfo* renderInfo);
 
+    // Clears the queue's references to a texture about to be deleted
+    void removeTexture(TileTexture* texture);
+
     void cleanupGLResourcesAndQueue();
 
     bool needsInit() { return !m_sharedSurfaceTextureId; }
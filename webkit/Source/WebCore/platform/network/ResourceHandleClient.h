@@ -30,6 +30,10 @@
 #include <wtf/RefCounted.h>
 #include <wtf/RefPtr.h>
 
+#if PLATFORM(ANDROID)
+#include <wtf/Vector.h>
+#endif
+
 #if USE(CFNETWORK)
 #include <ConditionalMacros.h>
 #include <CFNetwork/CFURLCachePriv.h>
@@ -55,6 +59,9 @@ namespace WebCore {
     class ResourceError;
     class ResourceRequest;
     class ResourceResponse;
+#if PLATFORM(ANDROID)
+    class SharedBufferSegment;
+#endif
 
     enum CacheStoragePolicy {
         StorageAllowed,
@@ -82,6 +89,12 @@ namespace WebCore {
         virtual bool supportsDataArray() { return false; }
         virtual void didReceiveDataArray(ResourceHandle*, CFArrayRef) { }
 #endif
+#if PLATFORM(ANDROID)
+        // Clients that support segments keep references to the network's read
+        // buffers instead of copying them out of didReceiveData.
+        virtual bool supportsDataSegments() { return false; }
+        virtual void didReceiveDataSegments(ResourceHandle*, const Vector<RefPtr<SharedBufferSegment> >&) { }
+#endif
 
         virtual void willCacheResponse(ResourceHandle*, CacheStoragePolicy&) { }
 
@@ -34,6 +34,7 @@
 #include "ColorSpace.h"
 #include "CounterDirectives.h"
 #include "DataRef.h"
+#include "DocumentArena.h"
 #include "FillLayer.h"
 #include "Font.h"
 #include "GraphicsTypes.h"
@@ -319,6 +320,12 @@ public:
 
     ~RenderStyle();
 
+#ifdef ANDROID_DOCUMENT_ARENA
+    // Styles share the slabs of the document being styled, see DocumentArena
+    void* operator new(size_t size) { return DocumentArena::allocate(size); }
+    void operator delete(void* p, size_t size) { DocumentArena::free(p, size); }
+#endif
+
     void inheritFrom(const RenderStyle* inheritParent);
 
     PseudoId styleType() const { return static_cast<PseudoId>(noninherited_flags._styleType); }
@@ -41,6 +41,12 @@ class SVGFEImageElement : public SVGFilterPrimitiveStandardAttributes,
                           public SVGExternalResourcesRequired,
                           public CachedResourceClient {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // CachedResourceClient has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     static PassRefPtr<SVGFEImageElement> create(const QualifiedName&, Document*);
 
     virtual ~SVGFEImageElement();
@@ -32,6 +32,12 @@ class CachedFont;
 
 class SVGFontFaceUriElement : public SVGElement, public CachedResourceClient {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // CachedResourceClient has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     static PassRefPtr<SVGFontFaceUriElement> create(const QualifiedName&, Document*);
 
     virtual ~SVGFontFaceUriElement();
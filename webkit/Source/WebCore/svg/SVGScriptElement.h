@@ -36,6 +36,12 @@ class SVGScriptElement : public SVGElement
                        , public SVGExternalResourcesRequired
                        , public ScriptElement {
 public:
+#ifdef ANDROID_DOCUMENT_ARENA
+    // ScriptElement has its own allocator, keep the node one
+    using Node::operator new;
+    using Node::operator delete;
+#endif
+
     static PassRefPtr<SVGScriptElement> create(const QualifiedName&, Document*, bool wasInsertedByParser);
 
     String type() const;
@@ -4,10 +4,18 @@ include $(CLEAR_VARS)
 
 # Build the unit tests.
 test_src_files := \
+    OperationQueue_test.cpp \
+    PurgeableBuffer_test.cpp \
+    RTree_test.cpp \
+    Recording_test.cpp \
+    SerializedRecording_test.cpp \
+    StringImpl8Bit_test.cpp \
+    TexturePool_test.cpp \
     TreeManager_test.cpp
 
 shared_libraries := \
     libcutils \
+    libutils \
     libwebcore \
     libskia \
     libstlport
@@ -28,7 +36,10 @@ c_includes := \
     $(LOCAL_PATH)/.. \
     $(LOCAL_PATH)/../platform/graphics \
     $(LOCAL_PATH)/../platform/graphics/transforms \
-    $(LOCAL_PATH)/../platform/graphics/android
+    $(LOCAL_PATH)/../platform/graphics/android \
+    $(LOCAL_PATH)/../platform/graphics/android/context \
+    $(LOCAL_PATH)/../platform/graphics/android/rendering \
+    $(LOCAL_PATH)/../platform/graphics/android/utils
 
     # external/webkit/Source/WebCore/platform/graphics/android
 
@@ -45,5 +56,20 @@ $(foreach file,$(test_src_files), \
     $(eval include $(BUILD_EXECUTABLE)) \
 )
 
+# The style tests need the DOM classes, which are not exported from
+# libwebcore.so, so link the static library as tests/domcreate does.
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := SharedStyleCache_test.cpp
+LOCAL_CFLAGS := $(WEBKIT_CFLAGS)
+LOCAL_CPPFLAGS := $(WEBKIT_CPPFLAGS)
+LOCAL_C_INCLUDES := $(WEBKIT_C_INCLUDES) external/gtest/include
+LOCAL_LDLIBS := $(WEBKIT_LDLIBS)
+LOCAL_SHARED_LIBRARIES := $(WEBKIT_SHARED_LIBRARIES)
+LOCAL_STATIC_LIBRARIES := libwebcore $(WEBKIT_STATIC_LIBRARIES) $(static_libraries)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(filter %.h, $(WEBKIT_GENERATED_SOURCES))
+LOCAL_MODULE := SharedStyleCache_test
+LOCAL_MODULE_TAGS := $(module_tags)
+include $(BUILD_EXECUTABLE)
+
 # Build the manual test programs.
 include $(call all-makefiles-under, $(LOCAL_PATH))
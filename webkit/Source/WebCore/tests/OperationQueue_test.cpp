@@ -0,0 +1,134 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "OperationQueue.h"
+#include "QueuedOperation.h"
+
+#include <stdlib.h>
+#include <wtf/Vector.h>
+
+namespace WebCore {
+
+// Operation with an externally controlled priority, keyed by its own address
+class TestOperation : public QueuedOperation {
+public:
+    TestOperation(int priority) : m_priority(priority) {}
+    virtual void run(BaseRenderer* renderer) {}
+    virtual bool operator==(const QueuedOperation* operation) { return operation == this; }
+    virtual void* uniquePtr() { return this; }
+    virtual int priority() { return m_priority; }
+
+    int m_priority;
+};
+
+class OperationQueueTest : public testing::Test {
+protected:
+    virtual void TearDown()
+    {
+        for (unsigned i = 0; i < m_operations.size(); i++)
+            delete m_operations[i];
+        m_operations.clear();
+    }
+
+    TestOperation* create(int priority)
+    {
+        TestOperation* operation = new TestOperation(priority);
+        m_operations.append(operation);
+        return operation;
+    }
+
+    Vector<TestOperation*> m_operations;
+};
+
+TEST_F(OperationQueueTest, PopsInPriorityThenInsertionOrder) {
+    OperationQueue queue;
+    TestOperation* a = create(5);
+    TestOperation* b = create(1);
+    TestOperation* c = create(5);
+    TestOperation* d = create(-1);
+    queue.push(a, a->priority());
+    queue.push(b, b->priority());
+    queue.push(c, c->priority());
+    queue.push(d, d->priority());
+
+    ASSERT_EQ(queue.size(), 4u);
+    ASSERT_EQ(queue.pop(), d);
+    ASSERT_EQ(queue.pop(), b);
+    ASSERT_EQ(queue.pop(), a);
+    ASSERT_EQ(queue.pop(), c);
+    ASSERT_TRUE(queue.isEmpty());
+}
+
+TEST_F(OperationQueueTest, UpdatePriorityMovesBothWays) {
+    OperationQueue queue;
+    TestOperation* a = create(10);
+    TestOperation* b = create(20);
+    TestOperation* c = create(30);
+    queue.push(a, a->priority());
+    queue.push(b, b->priority());
+    queue.push(c, c->priority());
+
+    queue.updatePriority(c, 0);
+    ASSERT_EQ(queue.top(), c);
+    queue.updatePriority(c, 40);
+    ASSERT_EQ(queue.top(), a);
+    queue.updatePriority(a, 25);
+    ASSERT_EQ(queue.pop(), b);
+    ASSERT_EQ(queue.pop(), a);
+    ASSERT_EQ(queue.pop(), c);
+}
+
+TEST_F(OperationQueueTest, TakeAndUpdatePriorities) {
+    OperationQueue queue;
+    for (int i = 0; i < 64; i++) {
+        TestOperation* operation = create(rand() % 16);
+        queue.push(operation, operation->priority());
+    }
+
+    ASSERT_TRUE(queue.contains(m_operations[10]));
+    ASSERT_EQ(queue.take(m_operations[10]), m_operations[10]);
+    ASSERT_FALSE(queue.contains(m_operations[10]));
+    ASSERT_EQ(queue.get(m_operations[10]), (QueuedOperation*) 0);
+    ASSERT_EQ(queue.take(m_operations[10]), (QueuedOperation*) 0);
+
+    for (unsigned i = 0; i < m_operations.size(); i++)
+        m_operations[i]->m_priority = 64 - i;
+    queue.updatePriorities();
+
+    int lastPriority = -1;
+    while (!queue.isEmpty()) {
+        int priority = queue.top()->priority();
+        ASSERT_EQ(priority, queue.topPriority());
+        ASSERT_GE(priority, lastPriority);
+        lastPriority = priority;
+        queue.pop();
+    }
+}
+
+} // namespace WebCore
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "PurgeableBuffer.h"
+
+#include <cutils/ashmem.h>
+#include <linux/ashmem.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <wtf/OwnPtr.h>
+#include <wtf/Vector.h>
+
+#if ENABLE(PURGEABLE_MEMORY)
+
+namespace WebCore {
+
+static const size_t bufferSize = 64 * 1024;
+
+static void fillData(Vector<char>& data)
+{
+    data.resize(bufferSize);
+    for (size_t i = 0; i < bufferSize; i++)
+        data[i] = static_cast<char>(i * 7);
+}
+
+// Makes the kernel reclaim every unpinned ashmem region, returns false if this
+// process may not do that.
+static bool purgeAllAshmem()
+{
+    int fd = ashmem_create_region("PurgeableBuffer_test", 4096);
+    if (fd < 0)
+        return false;
+    bool purged = ioctl(fd, ASHMEM_PURGE_ALL_CACHES) >= 0;
+    close(fd);
+    return purged;
+}
+
+TEST(PurgeableBufferTest, SmallBuffersAreNotPurgeable) {
+    Vector<char> data;
+    fillData(data);
+    EXPECT_FALSE(PurgeableBuffer::create(data.data(), 4096).get());
+}
+
+TEST(PurgeableBufferTest, RepinsUnpurgedContents) {
+    Vector<char> data;
+    fillData(data);
+    OwnPtr<PurgeableBuffer> buffer = PurgeableBuffer::create(data.data(), bufferSize);
+    ASSERT_TRUE(buffer.get());
+    EXPECT_FALSE(buffer->isPurgeable());
+    EXPECT_EQ(0, memcmp(buffer->data(), data.data(), bufferSize));
+
+    EXPECT_TRUE(buffer->makePurgeable(true));
+    EXPECT_TRUE(buffer->isPurgeable());
+    EXPECT_FALSE(buffer->wasPurged());
+
+    ASSERT_TRUE(buffer->makePurgeable(false));
+    EXPECT_FALSE(buffer->isPurgeable());
+    EXPECT_FALSE(buffer->wasPurged());
+    EXPECT_EQ(0, memcmp(buffer->data(), data.data(), bufferSize));
+}
+
+TEST(PurgeableBufferTest, ReportsPurgeWhenRepinning) {
+    Vector<char> data;
+    fillData(data);
+    OwnPtr<PurgeableBuffer> buffer = PurgeableBuffer::create(data.data(), bufferSize);
+    ASSERT_TRUE(buffer.get());
+    EXPECT_TRUE(buffer->makePurgeable(true));
+    if (!purgeAllAshmem()) {
+        printf("Can't purge ashmem, run as root to test purging\n");
+        return;
+    }
+
+    // Only pinning finds out about the purge
+    EXPECT_FALSE(buffer->wasPurged());
+    EXPECT_FALSE(buffer->makePurgeable(false));
+    EXPECT_TRUE(buffer->wasPurged());
+    EXPECT_TRUE(buffer->isPurgeable());
+    EXPECT_FALSE(buffer->makePurgeable(false));
+}
+
+TEST(PurgeableBufferTest, CheckingForPurgesKeepsBufferVolatile) {
+    Vector<char> data;
+    fillData(data);
+    OwnPtr<PurgeableBuffer> buffer = PurgeableBuffer::create(data.data(), bufferSize);
+    ASSERT_TRUE(buffer.get());
+    EXPECT_FALSE(buffer->checkPurged());
+    EXPECT_FALSE(buffer->isPurgeable());
+
+    EXPECT_TRUE(buffer->makePurgeable(true));
+    EXPECT_FALSE(buffer->checkPurged());
+    EXPECT_TRUE(buffer->isPurgeable());
+    if (!purgeAllAshmem()) {
+        printf("Can't purge ashmem, run as root to test purging\n");
+        return;
+    }
+
+    EXPECT_TRUE(buffer->checkPurged());
+    EXPECT_TRUE(buffer->wasPurged());
+    EXPECT_FALSE(buffer->makePurgeable(false));
+}
+
+TEST(PurgeableBufferTest, PinnedBuffersSurvivePurges) {
+    Vector<char> data;
+    fillData(data);
+    OwnPtr<PurgeableBuffer> buffer = PurgeableBuffer::create(data.data(), bufferSize);
+    ASSERT_TRUE(buffer.get());
+    EXPECT_TRUE(buffer->makePurgeable(true));
+    ASSERT_TRUE(buffer->makePurgeable(false));
+    if (!purgeAllAshmem()) {
+        printf("Can't purge ashmem, run as root to test purging\n");
+        return;
+    }
+
+    EXPECT_FALSE(buffer->wasPurged());
+    EXPECT_EQ(0, memcmp(buffer->data(), data.data(), bufferSize));
+}
+
+} // namespace WebCore
+
+#endif // ENABLE(PURGEABLE_MEMORY)
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "GraphicsOperation.h"
+#include "IntRect.h"
+#include "RTree.h"
+
+#include <stdlib.h>
+#include <utils/LinearAllocator.h>
+#include <wtf/HashSet.h>
+#include <wtf/Vector.h>
+
+namespace WebCore {
+
+class TestOperation : public GraphicsOperation::Operation {
+public:
+    void* operator new(size_t size, android::LinearAllocator* allocator) { return allocator->alloc(size); }
+    virtual bool applyImpl(PlatformGraphicsContext* context) { return true; }
+};
+
+// Lays out operations the way a long text page would: lines of words, with
+// the occasional large box
+static void generatePage(int count, Vector<IntRect>& bounds)
+{
+    srand(count);
+    int y = 0;
+    int x = 0;
+    for (int i = 0; i < count; i++) {
+        if (!(i % 100)) {
+            bounds.append(IntRect(0, y, 980, 200 + rand() % 300));
+            continue;
+        }
+        int width = 20 + rand() % 80;
+        if (x + width > 980) {
+            x = 0;
+            y += 18;
+        }
+        bounds.append(IntRect(x, y, width, 16));
+        x += width + 4;
+    }
+}
+
+static void fill(RTree::RTree& tree, android::LinearAllocator& heap, Vector<IntRect>& bounds)
+{
+    for (unsigned i = 0; i < bounds.size(); i++) {
+        RecordingData* data = new (&heap) RecordingData(new (&heap) TestOperation(), i);
+        tree.insert(bounds[i], data);
+    }
+}
+
+static void collect(RTree::RTree& tree, IntRect clip, HashSet<size_t>& found)
+{
+    Vector<RecordingData*> list;
+    tree.search(clip, list);
+    for (unsigned i = 0; i < list.size(); i++)
+        found.add(list[i]->m_orderBy + 1);
+}
+
+TEST(RTreeTest, PackedSearchMatchesDynamic) {
+    Vector<IntRect> bounds;
+    generatePage(5000, bounds);
+
+    android::LinearAllocator dynamicHeap;
+    RTree::RTree dynamicTree(&dynamicHeap);
+    fill(dynamicTree, dynamicHeap, bounds);
+
+    android::LinearAllocator packedHeap;
+    RTree::RTree packedTree(&packedHeap);
+    packedTree.beginBulkLoad();
+    fill(packedTree, packedHeap, bounds);
+    packedTree.endBulkLoad();
+
+    for (int i = 0; i < 200; i++) {
+        IntRect clip(rand() % 1000, rand() % 60000, 1 + rand() % 512, 1 + rand() % 512);
+        HashSet<size_t> expected;
+        HashSet<size_t> found;
+        collect(dynamicTree, clip, expected);
+        collect(packedTree, clip, found);
+        ASSERT_EQ(expected.size(), found.size());
+        for (HashSet<size_t>::iterator it = expected.begin(); it != expected.end(); ++it)
+            ASSERT_TRUE(found.contains(*it));
+    }
+}
+
+TEST(RTreeTest, RemoveAndInsertAfterPacking) {
+    android::LinearAllocator heap;
+    RTree::RTree tree(&heap);
+    Vector<IntRect> bounds;
+    for (int i = 0; i < 100; i++)
+        bounds.append(IntRect((i % 10) * 100, (i / 10) * 100, 50, 50));
+
+    tree.beginBulkLoad();
+    fill(tree, heap, bounds);
+    tree.endBulkLoad();
+
+    HashSet<size_t> found;
+    collect(tree, IntRect(0, 0, 1000, 1000), found);
+    ASSERT_EQ(found.size(), 100u);
+
+    // removes the four elements fully inside, not the one partially inside
+    IntRect removed(0, 0, 200, 175);
+    tree.remove(removed);
+    found.clear();
+    collect(tree, IntRect(0, 0, 1000, 1000), found);
+    ASSERT_EQ(found.size(), 96u);
+
+    IntRect added(10, 10, 20, 20);
+    tree.insert(added, new (&heap) RecordingData(new (&heap) TestOperation(), 100));
+    found.clear();
+    collect(tree, IntRect(0, 0, 40, 40), found);
+    ASSERT_EQ(found.size(), 1u);
+    ASSERT_TRUE(found.contains(101));
+}
+
+TEST(RTreeTest, SearchLeavesOutHiddenElements) {
+    android::LinearAllocator heap;
+    RTree::RTree tree(&heap);
+    Vector<IntRect> bounds;
+    for (int i = 0; i < 100; i++)
+        bounds.append(IntRect((i % 10) * 100, (i / 10) * 100, 50, 50));
+    tree.beginBulkLoad();
+    fill(tree, heap, bounds);
+    tree.endBulkLoad();
+    // goes into the dynamic tree, as the tree is already packed
+    IntRect late(5, 5, 10, 10);
+    tree.insert(late, new (&heap) RecordingData(new (&heap) TestOperation(), 100));
+
+    // Splices draw their area instead of what is entirely inside of it,
+    // elements only partially inside are still found
+    Vector<IntRect> hidden;
+    hidden.append(IntRect(0, 0, 100, 100));
+    hidden.append(IntRect(220, 220, 100, 100));
+    Vector<RecordingData*> list;
+    tree.search(IntRect(0, 0, 1000, 1000), hidden, list);
+    HashSet<size_t> found;
+    for (unsigned i = 0; i < list.size(); i++)
+        found.add(list[i]->m_orderBy + 1);
+    ASSERT_EQ(found.size(), 99u);
+    ASSERT_FALSE(found.contains(1));
+    ASSERT_FALSE(found.contains(101));
+    ASSERT_TRUE(found.contains(23));
+
+    // Without hidden areas, everything overlapping is found
+    found.clear();
+    collect(tree, IntRect(0, 0, 1000, 1000), found);
+    ASSERT_EQ(found.size(), 101u);
+    tree.search(IntRect(0, 0, 1000, 1000), Vector<IntRect>(), list);
+    ASSERT_EQ(list.size(), 99u + 101u);
+}
+
+TEST(RTreeTest, SearchCopiedPackedView) {
+    Vector<IntRect> bounds;
+    generatePage(5000, bounds);
+    android::LinearAllocator heap;
+    Vector<RTree::PackedTree::Element> elements;
+    for (unsigned i = 0; i < bounds.size(); i++) {
+        RTree::PackedTree::Element e;
+        e.m_minX = bounds[i].x();
+        e.m_minY = bounds[i].y();
+        e.m_maxX = bounds[i].maxX();
+        e.m_maxY = bounds[i].maxY();
+        e.m_payload = new (&heap) RecordingData(new (&heap) TestOperation(), i);
+        elements.append(e);
+    }
+    RTree::PackedTree tree;
+    tree.build(elements, 10);
+
+    // A serialized tree is searched from a copy of its arrays
+    RTree::PackedTree::View view = tree.view();
+    unsigned nodes = tree.nodeCount();
+    unsigned parents = nodes - tree.size();
+    Vector<int> minX, minY, maxX, maxY;
+    Vector<unsigned> firstChild, nbChildren;
+    minX.append(view.m_minX, nodes);
+    minY.append(view.m_minY, nodes);
+    maxX.append(view.m_maxX, nodes);
+    maxY.append(view.m_maxY, nodes);
+    firstChild.append(view.m_firstChild, parents);
+    nbChildren.append(view.m_nbChildren, parents);
+    RTree::PackedTree::View copy = view;
+    copy.m_minX = minX.data();
+    copy.m_minY = minY.data();
+    copy.m_maxX = maxX.data();
+    copy.m_maxY = maxY.data();
+    copy.m_firstChild = firstChild.data();
+    copy.m_nbChildren = nbChildren.data();
+
+    for (int i = 0; i < 200; i++) {
+        IntRect clip(rand() % 1000, rand() % 60000, 1 + rand() % 512, 1 + rand() % 512);
+        Vector<RecordingData*> expected;
+        tree.search(clip.x(), clip.y(), clip.maxX(), clip.maxY(), expected);
+        Vector<unsigned> found;
+        copy.search(clip.x(), clip.y(), clip.maxX(), clip.maxY(), found);
+        ASSERT_EQ(expected.size(), found.size());
+        for (unsigned j = 0; j < found.size(); j++)
+            ASSERT_EQ(expected[j], tree.payload(found[j]));
+    }
+    tree.destroyPayloads();
+}
+
+} // namespace WebCore
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "Color.h"
+#include "FloatRect.h"
+#include "FloatSize.h"
+#include "IntPoint.h"
+#include "IntRect.h"
+#include "PlatformGraphicsContextRecording.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+
+#include <stdlib.h>
+
+namespace WebCore {
+
+static const int kPageWidth = 512;
+static const int kPageHeight = 768;
+static const int kTileSize = 256;
+
+typedef void (*PaintProc)(PlatformGraphicsContext* context);
+
+// Opaque backgrounds covering what was drawn under them, for culling
+static void paintOccluded(PlatformGraphicsContext* context)
+{
+    context->fillRect(FloatRect(0, 0, kPageWidth, kPageHeight), Color(255, 255, 255));
+    context->fillRect(FloatRect(20, 20, 100, 100), Color(255, 0, 0));
+    context->fillRect(FloatRect(10, 10, 300, 300), Color(0, 0, 255));
+    context->fillRect(FloatRect(200, 200, 100, 100), Color(0, 128, 0, 128));
+    context->fillRect(FloatRect(0, 400, kPageWidth, 200), Color(30, 30, 30));
+}
+
+// Runs of similar operations, for merging
+static void paintRuns(PlatformGraphicsContext* context)
+{
+    srand(5);
+    context->setFillColor(Color(10, 20, 200));
+    for (int i = 0; i < 200; i++)
+        context->fillRect(FloatRect(rand() % kPageWidth, rand() % kPageHeight, 4 + rand() % 40, 12));
+    for (int i = 0; i < 200; i++) {
+        Color color = (i / 7) % 2 ? Color(200, 20, 20, 160) : Color(20, 200, 20);
+        context->fillRect(FloatRect((i % 20) * 25, 300 + (i / 20) * 20, 20, 16), color);
+    }
+    context->save();
+    for (int i = 0; i < 20; i++) {
+        context->translate(3, 5);
+        context->scale(FloatSize(1.01f, 1.01f));
+    }
+    context->fillRect(FloatRect(0, 0, 50, 50), Color(90, 0, 90));
+    context->restore();
+}
+
+// Nested states with and without state operations, for collapsing them
+static void paintStates(PlatformGraphicsContext* context)
+{
+    context->save();
+    context->fillRect(FloatRect(0, 0, 100, 100), Color(255, 0, 0));
+    context->save();
+    context->fillRect(FloatRect(50, 50, 100, 100), Color(0, 255, 0, 200));
+    context->restore();
+    context->restore();
+
+    context->save();
+    context->translate(200, 100);
+    context->clip(FloatRect(0, 0, 150, 150));
+    context->fillRect(FloatRect(-50, -50, 300, 300), Color(0, 0, 255));
+    context->save();
+    context->setAlpha(0.5f);
+    context->fillRect(FloatRect(20, 20, 80, 80), Color(255, 255, 0));
+    context->restore();
+    context->restore();
+
+    context->beginTransparencyLayer(0.6f);
+    context->fillRect(FloatRect(100, 300, 200, 200), Color(0, 0, 0));
+    context->fillRect(FloatRect(150, 350, 200, 200), Color(255, 0, 255));
+    context->endTransparencyLayer();
+
+    context->save();
+    context->setShadow(4, 3, 3, SK_ColorBLACK);
+    context->fillRect(FloatRect(10, 600, 40, 40), Color(200, 200, 200));
+    context->fillRect(FloatRect(40, 610, 40, 40), Color(200, 200, 200));
+    context->restore();
+
+    context->setStrokeColor(Color(0, 0, 0));
+    context->setStrokeThickness(3);
+    context->drawLine(IntPoint(0, 700), IntPoint(kPageWidth, 740));
+    context->drawEllipse(IntRect(300, 550, 120, 80));
+    context->strokeRect(FloatRect(320, 20, 150, 60), 2);
+}
+
+static Recording* record(PaintProc paint, bool optimize)
+{
+    PlatformGraphicsContextRecording::setOptimizationsEnabled(optimize);
+    Recording* recording = new Recording();
+    {
+        PlatformGraphicsContextRecording context(recording);
+        paint(&context);
+    }
+    PlatformGraphicsContextRecording::setOptimizationsEnabled(true);
+    return recording;
+}
+
+// Draws |recording| the way TileGrid does, one tile at a time
+static void drawTiled(const Recording* recording, SkBitmap& bitmap)
+{
+    bitmap.setConfig(SkBitmap::kARGB_8888_Config, kPageWidth, kPageHeight);
+    bitmap.allocPixels();
+    bitmap.eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(bitmap);
+    for (int y = 0; y < kPageHeight; y += kTileSize) {
+        for (int x = 0; x < kPageWidth; x += kTileSize) {
+            canvas.save();
+            canvas.clipRect(SkRect::MakeXYWH(x, y, kTileSize, kTileSize));
+            recording->draw(&canvas);
+            canvas.restore();
+        }
+    }
+}
+
+// Returns the number of pixels that differ
+static int compare(const SkBitmap& a, const SkBitmap& b)
+{
+    int differences = 0;
+    for (int y = 0; y < a.height(); y++) {
+        for (int x = 0; x < a.width(); x++) {
+            if (*a.getAddr32(x, y) != *b.getAddr32(x, y))
+                differences++;
+        }
+    }
+    return differences;
+}
+
+static void expectOptimizedMatches(PaintProc paint)
+{
+    Recording* unoptimized = record(paint, false);
+    Recording* optimized = record(paint, true);
+    SkBitmap expected;
+    SkBitmap actual;
+    drawTiled(unoptimized, expected);
+    drawTiled(optimized, actual);
+    EXPECT_EQ(compare(expected, actual), 0);
+    unoptimized->unref();
+    optimized->unref();
+}
+
+TEST(RecordingTest, OptimizedCullingDrawsTheSame) {
+    expectOptimizedMatches(paintOccluded);
+}
+
+TEST(RecordingTest, OptimizedMergingDrawsTheSame) {
+    expectOptimizedMatches(paintRuns);
+}
+
+TEST(RecordingTest, OptimizedStatesDrawTheSame) {
+    expectOptimizedMatches(paintStates);
+}
+
+// A page whose block |k| changes color on its |k|th update, |version| is
+// the number of updates made so far
+static const IntRect kChangedAreas[] = {
+    IntRect(40, 40, 60, 60),
+    IntRect(300, 200, 150, 90),
+    IntRect(100, 500, 200, 200),
+    IntRect(250, 260, 100, 100),
+};
+static const int kChangeCount = sizeof(kChangedAreas) / sizeof(kChangedAreas[0]);
+
+static void paintPage(PlatformGraphicsContext* context, int version)
+{
+    context->fillRect(FloatRect(0, 0, kPageWidth, kPageHeight), Color(240, 240, 240));
+    paintRuns(context);
+    for (int k = 0; k < kChangeCount; k++) {
+        const IntRect& area = kChangedAreas[k];
+        Color color = k < version ? Color(20 * k, 200, 255 - 40 * k) : Color(128, 64, 0);
+        context->fillRect(FloatRect(area.x() + 5, area.y() + 5, area.width() - 10, area.height() - 10),
+                          color);
+    }
+    // Drawn across the changed areas, so partially inside each splice
+    context->fillRect(FloatRect(0, 90, kPageWidth, 20), Color(0, 0, 0, 100));
+    context->setStrokeColor(Color(0, 0, 128));
+    context->setStrokeThickness(5);
+    context->drawEllipse(IntRect(60, 60, 380, 600));
+}
+
+static Recording* recordPage(int version)
+{
+    Recording* recording = new Recording();
+    {
+        PlatformGraphicsContextRecording context(recording);
+        paintPage(&context, version);
+    }
+    return recording;
+}
+
+TEST(RecordingTest, SplicesDrawLikeFullRecordings) {
+    Recording* spliced = recordPage(0);
+    for (int version = 1; version <= kChangeCount; version++) {
+        Recording* splice = new Recording();
+        {
+            PlatformGraphicsContextRecording context(splice, spliced, kChangedAreas[version - 1]);
+            paintPage(&context, version);
+        }
+        spliced->unref();
+        spliced = splice;
+        ASSERT_EQ(spliced->spliceCount(), static_cast<size_t>(version));
+
+        Recording* full = recordPage(version);
+        SkBitmap expected;
+        SkBitmap actual;
+        drawTiled(full, expected);
+        drawTiled(spliced, actual);
+        EXPECT_EQ(compare(expected, actual), 0);
+
+        // Only what overlaps the splice is recorded, the rest is shared
+        EXPECT_LT(spliced->recordedOperationCount(), full->recordedOperationCount());
+        EXPECT_LT(spliced->recordedBytes(), full->recordedBytes());
+        full->unref();
+    }
+    spliced->unref();
+}
+
+} // namespace WebCore
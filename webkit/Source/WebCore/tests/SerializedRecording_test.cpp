@@ -0,0 +1,443 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "Color.h"
+#include "FloatPoint.h"
+#include "FloatRect.h"
+#include "IntRect.h"
+#include "Path.h"
+#include "PlatformGraphicsContextRecording.h"
+#include "SerializedRecording.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkMatrix.h"
+#include "SkStream.h"
+
+#include <string.h>
+
+namespace WebCore {
+
+static const int kPageWidth = 512;
+static const int kPageHeight = 512;
+static const int kTileSize = 256;
+
+// Odd sizes, to find their records in the serialized data
+static const int kImageWidth = 13;
+static const int kImageHeight = 7;
+
+static void makeImage(SkBitmap& bitmap, SkColor color)
+{
+    bitmap.setConfig(SkBitmap::kARGB_8888_Config, kImageWidth, kImageHeight);
+    bitmap.allocPixels();
+    bitmap.eraseColor(color);
+    *bitmap.getAddr32(1, 1) = SkPreMultiplyColor(SK_ColorBLACK);
+}
+
+// Operations of most types, with bitmaps that are the same or differ in
+// content but never share pixels
+static void paintScene(PlatformGraphicsContext* context)
+{
+    context->fillRect(FloatRect(0, 0, kPageWidth, kPageHeight), Color(250, 250, 250));
+
+    Path path;
+    path.moveTo(FloatPoint(20, 20));
+    path.addLineTo(FloatPoint(200, 40));
+    path.addQuadCurveTo(FloatPoint(220, 120), FloatPoint(120, 180));
+    path.addBezierCurveTo(FloatPoint(80, 200), FloatPoint(40, 120), FloatPoint(30, 90));
+    path.closeSubpath();
+    path.addEllipse(FloatRect(60, 60, 40, 30));
+    context->setFillColor(Color(30, 120, 200));
+    context->fillPath(path, RULE_EVENODD);
+    context->setStrokeColor(Color(200, 30, 30));
+    context->setStrokeThickness(4);
+    context->strokePath(path);
+
+    context->save();
+    context->translate(260, 20);
+    context->rotate(0.2f);
+    context->clip(FloatRect(0, 0, 200, 150));
+    context->fillRect(FloatRect(-20, -20, 300, 300), Color(0, 160, 0, 180));
+    context->drawEllipse(IntRect(20, 20, 120, 80));
+    context->restore();
+
+    SkBitmap image;
+    makeImage(image, SK_ColorRED);
+    SkBitmap sameImage;
+    makeImage(sameImage, SK_ColorRED);
+    SkBitmap otherImage;
+    makeImage(otherImage, SK_ColorBLUE);
+    context->drawBitmapRect(image, 0, SkRect::MakeXYWH(20, 260, 100, 60));
+    context->drawBitmapRect(sameImage, 0, SkRect::MakeXYWH(140, 260, 100, 60));
+    SkIRect src = SkIRect::MakeXYWH(2, 2, 8, 4);
+    context->drawBitmapRect(otherImage, &src, SkRect::MakeXYWH(260, 260, 100, 60));
+    SkMatrix matrix;
+    matrix.setScale(2, 2);
+    context->drawBitmapPattern(otherImage, matrix, CompositeSourceOver,
+                               FloatRect(380, 260, 120, 100));
+
+    context->beginTransparencyLayer(0.5f);
+    context->setShadow(3, 2, 2, SK_ColorBLACK);
+    context->fillRect(FloatRect(40, 380, 200, 100), Color(255, 200, 0));
+    context->fillRect(FloatRect(140, 420, 200, 80), Color(120, 0, 160));
+    context->endTransparencyLayer();
+
+    context->drawLine(IntPoint(0, kPageHeight - 1), IntPoint(kPageWidth, 300));
+    context->strokeRect(FloatRect(360, 400, 100, 80), 3);
+}
+
+static Recording* record(void (*paint)(PlatformGraphicsContext*))
+{
+    Recording* recording = new Recording();
+    {
+        PlatformGraphicsContextRecording context(recording);
+        paint(&context);
+    }
+    return recording;
+}
+
+static SkData* serialize(const Recording* recording)
+{
+    SkDynamicMemoryWStream stream;
+    return recording->serialize(&stream) ? stream.copyToData() : 0;
+}
+
+// Draws |recording| the way TileGrid does, one tile at a time
+template<typename T>
+static void drawTiled(const T* recording, SkBitmap& bitmap)
+{
+    bitmap.setConfig(SkBitmap::kARGB_8888_Config, kPageWidth, kPageHeight);
+    bitmap.allocPixels();
+    bitmap.eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(bitmap);
+    for (int y = 0; y < kPageHeight; y += kTileSize) {
+        for (int x = 0; x < kPageWidth; x += kTileSize) {
+            canvas.save();
+            canvas.clipRect(SkRect::MakeXYWH(x, y, kTileSize, kTileSize));
+            recording->draw(&canvas);
+            canvas.restore();
+        }
+    }
+}
+
+// Returns the number of pixels that differ
+static int compare(const SkBitmap& a, const SkBitmap& b)
+{
+    int differences = 0;
+    for (int y = 0; y < a.height(); y++) {
+        for (int x = 0; x < a.width(); x++) {
+            if (*a.getAddr32(x, y) != *b.getAddr32(x, y))
+                differences++;
+        }
+    }
+    return differences;
+}
+
+static void expectSameDrawing(const Recording* recording, SkData* data)
+{
+    SerializedRecording* serialized = SerializedRecording::create(data);
+    ASSERT_TRUE(serialized);
+    SkBitmap expected;
+    SkBitmap actual;
+    drawTiled(recording, expected);
+    drawTiled(serialized, actual);
+    EXPECT_EQ(compare(expected, actual), 0);
+    serialized->unref();
+}
+
+static SkData* serializeEmptyRecording()
+{
+    Recording* recording = new Recording();
+    {
+        // Nothing drawn, only the root canvas state is recorded
+        PlatformGraphicsContextRecording context(recording);
+    }
+    SkData* data = serialize(recording);
+    recording->unref();
+    return data;
+}
+
+TEST(SerializedRecordingTest, EmptyRecording) {
+    SkData* data = serializeEmptyRecording();
+    ASSERT_TRUE(data);
+    SerializedRecording* recording = SerializedRecording::create(data);
+    ASSERT_TRUE(recording);
+    EXPECT_EQ(recording->operationCount(), 0u);
+    EXPECT_EQ(recording->bitmapCount(), 0u);
+    EXPECT_EQ(recording->byteSize(), data->size());
+
+    SkBitmap bitmap;
+    bitmap.setConfig(SkBitmap::kARGB_8888_Config, 16, 16);
+    bitmap.allocPixels();
+    bitmap.eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(bitmap);
+    recording->draw(&canvas);
+    EXPECT_EQ(canvas.getSaveCount(), 1);
+    EXPECT_EQ(*bitmap.getAddr32(8, 8), SK_ColorWHITE);
+
+    recording->unref();
+    data->unref();
+}
+
+TEST(SerializedRecordingTest, DrawsLikeTheRecording) {
+    Recording* recording = record(paintScene);
+    SkData* data = serialize(recording);
+    ASSERT_TRUE(data);
+
+    SerializedRecording* serialized = SerializedRecording::create(data);
+    ASSERT_TRUE(serialized);
+    EXPECT_GT(serialized->operationCount(), 0u);
+    // The two red images are written once
+    EXPECT_EQ(serialized->bitmapCount(), 2u);
+    serialized->unref();
+
+    expectSameDrawing(recording, data);
+    data->unref();
+    recording->unref();
+}
+
+TEST(SerializedRecordingTest, SplicesDrawLikeTheRecording) {
+    Recording* recording = record(paintScene);
+    static const IntRect areas[] = {
+        IntRect(100, 100, 200, 200),
+        IntRect(250, 240, 200, 100),
+    };
+    for (size_t i = 0; i < sizeof(areas) / sizeof(areas[0]); i++) {
+        Recording* splice = new Recording();
+        {
+            PlatformGraphicsContextRecording context(splice, recording, areas[i]);
+            context.fillRect(FloatRect(0, 0, kPageWidth, kPageHeight), Color(0, 90 * i, 255, 200));
+            paintScene(&context);
+        }
+        recording->unref();
+        recording = splice;
+    }
+
+    SkData* data = serialize(recording);
+    ASSERT_TRUE(data);
+    expectSameDrawing(recording, data);
+    data->unref();
+    recording->unref();
+}
+
+// Draws like PicturePile, each recording over the ones before it
+class Pile {
+public:
+    Pile(const Vector<const Recording*>& recordings, const Vector<IntRect>& areas)
+        : m_recordings(recordings), m_areas(areas) {}
+
+    void draw(SkCanvas* canvas) const {
+        for (size_t i = 0; i < m_recordings.size(); i++) {
+            canvas->save();
+            canvas->clipRect(m_areas[i]);
+            for (size_t j = i + 1; j < m_recordings.size(); j++)
+                canvas->clipRect(m_areas[j], SkRegion::kDifference_Op);
+            m_recordings[i]->draw(canvas);
+            canvas->restore();
+        }
+    }
+
+private:
+    const Vector<const Recording*>& m_recordings;
+    const Vector<IntRect>& m_areas;
+};
+
+TEST(SerializedRecordingTest, PilesDrawLikePicturePile) {
+    Recording* page = record(paintScene);
+    Recording* update = new Recording();
+    {
+        PlatformGraphicsContextRecording context(update);
+        context.fillRect(FloatRect(0, 0, kPageWidth, kPageHeight), Color(0, 0, 0, 60));
+        paintScene(&context);
+    }
+    Vector<const Recording*> recordings;
+    Vector<IntRect> areas;
+    recordings.append(page);
+    areas.append(IntRect(0, 0, kPageWidth, kPageHeight));
+    recordings.append(update);
+    areas.append(IntRect(200, 150, 250, 200));
+
+    SkDynamicMemoryWStream stream;
+    ASSERT_TRUE(Recording::serialize(recordings, areas, &stream));
+    SkData* data = stream.copyToData();
+    SerializedRecording* serialized = SerializedRecording::create(data);
+    ASSERT_TRUE(serialized);
+    Pile pile(recordings, areas);
+    SkBitmap expected;
+    SkBitmap actual;
+    drawTiled(&pile, expected);
+    drawTiled(serialized, actual);
+    EXPECT_EQ(compare(expected, actual), 0);
+
+    serialized->unref();
+    data->unref();
+    page->unref();
+    update->unref();
+}
+
+static SkData* copyWithWord(SkData* data, size_t word, uint32_t value)
+{
+    char* copy = static_cast<char*>(malloc(data->size()));
+    memcpy(copy, data->data(), data->size());
+    reinterpret_cast<uint32_t*>(copy)[word] = value;
+    return SkData::NewFromMalloc(copy, data->size());
+}
+
+TEST(SerializedRecordingTest, RejectsInvalidData) {
+    SkData* data = serializeEmptyRecording();
+    ASSERT_TRUE(data);
+
+    // Every truncation is caught when parsing
+    for (size_t size = 0; size < data->size(); size += 4) {
+        SkData* truncated = SkData::NewWithCopy(data->data(), size);
+        EXPECT_FALSE(SerializedRecording::create(truncated));
+        truncated->unref();
+    }
+
+    // So is another format or version
+    for (size_t word = 0; word < 2; word++) {
+        uint32_t value = static_cast<const uint32_t*>(data->data())[word] ^ 0x1000;
+        SkData* modified = copyWithWord(data, word, value);
+        EXPECT_FALSE(SerializedRecording::create(modified));
+        modified->unref();
+    }
+    data->unref();
+}
+
+TEST(SerializedRecordingTest, RejectsInvalidBitmaps) {
+    Recording* recording = record(paintScene);
+    SkData* data = serialize(recording);
+    recording->unref();
+    ASSERT_TRUE(data);
+
+    // Finds the BitmapRecords by their size
+    const uint32_t* words = static_cast<const uint32_t*>(data->data());
+    size_t count = data->size() / sizeof(uint32_t);
+    size_t found = 0;
+    for (size_t i = 1; i + 1 < count; i++) {
+        if (words[i] != static_cast<uint32_t>(kImageWidth)
+            || words[i + 1] != static_cast<uint32_t>(kImageHeight)
+            || words[i - 1] != SkBitmap::kARGB_8888_Config)
+            continue;
+        found++;
+        // Index8 needs a color table, which isn't serialized
+        SkData* modified = copyWithWord(data, i - 1, SkBitmap::kIndex8_Config);
+        EXPECT_FALSE(SerializedRecording::create(modified));
+        modified->unref();
+        // Rows must hold a whole line of pixels
+        modified = copyWithWord(data, i + 2, kImageWidth);
+        EXPECT_FALSE(SerializedRecording::create(modified));
+        modified->unref();
+    }
+    EXPECT_EQ(found, 2u);
+    data->unref();
+}
+
+TEST(SerializedRecordingTest, SurvivesCorruptOperations) {
+    Recording* recording = record(paintScene);
+    SkData* data = serialize(recording);
+    recording->unref();
+    ASSERT_TRUE(data);
+
+    // The operation data is followed by the pixels of the two images, each
+    // block starting with its size
+    const uint32_t* words = static_cast<const uint32_t*>(data->data());
+    size_t pixelDataSize = 2 * SkAlign4(kImageWidth * kImageHeight * sizeof(SkPMColor));
+    size_t pixelData = (data->size() - pixelDataSize) / sizeof(uint32_t) - 1;
+    ASSERT_EQ(words[pixelData], pixelDataSize);
+    size_t operationData = pixelData - 1;
+    while (operationData && words[operationData] != (pixelData - operationData - 1) * sizeof(uint32_t))
+        operationData--;
+    ASSERT_TRUE(operationData);
+    ASSERT_LT(operationData + 1, pixelData);
+
+    // Whatever a word of an operation is changed to, the data is either
+    // rejected when parsing or drawn without reading outside of it
+    static const uint32_t values[] = { 0, 1, 0x7fffffff, 0xffffffff };
+    SkBitmap bitmap;
+    bitmap.setConfig(SkBitmap::kARGB_8888_Config, kPageWidth, kPageHeight);
+    bitmap.allocPixels();
+    SkCanvas canvas(bitmap);
+    for (size_t word = operationData + 1; word < pixelData; word++) {
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            SkData* modified = copyWithWord(data, word, values[i]);
+            SerializedRecording* serialized = SerializedRecording::create(modified);
+            if (serialized) {
+                serialized->draw(&canvas);
+                serialized->unref();
+            }
+            modified->unref();
+        }
+    }
+    data->unref();
+}
+
+TEST(SerializedRecordingTest, SurvivesCorruptTree) {
+    Recording* recording = record(paintScene);
+    SkData* data = serialize(recording);
+    recording->unref();
+    ASSERT_TRUE(data);
+    SerializedRecording* serialized = SerializedRecording::create(data);
+    ASSERT_TRUE(serialized);
+    uint32_t elementCount = serialized->operationCount();
+    serialized->unref();
+
+    // The tree starts with its element count, its root, which is its last
+    // node, and its node count
+    const uint32_t* words = static_cast<const uint32_t*>(data->data());
+    size_t count = data->size() / sizeof(uint32_t);
+    size_t tree = 0;
+    while (tree + 2 < count && (words[tree] != elementCount || words[tree + 2] <= elementCount
+                                || words[tree + 1] != words[tree + 2] - 1))
+        tree++;
+    ASSERT_LT(tree + 2, count);
+    uint32_t nodeCount = words[tree + 2];
+    size_t treeEnd = tree + 3 + 4 * nodeCount + 2 * (nodeCount - elementCount) + elementCount;
+    ASSERT_LE(treeEnd, count);
+
+    // Whatever a word of the tree is changed to, the data is either rejected
+    // when parsing or drawn without looping or reading outside of the tree
+    SkBitmap bitmap;
+    for (size_t word = tree; word < treeEnd; word++) {
+        const uint32_t values[] = { 0, 1, words[word] - 1, words[word] + 1,
+                                    nodeCount, 0xffffffff };
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            SkData* modified = copyWithWord(data, word, values[i]);
+            serialized = SerializedRecording::create(modified);
+            if (serialized) {
+                drawTiled(serialized, bitmap);
+                serialized->unref();
+            }
+            modified->unref();
+        }
+    }
+    data->unref();
+}
+
+} // namespace WebCore
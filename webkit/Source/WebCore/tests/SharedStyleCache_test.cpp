@@ -0,0 +1,164 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "CSSStyleSelector.h"
+#include "Element.h"
+#include "ExceptionCode.h"
+#include "HTMLDocument.h"
+#include "HTMLNames.h"
+#include "KURL.h"
+#include "QualifiedName.h"
+#include "RenderStyle.h"
+
+#include <wtf/MainThread.h>
+#include <wtf/Threading.h>
+
+#ifdef ANDROID_SHARED_STYLE_CACHE
+
+namespace WebCore {
+
+using namespace HTMLNames;
+
+// The elements have no renderers, so the sibling and cousin search of
+// locateSharedStyle() never finds a style to share, only the cache does.
+class SharedStyleCacheTest : public testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        // Same as Frame's constructor
+        WTF::initializeThreading();
+        WTF::initializeMainThread();
+        AtomicString::init();
+        HTMLNames::init();
+        QualifiedName::init();
+    }
+
+    virtual void SetUp()
+    {
+        ExceptionCode ec = 0;
+        m_document = HTMLDocument::create(0, KURL());
+        RefPtr<Element> html = m_document->createElement(htmlTag, false);
+        m_document->appendChild(html, ec);
+        m_body = m_document->createElement(bodyTag, false);
+        html->appendChild(m_body, ec);
+
+        m_selector = m_document->styleSelector();
+        m_documentStyle = CSSStyleSelector::styleForDocument(m_document.get());
+        m_bodyStyle = m_selector->styleForElement(m_body.get(), m_documentStyle.get(), false);
+    }
+
+    virtual void TearDown()
+    {
+        m_bodyStyle = 0;
+        m_documentStyle = 0;
+        m_body = 0;
+        m_document = 0;
+    }
+
+    // Appends a div of the class to a new section of the body, so that no
+    // two divs are siblings or cousins
+    PassRefPtr<Element> createDistantDiv(const AtomicString& className)
+    {
+        ExceptionCode ec = 0;
+        RefPtr<Element> section = m_document->createElement(sectionTag, false);
+        m_body->appendChild(section, ec);
+        RefPtr<Element> div = m_document->createElement(divTag, false);
+        div->setAttribute(classAttr, className, ec);
+        section->appendChild(div, ec);
+        return div.release();
+    }
+
+    PassRefPtr<RenderStyle> styleFor(Element* element, RenderStyle* parentStyle)
+    {
+        return m_selector->styleForElement(element, parentStyle);
+    }
+
+    RefPtr<HTMLDocument> m_document;
+    RefPtr<Element> m_body;
+    CSSStyleSelector* m_selector;
+    RefPtr<RenderStyle> m_documentStyle;
+    RefPtr<RenderStyle> m_bodyStyle;
+};
+
+TEST_F(SharedStyleCacheTest, SharesBetweenDistantElements) {
+    RefPtr<Element> first = createDistantDiv("item");
+    RefPtr<Element> second = createDistantDiv("item");
+    unsigned hits = m_selector->sharedStyleCacheHits();
+
+    RefPtr<RenderStyle> firstStyle = styleFor(first.get(), m_bodyStyle.get());
+    RefPtr<RenderStyle> secondStyle = styleFor(second.get(), m_bodyStyle.get());
+    EXPECT_EQ(firstStyle.get(), secondStyle.get());
+    EXPECT_EQ(hits + 1, m_selector->sharedStyleCacheHits());
+}
+
+TEST_F(SharedStyleCacheTest, KeysOnClassAndParentStyle) {
+    RefPtr<Element> item = createDistantDiv("item");
+    RefPtr<Element> other = createDistantDiv("other");
+    RefPtr<Element> nested = createDistantDiv("item");
+    unsigned hits = m_selector->sharedStyleCacheHits();
+
+    RefPtr<RenderStyle> itemStyle = styleFor(item.get(), m_bodyStyle.get());
+    RefPtr<RenderStyle> otherStyle = styleFor(other.get(), m_bodyStyle.get());
+    EXPECT_NE(itemStyle.get(), otherStyle.get());
+
+    // An equal but distinct parent style is not shared with
+    RefPtr<RenderStyle> parentStyle = RenderStyle::clone(m_bodyStyle.get());
+    RefPtr<RenderStyle> nestedStyle = styleFor(nested.get(), parentStyle.get());
+    EXPECT_NE(itemStyle.get(), nestedStyle.get());
+    EXPECT_EQ(hits, m_selector->sharedStyleCacheHits());
+}
+
+TEST_F(SharedStyleCacheTest, SkipsInlineStyles) {
+    RefPtr<Element> first = createDistantDiv("item");
+    RefPtr<Element> second = createDistantDiv("item");
+    ExceptionCode ec = 0;
+    second->setAttribute(styleAttr, "color: red", ec);
+    unsigned hits = m_selector->sharedStyleCacheHits();
+
+    RefPtr<RenderStyle> firstStyle = styleFor(first.get(), m_bodyStyle.get());
+    RefPtr<RenderStyle> secondStyle = styleFor(second.get(), m_bodyStyle.get());
+    EXPECT_NE(firstStyle.get(), secondStyle.get());
+    EXPECT_EQ(hits, m_selector->sharedStyleCacheHits());
+}
+
+TEST_F(SharedStyleCacheTest, ClearForgetsStyles) {
+    RefPtr<Element> first = createDistantDiv("item");
+    RefPtr<Element> second = createDistantDiv("item");
+
+    RefPtr<RenderStyle> firstStyle = styleFor(first.get(), m_bodyStyle.get());
+    m_selector->clearSharedStyleCache();
+    unsigned misses = m_selector->sharedStyleCacheMisses();
+    RefPtr<RenderStyle> secondStyle = styleFor(second.get(), m_bodyStyle.get());
+    EXPECT_NE(firstStyle.get(), secondStyle.get());
+    EXPECT_EQ(misses + 1, m_selector->sharedStyleCacheMisses());
+}
+
+} // namespace WebCore
+
+#endif // ANDROID_SHARED_STYLE_CACHE
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include <wtf/text/AtomicString.h>
+#include <wtf/text/StringBuilder.h>
+#include <wtf/text/StringHash.h>
+#include <wtf/text/WTFString.h>
+
+namespace WTF {
+
+static const UChar helloWorld[] = { 'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd' };
+
+TEST(StringImpl8BitTest, LiteralsAre8Bit) {
+    String latin1("hello world");
+    String utf16(helloWorld, 11);
+    EXPECT_TRUE(latin1.is8Bit());
+    EXPECT_FALSE(utf16.is8Bit());
+    EXPECT_TRUE(latin1 == utf16);
+    EXPECT_EQ(latin1.impl()->hash(), utf16.impl()->hash());
+    EXPECT_TRUE(StringHash::equal(latin1.impl(), utf16.impl()));
+    EXPECT_EQ(latin1[6], 'w');
+}
+
+TEST(StringImpl8BitTest, WidenOnDemand) {
+    String string("hello world");
+    const UChar* characters = string.characters();
+    ASSERT_TRUE(characters);
+    EXPECT_EQ(0, memcmp(characters, helloWorld, sizeof(helloWorld)));
+    // The widened copy is kept, and the string stays 8-bit
+    EXPECT_EQ(characters, string.characters());
+    EXPECT_TRUE(string.is8Bit());
+}
+
+TEST(StringImpl8BitTest, OperationsKeepWidth) {
+    String string("Hello World");
+    EXPECT_TRUE(string.substring(6).is8Bit());
+    EXPECT_TRUE(string.substring(6) == "World");
+    EXPECT_TRUE(string.lower().is8Bit());
+    EXPECT_TRUE(string.lower() == "hello world");
+    EXPECT_TRUE(String("  x ").stripWhiteSpace() == "x");
+    EXPECT_TRUE(string.threadsafeCopy().is8Bit());
+    EXPECT_TRUE(string.crossThreadString() == string);
+    EXPECT_EQ(string.find('W'), 6u);
+    EXPECT_EQ(string.find(0x3b1), notFound);
+    EXPECT_EQ(CaseFoldingHash::hash(String("HELLO").impl()),
+              CaseFoldingHash::hash(String(helloWorld, 5).impl()));
+}
+
+TEST(StringImpl8BitTest, AtomicStringsCompact) {
+    AtomicString fromUChars(helloWorld, 5);
+    AtomicString fromLiteral("hello");
+    EXPECT_TRUE(fromUChars.impl()->is8Bit());
+    EXPECT_EQ(fromUChars.impl(), fromLiteral.impl());
+
+    const UChar cafe[] = { 'c', 'a', 'f', 0xe9 };
+    AtomicString latin1(cafe, 4);
+    EXPECT_TRUE(latin1.impl()->is8Bit());
+    EXPECT_EQ(latin1.impl(), AtomicString::fromUTF8("caf\xc3\xa9").impl());
+
+    const UChar alpha[] = { 'a', 0x3b1 };
+    AtomicString utf16(alpha, 2);
+    EXPECT_FALSE(utf16.impl()->is8Bit());
+}
+
+TEST(StringImpl8BitTest, StringBuilderUpConverts) {
+    StringBuilder builder;
+    builder.append("abc");
+    builder.append('d');
+    builder.append(String("ef"));
+    String latin1 = builder.toStringPreserveCapacity();
+    EXPECT_TRUE(latin1.is8Bit());
+    EXPECT_TRUE(latin1 == "abcdef");
+
+    builder.append(static_cast<UChar>(0x3b1));
+    builder.append("gh");
+    String utf16 = builder.toString();
+    EXPECT_FALSE(utf16.is8Bit());
+    EXPECT_EQ(utf16.length(), 9u);
+    EXPECT_EQ(utf16[0], 'a');
+    EXPECT_EQ(utf16[6], 0x3b1);
+    EXPECT_EQ(utf16[8], 'h');
+    // The string taken before the up conversion is unchanged
+    EXPECT_TRUE(latin1 == "abcdef");
+}
+
+} // namespace WTF
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include "TexturePool.h"
+
+namespace WebCore {
+
+struct TestTexture {
+    int m_width;
+    int m_height;
+    unsigned long long m_lastUsed;
+    bool m_recycled;
+};
+
+// Keeps the textures alive after they are destroyed so the tests can check
+// which ones were
+class TestAllocator : public TexturePool<TestTexture>::Allocator {
+public:
+    TestAllocator() : m_created(0), m_destroyed(0) {}
+
+    ~TestAllocator()
+    {
+        for (size_t i = 0; i < m_textures.size(); i++)
+            delete m_textures[i];
+    }
+
+    virtual TestTexture* createTexture(int width, int height)
+    {
+        TestTexture* texture = new TestTexture();
+        texture->m_width = width;
+        texture->m_height = height;
+        texture->m_lastUsed = 0;
+        texture->m_recycled = false;
+        m_textures.append(texture);
+        m_created++;
+        return texture;
+    }
+
+    virtual void destroyTexture(TestTexture* texture) { m_destroyed++; }
+    virtual void recycleTexture(TestTexture* texture) { texture->m_recycled = true; }
+    virtual unsigned long long lastUsed(TestTexture* texture) { return texture->m_lastUsed; }
+
+    int m_created;
+    int m_destroyed;
+    Vector<TestTexture*> m_textures;
+};
+
+typedef TexturePool<TestTexture> TestPool;
+
+static const size_t s_tileBytes = 256 * 256 * 4;
+
+TEST(TexturePoolTest, SizeClasses) {
+    EXPECT_EQ(TestPool::sizeClassBytes(256, 256), s_tileBytes);
+    EXPECT_EQ(TestPool::sizeClassBytes(200, 256), s_tileBytes);
+    EXPECT_EQ(TestPool::sizeClassBytes(257, 256), 2 * s_tileBytes);
+    EXPECT_EQ(TestPool::sizeClassBytes(1, 1), 4u);
+}
+
+TEST(TexturePoolTest, GrowsWithinBudget) {
+    TestAllocator allocator;
+    TestPool pool(&allocator, 10 * s_tileBytes);
+
+    EXPECT_EQ(pool.grow(TestPool::BaseUsage, 6, 256, 256, 1), 6u);
+    EXPECT_EQ(pool.grow(TestPool::LayerUsage, 3, 256, 256, 1), 3u);
+    EXPECT_EQ(pool.usedBytes(), 9 * s_tileBytes);
+
+    // All textures were just used, nothing can make room
+    for (size_t i = 0; i < allocator.m_textures.size(); i++)
+        allocator.m_textures[i]->m_lastUsed = 5;
+    EXPECT_EQ(pool.grow(TestPool::BaseUsage, 12, 256, 256, 5), 7u);
+    EXPECT_EQ(pool.usedBytes(), 10 * s_tileBytes);
+    EXPECT_EQ(allocator.m_created, 10);
+    EXPECT_EQ(allocator.m_destroyed, 0);
+
+    // Growing to fewer textures is a no-op
+    EXPECT_EQ(pool.grow(TestPool::LayerUsage, 1, 256, 256, 5), 3u);
+}
+
+TEST(TexturePoolTest, RecyclesLeastRecentlyUsedOfOtherUsage) {
+    TestAllocator allocator;
+    TestPool pool(&allocator, 4 * s_tileBytes);
+
+    pool.grow(TestPool::BaseUsage, 2, 256, 256, 1);
+    pool.grow(TestPool::LayerUsage, 2, 256, 256, 1);
+    Vector<TestTexture*> layers;
+    pool.textures(TestPool::LayerUsage, layers);
+    layers[0]->m_lastUsed = 3;
+    layers[1]->m_lastUsed = 2;
+
+    // The layer texture used at 2 is recycled, the one used at 3 is spared
+    EXPECT_EQ(pool.grow(TestPool::BaseUsage, 4, 256, 256, 3), 3u);
+    EXPECT_TRUE(layers[1]->m_recycled);
+    EXPECT_FALSE(layers[0]->m_recycled);
+    EXPECT_EQ(pool.count(TestPool::LayerUsage), 1u);
+    EXPECT_EQ(allocator.m_created, 4);
+    EXPECT_EQ(pool.usedBytes(), 4 * s_tileBytes);
+
+    Vector<TestTexture*> bases;
+    pool.textures(TestPool::BaseUsage, bases);
+    EXPECT_NE(bases.find(layers[1]), notFound);
+}
+
+TEST(TexturePoolTest, DestroysOtherSizeClasses) {
+    TestAllocator allocator;
+    TestPool pool(&allocator, 4 * s_tileBytes);
+
+    // One texture of twice the size of a tile
+    pool.grow(TestPool::LayerUsage, 1, 512, 256, 1);
+    pool.grow(TestPool::BaseUsage, 2, 256, 256, 1);
+    EXPECT_EQ(pool.grow(TestPool::BaseUsage, 4, 256, 256, 1), 4u);
+    EXPECT_EQ(allocator.m_destroyed, 1);
+    EXPECT_EQ(pool.count(TestPool::LayerUsage), 0u);
+    EXPECT_EQ(pool.usedBytes(), 4 * s_tileBytes);
+}
+
+TEST(TexturePoolTest, TrimsToTarget) {
+    TestAllocator allocator;
+    TestPool pool(&allocator, 8 * s_tileBytes);
+
+    pool.grow(TestPool::BaseUsage, 4, 256, 256, 1);
+    pool.grow(TestPool::LayerUsage, 4, 256, 256, 1);
+    for (size_t i = 0; i < allocator.m_textures.size(); i++)
+        allocator.m_textures[i]->m_lastUsed = i + 1;
+
+    // Textures used at 1, 2 and 3 are destroyed first
+    EXPECT_EQ(pool.trim(5 * s_tileBytes, TestPool::s_spareNone), 3u);
+    EXPECT_FALSE(pool.contains(allocator.m_textures[0]));
+    EXPECT_FALSE(pool.contains(allocator.m_textures[2]));
+    EXPECT_TRUE(pool.contains(allocator.m_textures[3]));
+
+    // Textures used since 7 are spared
+    EXPECT_EQ(pool.trim(0, 7), 3u);
+    EXPECT_EQ(pool.usedBytes(), 2 * s_tileBytes);
+    EXPECT_EQ(pool.count(TestPool::LayerUsage), 2u);
+
+    EXPECT_EQ(pool.trim(0, TestPool::s_spareNone), 2u);
+    EXPECT_EQ(pool.usedBytes(), 0u);
+    EXPECT_EQ(allocator.m_destroyed, 8);
+}
+
+TEST(TexturePoolTest, ShrinkingBudgetTrims) {
+    TestAllocator allocator;
+    TestPool pool(&allocator, 8 * s_tileBytes);
+
+    pool.grow(TestPool::BaseUsage, 8, 256, 256, 1);
+    allocator.m_textures[0]->m_lastUsed = 5;
+    allocator.m_textures[1]->m_lastUsed = 5;
+
+    // Textures used since 5 are spared, even below the budget
+    pool.setBudget(1 * s_tileBytes, 5);
+    EXPECT_EQ(pool.usedBytes(), 2 * s_tileBytes);
+    EXPECT_TRUE(pool.contains(allocator.m_textures[0]));
+    EXPECT_TRUE(pool.contains(allocator.m_textures[1]));
+
+    // Once they age out, growing makes room with them
+    EXPECT_EQ(pool.grow(TestPool::LayerUsage, 1, 256, 256, 6), 1u);
+    EXPECT_EQ(pool.usedBytes(), 1 * s_tileBytes);
+    EXPECT_EQ(pool.count(TestPool::BaseUsage), 0u);
+}
+
+TEST(TexturePoolTest, ReleasesUsage) {
+    TestAllocator allocator;
+    TestPool pool(&allocator, 8 * s_tileBytes);
+
+    pool.grow(TestPool::BaseUsage, 2, 256, 256, 1);
+    pool.grow(TestPool::LayerUsage, 3, 256, 256, 1);
+    allocator.m_textures[2]->m_lastUsed = 4;
+
+    EXPECT_EQ(pool.release(TestPool::LayerUsage, 4), 2u);
+    EXPECT_EQ(pool.count(TestPool::LayerUsage), 1u);
+    EXPECT_EQ(pool.count(TestPool::BaseUsage), 2u);
+    EXPECT_EQ(pool.release(TestPool::LayerUsage, TestPool::s_spareNone), 1u);
+    EXPECT_EQ(pool.usedBytes(), 2 * s_tileBytes);
+}
+
+} // namespace WebCore
@@ -0,0 +1,24 @@
+# Build the DOM creation benchmark, see DomCreateBench.cpp.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    DomCreateBench.cpp
+
+# The DOM classes are not exported from libwebcore.so, so link the static
+# library with the same flags and includes as libwebcore.
+LOCAL_CFLAGS := $(WEBKIT_CFLAGS)
+LOCAL_CPPFLAGS := $(WEBKIT_CPPFLAGS)
+LOCAL_C_INCLUDES := $(WEBKIT_C_INCLUDES)
+LOCAL_LDLIBS := $(WEBKIT_LDLIBS)
+LOCAL_SHARED_LIBRARIES := $(WEBKIT_SHARED_LIBRARIES)
+LOCAL_STATIC_LIBRARIES := libwebcore $(WEBKIT_STATIC_LIBRARIES)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(filter %.h, $(WEBKIT_GENERATED_SOURCES))
+
+# Count the allocations WebCore and WTF make, see the __wrap_ functions
+LOCAL_LDFLAGS := -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=memalign,--wrap=free
+
+LOCAL_MODULE := domcreate
+LOCAL_MODULE_TAGS := eng tests
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// DOM creation benchmark.
+//
+// Builds documents the way a page load does, once through the DOM API
+// (createElement, setAttribute, appendChild, with a RenderStyle per element
+// as style recalc would make) and once through the HTML parser (innerHTML),
+// and then tears them down again. Run it once as is and once with -m, which
+// turns DocumentArena off so that every node and style is its own malloc, to
+// compare the two:
+//   domcreate > arena.txt
+//   domcreate -m > malloc.txt
+//   bench_compare.py -o malloc.txt -n arena.txt
+// Besides the times, each bench reports the number of nodes and styles
+// allocated and the system mallocs made for them, the mallocs and frees made
+// by all of WebCore and WTF (strings, vectors, attribute maps as well), and
+// the RSS after building the document and after tearing it down.
+
+#define LOG_TAG "domcreate"
+
+#include "config.h"
+
+#include "DocumentArena.h"
+#include "Element.h"
+#include "ExceptionCode.h"
+#include "HTMLDocument.h"
+#include "HTMLElement.h"
+#include "HTMLNames.h"
+#include "KURL.h"
+#include "QualifiedName.h"
+#include "RenderStyle.h"
+#include "Text.h"
+
+#include <cutils/atomic.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <wtf/MainThread.h>
+#include <wtf/Threading.h>
+#include <wtf/Vector.h>
+#include <wtf/text/CString.h>
+#include <wtf/text/StringBuilder.h>
+
+#define DEFAULT_ELEMENTS 20000
+#define DEFAULT_REPEAT 5
+
+using namespace WebCore;
+using namespace HTMLNames;
+
+// WebCore and WTF are linked in statically, and Android.mk wraps their calls
+// to the allocator with these, which count every system malloc and free they
+// make, whether through fastMalloc or not. Calls from shared libraries (Skia,
+// ICU) are not counted.
+static volatile int32_t gMallocs = 0;
+static volatile int32_t gFrees = 0;
+
+extern "C" {
+
+void* __real_malloc(size_t);
+void* __real_calloc(size_t, size_t);
+void* __real_realloc(void*, size_t);
+void* __real_memalign(size_t, size_t);
+void __real_free(void*);
+
+void* __wrap_malloc(size_t size)
+{
+    android_atomic_inc(&gMallocs);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    android_atomic_inc(&gMallocs);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* p, size_t size)
+{
+    if (!p)
+        android_atomic_inc(&gMallocs);
+    return __real_realloc(p, size);
+}
+
+void* __wrap_memalign(size_t alignment, size_t size)
+{
+    android_atomic_inc(&gMallocs);
+    return __real_memalign(alignment, size);
+}
+
+void __wrap_free(void* p)
+{
+    if (p)
+        android_atomic_inc(&gFrees);
+    __real_free(p);
+}
+
+} // extern "C"
+
+struct BenchResult {
+    Vector<double> buildTimes;
+    Vector<double> teardownTimes;
+    size_t objects;
+    size_t objectMallocs;
+    size_t mallocs;
+    size_t frees;
+    size_t builtKB;
+    size_t tornDownKB;
+};
+
+static double currentMS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static size_t residentKB()
+{
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    if (fscanf(file, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(file);
+    return resident * getpagesize() / 1024;
+}
+
+static PassRefPtr<HTMLDocument> createDocument()
+{
+    RefPtr<HTMLDocument> document = HTMLDocument::create(0, KURL());
+    ExceptionCode ec = 0;
+    RefPtr<Element> html = document->createElement(htmlTag, false);
+    document->appendChild(html, ec);
+    RefPtr<Element> body = document->createElement(bodyTag, false);
+    html->appendChild(body, ec);
+    return document.release();
+}
+
+// A list of items, each a div holding a span and some text, with a style for
+// every element
+static void buildWithDOM(HTMLDocument* document, int elements, Vector<RefPtr<RenderStyle> >& styles)
+{
+    ExceptionCode ec = 0;
+    Element* body = document->body();
+    DEFINE_STATIC_LOCAL(AtomicString, itemClass, ("item"));
+    for (int i = 0; i < elements; i += 2) {
+        RefPtr<Element> item = document->createElement(divTag, false);
+        item->setAttribute(classAttr, itemClass, ec);
+        RefPtr<Element> label = document->createElement(spanTag, false);
+        label->appendChild(document->createTextNode(String::number(i)), ec);
+        item->appendChild(label, ec);
+        item->appendChild(document->createTextNode("item text"), ec);
+        body->appendChild(item, ec);
+
+        DocumentArena::Scope arenaScope(document->arena());
+        styles.append(RenderStyle::create());
+        styles.append(RenderStyle::create());
+    }
+}
+
+static String createMarkup(int elements)
+{
+    StringBuilder markup;
+    for (int i = 0; i < elements; i += 2) {
+        markup.append("<div class=item><span>");
+        markup.append(String::number(i));
+        markup.append("</span>item text</div>");
+    }
+    return markup.toString();
+}
+
+static void buildWithParser(HTMLDocument* document, const String& markup)
+{
+    ExceptionCode ec = 0;
+    static_cast<HTMLElement*>(document->body())->setInnerHTML(markup, ec);
+}
+
+static void runBench(int elements, int repeat, bool parse, BenchResult& result)
+{
+    String markup = parse ? createMarkup(elements) : String();
+    DocumentArena::Stats before = DocumentArena::stats();
+    int32_t mallocsBefore = android_atomic_acquire_load(&gMallocs);
+    int32_t freesBefore = android_atomic_acquire_load(&gFrees);
+    result.builtKB = 0;
+    result.tornDownKB = 0;
+    for (int r = 0; r < repeat; r++) {
+        double start = currentMS();
+        RefPtr<HTMLDocument> document = createDocument();
+        Vector<RefPtr<RenderStyle> > styles;
+        if (parse)
+            buildWithParser(document.get(), markup);
+        else
+            buildWithDOM(document.get(), elements, styles);
+        result.buildTimes.append(currentMS() - start);
+        result.builtKB = std::max(result.builtKB, residentKB());
+
+        start = currentMS();
+        styles.clear();
+        document = 0;
+        result.teardownTimes.append(currentMS() - start);
+        result.tornDownKB = std::max(result.tornDownKB, residentKB());
+    }
+    const DocumentArena::Stats& after = DocumentArena::stats();
+    result.objects = (after.totalObjects - before.totalObjects) / repeat;
+    result.objectMallocs = (after.systemMallocs - before.systemMallocs) / repeat;
+    result.mallocs = (android_atomic_acquire_load(&gMallocs) - mallocsBefore) / repeat;
+    result.frees = (android_atomic_acquire_load(&gFrees) - freesBefore) / repeat;
+}
+
+static void printTimes(const char* name, const char* mode, int elements, const Vector<double>& times)
+{
+    printf("running bench [%d 1] domcreate_%s_%s\n", elements, name, mode);
+    printf("  8888: msecs = ");
+    for (size_t r = 0; r < times.size(); r++)
+        printf(r ? ",%.2f" : "%.2f", times[r]);
+    printf("\n");
+}
+
+static void printResult(const char* name, const char* mode, int elements, const BenchResult& result)
+{
+    printTimes(name, mode, elements, result.buildTimes);
+    // With the arena off every object is a malloc, so objects equals object
+    // mallocs. mallocs and frees count everything WebCore allocated.
+    printf("  objects %zu object mallocs %zu mallocs %zu frees %zu rss built %zuKB torn down %zuKB\n",
+           result.objects, result.objectMallocs, result.mallocs, result.frees, result.builtKB, result.tornDownKB);
+    String teardown = String(name) + "_teardown";
+    printTimes(teardown.utf8().data(), mode, elements, result.teardownTimes);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  -n <count>        elements per document (default %d)\n", DEFAULT_ELEMENTS);
+    fprintf(stderr, "  -r <count>        repeat count (default %d)\n", DEFAULT_REPEAT);
+    fprintf(stderr, "  -m                allocate every node and style with malloc\n");
+}
+
+int main(int argc, char** argv)
+{
+    int elements = DEFAULT_ELEMENTS;
+    int repeat = DEFAULT_REPEAT;
+    bool useMalloc = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:mh")) != -1) {
+        switch (opt) {
+        case 'n':
+            elements = atoi(optarg);
+            if (elements <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'r':
+            repeat = atoi(optarg);
+            if (repeat <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'm':
+            useMalloc = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // Before anything allocates a node or a style
+    DocumentArena::setEnabled(!useMalloc);
+
+    // Same as Frame's constructor
+    WTF::initializeThreading();
+    WTF::initializeMainThread();
+    AtomicString::init();
+    HTMLNames::init();
+    QualifiedName::init();
+
+    const char* mode = useMalloc ? "malloc" : "arena";
+    printf("skia bench: tool=domcreate elements=%d repeat=%d mode=%s\n", elements, repeat, mode);
+    printf("rss at start %zuKB\n", residentKB());
+
+    BenchResult dom;
+    runBench(elements, repeat, false, dom);
+    printResult("dom", mode, elements, dom);
+
+    BenchResult parser;
+    runBench(elements, repeat, true, parser);
+    printResult("parse", mode, elements, parser);
+    return 0;
+}
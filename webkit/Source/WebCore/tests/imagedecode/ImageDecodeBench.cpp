@@ -0,0 +1,223 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Image decode benchmark.
+//
+// Decodes a corpus of images the way ImageSource sets them up, with lazily
+// decoding pixel refs, once with the decode done by the first draw on the
+// calling thread (as without ImageDecodeQueue) and once with the decodes
+// queued on ImageDecodeQueue ahead of the first draw.
+//
+// The sync and background msecs are the time spent on the calling thread, i.e.
+// the time the WebCore thread would be stalled. The time it spends waiting for
+// the queue to take more decodes is left out, as a page load doesn't wait. The
+// background_worker msecs are the CPU time the queue's worker spent decoding,
+// so that the work moved off the WebCore thread is not lost from sight. All use
+// the format of skia's bench tool so that builds can be compared with
+// skia/bench/bench_compare.py:
+//   imagedecode *.jpg *.png > old.txt
+//   ... rebuild ...
+//   imagedecode *.jpg *.png > new.txt
+//   bench_compare.py -o old.txt -n new.txt
+// The background bench also reports the wall clock time, waits included, until
+// the queue has decoded everything.
+//
+// It runs on the device: WebCore and its image decoders have no host build.
+
+#define LOG_TAG "imagedecode"
+
+#include "config.h"
+
+#include "ImageDecodeQueue.h"
+#include "SkBitmap.h"
+#include "SkImageRef_GlobalPool.h"
+#include "SkStream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <wtf/Vector.h>
+
+#define DEFAULT_REPEAT 5
+
+// Keeps every decoded image in the pool, so that the first draw after a
+// background decode finds its pixels
+#define POOL_BUDGET (256*1024*1024)
+
+using namespace WebCore;
+
+static double currentMS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static SkStream* readFile(const char* path)
+{
+    SkFILEStream file(path);
+    if (!file.isValid())
+        return 0;
+    size_t length = file.getLength();
+    SkMemoryStream* stream = new SkMemoryStream(length);
+    if (file.read(const_cast<void*>(stream->getMemoryBase()), length) != length) {
+        stream->unref();
+        return 0;
+    }
+    return stream;
+}
+
+static void createRefs(const Vector<SkStream*>& corpus, Vector<SkPixelRef*>& refs)
+{
+    for (size_t i = 0; i < corpus.size(); i++) {
+        corpus[i]->rewind();
+        refs.append(new SkImageRef_GlobalPool(corpus[i], SkBitmap::kARGB_8888_Config));
+    }
+}
+
+static void releaseRefs(Vector<SkPixelRef*>& refs)
+{
+    for (size_t i = 0; i < refs.size(); i++)
+        refs[i]->unref();
+    refs.clear();
+}
+
+// Same as a first draw, which locks the pixels and so decodes them
+static void draw(SkPixelRef* ref)
+{
+    ref->lockPixels();
+    ref->unlockPixels();
+}
+
+static void printTimes(const char* name, const Vector<double>& times)
+{
+    printf("running bench [%zu 1] imagedecode_%s\n", times.size(), name);
+    printf("  8888: msecs = ");
+    for (size_t r = 0; r < times.size(); r++)
+        printf(r ? ",%.2f" : "%.2f", times[r]);
+    printf("\n");
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options] <image> ...\n", name);
+    fprintf(stderr, "  -r <count>        repeat count (default %d)\n", DEFAULT_REPEAT);
+}
+
+int main(int argc, char** argv)
+{
+    int repeat = DEFAULT_REPEAT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:h")) != -1) {
+        switch (opt) {
+        case 'r':
+            repeat = atoi(optarg);
+            if (repeat <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind == argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Vector<SkStream*> corpus;
+    size_t corpusBytes = 0;
+    for (int i = optind; i < argc; i++) {
+        SkStream* stream = readFile(argv[i]);
+        if (!stream) {
+            fprintf(stderr, "Could not read %s\n", argv[i]);
+            return 1;
+        }
+        corpusBytes += stream->getLength();
+        corpus.append(stream);
+    }
+
+    SkImageRef_GlobalPool::SetRAMBudget(POOL_BUDGET);
+    ImageDecodeQueue* queue = ImageDecodeQueue::instance();
+
+    printf("skia bench: tool=imagedecode images=%zu bytes=%zu repeat=%d\n",
+           corpus.size(), corpusBytes, repeat);
+
+    Vector<double> syncTimes;
+    for (int r = 0; r < repeat; r++) {
+        Vector<SkPixelRef*> refs;
+        createRefs(corpus, refs);
+        double before = currentMS();
+        for (size_t i = 0; i < refs.size(); i++)
+            draw(refs[i]);
+        syncTimes.append(currentMS() - before);
+        releaseRefs(refs);
+    }
+    printTimes("sync", syncTimes);
+
+    // The queue only takes maxQueuedDecodes at a time, so the corpus goes in
+    // in batches, the way images arrive over a page load.
+    Vector<double> backgroundTimes;
+    Vector<double> workerTimes;
+    Vector<double> wallTimes;
+    for (int r = 0; r < repeat; r++) {
+        Vector<SkPixelRef*> refs;
+        createRefs(corpus, refs);
+        double callerMS = 0;
+        nsecs_t workerStart = queue->busyTime();
+        double start = currentMS();
+        for (size_t i = 0; i < refs.size(); i++) {
+            if (i && !(i % ImageDecodeQueue::maxQueuedDecodes))
+                queue->waitUntilIdle();
+            double before = currentMS();
+            queue->decode(refs[i], ImageDecodeQueue::Background);
+            callerMS += currentMS() - before;
+        }
+        queue->waitUntilIdle();
+        wallTimes.append(currentMS() - start);
+        workerTimes.append((queue->busyTime() - workerStart) / 1000000.0);
+
+        double before = currentMS();
+        for (size_t i = 0; i < refs.size(); i++)
+            draw(refs[i]);
+        callerMS += currentMS() - before;
+        backgroundTimes.append(callerMS);
+        releaseRefs(refs);
+    }
+    printTimes("background", backgroundTimes);
+    printTimes("background_worker", workerTimes);
+    printf("  wall clock ");
+    for (size_t r = 0; r < wallTimes.size(); r++)
+        printf(r ? ",%.2f" : "%.2f", wallTimes[r]);
+    printf("\n");
+
+    for (size_t i = 0; i < corpus.size(); i++)
+        corpus[i]->unref();
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// OperationQueue benchmark.
+//
+// Times popping every operation off queues of a few sizes, once with the
+// linear scan TexturesGenerator::popNext() used before OperationQueue and
+// once with OperationQueue's heap (pushes included), using the format of
+// skia's bench tool so that runs can be compared with
+// skia/bench/bench_compare.py.
+
+#include "config.h"
+
+#include "OperationQueue.h"
+#include "QueuedOperation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/Timers.h>
+#include <wtf/Vector.h>
+
+using namespace WebCore;
+
+#define DEFAULT_REPEAT 10
+
+// Operation with a fixed priority, keyed by its own address
+class BenchOperation : public QueuedOperation {
+public:
+    BenchOperation(int priority) : m_priority(priority) {}
+    virtual void run(BaseRenderer* renderer) {}
+    virtual bool operator==(const QueuedOperation* operation) { return operation == this; }
+    virtual void* uniquePtr() { return this; }
+    virtual int priority() { return m_priority; }
+
+private:
+    int m_priority;
+};
+
+static QueuedOperation* popLinear(Vector<QueuedOperation*>& operations)
+{
+    int currentIndex = operations.size() - 1;
+    int currentPriority = operations[currentIndex]->priority();
+    for (int i = operations.size() - 2; i >= 0; i--) {
+        int priority = operations[i]->priority();
+        if (priority <= currentPriority) {
+            currentPriority = priority;
+            currentIndex = i;
+        }
+    }
+    QueuedOperation* current = operations[currentIndex];
+    operations.remove(currentIndex);
+    return current;
+}
+
+static double timeLinear(const Vector<QueuedOperation*>& operations)
+{
+    Vector<QueuedOperation*> linear(operations);
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    while (linear.size())
+        popLinear(linear);
+    return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000000.0;
+}
+
+static double timeHeap(const Vector<QueuedOperation*>& operations)
+{
+    OperationQueue queue;
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (unsigned i = 0; i < operations.size(); i++)
+        queue.push(operations[i], operations[i]->priority());
+    while (!queue.isEmpty())
+        queue.pop();
+    return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000000.0;
+}
+
+static void report(const char* name, int count, double (*proc)(const Vector<QueuedOperation*>&),
+                   const Vector<QueuedOperation*>& operations, int repeat)
+{
+    printf("running bench [%d 1] operationqueue_%s_%d\n", count, name, count);
+    printf("  8888: msecs = ");
+    for (int r = 0; r < repeat; r++)
+        printf(r ? ",%.3f" : "%.3f", proc(operations));
+    printf("\n");
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  -r <count>        repeat count (default %d)\n", DEFAULT_REPEAT);
+}
+
+int main(int argc, char** argv)
+{
+    int repeat = DEFAULT_REPEAT;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    static const int sizes[] = { 100, 1000, 10000 };
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const int count = sizes[s];
+        srand(count);
+        Vector<QueuedOperation*> operations;
+        for (int i = 0; i < count; i++)
+            operations.append(new BenchOperation(rand() % 1000000));
+
+        report("linear", count, timeLinear, operations, repeat);
+        report("heap", count, timeHeap, operations, repeat);
+
+        for (int i = 0; i < count; i++)
+            delete operations[i];
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+# Build the RTree benchmark, see RTreeBench.cpp.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    RTreeBench.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    libutils \
+    libwebcore \
+    libskia \
+    libstlport
+
+LOCAL_C_INCLUDES := \
+    bionic \
+    bionic/libstdc++/include \
+    external/stlport/stlport \
+    external/skia/include/core \
+    external/icu/icu4c/source/common \
+    $(LOCAL_PATH)/../../../JavaScriptCore \
+    $(LOCAL_PATH)/../../../JavaScriptCore/wtf \
+    $(LOCAL_PATH)/../.. \
+    $(LOCAL_PATH)/../../platform/graphics \
+    $(LOCAL_PATH)/../../platform/graphics/transforms \
+    $(LOCAL_PATH)/../../platform/graphics/android \
+    $(LOCAL_PATH)/../../platform/graphics/android/context \
+    $(LOCAL_PATH)/../../platform/graphics/android/rendering \
+    $(LOCAL_PATH)/../../platform/graphics/android/utils
+
+LOCAL_MODULE := rtree
+LOCAL_MODULE_TAGS := eng tests
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// RTree benchmark.
+//
+// Records the operations of a long text page into an RTree, inserting them
+// one at a time and bulk loading them into a packed tree, then searches the
+// tree once per 256x256 tile as TileGrid does. Prints the record and search
+// times in the format of skia's bench tool, so that runs can be compared
+// with skia/bench/bench_compare.py.
+
+#include "config.h"
+
+#include "GraphicsOperation.h"
+#include "IntRect.h"
+#include "RTree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/LinearAllocator.h>
+#include <utils/Timers.h>
+#include <wtf/Vector.h>
+
+using namespace WebCore;
+
+#define DEFAULT_COUNT 50000
+#define DEFAULT_REPEAT 10
+#define TILE_SIZE 256
+
+class BenchOperation : public GraphicsOperation::Operation {
+public:
+    void* operator new(size_t size, android::LinearAllocator* allocator) { return allocator->alloc(size); }
+    virtual bool applyImpl(PlatformGraphicsContext* context) { return true; }
+};
+
+// Lays out operations the way a long text page would: lines of words, with
+// the occasional large box
+static void generatePage(int count, Vector<IntRect>& bounds)
+{
+    srand(count);
+    int y = 0;
+    int x = 0;
+    for (int i = 0; i < count; i++) {
+        if (!(i % 100)) {
+            bounds.append(IntRect(0, y, 980, 200 + rand() % 300));
+            continue;
+        }
+        int width = 20 + rand() % 80;
+        if (x + width > 980) {
+            x = 0;
+            y += 18;
+        }
+        bounds.append(IntRect(x, y, width, 16));
+        x += width + 4;
+    }
+}
+
+static void printTimes(const char* name, int count, const Vector<double>& times)
+{
+    printf("running bench [%d 1] rtree_%s\n", count, name);
+    printf("  8888: msecs = ");
+    for (unsigned r = 0; r < times.size(); r++)
+        printf(r ? ",%.2f" : "%.2f", times[r]);
+    printf("\n");
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  -n <count>        operation count (default %d)\n", DEFAULT_COUNT);
+    fprintf(stderr, "  -r <count>        repeat count (default %d)\n", DEFAULT_REPEAT);
+}
+
+int main(int argc, char** argv)
+{
+    int count = DEFAULT_COUNT;
+    int repeat = DEFAULT_REPEAT;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Vector<IntRect> bounds;
+    generatePage(count, bounds);
+    int pageHeight = 0;
+    for (unsigned i = 0; i < bounds.size(); i++)
+        pageHeight = std::max(pageHeight, bounds[i].maxY());
+
+    for (int packed = 0; packed < 2; packed++) {
+        Vector<double> recordTimes;
+        Vector<double> searchTimes;
+        for (int r = 0; r < repeat; r++) {
+            android::LinearAllocator heap;
+            RTree::RTree tree(&heap);
+            nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+            if (packed)
+                tree.beginBulkLoad();
+            for (unsigned i = 0; i < bounds.size(); i++) {
+                RecordingData* data = new (&heap) RecordingData(new (&heap) BenchOperation(), i);
+                tree.insert(bounds[i], data);
+            }
+            if (packed)
+                tree.endBulkLoad();
+            recordTimes.append((systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000000.0);
+
+            start = systemTime(SYSTEM_TIME_MONOTONIC);
+            Vector<RecordingData*> list;
+            for (int y = 0; y < pageHeight; y += TILE_SIZE) {
+                for (int x = 0; x < 1024; x += TILE_SIZE) {
+                    list.clear();
+                    tree.search(IntRect(x, y, TILE_SIZE, TILE_SIZE), list);
+                }
+            }
+            searchTimes.append((systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000000.0);
+        }
+        printTimes(packed ? "record_packed" : "record_dynamic", count, recordTimes);
+        printTimes(packed ? "search_packed" : "search_dynamic", count, searchTimes);
+    }
+    return 0;
+}
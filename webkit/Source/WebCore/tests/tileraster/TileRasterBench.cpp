@@ -0,0 +1,343 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Headless tile raster benchmark.
+//
+// Loads a page written by PicturePile::writeRecording(), which
+// WebViewCore::dumpRecordingStats() saves to RECORDING_LOG_FILE, or any
+// file written by SerializedRecording::writeToFile(). It then rasters the
+// tiles TileGrid::computeTilesArea() gives for a set of scroll positions
+// and zoom scales, through RasterRenderer and BaseRenderer::renderTiledContent()
+// as PaintTileOperation does. Only the upload of the tile bitmaps, which
+// needs a GL context, is left out.
+//
+// It runs on the device: WebCore and the renderers have no host build.
+//
+// The output uses the format of skia's bench tool, so that the results of two
+// builds can be compared with skia/bench/bench_compare.py:
+//   tileraster -s 1.0,2.0 /sdcard/recording.rec > old.txt
+//   ... rebuild ...
+//   tileraster -s 1.0,2.0 /sdcard/recording.rec > new.txt
+//   bench_compare.py -o old.txt -n new.txt
+// Each bench is one scale and scroll position, and its time is the time
+// taken to raster all of its tiles. The per tile lines and the operation
+// counts are deterministic, so they can be diffed as well. The heap lines
+// are the growth of the malloc heap while rastering, during the first
+// repetition and during the others.
+
+#define LOG_TAG "tileraster"
+
+#include "config.h"
+
+#include "BaseRenderer.h"
+#include "Color.h"
+#include "IntRect.h"
+#include "RasterRenderer.h"
+#include "SerializedRecording.h"
+#include "SkCanvas.h"
+#include "SkColor.h"
+#include "Tile.h"
+#include "TileGrid.h"
+#include "TilePainter.h"
+#include "TilesManager.h"
+
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wtf/Vector.h>
+
+#define DEFAULT_VIEWPORT_WIDTH 720
+#define DEFAULT_VIEWPORT_HEIGHT 1184
+#define DEFAULT_REPEAT 5
+#define MAX_DEFAULT_POSITIONS 8
+
+using namespace WebCore;
+
+struct TileResult {
+    int x;
+    int y;
+    size_t operations;
+    bool isPureColor;
+    double totalMS;
+};
+
+static double currentMS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static ssize_t heapSize()
+{
+    return mallinfo().uordblks;
+}
+
+// Paints the recording as the base layer's Surface paints its content
+class RecordingPainter : public TilePainter {
+public:
+    RecordingPainter(const SerializedRecording* recording, const Color& background)
+        : m_recording(recording)
+        , m_background(background)
+        , m_operations(0)
+    {}
+
+    virtual bool paint(SkCanvas* canvas) {
+        m_operations += m_recording->draw(canvas);
+        return true;
+    }
+    virtual Color* background() { return &m_background; }
+
+    // Returns the operations replayed since the last call
+    size_t takeOperations() {
+        size_t operations = m_operations;
+        m_operations = 0;
+        return operations;
+    }
+
+private:
+    const SerializedRecording* m_recording;
+    Color m_background;
+    size_t m_operations;
+};
+
+// Keeps the tiles in its bitmap rather than uploading them to textures
+class BitmapRenderer : public RasterRenderer {
+protected:
+    virtual void renderingComplete(const TileRenderInfo& renderInfo, SkCanvas* canvas) {}
+};
+
+// Rasters the tile the way Tile::paintBitmap() does, without a texture.
+// Returns the number of operations replayed.
+static size_t rasterTile(BaseRenderer* renderer, RecordingPainter* painter, Tile* tile,
+                         TileResult& result, float scale)
+{
+    TileRenderInfo renderInfo;
+    renderInfo.x = result.x;
+    renderInfo.y = result.y;
+    renderInfo.scale = scale;
+    renderInfo.tileSize = SkSize::Make(TilesManager::tileWidth(), TilesManager::tileHeight());
+    renderInfo.tilePainter = painter;
+    renderInfo.baseTile = tile;
+    renderInfo.textureInfo = 0;
+    renderInfo.isPureColor = false;
+    renderer->renderTiledContent(renderInfo);
+    result.isPureColor = renderInfo.isPureColor;
+    return painter->takeOperations();
+}
+
+static bool parseList(const char* arg, Vector<float>& list)
+{
+    while (*arg) {
+        char* end;
+        float value = strtof(arg, &end);
+        if (end == arg || value <= 0)
+            return false;
+        list.append(value);
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return !list.isEmpty();
+}
+
+static bool parsePositions(const char* arg, Vector<IntPoint>& list)
+{
+    int x, y, consumed;
+    while (*arg) {
+        if (sscanf(arg, "%d,%d%n", &x, &y, &consumed) != 2)
+            return false;
+        list.append(IntPoint(x, y));
+        arg += consumed;
+        if (*arg == ':')
+            arg++;
+    }
+    return !list.isEmpty();
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options] <recording>\n", name);
+    fprintf(stderr, "  -s <scale,...>    zoom scales (default 1.0)\n");
+    fprintf(stderr, "  -p <x,y:...>      scroll positions in content coordinates\n");
+    fprintf(stderr, "                    (default: pages down the content)\n");
+    fprintf(stderr, "  -v <width,height> viewport size in screen pixels (default %d,%d)\n",
+            DEFAULT_VIEWPORT_WIDTH, DEFAULT_VIEWPORT_HEIGHT);
+    fprintf(stderr, "  -r <count>        repeat count (default %d)\n", DEFAULT_REPEAT);
+    fprintf(stderr, "  -b <aarrggbb>     background color (default ffffffff)\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<float> scales;
+    Vector<IntPoint> positions;
+    int viewportWidth = DEFAULT_VIEWPORT_WIDTH;
+    int viewportHeight = DEFAULT_VIEWPORT_HEIGHT;
+    int repeat = DEFAULT_REPEAT;
+    SkColor background = SK_ColorWHITE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:v:r:b:h")) != -1) {
+        switch (opt) {
+        case 's':
+            if (!parseList(optarg, scales)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'p':
+            if (!parsePositions(optarg, positions)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'v':
+            if (sscanf(optarg, "%d,%d", &viewportWidth, &viewportHeight) != 2
+                || viewportWidth <= 0 || viewportHeight <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'r':
+            repeat = atoi(optarg);
+            if (repeat <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'b':
+            background = strtoul(optarg, 0, 16);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[optind];
+    SerializedRecording* recording = SerializedRecording::createFromFile(path);
+    if (!recording) {
+        fprintf(stderr, "Could not load a recording from %s\n", path);
+        return 1;
+    }
+    IntRect bounds = recording->bounds();
+
+    if (scales.isEmpty())
+        scales.append(1.0f);
+    if (positions.isEmpty()) {
+        // Page down the content, at the first scale
+        int pageHeight = viewportHeight / scales[0];
+        for (int y = 0; positions.isEmpty() || y < bounds.maxY(); y += pageHeight) {
+            positions.append(IntPoint(0, y));
+            if (positions.size() == MAX_DEFAULT_POSITIONS)
+                break;
+        }
+    }
+
+    RecordingPainter* painter = new RecordingPainter(recording, Color(background));
+    BitmapRenderer renderer;
+    Tile tile;
+
+    printf("skia bench: tool=tileraster file=%s tile=%dx%d viewport=%dx%d repeat=%d\n",
+           path, TilesManager::tileWidth(), TilesManager::tileHeight(),
+           viewportWidth, viewportHeight, repeat);
+    printf("recording: operations %zu bitmaps %zu bytes %zu bounds %d,%d %dx%d\n",
+           recording->operationCount(), recording->bitmapCount(), recording->byteSize(),
+           bounds.x(), bounds.y(), bounds.width(), bounds.height());
+
+    for (size_t s = 0; s < scales.size(); s++) {
+        float scale = scales[s];
+        IntSize contentSize(ceilf(viewportWidth / scale), ceilf(viewportHeight / scale));
+        for (size_t p = 0; p < positions.size(); p++) {
+            IntRect contentArea(positions[p], contentSize);
+            IntRect tilesArea = TileGrid::computeTilesArea(contentArea, scale);
+
+            Vector<TileResult> tiles;
+            for (int y = tilesArea.y(); y < tilesArea.maxY(); y++) {
+                for (int x = tilesArea.x(); x < tilesArea.maxX(); x++) {
+                    TileResult result = { x, y, 0, false, 0 };
+                    tiles.append(result);
+                }
+            }
+
+            Vector<double> times;
+            ssize_t firstHeapGrowth = 0;
+            ssize_t heapGrowth = 0;
+            for (int r = 0; r < repeat; r++) {
+                double total = 0;
+                ssize_t heapBefore = heapSize();
+                for (size_t t = 0; t < tiles.size(); t++) {
+                    TileResult& result = tiles[t];
+                    double before = currentMS();
+                    result.operations = rasterTile(&renderer, painter, &tile, result, scale);
+                    double elapsed = currentMS() - before;
+                    result.totalMS += elapsed;
+                    total += elapsed;
+                }
+                times.append(total);
+                if (r)
+                    heapGrowth += heapSize() - heapBefore;
+                else
+                    firstHeapGrowth = heapSize() - heapBefore;
+            }
+
+            // The config lines are the only ones with a colon, so that
+            // bench_compare.py only picks the total times up
+            printf("running bench [%d %d] tileraster_%.2f_%d_%d\n",
+                   contentArea.width(), contentArea.height(), scale,
+                   contentArea.x(), contentArea.y());
+            printf("  8888: msecs = ");
+            for (size_t r = 0; r < times.size(); r++)
+                printf(r ? ",%.2f" : "%.2f", times[r]);
+            printf("\n");
+
+            size_t operations = 0;
+            size_t pureColorTiles = 0;
+            for (size_t t = 0; t < tiles.size(); t++) {
+                operations += tiles[t].operations;
+                if (tiles[t].isPureColor)
+                    pureColorTiles++;
+            }
+            printf("  tiles %zu pure %zu ops %zu\n", tiles.size(), pureColorTiles, operations);
+            printf("  heap first %zd then %zd\n", firstHeapGrowth, heapGrowth);
+            for (size_t t = 0; t < tiles.size(); t++) {
+                const TileResult& result = tiles[t];
+                printf("    tile %d,%d ops %zu%s msecs %.3f\n", result.x, result.y,
+                       result.operations, result.isPureColor ? " pure" : "",
+                       result.totalMS / repeat);
+            }
+        }
+    }
+
+    painter->unref();
+    recording->unref();
+    return 0;
+}
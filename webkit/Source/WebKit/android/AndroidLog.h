@@ -54,6 +54,8 @@ extern FILE* gRenderTreeFile;
 
 #define DISPLAY_TREE_LOG_FILE "/sdcard/displayTree.txt"
 #define LAYERS_TREE_LOG_FILE "/sdcard/layersTree.plist"
+#define RECORDING_STATS_LOG_FILE "/sdcard/recordingStats.json"
+#define RECORDING_LOG_FILE "/sdcard/recording.rec"
 
 #define FLOAT_RECT_FORMAT "[x=%.2f,y=%.2f,w=%.2f,h=%.2f]"
 #define FLOAT_RECT_ARGS(fr) fr.x(), fr.y(), fr.width(), fr.height()
@@ -40,6 +40,7 @@
 #include <androidfw/AssetManager.h>
 #include <utils/Debug.h>
 #include <utils/Log.h>
+#include <utils/threads.h>
 #include <wtf/text/CString.h>
 
 extern android::AssetManager* globalAssetManager();
@@ -69,14 +70,20 @@ static const PatchData gFiles[] =
 static SkBitmap gButton[sizeof(gFiles)/sizeof(gFiles[0])];
 static bool gDecoded;
 static bool gDecodingFailed;
+// Recordings containing media buttons can be replayed on several
+// raster threads at once, the first one decodes the assets
+static android::Mutex gDecodeMutex;
 
 namespace WebCore {
 
 void RenderSkinMediaButton::Decode()
 {
+    android::Mutex::Autolock lock(gDecodeMutex);
+    if (gDecoded)
+        return;
+
     String drawableDirectory = RenderSkinAndroid::DrawableDirectory();
 
-    gDecoded = true;
     gDecodingFailed = false;
     android::AssetManager* am = globalAssetManager();
     for (size_t i = 0; i < sizeof(gFiles)/sizeof(gFiles[0]); i++) {
@@ -87,15 +94,14 @@ void RenderSkinMediaButton::Decode()
             break;
         }
     }
+    gDecoded = true;
 }
 
 void RenderSkinMediaButton::Draw(SkCanvas* canvas, const IntRect& r,
                                  MediaButton buttonType, bool translucent,
                                  bool drawBackground, const IntRect& thumb)
 {
-    if (!gDecoded) {
-        Decode();
-    }
+    Decode();
 
     if (!canvas)
         return;
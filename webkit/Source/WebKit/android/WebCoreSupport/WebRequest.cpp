@@ -28,6 +28,7 @@
 
 #include "JNIUtility.h"
 #include "MainThread.h"
+#include "SharedBuffer.h"
 #include "UrlInterceptResponse.h"
 #include "WebCoreFrameBridge.h"
 #include "WebCoreJni.h"
@@ -36,6 +37,7 @@
 #include "WebUrlLoaderClient.h"
 #include "jni.h"
 
+#include <algorithm>
 #include <cutils/log.h>
 #include <openssl/x509.h>
 #include <string>
@@ -60,6 +62,16 @@ namespace android {
 
 namespace {
 const int kInitialReadBufSize = 32768;
+// A read that fills its buffer doubles the size of the next one, and a read
+// that uses less than a quarter of it halves it.
+const int kMinReadBufSize = 8192;
+const int kMaxReadBufSize = 262144;
+// Reads are coalesced until this much data is pending or the network has
+// nothing more ready.
+const int kMaxCoalescedDataSize = 262144;
+// While this many data tasks are waiting for the main thread, further reads
+// keep coalescing rather than queueing more tasks.
+const int kMaxDataTasksInFlight = 2;
 const char* kXRequestedWithHeader = "X-Requested-With";
 
 struct RequestPackageName {
@@ -67,6 +79,28 @@ struct RequestPackageName {
     RequestPackageName();
 };
 
+// Hands a network read buffer over to WebCore without copying it.
+class IOBufferSegment : public WebCore::SharedBufferSegment {
+public:
+    static PassRefPtr<IOBufferSegment> create(net::IOBuffer* buffer, int size)
+    {
+        return adoptRef(new IOBufferSegment(buffer, size));
+    }
+
+    virtual const char* data() const { return m_buffer->data(); }
+    virtual unsigned size() const { return m_size; }
+
+private:
+    IOBufferSegment(net::IOBuffer* buffer, int size)
+        : m_buffer(buffer)
+        , m_size(size)
+    {
+    }
+
+    scoped_refptr<net::IOBuffer> m_buffer;
+    int m_size;
+};
+
 RequestPackageName::RequestPackageName() {
     JNIEnv* env = JSC::Bindings::getJNIEnv();
     jclass bridgeClass = env->FindClass("android/webkit/JniUtil");
@@ -87,6 +121,9 @@ WebRequest::WebRequest(WebUrlLoaderClient* loader, const WebResourceRequest& web
     , m_loadState(Created)
     , m_authRequestCount(0)
     , m_cacheMode(0)
+    , m_readBufferSize(kInitialReadBufSize)
+    , m_pendingDataSize(0)
+    , m_dataTasksInFlight(0)
     , m_runnableFactory(this)
     , m_wantToPause(false)
     , m_isPaused(false)
@@ -114,6 +151,9 @@ WebRequest::WebRequest(WebUrlLoaderClient* loader, const WebResourceRequest& web
     , m_loadState(Created)
     , m_authRequestCount(0)
     , m_cacheMode(0)
+    , m_readBufferSize(kInitialReadBufSize)
+    , m_pendingDataSize(0)
+    , m_dataTasksInFlight(0)
     , m_runnableFactory(this)
     , m_wantToPause(false)
     , m_isPaused(false)
@@ -169,6 +209,13 @@ void WebRequest::finish(bool success)
     // Make sure WebUrlLoaderClient doesn't delete us in the middle of this method.
     scoped_refptr<WebRequest> guard(this);
 
+    // Data read before the request finished goes out ahead of the finish
+    // message, unless WebCore cancelled the request.
+    if (m_loadState == Cancelled)
+        m_pendingData.clear();
+    else
+        flushReadData();
+
     m_loadState = Finished;
     if (success) {
         m_urlLoader->maybeCallOnMainThread(NewRunnableMethod(
@@ -511,6 +558,7 @@ void WebRequest::startReading()
         return;
 
     if (m_wantToPause) {
+        flushReadData();
         m_isPaused = true;
         return;
     }
@@ -518,8 +566,13 @@ void WebRequest::startReading()
     int bytesRead = 0;
 
     if (!read(&bytesRead)) {
-        if (m_request && m_request->status().is_io_pending())
+        if (m_request && m_request->status().is_io_pending()) {
+            // Nothing more is ready, so hand over what we have unless WebCore
+            // is still busy with earlier data; didDeliverData() sends it then.
+            if (m_dataTasksInFlight < kMaxDataTasksInFlight)
+                flushReadData();
             return; // Wait for OnReadCompleted()
+        }
         return finish(false);
     }
 
@@ -528,9 +581,8 @@ void WebRequest::startReading()
         return finish(true);
 
     m_loadState = GotData;
-    // Read ok, forward buffer to webcore
-    m_urlLoader->maybeCallOnMainThread(NewRunnableMethod(m_urlLoader.get(), &WebUrlLoaderClient::didReceiveData, m_networkBuffer, bytesRead));
-    m_networkBuffer = 0;
+    // Read ok, queue the buffer for webcore
+    appendReadData(bytesRead);
     MessageLoop::current()->PostTask(FROM_HERE, m_runnableFactory.NewRunnableMethod(&WebRequest::startReading));
 }
 
@@ -540,8 +592,57 @@ bool WebRequest::read(int* bytesRead)
     ASSERT(m_networkBuffer == 0, "Read called with a nonzero buffer");
 
     // TODO: when asserts work, check that the buffer is 0 here
-    m_networkBuffer = new net::IOBuffer(kInitialReadBufSize);
-    return m_request->Read(m_networkBuffer, kInitialReadBufSize, bytesRead);
+    m_networkBuffer = new net::IOBuffer(m_readBufferSize);
+    return m_request->Read(m_networkBuffer, m_readBufferSize, bytesRead);
+}
+
+void WebRequest::appendReadData(int bytesRead)
+{
+    scoped_refptr<net::IOBuffer> buffer = m_networkBuffer;
+    m_networkBuffer = 0;
+    if (bytesRead <= 0)
+        return;
+
+    // WebCore keeps the buffer for as long as the resource stays in the memory
+    // cache, so don't let a short read pin a mostly empty one.
+    if (bytesRead < m_readBufferSize / 2) {
+        scoped_refptr<net::IOBuffer> compact = new net::IOBuffer(bytesRead);
+        memcpy(compact->data(), buffer->data(), bytesRead);
+        buffer = compact;
+    }
+
+    if (bytesRead == m_readBufferSize)
+        m_readBufferSize = std::min(m_readBufferSize * 2, kMaxReadBufSize);
+    else if (bytesRead < m_readBufferSize / 4)
+        m_readBufferSize = std::max(m_readBufferSize / 2, kMinReadBufSize);
+
+    if (!m_pendingData)
+        m_pendingData = adoptPtr(new Vector<RefPtr<WebCore::SharedBufferSegment> >);
+    m_pendingData->append(IOBufferSegment::create(buffer.get(), bytesRead));
+    m_pendingDataSize += bytesRead;
+
+    if (m_pendingDataSize >= kMaxCoalescedDataSize)
+        flushReadData();
+}
+
+void WebRequest::flushReadData()
+{
+    if (!m_pendingData)
+        return;
+
+    m_urlLoader->maybeCallOnMainThread(NewRunnableMethod(
+            m_urlLoader.get(), &WebUrlLoaderClient::didReceiveData, m_pendingData.release()));
+    m_pendingDataSize = 0;
+    ++m_dataTasksInFlight;
+}
+
+void WebRequest::didDeliverData()
+{
+    --m_dataTasksInFlight;
+
+    // Send on anything that was held back while WebCore was busy.
+    if (m_loadState == GotData && !m_isPaused)
+        flushReadData();
 }
 
 // This is called when there is data available
@@ -559,9 +660,7 @@ void WebRequest::OnReadCompleted(net::URLRequest* request, int bytesRead)
 
     if (request->status().is_success()) {
         m_loadState = GotData;
-        m_urlLoader->maybeCallOnMainThread(NewRunnableMethod(
-                m_urlLoader.get(), &WebUrlLoaderClient::didReceiveData, m_networkBuffer, bytesRead));
-        m_networkBuffer = 0;
+        appendReadData(bytesRead);
 
         // Get the rest of the data
         startReading();
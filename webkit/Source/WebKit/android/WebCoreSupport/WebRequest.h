@@ -27,8 +27,14 @@
 #define WebRequest_h
 
 #include "ChromiumIncludes.h"
+#include <wtf/OwnPtr.h>
+#include <wtf/RefPtr.h>
 #include <wtf/Vector.h>
 
+namespace WebCore {
+class SharedBufferSegment;
+}
+
 class MessageLoop;
 
 namespace android {
@@ -86,6 +92,8 @@ public:
     void proceedSslCertError();
     void cancelSslCertError(int cert_error);
     void sslClientCert(EVP_PKEY* pkey, scoped_refptr<net::X509Certificate> chain);
+    // Called once WebCore has consumed a batch of data posted by flushReadData().
+    void didDeliverData();
 
     const std::string& getUrl() const;
     const std::string& getUserAgent() const;
@@ -95,6 +103,8 @@ public:
 private:
     void startReading();
     bool read(int* bytesRead);
+    void appendReadData(int bytesRead);
+    void flushReadData();
 
     friend class base::RefCountedThreadSafe<WebRequest>;
     virtual ~WebRequest();
@@ -114,6 +124,12 @@ private:
     LoadState m_loadState;
     int m_authRequestCount;
     int m_cacheMode;
+    int m_readBufferSize;
+    // Reads not yet handed to WebCore. They are posted to the main thread in
+    // one task to keep fast networks from flooding it with small ones.
+    OwnPtr<Vector<RefPtr<WebCore::SharedBufferSegment> > > m_pendingData;
+    int m_pendingDataSize;
+    int m_dataTasksInFlight;
     ScopedRunnableMethodFactory<WebRequest> m_runnableFactory;
     bool m_wantToPause;
     bool m_isPaused;
@@ -33,6 +33,7 @@
 #include "ResourceHandle.h"
 #include "ResourceHandleClient.h"
 #include "ResourceResponse.h"
+#include "SharedBuffer.h"
 #include "WebCoreFrameBridge.h"
 #include "WebRequest.h"
 #include "WebResourceRequest.h"
@@ -390,19 +391,34 @@ void WebUrlLoaderClient::didReceiveResponse(PassOwnPtr<WebResponse> webResponse)
     ALOGI("finish WebUrlLoaderClient::didReceiveResponse");
 }
 
-void WebUrlLoaderClient::didReceiveData(scoped_refptr<net::IOBuffer> buf, int size)
+void WebUrlLoaderClient::didReceiveData(PassOwnPtr<Vector<RefPtr<WebCore::SharedBufferSegment> > > segments)
 {
     ALOGI("WebUrlLoaderClient::didReceiveData");
+    // Let the IO thread know this batch is consumed, so it can send on any
+    // data it held back meanwhile.
+    base::Thread* thread = ioThread();
+    if (m_request && thread)
+        thread->message_loop()->PostTask(FROM_HERE, NewRunnableMethod(m_request.get(), &WebRequest::didDeliverData));
+
     if (m_isMainResource && m_isCertMimeType) {
-        m_webFrame->didReceiveData(buf->data(), size);
+        for (size_t i = 0; i < segments->size(); ++i)
+            m_webFrame->didReceiveData(segments->at(i)->data(), segments->at(i)->size());
     }
 
-    if (!isActive() || !size)
+    if (!isActive() || segments->isEmpty())
         return;
 
-    // didReceiveData will take a copy of the data
-    if (m_resourceHandle && m_resourceHandle->client())
-        m_resourceHandle->client()->didReceiveData(m_resourceHandle.get(), buf->data(), size, size);
+    WebCore::ResourceHandleClient* client = m_resourceHandle->client();
+    if (client->supportsDataSegments()) {
+        // The client keeps references to the network buffers instead of copying them.
+        client->didReceiveDataSegments(m_resourceHandle.get(), *segments);
+    } else {
+        // didReceiveData will take a copy of the data
+        for (size_t i = 0; i < segments->size() && isActive(); ++i) {
+            int size = segments->at(i)->size();
+            m_resourceHandle->client()->didReceiveData(m_resourceHandle.get(), segments->at(i)->data(), size, size);
+        }
+    }
     ALOGI("finish WebUrlLoaderClient::didReceiveData");
 }
 
@@ -35,7 +35,12 @@
 #include <deque>
 #include <string>
 #include <vector>
+#include <wtf/PassOwnPtr.h>
+#include <wtf/Vector.h>
 
+namespace WebCore {
+class SharedBufferSegment;
+}
 
 namespace base {
 class ConditionVariable;
@@ -44,7 +49,6 @@ class Thread;
 }
 
 namespace net {
-class IOBuffer;
 class AuthChallengeInfo;
 }
 
@@ -83,7 +87,7 @@ public:
 
     // Called by WebRequest (using maybeCallOnMainThread), should be forwarded to WebCore.
     void didReceiveResponse(PassOwnPtr<WebResponse>);
-    void didReceiveData(scoped_refptr<net::IOBuffer>, int size);
+    void didReceiveData(PassOwnPtr<Vector<RefPtr<WebCore::SharedBufferSegment> > >);
     void didReceiveDataUrl(PassOwnPtr<std::string>);
     void didReceiveAndroidFileData(PassOwnPtr<std::vector<char> >);
     void didFinishLoading();
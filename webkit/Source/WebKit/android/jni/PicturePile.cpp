@@ -41,24 +41,92 @@
 
 #if USE_RECORDING_CONTEXT
 #include "PlatformGraphicsContextRecording.h"
+#include "SerializedRecording.h"
 #else
 #include "SkPicture.h"
 #endif
 
+#include <wtf/CurrentTime.h>
+
 #define ENABLE_PRERENDERED_INVALS true
 #define MAX_OVERLAP_COUNT 2
 #define MAX_OVERLAP_AREA .7
 
+// Small invals inside of a single recording are recorded on their own and
+// spliced into it, rather than re-recording the whole area. Past a few
+// splices the recording is done again from scratch, as each one keeps the
+// recording it was made from alive.
+#define ENABLE_SPLICED_RECORDINGS USE_RECORDING_CONTEXT
+#define MAX_SPLICE_COUNT 4
+#define MAX_SPLICE_AREA .25
+
+// Invals are kept as separate rects until there are this many, and merged
+// when that adds less than RecordingCostModel::coalesceArea() pixels
+#define MAX_WEBKIT_INVALS 8
+// The weight of the older samples in the cost model, per sample
+#define COST_MODEL_DECAY .95
+#define COST_MODEL_MIN_SAMPLES 4
+// A 256x256 tile, until there are enough samples
+#define DEFAULT_COALESCE_AREA (256 * 256)
+#define MIN_COALESCE_AREA (32 * 32)
+#define MAX_COALESCE_AREA (1024 * 1024)
+
 namespace WebCore {
 
 static SkIRect toSkIRect(const IntRect& rect) {
     return SkIRect::MakeXYWH(rect.x(), rect.y(), rect.width(), rect.height());
 }
 
+static size_t area(const IntRect& rect) {
+    return static_cast<size_t>(rect.width()) * rect.height();
+}
+
+static size_t area(const SkRegion& region) {
+    size_t total = 0;
+    for (SkRegion::Iterator it(region); !it.done(); it.next())
+        total += static_cast<size_t>(it.rect().width()) * it.rect().height();
+    return total;
+}
+
+RecordingCostModel::RecordingCostModel()
+    : m_weight(0)
+    , m_sumArea(0)
+    , m_sumTime(0)
+    , m_sumAreaSquared(0)
+    , m_sumAreaTime(0)
+    , m_coalesceArea(DEFAULT_COALESCE_AREA)
+{
+}
+
+void RecordingCostModel::addSample(size_t area, double time)
+{
+    // Least squares fit of time = perRecording + perPixel * area, weighted
+    // towards the recent samples
+    m_weight = m_weight * COST_MODEL_DECAY + 1;
+    m_sumArea = m_sumArea * COST_MODEL_DECAY + area;
+    m_sumTime = m_sumTime * COST_MODEL_DECAY + time;
+    m_sumAreaSquared = m_sumAreaSquared * COST_MODEL_DECAY + static_cast<double>(area) * area;
+    m_sumAreaTime = m_sumAreaTime * COST_MODEL_DECAY + area * time;
+    if (m_weight < COST_MODEL_MIN_SAMPLES)
+        return;
+
+    double det = m_weight * m_sumAreaSquared - m_sumArea * m_sumArea;
+    if (det <= 0)
+        return; // all the same size so far
+    double perPixel = (m_weight * m_sumAreaTime - m_sumArea * m_sumTime) / det;
+    double perRecording = (m_sumTime - perPixel * m_sumArea) / m_weight;
+    if (perPixel <= 0 || perRecording <= 0)
+        return; // too noisy, keep the last estimate
+    double coalesceArea = perRecording / perPixel;
+    m_coalesceArea = std::max<double>(MIN_COALESCE_AREA,
+                                      std::min<double>(MAX_COALESCE_AREA, coalesceArea));
+}
+
 PictureContainer::PictureContainer(const PictureContainer& other)
     : picture(other.picture)
     , area(other.area)
     , dirty(other.dirty)
+    , spliceArea(other.spliceArea)
     , prerendered(other.prerendered)
 {
     SkSafeRef(picture);
@@ -73,6 +141,8 @@ PicturePile::PicturePile(const PicturePile& other)
     : m_size(other.m_size)
     , m_pile(other.m_pile)
     , m_webkitInvals(other.m_webkitInvals)
+    , m_invalCount(0)
+    , m_invalArea(0)
 {
 }
 
@@ -137,11 +207,39 @@ void PicturePile::invalidate(const IntRect& dirtyRect)
         ALOGV("Rejecting inval " INT_RECT_FORMAT, INT_RECT_ARGS(dirtyRect));
         return;
     }
-    // TODO: Support multiple non-intersecting webkit invals
-    if (m_webkitInvals.size())
-        m_webkitInvals[0].unite(inval);
-    else
-        m_webkitInvals.append(inval);
+    m_invalCount++;
+    m_invalArea += area(inval);
+    coalesceInval(inval);
+}
+
+void PicturePile::coalesceInval(const IntRect& inval)
+{
+    // Merge the inval with the rect it adds the least area to, as long as
+    // that is cheaper than recording it on its own, then see if the merged
+    // rect should take in another one
+    IntRect rect = inval;
+    while (m_webkitInvals.size()) {
+        int best = -1;
+        size_t bestExtra = 0;
+        for (size_t i = 0; i < m_webkitInvals.size(); i++) {
+            const IntRect& other = m_webkitInvals[i];
+            size_t extra = 0;
+            if (!other.intersects(rect)) {
+                IntRect merged = unionRect(other, rect);
+                extra = area(merged) - area(other) - area(rect);
+            }
+            if (best < 0 || extra < bestExtra) {
+                best = i;
+                bestExtra = extra;
+            }
+        }
+        if (bestExtra > m_recordingCost.coalesceArea()
+                && m_webkitInvals.size() < MAX_WEBKIT_INVALS)
+            break;
+        rect.unite(m_webkitInvals[best]);
+        m_webkitInvals.remove(best);
+    }
+    m_webkitInvals.append(rect);
 }
 
 void PicturePile::setSize(const IntSize& size)
@@ -177,26 +275,92 @@ void PicturePile::setSize(const IntSize& size)
 
 void PicturePile::updatePicturesIfNeeded(PicturePainter* painter)
 {
+    m_lastUpdateStats = PicturePileStats();
+    m_lastUpdateStats.startTime = currentTime();
+    m_lastUpdateStats.invalCount = m_invalCount;
+    m_lastUpdateStats.invalArea = m_invalArea;
+    m_invalCount = 0;
+    m_invalArea = 0;
     applyWebkitInvals();
     for (size_t i = 0; i < m_pile.size(); i++) {
         PictureContainer& pc = m_pile[i];
         if (pc.dirty)
             updatePicture(painter, pc);
     }
+    m_lastUpdateStats.pileSize = m_pile.size();
+#if USE_RECORDING_CONTEXT
+    for (size_t i = 0; i < m_pile.size(); i++) {
+        if (m_pile[i].picture)
+            m_lastUpdateStats.pileBytes += m_pile[i].picture->recordedBytes();
+    }
+#endif
+    m_lastUpdateStats.coalesceArea = m_recordingCost.coalesceArea();
+    if (m_lastUpdateStats.recordedPictures || m_lastUpdateStats.splicedPictures) {
+        ALOGV("Recorded %u pictures, spliced %u: %zu operations, %zu bytes, %.2fms",
+              m_lastUpdateStats.recordedPictures, m_lastUpdateStats.splicedPictures,
+              m_lastUpdateStats.recordedOperations, m_lastUpdateStats.recordedBytes,
+              m_lastUpdateStats.recordTime);
+    }
 }
 
 void PicturePile::updatePicture(PicturePainter* painter, PictureContainer& pc)
 {
     TRACE_METHOD();
+#if USE_RECORDING_CONTEXT
+    if (!pc.spliceArea.isEmpty() && pc.picture) {
+        splicePicture(painter, pc);
+        return;
+    }
+#endif
+    pc.spliceArea = IntRect();
+    m_lastUpdateStats.recordedPictures++;
+    double startTime = currentTimeMS();
 #if ENABLE(OLD_SKIA)
     Picture* picture = recordPicture(painter, pc);
 #else
     WebPicture* picture = recordPicture(painter, pc);
 #endif
+    double time = currentTimeMS() - startTime;
+    m_lastUpdateStats.recordedArea += area(pc.area);
+    m_lastUpdateStats.recordTime += time;
+    m_recordingCost.addSample(area(pc.area), time);
+    SkSafeUnref(pc.picture);
+    pc.picture = picture;
+    pc.dirty = false;
+#if USE_RECORDING_CONTEXT
+    if (picture) {
+        m_lastUpdateStats.recordedOperations += picture->recordedOperationCount();
+        m_lastUpdateStats.recordedBytes += picture->recordedBytes();
+    }
+#endif
+}
+
+#if USE_RECORDING_CONTEXT
+void PicturePile::splicePicture(PicturePainter* painter, PictureContainer& pc)
+{
+    TRACE_METHOD();
+    IntRect dirty = pc.spliceArea;
+    double startTime = currentTimeMS();
+    Recording* picture = new Recording();
+    {
+        WebCore::PlatformGraphicsContextRecording pgc(picture, pc.picture, dirty);
+        WebCore::GraphicsContext gc(&pgc);
+        painter->paintContents(&gc, dirty);
+        pc.maxZoomScale = std::max(pc.maxZoomScale, pgc.maxZoomScale());
+    }
+    double time = currentTimeMS() - startTime;
+    m_lastUpdateStats.recordedArea += area(dirty);
+    m_lastUpdateStats.recordTime += time;
+    m_recordingCost.addSample(area(dirty), time);
     SkSafeUnref(pc.picture);
     pc.picture = picture;
     pc.dirty = false;
+    pc.spliceArea = IntRect();
+    m_lastUpdateStats.splicedPictures++;
+    m_lastUpdateStats.recordedOperations += picture->recordedOperationCount();
+    m_lastUpdateStats.recordedBytes += picture->recordedBytes();
 }
+#endif
 
 void PicturePile::reset()
 {
@@ -210,18 +374,27 @@ void PicturePile::applyWebkitInvals()
     m_dirtyRegion.setEmpty();
     if (!m_webkitInvals.size())
         return;
-    // Build the invals (TODO: Support multiple inval regions)
-    IntRect inval = m_webkitInvals[0];
-    m_dirtyRegion.setRect(toSkIRect(inval));
-    for (size_t i = 1; i < m_webkitInvals.size(); i++) {
-        inval.unite(m_webkitInvals[i]);
-        m_dirtyRegion.op(toSkIRect(m_webkitInvals[i]), SkRegion::kUnion_Op);
-    }
-    m_webkitInvals.clear();
+    // Build the invals
+    Vector<IntRect> invals;
+    invals.swap(m_webkitInvals);
+    m_dirtyRegion.setRect(toSkIRect(invals[0]));
+    for (size_t i = 1; i < invals.size(); i++)
+        m_dirtyRegion.op(toSkIRect(invals[i]), SkRegion::kUnion_Op);
+    m_lastUpdateStats.dirtyRects = invals.size();
+    m_lastUpdateStats.unionArea = area(m_dirtyRegion);
+    for (size_t i = 0; i < invals.size(); i++)
+        applyWebkitInval(invals[i]);
+}
+
+void PicturePile::applyWebkitInval(const IntRect& inval)
+{
     ALOGV("Webkit inval: " INT_RECT_FORMAT, INT_RECT_ARGS(inval));
     if (inval.isEmpty())
         return;
 
+    if (ENABLE_SPLICED_RECORDINGS && spliceInval(inval))
+        return;
+
     // Find the overlaps
     Vector<int> overlaps;
     for (size_t i = 0; i < m_pile.size(); i++) {
@@ -229,6 +402,8 @@ void PicturePile::applyWebkitInvals()
         if (pc.area.contains(inval)) {
             if (pc.dirty) {
                 ALOGV("Found already dirty intersection");
+                // record all of it, the splice may not cover this inval
+                pc.spliceArea = IntRect();
                 return;
             }
             if (pc.area == inval) {
@@ -261,6 +436,44 @@ void PicturePile::applyWebkitInvals()
     appendToPile(inval);
 }
 
+bool PicturePile::spliceInval(const IntRect& inval)
+{
+#if USE_RECORDING_CONTEXT
+    // Only the topmost picture touching the inval is recorded again, so it
+    // has to contain all of it
+    for (int i = (int) m_pile.size() - 1; i >= 0; i--) {
+        PictureContainer& pc = m_pile[i];
+        if (!pc.area.intersects(inval))
+            continue;
+        if (!pc.area.contains(inval))
+            return false;
+        float pictureArea = pc.area.width() * pc.area.height();
+        if (pc.dirty) {
+            // An earlier inval of this update already made it dirty, so grow
+            // its splice, or record all of it if that is already the plan
+            if (!pc.spliceArea.isEmpty()) {
+                pc.spliceArea.unite(inval);
+                float spliceArea = pc.spliceArea.width() * pc.spliceArea.height();
+                if (spliceArea / pictureArea > MAX_SPLICE_AREA)
+                    pc.spliceArea = IntRect();
+            }
+            return true;
+        }
+        if (!pc.picture || pc.picture->spliceCount() >= MAX_SPLICE_COUNT)
+            return false;
+        float invalArea = inval.width() * inval.height();
+        if (invalArea / pictureArea > MAX_SPLICE_AREA)
+            return false;
+        ALOGV("Splicing inval " INT_RECT_FORMAT " into " INT_RECT_FORMAT,
+              INT_RECT_ARGS(inval), INT_RECT_ARGS(pc.area));
+        pc.dirty = true;
+        pc.spliceArea = inval;
+        return true;
+    }
+#endif
+    return false;
+}
+
 void PicturePile::appendToPile(const IntRect& inval, const IntRect& originalInval)
 {
     ALOGV("Adding inval " INT_RECT_FORMAT " for original inval " INT_RECT_FORMAT,
@@ -310,6 +523,19 @@ bool PicturePile::isEmpty() const
 }
 
 #if USE_RECORDING_CONTEXT
+bool PicturePile::writeRecording(const char* path) const
+{
+    Vector<const Recording*> recordings;
+    Vector<IntRect> areas;
+    for (size_t i = 0; i < m_pile.size(); i++) {
+        if (!m_pile[i].picture)
+            continue;
+        recordings.append(m_pile[i].picture);
+        areas.append(m_pile[i].area);
+    }
+    return SerializedRecording::writeToFile(recordings, areas, path);
+}
+
 void PicturePile::drawPicture(SkCanvas* canvas, PictureContainer& pc)
 {
     TRACE_METHOD();
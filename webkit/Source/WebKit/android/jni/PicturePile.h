@@ -78,6 +78,8 @@ public:
 #endif
     IntRect area;
     bool dirty;
+    // When not empty, only this part of area needs to be recorded again
+    IntRect spliceArea;
     RefPtr<PrerenderedInval> prerendered;
     float maxZoomScale;
 
@@ -92,9 +94,69 @@ public:
     ~PictureContainer();
 };
 
+// What the last updatePicturesIfNeeded() recorded, and the invals since the
+// one before it that led to it
+struct PicturePileStats {
+    PicturePileStats()
+        : startTime(0)
+        , invalCount(0)
+        , invalArea(0)
+        , unionArea(0)
+        , dirtyRects(0)
+        , recordedPictures(0)
+        , splicedPictures(0)
+        , recordedOperations(0)
+        , recordedBytes(0)
+        , recordedArea(0)
+        , recordTime(0)
+        , pileSize(0)
+        , pileBytes(0)
+        , coalesceArea(0)
+    {}
+
+    double startTime;
+    // invalidate() calls, the sum of their areas and the area of their union
+    unsigned invalCount;
+    size_t invalArea;
+    size_t unionArea;
+    // the rects the invals were coalesced into
+    unsigned dirtyRects;
+    unsigned recordedPictures;
+    unsigned splicedPictures;
+    size_t recordedOperations;
+    size_t recordedBytes;
+    size_t recordedArea;
+    double recordTime; // in ms
+    // the pictures in the pile after the update
+    unsigned pileSize;
+    size_t pileBytes;
+    // see RecordingCostModel
+    size_t coalesceArea;
+};
+
+// Fits the time a recording takes as a fixed cost per recording plus a cost
+// per pixel recorded, from the recent recordings. Two invals are worth
+// recording as one rect when that adds less area than what costs as much
+// as a recording.
+class RecordingCostModel {
+public:
+    RecordingCostModel();
+
+    void addSample(size_t area, double time);
+    size_t coalesceArea() const { return m_coalesceArea; }
+
+private:
+    double m_weight;
+    double m_sumArea;
+    double m_sumTime;
+    double m_sumAreaSquared;
+    double m_sumAreaTime;
+    size_t m_coalesceArea;
+};
+
 class PicturePile {
 public:
-    PicturePile() {}
+    PicturePile() : m_invalCount(0), m_invalArea(0) {}
     PicturePile(const PicturePile& other);
 
     const IntSize& size() { return m_size; }
@@ -111,14 +173,27 @@ public:
     void reset();
     SkRegion& dirtyRegion() { return m_dirtyRegion; }
     PrerenderedInval* prerenderedInvalForArea(const IntRect& area);
+    const PicturePileStats& lastUpdateStats() const { return m_lastUpdateStats; }
 
     // UI-side methods used to check content, after construction/updates are complete
     float maxZoomScale() const;
     bool isEmpty() const;
 
+#if USE_RECORDING_CONTEXT
+    // Writes the pictures as one SerializedRecording, for the tools in
+    // WebCore/tests. Returns false if they can't be serialized.
+    bool writeRecording(const char* path) const;
+#endif
+
 private:
+    void coalesceInval(const IntRect& inval);
     void applyWebkitInvals();
+    void applyWebkitInval(const IntRect& inval);
+    bool spliceInval(const IntRect& inval);
     void updatePicture(PicturePainter* painter, PictureContainer& container);
+#if USE_RECORDING_CONTEXT
+    void splicePicture(PicturePainter* painter, PictureContainer& container);
+#endif
 #if ENABLE(OLD_SKIA)
     Picture* recordPicture(PicturePainter* painter, PictureContainer& container);
 #else
@@ -132,6 +207,10 @@ private:
     Vector<PictureContainer> m_pile;
     Vector<IntRect> m_webkitInvals;
     SkRegion m_dirtyRegion;
+    PicturePileStats m_lastUpdateStats;
+    unsigned m_invalCount;
+    size_t m_invalArea;
+    RecordingCostModel m_recordingCost;
 };
 
 } // namespace android
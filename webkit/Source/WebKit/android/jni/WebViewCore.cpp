@@ -30,6 +30,7 @@
 
 #include "AccessibilityObject.h"
 #include "AndroidHitTestResult.h"
+#include "AndroidLog.h"
 #include "ApplicationCacheStorage.h"
 #include "Attribute.h"
 #include "content/address_detector.h"
@@ -40,6 +41,7 @@
 #include "ClientRectList.h"
 #include "Color.h"
 #include "CSSPropertyNames.h"
+#include "CSSStyleSelector.h"
 #include "CSSValueKeywords.h"
 #include "DatabaseTracker.h"
 #include "Document.h"
@@ -83,6 +85,7 @@
 #include "HistoryItem.h"
 #include "HitTestRequest.h"
 #include "HitTestResult.h"
+#include "ImageSource.h"
 #include "InlineTextBox.h"
 #include "KeyboardEvent.h"
 #include "MemoryUsage.h"
@@ -149,6 +152,7 @@
 #include <wtf/CurrentTime.h>
 #include <wtf/text/AtomicString.h>
 #include <wtf/text/CString.h>
+#include <wtf/text/StringBuilder.h>
 #include <wtf/text/StringImpl.h>
 
 #if DEBUG_NAV_UI
@@ -185,6 +189,9 @@ FILE* gRenderTreeFile = 0;
 #define TOUCH_FLAG_HIT_HANDLER 0x1
 #define TOUCH_FLAG_PREVENT_DEFAULT 0x2
 
+// How many recordContent() calls dumpRecordingStats() reports on
+#define MAX_RECORDING_STATS 300
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace android {
@@ -721,6 +728,10 @@ void WebViewCore::recordPicturePile()
 
     // Rebuild the pictureset (webkit repaint)
     m_content.updatePicturesIfNeeded(this);
+
+    if (m_recordingStats.size() == MAX_RECORDING_STATS)
+        m_recordingStats.removeFirst();
+    m_recordingStats.append(m_content.lastUpdateStats());
 }
 
 void WebViewCore::clearContent()
@@ -1246,6 +1257,13 @@ void WebViewCore::setSizeScreenWidthAndScale(int width, int height,
             m_mainFrame->view()->setUseFixedLayout(false);
     }
 
+#if defined(ANDROID_DECODED_IMAGE_BUDGET)
+    // Images subsampled for the old scale are painted again, so that they
+    // can pick a higher resolution.
+    if (WebCore::ImageSource::setDisplayScale(m_scale))
+        contentInvalidateAll();
+#endif
+
     // update the currently visible screen as perceived by the plugin
     sendPluginVisibleScreen();
 }
@@ -1256,6 +1274,12 @@ void WebViewCore::dumpDomTree(bool useFile)
     if (useFile)
         gDomTreeFile = fopen(DOM_TREE_LOG_FILE, "w");
     m_mainFrame->document()->showTreeForThis();
+#ifdef ANDROID_SHARED_STYLE_CACHE
+    if (CSSStyleSelector* styleSelector = m_mainFrame->document()->styleSelectorIfExists()) {
+        DUMP_DOM_LOGD("shared style cache: %u hits, %u misses\n",
+                styleSelector->sharedStyleCacheHits(), styleSelector->sharedStyleCacheMisses());
+    }
+#endif
     if (gDomTreeFile) {
         fclose(gDomTreeFile);
         gDomTreeFile = 0;
@@ -1288,6 +1312,53 @@ void WebViewCore::dumpRenderTree(bool useFile)
 #endif
 }
 
+void WebViewCore::dumpRecordingStats(bool useFile)
+{
+    // One frame per line, as adb log can only output 1024 characters
+    Vector<String> lines;
+    lines.append("{\"frames\":[");
+    size_t remaining = m_recordingStats.size();
+    Deque<PicturePileStats>::const_iterator end = m_recordingStats.end();
+    for (Deque<PicturePileStats>::const_iterator it = m_recordingStats.begin(); it != end; ++it) {
+        const PicturePileStats& stats = *it;
+        StringBuilder line;
+        line.append(String::format("{\"time\":%.3f,\"invals\":%u,\"invalArea\":%zu,"
+                "\"unionArea\":%zu,\"dirtyRects\":%u,\"recordedPictures\":%u,"
+                "\"splicedPictures\":%u,\"recordedArea\":%zu,\"recordTime\":%.2f,",
+                stats.startTime, stats.invalCount, stats.invalArea, stats.unionArea,
+                stats.dirtyRects, stats.recordedPictures, stats.splicedPictures,
+                stats.recordedArea, stats.recordTime));
+        line.append(String::format("\"operations\":%zu,\"bytes\":%zu,\"pictures\":%u,"
+                "\"pictureBytes\":%zu,\"coalesceArea\":%zu}",
+                stats.recordedOperations, stats.recordedBytes, stats.pileSize,
+                stats.pileBytes, stats.coalesceArea));
+        if (--remaining)
+            line.append(',');
+        lines.append(line.toString());
+    }
+    lines.append("]}");
+
+    FILE* file = useFile ? fopen(RECORDING_STATS_LOG_FILE, "w") : 0;
+    if (useFile && !file) {
+        ALOGE("Could not open %s", RECORDING_STATS_LOG_FILE);
+        return;
+    }
+    for (size_t i = 0; i < lines.size(); i++) {
+        CString line = lines[i].utf8();
+        if (file)
+            fprintf(file, "%s\n", line.data());
+        else
+            ALOGD("%s", line.data());
+    }
+    if (!file)
+        return;
+    fclose(file);
+#if USE_RECORDING_CONTEXT
+    if (!m_content.writeRecording(RECORDING_LOG_FILE))
+        ALOGE("Could not write %s", RECORDING_LOG_FILE);
+#endif
+}
+
 HTMLElement* WebViewCore::retrieveElement(int x, int y,
     const QualifiedName& tagName)
 {
@@ -4823,6 +4894,15 @@ static void DumpRenderTree(JNIEnv* env, jobject obj, jint nativeClass,
     viewImpl->dumpRenderTree(useFile);
 }
 
+static void DumpRecordingStats(JNIEnv* env, jobject obj, jint nativeClass,
+        jboolean useFile)
+{
+    WebViewCore* viewImpl = reinterpret_cast<WebViewCore*>(nativeClass);
+    ALOG_ASSERT(viewImpl, "viewImpl not set in %s", __FUNCTION__);
+
+    viewImpl->dumpRecordingStats(useFile);
+}
+
 static void SetJsFlags(JNIEnv* env, jobject obj, jint nativeClass, jstring flags)
 {
     WTF::String flagsString = jstringToWtfString(env, flags);
@@ -4907,6 +4987,8 @@ static void FreeMemory(JNIEnv* env, jobject obj, jint nativeClass)
     SkANP::InitEvent(&event, kLifecycle_ANPEventType);
     event.data.lifecycle.action = kFreeMemory_ANPLifecycleAction;
     reinterpret_cast<WebViewCore*>(nativeClass)->sendPluginEvent(event);
+    // Fonts no page uses anymore, and with them the cached text shaping
+    fontCache()->purgeInactiveFontData();
 }
 
 static void ProvideVisitedHistory(JNIEnv* env, jobject obj, jint nativeClass,
@@ -5123,6 +5205,8 @@ static JNINativeMethod gJavaWebViewCoreMethods[] = {
         (void*) DumpDomTree },
     { "nativeDumpRenderTree", "(IZ)V",
         (void*) DumpRenderTree },
+    { "nativeDumpRecordingStats", "(IZ)V",
+        (void*) DumpRecordingStats },
     { "nativeSetNewStorageLimit", "(IJ)V",
         (void*) SetNewStorageLimit },
     { "nativeGeolocationPermissionsProvide", "(ILjava/lang/String;ZZ)V",
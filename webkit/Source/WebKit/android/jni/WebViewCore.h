@@ -52,6 +52,7 @@
 #include <android/keycodes.h>
 #include <ui/PixelFormat.h>
 #include <utils/threads.h>
+#include <wtf/Deque.h>
 #include <wtf/Threading.h>
 
 namespace WebCore {
@@ -416,6 +417,10 @@ namespace android {
 
         void dumpDomTree(bool);
         void dumpRenderTree(bool);
+        // Writes the PicturePileStats of the recent recordContent() calls as
+        // JSON, to the log or to RECORDING_STATS_LOG_FILE. In the latter case
+        // the recording of the page goes to RECORDING_LOG_FILE as well.
+        void dumpRecordingStats(bool);
 
         /*  We maintain a list of active plugins. The list is edited by the
             pluginview itself. The list is used to service invals to the plugin
@@ -750,6 +755,7 @@ namespace android {
         WebCore::Frame*        m_mainFrame;
         WebCoreReply*          m_popupReply;
         WebCore::PicturePile m_content; // the set of pictures to draw
+        Deque<WebCore::PicturePileStats> m_recordingStats;
         // Used in passToJS to avoid updating the UI text field until after the
         // key event has been processed.
         bool m_blockTextfieldUpdates;
@@ -1262,8 +1262,9 @@ static void nativeOnTrimMemory(JNIEnv *env, jobject obj, jint level)
             tilesManager->cleanupGLResources();
         }
 
-        bool freeAllTextures = (level > TRIM_MEMORY_UI_HIDDEN), glTextures = true;
-        tilesManager->discardTextures(freeAllTextures, glTextures);
+        // Past TRIM_MEMORY_UI_HIDDEN, free the textures still drawn as well
+        bool spareVisible = (level <= TRIM_MEMORY_UI_HIDDEN);
+        tilesManager->trimTextures(0, spareVisible);
     }
 }
 